@@ -0,0 +1,457 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_app.h"
+#include "qmk-keymap-wiz/keyboard_bench.h"
+#include "qmk-keymap-wiz/keyboard_editor.h"
+#include "qmk-keymap-wiz/keyboard_profile.h"
+#include "qmk-keymap-wiz/keyboard_render.h"
+
+#include "libimgui/imgui.h"
+#include "libimgui/imgui_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+void keyboard_profiler(float height)
+{
+    bool enabled = xcore::profile_enabled();
+    if (ImGui::Checkbox("profile", &enabled))
+        xcore::profile_enable(enabled);
+    ImGui::SameLine();
+    if (ImGui::Button("Export trace"))
+    {
+        xcore::s32 const nb_events = xcore::profile_export("profile.json");
+        if (nb_events >= 0)
+            printf("wrote %d events to profile.json\n", nb_events);
+    }
+
+    // a frame of the render loop should not allocate once it is warmed up
+    xcore::s64 nb_allocs, nb_bytes;
+    xcore::profile_frame_allocs(nb_allocs, nb_bytes);
+    if (nb_allocs > 0)
+        ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "%lld allocations (%lld bytes) last frame", (long long)nb_allocs, (long long)nb_bytes);
+    else
+        ImGui::Text("no allocations last frame");
+
+    if (!enabled || !ImGui::BeginListBox("##zones", ImVec2(-1.0f, height)))
+        return;
+
+    // a zone that never ran (or never allocated) stays out of the way
+    for (xcore::s32 z = 0; z < xcore::PROFILE_NB_ZONES; ++z)
+    {
+        xcore::s32   offset  = 0;
+        float const* history = xcore::profile_history(z, offset);
+        float const  average = xcore::profile_average(z);
+        float        peak    = 0.0f;
+        for (xcore::s32 i = 0; i < xcore::PROFILE_HISTORY; ++i)
+            peak = history[i] > peak ? history[i] : peak;
+        if (peak <= 0.0f)
+            continue;
+
+        char overlay[64];
+        snprintf(overlay, sizeof(overlay), "%.3f ms (max %.3f)", average, peak);
+        ImGui::PlotLines(xcore::profile_zone_name(z), history, xcore::PROFILE_HISTORY, offset, overlay, 0.0f, peak * 1.2f, ImVec2(220.0f, 32.0f));
+    }
+    for (xcore::s32 z = 0; z <= xcore::PROFILE_NB_ZONES; ++z)
+    {
+        xcore::s32   offset  = 0;
+        float const* history = xcore::profile_alloc_history(z, offset);
+        float        peak    = 0.0f;
+        for (xcore::s32 i = 0; i < xcore::PROFILE_HISTORY; ++i)
+            peak = history[i] > peak ? history[i] : peak;
+        if (peak <= 0.0f)
+            continue;
+
+        char label[64];
+        char overlay[64];
+        snprintf(label, sizeof(label), "%s allocs", xcore::profile_zone_name(z));
+        snprintf(overlay, sizeof(overlay), "%.0f (max %.0f)", history[(offset + xcore::PROFILE_HISTORY - 1) % xcore::PROFILE_HISTORY], peak);
+        ImGui::PlotHistogram(label, history, xcore::PROFILE_HISTORY, offset, overlay, 0.0f, peak * 1.2f, ImVec2(220.0f, 32.0f));
+    }
+    ImGui::EndListBox();
+}
+
+void keyboard_app_frame(keditor_t& editor, xcore::keycodes_t const* kcDB, xcore::ckeyboards_t const* kbDB, float& width, float& height)
+{
+    xcore::kprofilescope_t zone(xcore::PROFILE_UI);
+
+    // a file picked in the workspace panel last frame is opened before anything of the open file is looked at
+    keyboard_editor_switch(editor, kcDB, kbDB);
+
+    ImGuiIO&                  io = ImGui::GetIO();
+    xcore::keymap_t const*    km = &keyboard_editor_keymaps(editor)->m_keymaps[0];
+    xcore::ckeyboard_t const* kb = xcore::find_keyboard(kbDB, km->m_name); // nullptr when it is not in the keyboard database
+
+    ImGui::SetNextWindowPos(ImVec2(0, 0));
+    ImGui::Begin("Keyboard Wiz", nullptr,
+                 ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse);
+
+    ImGui::BeginChildFrame(ImGui::GetID("Settings"), ImVec2(420, 260), ImGuiWindowFlags_NoMove);
+
+    // When clicking a key we would like a menu to popup
+    // The menu should be able to provide to the user:
+    //   - change the key's keycode
+    //   - change the key's modifiers (shift, ctrl, alt, etc.)
+    //   - change the key's cap color
+    //   - change the key's led color
+
+    // Adding/Removing layers
+    //   - add a new layer (see if there was a layer with the same name that is marked as deleted')
+    //   - remove a layer (when removing we should just mark it as 'deleted')
+
+    keyboard_editor_toolbar(editor);
+    keyboard_editor_workspace(editor, 80.0f);
+    keyboard_editor_diagnostics(editor, 80.0f);
+    keyboard_editor_find(editor, 80.0f);
+    keyboard_editor_optimizer(editor, kb);
+    keyboard_editor_simulator(editor);
+    keyboard_editor_rgb(editor);
+
+    ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+    keyboard_profiler(160.0f);
+
+    const float MIN_SCALE = 0.7f;
+    const float MAX_SCALE = 1.5f;
+    ImGui::DragFloat("global scale", &io.FontGlobalScale, 0.005f, MIN_SCALE, MAX_SCALE, "%.2f", ImGuiSliderFlags_AlwaysClamp); // Scale everything
+
+    ImGui::EndChildFrame();
+
+    static ImGuiTabBarFlags tab_bar_flags = ImGuiTabBarFlags_AutoSelectNewTabs | ImGuiTabBarFlags_FittingPolicyResizeDown;
+
+    ImVec2 frameSize = ImVec2(2048, 840);
+    ImGui::BeginChildFrame(ImGui::GetID("keyboard_area"), frameSize);
+    if (ImGui::BeginTabBar("Layers", tab_bar_flags))
+    {
+        ImColor tabkgrndcolor(10, 10, 10, 256);
+
+        if (ImGui::TabItemButton("?", ImGuiTabItemFlags_Leading | ImGuiTabItemFlags_NoTooltip))
+            ImGui::OpenPopup("MyHelpMenu");
+        if (ImGui::BeginPopup("MyHelpMenu"))
+        {
+            ImGui::Selectable("Hello!");
+            ImGui::EndPopup();
+        }
+
+        if (ImGui::TabItemButton("+", ImGuiTabItemFlags_Trailing | ImGuiTabItemFlags_NoTooltip))
+        {
+            // create a new layer?
+            //active_tabs.push_back(next_tab_id++); // Add new tab
+        }
+
+        // Submit our regular tabs, while simulating the active layers are green and the highest one is selected
+        xcore::u32 const active = keyboard_editor_simulate_layers(editor);
+        xcore::s32 const follow = keyboard_editor_simulate_follow(editor);
+        for (int n = 0; n < km->m_nb_layers; n++)
+        {
+            char name[16];
+            snprintf(name, IM_ARRAYSIZE(name), "%s", km->m_layers[n].m_name);
+            bool const on = n < 32 && (active & (1u << n)) != 0;
+            if (on)
+                ImGui::PushStyleColor(ImGuiCol_Tab, IM_COL32(40, 110, 40, 255));
+            bool const open = ImGui::BeginTabItem(name, nullptr, n == follow ? ImGuiTabItemFlags_SetSelected : 0);
+            if (on)
+                ImGui::PopStyleColor();
+            if (open && kb == nullptr)
+            {
+                ImGui::Text("Keyboard '%s' is not in the keyboard database (kbdb), the keymap cannot be shown", km->m_name != nullptr ? km->m_name : "");
+                ImGui::EndTabItem();
+            }
+            else if (open)
+            {
+                ImVec2 p = ImGui::GetCursorScreenPos();
+
+                ImDrawList* draw_list = ImGui::GetWindowDrawList();
+                draw_list->AddRectFilled(ImVec2(p.x, p.y), ImVec2(p.x + frameSize.x, p.y + frameSize.y), tabkgrndcolor, 0, ImDrawFlags_RoundCornersAll);
+
+                // the best layout of the optimizer is previewed as is, without the views of the keymap itself
+                xcore::keymap_t const* candidate = keyboard_editor_candidate(editor);
+                xcore::krgb_t*         rgb       = candidate == nullptr ? keyboard_editor_rgb_frame(editor, kb, n) : nullptr;
+                xcore::s32 const       key       = candidate != nullptr ? keyboard_render(kb, kcDB, candidate, n, p.x, p.y, io.MousePos.x, io.MousePos.y, io.FontGlobalScale)
+                                                                        : keyboard_render(kb, kcDB, km, n, p.x, p.y, io.MousePos.x, io.MousePos.y, io.FontGlobalScale, keyboard_editor_compose(editor, 0), keyboard_editor_heatmap(editor, 0), rgb);
+                if (candidate == nullptr && key >= 0 && ImGui::IsMouseClicked(ImGuiMouseButton_Left))
+                    keyboard_editor_rgb_hit(editor, key);
+                if (candidate == nullptr && !keyboard_editor_simulate_mouse(editor, key) && key >= 0 && ImGui::IsMouseClicked(ImGuiMouseButton_Left))
+                    keyboard_editor_select(editor, 0, n, key);
+                keyboard_editor_find_overlay(editor, kb, n, p.x, p.y, io.FontGlobalScale);
+                keyboard_editor_simulate_overlay(editor, kb, p.x, p.y, io.FontGlobalScale);
+                keyboard_editor_layer_graph(editor, 0, n, p.x + frameSize.x - 380.0f, p.y + 10.0f, 360.0f);
+
+                ImGui::EndTabItem();
+            }
+        }
+        ImGui::EndTabBar();
+    }
+    ImGui::EndChildFrame();
+    keyboard_editor_popup(editor, kcDB);
+    ImVec2 const winSize = ImGui::GetWindowSize();
+
+    ImGui::ShowDemoWindow();
+
+    ImGui::End();
+
+    width  = winSize.x;
+    height = winSize.y;
+}
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// Input, the named keys are recorded relative to ImGuiKey_NamedKey_BEGIN. The mouse buttons also exist as keys, those
+// are aliases that ImGui updates itself and that cannot be submitted as key events.
+
+static xcore::s32 nb_input_keys() { return (xcore::s32)ImGuiKey_NamedKey_COUNT < (xcore::s32)xcore::INPUT_MAX_KEYS ? (xcore::s32)ImGuiKey_NamedKey_COUNT : (xcore::s32)xcore::INPUT_MAX_KEYS; }
+
+void keyboard_input_capture(xcore::kinputframe_t& frame)
+{
+    ImGuiIO& io = ImGui::GetIO();
+    xcore::input_clear(frame);
+    frame.m_delta_time = io.DeltaTime;
+    frame.m_display_w  = io.DisplaySize.x;
+    frame.m_display_h  = io.DisplaySize.y;
+    frame.m_font_scale = io.FontGlobalScale;
+    frame.m_mouse_x    = io.MousePos.x;
+    frame.m_mouse_y    = io.MousePos.y;
+    frame.m_wheel_x    = io.MouseWheelH;
+    frame.m_wheel_y    = io.MouseWheel;
+    for (xcore::s32 b = 0; b < xcore::INPUT_MAX_BUTTONS; ++b)
+        frame.m_buttons |= io.MouseDown[b] ? (1u << b) : 0u;
+
+    xcore::s32 const nb_keys = nb_input_keys();
+    for (xcore::s32 k = 0; k < nb_keys; ++k)
+    {
+        ImGuiKey const key = (ImGuiKey)(ImGuiKey_NamedKey_BEGIN + k);
+        if (!ImGui::IsAliasKey(key) && ImGui::IsKeyDown(key))
+            xcore::input_set_key(frame, k, true);
+    }
+
+    for (int i = 0; i < io.InputQueueCharacters.Size && frame.m_nb_chars < xcore::INPUT_MAX_CHARS; ++i)
+        frame.m_chars[frame.m_nb_chars++] = (xcore::u32)io.InputQueueCharacters[i];
+}
+
+void keyboard_input_apply(xcore::kinputframe_t const& frame, xcore::kinputframe_t const& previous, bool display)
+{
+    ImGuiIO& io        = ImGui::GetIO();
+    io.DeltaTime       = frame.m_delta_time > 0.0f ? frame.m_delta_time : 1.0f / 60.0f;
+    io.FontGlobalScale = frame.m_font_scale;
+    if (display)
+        io.DisplaySize = ImVec2(frame.m_display_w, frame.m_display_h);
+
+    io.AddMousePosEvent(frame.m_mouse_x, frame.m_mouse_y);
+    for (xcore::s32 b = 0; b < xcore::INPUT_MAX_BUTTONS; ++b)
+    {
+        bool const down = (frame.m_buttons & (1u << b)) != 0;
+        if (down != ((previous.m_buttons & (1u << b)) != 0))
+            io.AddMouseButtonEvent(b, down);
+    }
+    if (frame.m_wheel_x != 0.0f || frame.m_wheel_y != 0.0f)
+        io.AddMouseWheelEvent(frame.m_wheel_x, frame.m_wheel_y);
+
+    xcore::s32 const nb_keys = nb_input_keys();
+    for (xcore::s32 k = 0; k < nb_keys; ++k)
+    {
+        bool const down = xcore::input_key(frame, k);
+        if (down != xcore::input_key(previous, k))
+            io.AddKeyEvent((ImGuiKey)(ImGuiKey_NamedKey_BEGIN + k), down);
+    }
+    for (xcore::s32 i = 0; i < frame.m_nb_chars; ++i)
+        io.AddInputCharacter(frame.m_chars[i]);
+}
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+
+struct kreplay_t
+{
+    xcore::kplayer_t*    m_player;
+    xcore::kinputframe_t m_previous;
+    bool                 m_headless;
+    bool                 m_pending; // a frame was applied, its timings are not collected yet
+    bool                 m_idle;    // the pending frame has the same input as the one before
+    xcore::s32           m_nb_frames;
+    xcore::s32           m_max_frames;
+    float*               m_timings; // 4 per frame: frame, ui, keyboard_render, imgui_render (ms)
+    xcore::s32*          m_vertices;
+    xcore::s64*          m_allocs; // 2 per frame: allocations and bytes
+    bool*                m_idles;
+};
+
+kreplay_t* keyboard_replay_open(const char* filename, bool headless)
+{
+    xcore::kplayer_t* player = xcore::player_open(filename);
+    if (player == nullptr)
+        return nullptr;
+
+    kreplay_t* replay    = (kreplay_t*)::malloc(sizeof(kreplay_t));
+    replay->m_player     = player;
+    replay->m_headless   = headless;
+    replay->m_pending    = false;
+    replay->m_idle       = false;
+    replay->m_nb_frames  = 0;
+    replay->m_max_frames = xcore::player_nb_frames(player);
+    replay->m_timings    = (float*)::malloc(sizeof(float) * 4 * (replay->m_max_frames + 1));
+    replay->m_vertices   = (xcore::s32*)::malloc(sizeof(xcore::s32) * (replay->m_max_frames + 1));
+    replay->m_allocs     = (xcore::s64*)::malloc(sizeof(xcore::s64) * 2 * (replay->m_max_frames + 1));
+    replay->m_idles      = (bool*)::malloc(sizeof(bool) * (replay->m_max_frames + 1));
+    xcore::input_clear(replay->m_previous);
+    return replay;
+}
+
+bool keyboard_replay_input(kreplay_t* replay)
+{
+    xcore::kinputframe_t frame;
+    if (!xcore::player_next(replay->m_player, frame))
+        return false;
+
+    // the recorded frames are replayed as they were seen, not spread over multiple frames
+    ImGui::GetIO().ConfigInputTrickleEventQueue = false;
+    keyboard_input_apply(frame, replay->m_previous, replay->m_headless);
+    replay->m_idle     = replay->m_nb_frames > 0 && xcore::input_idle(frame, replay->m_previous);
+    replay->m_previous = frame;
+    replay->m_pending  = true;
+    return true;
+}
+
+void keyboard_replay_timings(kreplay_t* replay)
+{
+    if (!replay->m_pending || replay->m_nb_frames >= replay->m_max_frames)
+        return;
+    replay->m_pending = false;
+
+    static const xcore::s32 s_zones[4] = {xcore::PROFILE_FRAME, xcore::PROFILE_UI, xcore::PROFILE_KEYBOARD_RENDER, xcore::PROFILE_IMGUI_RENDER};
+
+    float* timings = replay->m_timings + 4 * replay->m_nb_frames;
+    for (xcore::s32 i = 0; i < 4; ++i)
+    {
+        xcore::s32   offset  = 0;
+        float const* history = xcore::profile_history(s_zones[i], offset);
+        timings[i]           = history[(offset + xcore::PROFILE_HISTORY - 1) % xcore::PROFILE_HISTORY];
+    }
+    ImDrawData const* draw_data             = ImGui::GetDrawData();
+    replay->m_vertices[replay->m_nb_frames] = draw_data != nullptr ? draw_data->TotalVtxCount : 0;
+    replay->m_idles[replay->m_nb_frames]    = replay->m_idle;
+    xcore::profile_frame_allocs(replay->m_allocs[2 * replay->m_nb_frames], replay->m_allocs[2 * replay->m_nb_frames + 1]);
+    replay->m_nb_frames += 1;
+}
+
+static int compare_floats(const void* a, const void* b)
+{
+    float const fa = *(float const*)a;
+    float const fb = *(float const*)b;
+    return fa < fb ? -1 : (fa > fb ? 1 : 0);
+}
+
+bool keyboard_replay_close(kreplay_t* replay, xcore::kwriter_t* out, xcore::s32 warmup)
+{
+    xcore::s32 const n = replay->m_nb_frames;
+
+    // the summary of every zone, the percentiles from a sorted copy
+    static const char* s_names[4] = {"frame", "ui", "keyboard_render", "imgui_render"};
+    float              mean[4], p50[4], p95[4], peak[4];
+    float*             sorted = (float*)::malloc(sizeof(float) * (n + 1));
+    for (xcore::s32 z = 0; z < 4; ++z)
+    {
+        double sum = 0.0;
+        for (xcore::s32 f = 0; f < n; ++f)
+        {
+            sorted[f] = replay->m_timings[4 * f + z];
+            sum += sorted[f];
+        }
+        qsort(sorted, n, sizeof(float), compare_floats);
+        mean[z] = n > 0 ? (float)(sum / n) : 0.0f;
+        p50[z]  = n > 0 ? sorted[n / 2] : 0.0f;
+        p95[z]  = n > 0 ? sorted[(n * 95) / 100] : 0.0f;
+        peak[z] = n > 0 ? sorted[n - 1] : 0.0f;
+        printf("%-16s mean %8.3f ms  p50 %8.3f ms  p95 %8.3f ms  max %8.3f ms\n", s_names[z], mean[z], p50[z], p95[z], peak[z]);
+    }
+    ::free(sorted);
+
+    // the steady frames that allocated, the first few are listed
+    xcore::s32 nb_allocating = 0;
+    xcore::s64 total_allocs  = 0;
+    for (xcore::s32 f = 0; f < n; ++f)
+    {
+        xcore::s64 const allocs = replay->m_allocs[2 * f];
+        total_allocs += allocs;
+        if (warmup < 0 || f < warmup || !replay->m_idles[f] || allocs == 0)
+            continue;
+        if (nb_allocating < 8)
+            printf("steady frame %d made %lld allocations (%lld bytes)\n", f, (long long)allocs, (long long)replay->m_allocs[2 * f + 1]);
+        nb_allocating += 1;
+    }
+    printf("replayed %d of %d frames, %lld allocations\n", n, replay->m_max_frames, (long long)total_allocs);
+    if (warmup >= 0)
+        printf("%d steady frames allocated after a warmup of %d frames\n", nb_allocating, warmup);
+
+    if (out != nullptr)
+    {
+        char line[256];
+        snprintf(line, sizeof(line), "{\n  \"frames\": %d,\n  \"headless\": %s,\n  \"allocations\": %lld,\n  \"allocating_steady_frames\": %d,\n  \"summary\": {", n, replay->m_headless ? "true" : "false",
+                 (long long)total_allocs, nb_allocating);
+        xcore::writer_str(*out, line);
+        for (xcore::s32 z = 0; z < 4; ++z)
+        {
+            snprintf(line, sizeof(line), "%s\n    \"%s\": {\"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p95_ms\": %.4f, \"max_ms\": %.4f}", z == 0 ? "" : ",", s_names[z], mean[z], p50[z], p95[z], peak[z]);
+            xcore::writer_str(*out, line);
+        }
+        xcore::writer_str(*out, "\n  },\n  \"timings\": [");
+        for (xcore::s32 f = 0; f < n; ++f)
+        {
+            float const* t = replay->m_timings + 4 * f;
+            snprintf(line, sizeof(line), "%s\n    {\"frame\": %d, \"frame_ms\": %.4f, \"ui_ms\": %.4f, \"keyboard_render_ms\": %.4f, \"imgui_render_ms\": %.4f, \"vertices\": %d, \"allocs\": %lld, \"alloc_bytes\": %lld, \"idle\": %s}",
+                     f == 0 ? "" : ",", f, t[0], t[1], t[2], t[3], replay->m_vertices[f], (long long)replay->m_allocs[2 * f], (long long)replay->m_allocs[2 * f + 1], replay->m_idles[f] ? "true" : "false");
+            xcore::writer_str(*out, line);
+        }
+        xcore::writer_str(*out, "\n  ]\n}\n");
+    }
+
+    xcore::player_close(replay->m_player);
+    ::free(replay->m_timings);
+    ::free(replay->m_vertices);
+    ::free(replay->m_allocs);
+    ::free(replay->m_idles);
+    ::free(replay);
+    return n > 0 && nb_allocating == 0;
+}
+
+bool keyboard_replay_headless(xcore::kwriter_t& out, const char* filename, keditor_t& editor, xcore::keycodes_t const* kcdb, xcore::ckeyboards_t const* kbdb, xcore::s32 warmup)
+{
+    // the same fonts as the application, without the font files the labels are drawn with the default font
+    if (!keyboard_bench_context())
+        printf("fonts/ not found, the labels are rendered with the default font\n");
+
+    kreplay_t* replay = keyboard_replay_open(filename, true);
+    if (replay == nullptr)
+    {
+        ImGui::DestroyContext();
+        return false;
+    }
+
+    // the zones of loading the databases are not part of the first frame
+    xcore::profile_enable(true);
+    xcore::profile_frame();
+    while (true)
+    {
+        {
+            xcore::kprofilescope_t frame_zone(xcore::PROFILE_FRAME);
+            {
+                xcore::kprofilescope_t zone(xcore::PROFILE_EDITOR_UPDATE);
+                keyboard_editor_update(editor);
+            }
+            if (!keyboard_replay_input(replay))
+                break;
+
+            ImGui::NewFrame();
+            float width, height;
+            keyboard_app_frame(editor, kcdb, kbdb, width, height);
+            {
+                xcore::kprofilescope_t zone(xcore::PROFILE_IMGUI_RENDER);
+                ImGui::Render();
+            }
+        }
+        xcore::profile_frame();
+        keyboard_replay_timings(replay);
+    }
+
+    bool const ok = keyboard_replay_close(replay, &out, warmup);
+    ImGui::DestroyContext();
+    return ok;
+}
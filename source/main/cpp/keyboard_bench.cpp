@@ -0,0 +1,375 @@
+#include "xbase/x_base.h"
+#include "xbase/x_memory.h"
+
+#include "qmk-keymap-wiz/keyboard_app.h"
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_keycode.h"
+#include "qmk-keymap-wiz/keyboard_layout.h"
+#include "qmk-keymap-wiz/keyboard_render.h"
+#include "qmk-keymap-wiz/keyboard_rgb.h"
+#include "qmk-keymap-wiz/keyboard_save.h"
+#include "qmk-keymap-wiz/keyboard_bench.h"
+
+#include "libimgui/imgui.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+using namespace xcore;
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// Timing, a benchmark runs its body at least once and until it has taken 'min_seconds'
+
+struct sbenchtimer_t
+{
+    std::chrono::steady_clock::time_point m_start;
+    s64                                   m_iterations;
+    double                                m_seconds;
+};
+
+static void bench_start(sbenchtimer_t& t)
+{
+    t.m_start      = std::chrono::steady_clock::now();
+    t.m_iterations = 0;
+    t.m_seconds    = 0.0;
+}
+
+static bool bench_next(sbenchtimer_t& t, double min_seconds)
+{
+    t.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t.m_start).count();
+    if (t.m_iterations > 0 && t.m_seconds >= min_seconds)
+        return false;
+    t.m_iterations += 1;
+    return true;
+}
+
+struct sbenchreport_t
+{
+    kwriter_t* m_out;
+    s32        m_nb_results;
+};
+
+// 'ops' and 'bytes' are per iteration, e.g. the number of keys that were looked up or the size of a decoded file
+static void bench_result(sbenchreport_t& r, kbenchsize_t const& size, const char* name, sbenchtimer_t const& t, s64 ops, s64 bytes)
+{
+    double const total_ops = (double)t.m_iterations * (double)(ops > 0 ? ops : 1);
+    double const ns_per_op = t.m_seconds * 1e9 / total_ops;
+    double const mb_per_s  = t.m_seconds > 0.0 ? (double)t.m_iterations * (double)bytes / t.m_seconds / (1024.0 * 1024.0) : 0.0;
+
+    char line[384];
+    snprintf(line, sizeof(line), "%s\n    {\"name\": \"%s\", \"keys\": %d, \"layers\": %d, \"iterations\": %lld, \"seconds\": %.6f, \"ops\": %lld, \"ns_per_op\": %.2f, \"mb_per_s\": %.2f}",
+             r.m_nb_results == 0 ? "" : ",", name, size.m_nb_keys, size.m_nb_layers, (long long)t.m_iterations, t.m_seconds, (long long)ops, ns_per_op, mb_per_s);
+    writer_str(*r.m_out, line);
+    r.m_nb_results += 1;
+
+    printf("%-16s %6d keys %3d layers %14.2f ns/op", name, size.m_nb_keys, size.m_nb_layers, ns_per_op);
+    if (bytes > 0)
+        printf(" %10.2f MB/s", mb_per_s);
+    printf("\n");
+}
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// Synthetic data
+
+// split halves of 3x6 keygroups next to each other, the groups of the right halves are rotated
+static bool write_keyboard(const char* filename, s32 nb_keys)
+{
+    kwriter_t w;
+    if (!writer_open(w, filename))
+        return false;
+
+    s32 const per_group = 18;
+    s32 const nb_groups = (nb_keys + per_group - 1) / per_group;
+    s32       columns   = 2;
+    while (columns * columns < nb_groups)
+        columns += 2;
+
+    writer_str(w, "{\n    \"keyboards\": [\n        {\n            \"name\": \"bench ");
+    writer_int(w, nb_keys);
+    writer_str(w, "\",\n            \"scale\": 100,\n            \"keygroups\": [\n");
+    s32 index = 0;
+    for (s32 g = 0; g < nb_groups; ++g)
+    {
+        s32 const n = (nb_keys - index) < per_group ? (nb_keys - index) : per_group;
+        writer_str(w, g == 0 ? "                {\"name\": \"g" : ",\n                {\"name\": \"g");
+        writer_int(w, g);
+        writer_str(w, "\", \"x\": ");
+        writer_float(w, (float)(g % columns) * 7.5f, 1);
+        writer_str(w, ", \"y\": ");
+        writer_float(w, (float)(g / columns) * 4.0f, 1);
+        writer_str(w, ", \"r\": 3, \"c\": 6, \"a\": ");
+        writer_int(w, (g & 1) != 0 ? 10 : 0);
+        writer_str(w, ", \"keys\": [");
+        for (s32 k = 0; k < n; ++k)
+        {
+            writer_str(w, k == 0 ? "{\"index\": " : ", {\"index\": ");
+            writer_int(w, index++);
+            writer_str(w, ", \"label\": \"K\"}");
+        }
+        writer_str(w, "]}");
+    }
+    writer_str(w, "\n            ]\n        }\n    ]\n}\n");
+    return writer_close(w);
+}
+
+// every layer has a keycode from the database on every key, the upper layers have every other key transparent and
+// the base layer has a momentary switch to every other layer
+static bool write_keymaps(const char* filename, keycodes_t const* kcdb, s32 nb_keys, s32 nb_layers)
+{
+    char*         names  = (char*)::malloc(8 * nb_layers);
+    layer_t*      layers = (layer_t*)::malloc(sizeof(layer_t) * nb_layers);
+    xcore::key_t* keys   = (xcore::key_t*)::malloc(sizeof(xcore::key_t) * nb_keys * nb_layers);
+    for (s32 l = 0; l < nb_layers; ++l)
+    {
+        layer_t& layer = layers[l];
+        new (&layer) layer_t();
+        snprintf(names + 8 * l, 8, "L%d", l);
+        layer.m_name    = names + 8 * l;
+        layer.m_index   = (s16)l;
+        layer.m_nb_keys = (s16)nb_keys;
+        layer.m_keys    = &keys[l * nb_keys];
+        for (s32 k = 0; k < nb_keys; ++k)
+        {
+            xcore::key_t& key = layer.m_keys[k];
+            new (&key) xcore::key_t();
+            if (l > 0 && (k & 1) != 0)
+                key.m_keycode_str = "KC_TRNS";
+            else if (kcdb->m_nb_keycodes > 1)
+                key.m_keycode_str = kcdb->m_keycodes[1 + (k * 7 + l * 13) % (kcdb->m_nb_keycodes - 1)].m_code;
+        }
+    }
+    for (s32 l = 1; l < nb_layers && 3 * l < nb_keys; ++l)
+    {
+        xcore::key_t& key  = layers[0].m_keys[3 * l];
+        key.m_keycode_str  = "KC_NO";
+        key.m_layer_switch = MO;
+        key.m_layer        = layers[l].m_name;
+    }
+
+    keymap_t km;
+    km.m_name      = "bench";
+    km.m_nb_layers = nb_layers;
+    km.m_layers    = layers;
+    keymaps_t kms;
+    kms.m_nb_keymaps = 1;
+    kms.m_keymaps    = &km;
+
+    kwriter_t w;
+    bool      ok = writer_open(w, filename);
+    if (ok)
+    {
+        encode_keymaps(w, &kms);
+        ok = writer_close(w);
+    }
+    ::free(keys);
+    ::free(layers);
+    ::free(names);
+    return ok;
+}
+
+bool keyboard_bench_write(const char* kb_file, const char* km_file, keycodes_t const* kcdb, kbenchsize_t const& size) { return write_keyboard(kb_file, size.m_nb_keys) && write_keymaps(km_file, kcdb, size.m_nb_keys, size.m_nb_layers); }
+
+static s64 file_size(const char* filename)
+{
+    FILE* f = fopen(filename, "rb");
+    if (f == nullptr)
+        return 0;
+    fseek(f, 0, SEEK_END);
+    s64 const size = (s64)ftell(f);
+    fclose(f);
+    return size;
+}
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+
+// an ImGui context that is never drawn, the fonts are built into the atlas on the CPU
+bool keyboard_bench_context()
+{
+    keyboard_profile_allocators();
+    ImGui::CreateContext();
+    ImGuiIO& io    = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    io.DisplaySize = ImVec2(8192.0f, 8192.0f);
+    io.DeltaTime   = 1.0f / 60.0f;
+    io.Fonts->AddFontDefault();
+
+    // without the font files the labels are drawn with the default font
+    FILE* f = fopen("fonts/Roboto-Medium.ttf", "rb");
+    if (f != nullptr)
+    {
+        fclose(f);
+        keyboard_loadfonts();
+    }
+    unsigned char* pixels = nullptr;
+    int            w = 0, h = 0;
+    io.Fonts->GetTexDataAsAlpha8(&pixels, &w, &h);
+    return f != nullptr;
+}
+
+static void bench_size(sbenchreport_t& report, keycodes_t const* kcdb, kbenchsize_t const& size, double min_seconds, const char* tmpdir)
+{
+    char kb_file[512];
+    char km_file[512];
+    snprintf(kb_file, sizeof(kb_file), "%s/bench_keyboards_%d.json", tmpdir, size.m_nb_keys);
+    snprintf(km_file, sizeof(km_file), "%s/bench_keymaps_%d_%d.json", tmpdir, size.m_nb_keys, size.m_nb_layers);
+    if (!keyboard_bench_write(kb_file, km_file, kcdb, size))
+    {
+        printf("failed to write the synthetic data to %s\n", tmpdir);
+        return;
+    }
+    s64 const kb_bytes = file_size(kb_file);
+    s64 const km_bytes = file_size(km_file);
+
+    // the decoded data takes a few times the size of the JSON, the arenas are reused by every iteration
+    karena_t kb_arena;
+    karena_t km_arena;
+    init_arena(kb_arena, (u32)(4 * kb_bytes + 1024 * 1024), (u32)(4 * kb_bytes + 1024 * 1024));
+    init_arena(km_arena, (u32)(4 * km_bytes + 1024 * 1024), (u32)(4 * km_bytes + 1024 * 1024));
+
+    sbenchtimer_t       t;
+    ckeyboards_t const* kbs = nullptr;
+    bool                ok  = true;
+    for (bench_start(t); ok && bench_next(t, min_seconds);)
+        ok = load_keyboards(kb_file, kb_arena, kbs);
+    if (ok)
+        bench_result(report, size, "decode_keyboards", t, 1, kb_bytes);
+
+    keymaps_t const* kms = nullptr;
+    for (bench_start(t); ok && bench_next(t, min_seconds);)
+        ok = load_keymaps(km_file, km_arena, kms);
+    if (ok)
+        bench_result(report, size, "decode_keymaps", t, 1, km_bytes);
+
+    remove(kb_file);
+    remove(km_file);
+    if (!ok || kbs->m_nb_keyboards == 0 || kms->m_nb_keymaps == 0)
+    {
+        printf("failed to decode the synthetic data of %d keys\n", size.m_nb_keys);
+        exit_arena(kb_arena);
+        exit_arena(km_arena);
+        return;
+    }
+
+    ckeyboard_t const* kb      = &kbs->m_keyboards[0];
+    keymap_t const*    km      = &kms->m_keymaps[0];
+    s64 const          nb_keys = (s64)size.m_nb_keys * size.m_nb_layers;
+
+    for (bench_start(t); bench_next(t, min_seconds);)
+        compile_keymaps(kcdb, const_cast<keymaps_t*>(kms));
+    bench_result(report, size, "compile", t, nb_keys, 0);
+
+    s32 found = 0;
+    for (bench_start(t); bench_next(t, min_seconds);)
+    {
+        for (s32 l = 0; l < km->m_nb_layers; ++l)
+        {
+            layer_t const& layer = km->m_layers[l];
+            for (s32 k = 0; k < layer.m_nb_keys; ++k)
+                found += find_keycode(kcdb, layer.m_keys[k].m_keycode_str) != nullptr ? 1 : 0;
+        }
+    }
+    bench_result(report, size, "find_keycode", t, nb_keys, 0);
+
+    s32 const    nb_places = keyboard_nb_keys(kb);
+    ckeyplace_t* places    = (ckeyplace_t*)::malloc(sizeof(ckeyplace_t) * (nb_places + 1));
+    for (bench_start(t); bench_next(t, min_seconds);)
+        keyboard_layout(kb, 0.0f, 0.0f, 1.0f, places, nb_places);
+    bench_result(report, size, "layout", t, nb_places, 0);
+
+    // random points in the bounding box of the keys, the first key that contains the point wins
+    float maxx = 1.0f, maxy = 1.0f;
+    for (s32 i = 0; i < nb_places; ++i)
+    {
+        maxx = places[i].m_x + places[i].m_hw > maxx ? places[i].m_x + places[i].m_hw : maxx;
+        maxy = places[i].m_y + places[i].m_hh > maxy ? places[i].m_y + places[i].m_hh : maxy;
+    }
+    s32 const queries = 1024;
+    u32       rnd     = 0x2545F491u;
+    s32       hits    = 0;
+    for (bench_start(t); bench_next(t, min_seconds);)
+    {
+        for (s32 q = 0; q < queries; ++q)
+        {
+            rnd           = rnd * 1664525u + 1013904223u;
+            float const x = (float)(rnd >> 16) / 65536.0f * maxx;
+            rnd           = rnd * 1664525u + 1013904223u;
+            float const y = (float)(rnd >> 16) / 65536.0f * maxy;
+            for (s32 i = 0; i < nb_places; ++i)
+            {
+                if (keyplace_contains(places[i], x, y))
+                {
+                    hits += 1;
+                    break;
+                }
+            }
+        }
+    }
+    bench_result(report, size, "hit_test", t, queries, 0);
+    ::free(places);
+
+    // the splash of the RGB preview, the heaviest effect, with every remembered press still going
+    krgb_t*      rgb = rgb_create();
+    krgbparams_t rgb_params;
+    rgb_params.m_effect = RGB_SPLASH;
+    rgb_build(rgb, kb);
+    rgb_colors(rgb, km, 0);
+    for (s32 h = 0; h < RGB_MAX_HITS; ++h)
+        rgb_hit(rgb, (h * 7919) % size.m_nb_keys, 0.0);
+    s32 frame = 0;
+    for (bench_start(t); bench_next(t, min_seconds);)
+    {
+        rgb_update(rgb, rgb_params, 0.1 + (double)frame * 0.001);
+        frame = (frame + 1) % 1000;
+    }
+    bench_result(report, size, "rgb", t, rgb_nb_leds(rgb), 0);
+    rgb_destroy(rgb);
+
+    // a frame per layer, the mouse on a key so that the tooltip is part of it
+    s32 layer    = 0;
+    s64 vertices = 0;
+    for (bench_start(t); bench_next(t, min_seconds);)
+    {
+        ImGui::NewFrame();
+        ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f));
+        ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+        ImGui::Begin("bench", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoSavedSettings);
+        keyboard_render(kb, kcdb, km, layer, 0.0f, 0.0f, 60.0f, 60.0f, 0.5f);
+        ImGui::End();
+        ImGui::Render();
+        vertices += ImGui::GetDrawData()->TotalVtxCount;
+        layer = (layer + 1) % km->m_nb_layers;
+    }
+    bench_result(report, size, "render", t, 1, 0);
+    printf("%-16s %6d keys %3d layers %14lld vertices/frame (%d keycodes found, %d hits)\n", "render", size.m_nb_keys, size.m_nb_layers, (long long)(vertices / t.m_iterations), found, hits);
+
+    exit_arena(kb_arena);
+    exit_arena(km_arena);
+}
+
+bool keyboard_bench(kwriter_t& out, keycodes_t const* kcdb, kbenchsize_t const* sizes, s32 nb_sizes, double min_seconds, const char* tmpdir, const char* label)
+{
+    if (!keyboard_bench_context())
+        printf("fonts/ not found, the labels are rendered with the default font\n");
+
+    sbenchreport_t report;
+    report.m_out        = &out;
+    report.m_nb_results = 0;
+
+    writer_str(out, "{\n  \"label\": ");
+    writer_json_str(out, label != nullptr ? label : "");
+    writer_str(out, ",\n  \"results\": [");
+    for (s32 i = 0; i < nb_sizes; ++i)
+    {
+        if (sizes[i].m_nb_keys > 0 && sizes[i].m_nb_keys <= 0x7FFF && sizes[i].m_nb_layers > 0)
+            bench_size(report, kcdb, sizes[i], min_seconds, tmpdir);
+    }
+    writer_str(out, "\n  ]\n}\n");
+
+    ImGui::DestroyContext();
+    return report.m_nb_results > 0;
+}
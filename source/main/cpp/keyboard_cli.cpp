@@ -0,0 +1,127 @@
+#include "xbase/x_base.h"
+#include "xbase/x_memory.h"
+
+#include "qmk-keymap-wiz/keyboard_cli.h"
+#include "qmk-keymap-wiz/keyboard_cli_commands.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace xcore;
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// Command line helpers
+
+const char* arg_value(int argc, char** argv, const char* name, const char* default_value)
+{
+    for (int i = 2; i < argc - 1; i++)
+    {
+        if (strcmp(argv[i], name) == 0)
+            return argv[i + 1];
+    }
+    return default_value;
+}
+
+bool arg_flag(int argc, char** argv, const char* name)
+{
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], name) == 0)
+            return true;
+    }
+    return false;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); }
+
+// replace anything that is not safe in a file name
+void sanitize(const char* name, char* out, int maxlen)
+{
+    int i = 0;
+    for (; name[i] != 0 && i < maxlen - 1; i++)
+    {
+        char const c = name[i];
+        out[i]       = ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-') ? c : '_';
+    }
+    out[i] = 0;
+}
+
+// The keycode and keyboard databases are loaded once and shared (read-only) by all the jobs
+bool load_databases(keycodes_t const*& kcdb, ckeyboards_t const*& kbdb)
+{
+    init_keycodes();
+    init_keyboards();
+    if (!load_keycodes(kcdb))
+        return false;
+    if (!load_keyboards(kbdb))
+        return false;
+    return true;
+}
+
+void unload_databases()
+{
+    exit_keyboards();
+    exit_keycodes();
+}
+
+// the arenas grow with the largest file a worker has seen
+void reserve_arena(karena_t& arena, s64 file_size)
+{
+    u32 const needed = (u32)(file_size * 2 + 1024 * 1024);
+    if (arena.m_main_size >= needed && arena.m_scratch_size >= needed)
+        return;
+    exit_arena(arena);
+    init_arena(arena, needed, needed);
+}
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+
+struct scommand_t
+{
+    const char* m_name;
+    int (*m_main)(int argc, char** argv);
+    const char* m_usage;
+};
+
+static const scommand_t s_commands[] = {
+    {"render", cmd_render, "render [--keymaps <dir>] [--out <dir>] [--scale <s>] [--threads <n>] [--svg] [--png]"},
+    {"export", cmd_export, "export [--keymaps <dir>] [--out <dir>] [--threads <n>]"},
+    {"validate", cmd_validate, "validate [--keymaps <dir>] [--report <file>] [--out <dir>] [--threads <n>]"},
+    {"bench-undo", cmd_bench_undo, "bench-undo [--keymap <file>] [--layers <n>] [--edits <n>]"},
+    {"search", cmd_search, "search --query <text> [--max <n>] [--repeat <n>]"},
+    {"keycode", cmd_keycode, "keycode [--expr <keycode>] [--keymap <file>] [--repeat <n>]"},
+    {"where", cmd_where, "where --query <text> [--keymap <file>] [--repeat <n>]"},
+    {"heatmap", cmd_heatmap, "heatmap --corpus <file> [--keymap <file>] [--threads <n>] [--top <n>]"},
+    {"optimize", cmd_optimize, "optimize --corpus <file> [--keymap <file>] [--layers <i,j,..>] [--rounds <n>] [--threads <n>]"},
+    {"bench", cmd_bench, "bench [--out <file>] [--sizes <keys>x<layers>,..] [--seconds <s>] [--tmp <dir>] [--label <text>]"},
+    {"fingerprint", cmd_fingerprint, "fingerprint [--golden <file>] [--update] [--tolerance <px>] [--tmp <dir>] [--out <file>]"},
+    {"replay", cmd_replay, "replay --input <recording> [--out <file>] [--zero-alloc] [--warmup <frames>]"},
+    {"simulate", cmd_simulate, "simulate --events <file> | --generate <n> [--keymap <file>] [--term <ms>] [--toggle <n>] [--permissive] [--hold-on-press] [--repeat <n>] [--out <file>] [--expect <file>]"},
+    {"import-info", cmd_import_info, "import-info [--keyboards <dir>] [--out <file>] [--threads <n>] [--check]"},
+    {"import-keymap", cmd_import_keymap, "import-keymap [--keyboards <dir>] [--out <dir>] [--threads <n>] [--check]"},
+};
+
+static void print_usage(const char* exe)
+{
+    printf("usage: %s <command> [options]\n", exe);
+    for (size_t i = 0; i < sizeof(s_commands) / sizeof(s_commands[0]); i++)
+        printf("  %s\n", s_commands[i].m_usage);
+}
+
+int keyboard_cli(int argc, char** argv)
+{
+    // no command, or only options (e.g. the -psn_ argument that macOS passes to applications), start the GUI
+    if (argc < 2 || argv[1][0] == '-')
+        return -1;
+
+    for (size_t i = 0; i < sizeof(s_commands) / sizeof(s_commands[0]); i++)
+    {
+        if (strcmp(argv[1], s_commands[i].m_name) == 0)
+            return s_commands[i].m_main(argc, argv);
+    }
+
+    print_usage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,313 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_writer.h"
+#include "qmk-keymap-wiz/keyboard_model.h"
+#include "qmk-keymap-wiz/keyboard_bench.h"
+#include "qmk-keymap-wiz/keyboard_app.h"
+#include "qmk-keymap-wiz/keyboard_fingerprint.h"
+#include "qmk-keymap-wiz/keyboard_workspace.h"
+#include "qmk-keymap-wiz/keyboard_cli_commands.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace xcore;
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// bench-undo: cost of the undo history, time and memory per snapshot on a keymap with many layers
+
+int cmd_bench_undo(int argc, char** argv)
+{
+    const char* filename  = arg_value(argc, argv, "--keymap", "keymaps/jurgen.json");
+    s32 const   nb_layers = atoi(arg_value(argc, argv, "--layers", "32"));
+    s32 const   nb_edits  = atoi(arg_value(argc, argv, "--edits", "100000"));
+
+    keycodes_t const*   kcdb = nullptr;
+    ckeyboards_t const* kbdb = nullptr;
+    if (!load_databases(kcdb, kbdb))
+    {
+        unload_databases();
+        return 1;
+    }
+
+    karena_t arena;
+    init_arena(arena, 4 * 1024 * 1024, 4 * 1024 * 1024);
+    keymaps_t const* keymaps = nullptr;
+    if (!load_keymaps(filename, arena, keymaps) || keymaps->m_nb_keymaps == 0 || keymaps->m_keymaps[0].m_nb_layers == 0 || nb_layers <= 0)
+    {
+        printf("failed to load keymaps from %s\n", filename);
+        exit_arena(arena);
+        unload_databases();
+        return 1;
+    }
+
+    // a keymap with 'nb_layers' layers, repeating the layers of the first keymap in the file
+    keymap_t const& src     = keymaps->m_keymaps[0];
+    layer_t*        layers  = (layer_t*)::malloc(sizeof(layer_t) * nb_layers);
+    s32             nb_keys = 0;
+    for (s32 l = 0; l < nb_layers; l++)
+    {
+        memcpy((void*)&layers[l], (void const*)&src.m_layers[l % src.m_nb_layers], sizeof(layer_t));
+        layers[l].m_index = (s16)l;
+        nb_keys += layers[l].m_nb_keys;
+    }
+    keymap_t  km;
+    keymaps_t kms;
+    km.m_name        = src.m_name;
+    km.m_nb_layers   = nb_layers;
+    km.m_layers      = layers;
+    kms.m_nb_keymaps = 1;
+    kms.m_keymaps    = &km;
+
+    kmodel_t*      model = model_create(&kms);
+    kmodel_stats_t base;
+    model_stats(model, base);
+
+    // random edits of random keys, keycodes, modifiers and colors
+    u32 rnd        = 0x12345678;
+    s32 nb_applied = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (s32 i = 0; i < nb_edits; i++)
+    {
+        rnd = rnd * 1664525u + 1013904223u;
+        kedit_t edit;
+        edit.m_layer = (s32)((rnd >> 8) % (u32)nb_layers);
+        edit.m_key   = (s32)((rnd >> 16) % (u32)(layers[edit.m_layer].m_nb_keys > 0 ? layers[edit.m_layer].m_nb_keys : 1));
+        switch (rnd % 3)
+        {
+            case 0:
+                edit.m_op  = EDIT_KEYCODE;
+                edit.m_str = kcdb->m_keycodes[(rnd >> 4) % (u32)kcdb->m_nb_keycodes].m_code;
+                break;
+            case 1:
+                edit.m_op    = EDIT_MOD;
+                edit.m_value = (rnd >> 4) & 0xFF;
+                break;
+            default:
+                edit.m_op       = EDIT_KEY_LEDCOLOR;
+                edit.m_color[0] = (u8)(rnd >> 4);
+                edit.m_color[1] = (u8)(rnd >> 12);
+                edit.m_color[2] = (u8)(rnd >> 20);
+                edit.m_color[3] = 255;
+                break;
+        }
+        if (model_apply(model, edit, nullptr, nullptr))
+            nb_applied++;
+    }
+    double const apply_seconds = seconds_since(start);
+
+    kmodel_stats_t stats;
+    model_stats(model, stats);
+
+    start = std::chrono::steady_clock::now();
+    while (model_undo(model, nullptr, nullptr)) {}
+    double const undo_seconds = seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    while (model_redo(model, nullptr, nullptr)) {}
+    double const redo_seconds = seconds_since(start);
+
+    s32 const    applied   = nb_applied > 0 ? nb_applied : 1;
+    s64 const    full_copy = (s64)nb_keys * (s64)sizeof(xcore::key_t) + (s64)nb_layers * (s64)sizeof(layer_t);
+    double const per_edit  = (double)(stats.m_nb_bytes - base.m_nb_bytes) / applied;
+
+    printf("keymap '%s' with %d layers, %d keys\n", km.m_name, nb_layers, nb_keys);
+    printf("  initial snapshot   : %lld bytes in %lld nodes, %lld of %lld keys stored (the others are blank)\n", (long long)base.m_nb_bytes, (long long)base.m_nb_nodes, (long long)base.m_nb_stored, (long long)base.m_nb_keys);
+    printf("  edits              : %d applied of %d\n", nb_applied, nb_edits);
+    printf("  time per snapshot  : %.3f us\n", apply_seconds * 1000000.0 / applied);
+    printf("  memory per snapshot: %.1f bytes (a full copy is %lld bytes)\n", per_edit, (long long)full_copy);
+    printf("  history            : %lld bytes in %lld nodes\n", (long long)stats.m_nb_bytes, (long long)stats.m_nb_nodes);
+    printf("  undo all           : %.3f ms (%.3f us per step)\n", undo_seconds * 1000.0, undo_seconds * 1000000.0 / applied);
+    printf("  redo all           : %.3f ms (%.3f us per step)\n", redo_seconds * 1000.0, redo_seconds * 1000000.0 / applied);
+
+    model_destroy(model);
+    ::free(layers);
+    exit_arena(arena);
+    unload_databases();
+    return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// bench: decode, lookup, hit-testing and rendering on synthetic keyboards and keymaps, the results go to a JSON file
+
+int cmd_bench(int argc, char** argv)
+{
+    const char*  out_file    = arg_value(argc, argv, "--out", "bench.json");
+    const char*  sizes_str   = arg_value(argc, argv, "--sizes", "36x4,360x16,2000x32,10000x64");
+    const char*  tmpdir      = arg_value(argc, argv, "--tmp", ".");
+    const char*  label       = arg_value(argc, argv, "--label", "");
+    double const min_seconds = atof(arg_value(argc, argv, "--seconds", "0.25"));
+
+    // <keys>x<layers>, separated by commas
+    kbenchsize_t sizes[16];
+    s32          nb_sizes = 0;
+    for (const char* c = sizes_str; *c != 0 && nb_sizes < 16;)
+    {
+        char*     end     = nullptr;
+        s32 const nb_keys = (s32)strtol(c, &end, 10);
+        if (end == c || *end != 'x')
+            break;
+        c                   = end + 1;
+        s32 const nb_layers = (s32)strtol(c, &end, 10);
+        if (end == c)
+            break;
+        sizes[nb_sizes].m_nb_keys   = nb_keys;
+        sizes[nb_sizes].m_nb_layers = nb_layers;
+        nb_sizes++;
+        c = *end == ',' ? end + 1 : end;
+    }
+    if (nb_sizes == 0)
+    {
+        printf("bench: --sizes expects <keys>x<layers>[,<keys>x<layers>..]\n");
+        return 1;
+    }
+
+    keycodes_t const*   kcdb = nullptr;
+    ckeyboards_t const* kbdb = nullptr;
+    if (!load_databases(kcdb, kbdb))
+    {
+        unload_databases();
+        return 1;
+    }
+
+    kwriter_t w;
+    if (!writer_open(w, out_file))
+    {
+        printf("failed to open %s\n", out_file);
+        unload_databases();
+        return 1;
+    }
+    bool const ok = keyboard_bench(w, kcdb, sizes, nb_sizes, min_seconds, tmpdir, label);
+    if (!writer_close(w))
+    {
+        printf("failed to write %s\n", out_file);
+        unload_databases();
+        return 1;
+    }
+    printf("wrote %s\n", out_file);
+
+    unload_databases();
+    return ok ? 0 : 1;
+}
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// replay: a recorded input session (--record) through the frames of the application without a window, the timings and
+// allocations of every frame go to a JSON file. The keymaps workspace, the file and the journal are those of the
+// application, edits and switches to another file that the session made are made again. With --zero-alloc the replay
+// fails when a frame without new input allocates.
+
+int cmd_replay(int argc, char** argv)
+{
+    const char* input_file = arg_value(argc, argv, "--input", nullptr);
+    const char* out_file   = arg_value(argc, argv, "--out", "replay.json");
+    s32 const   warmup     = arg_flag(argc, argv, "--zero-alloc") ? atoi(arg_value(argc, argv, "--warmup", "60")) : -1;
+    if (input_file == nullptr)
+    {
+        printf("replay: --input <recording> is required\n");
+        return 1;
+    }
+
+    keycodes_t const*   kcdb = nullptr;
+    ckeyboards_t const* kbdb = nullptr;
+    if (!load_databases(kcdb, kbdb))
+    {
+        unload_databases();
+        return 1;
+    }
+    // the same workspace and file as the application, the session may switch to another file
+    kworkspace_t* workspace = workspace_create("keymaps", 64 * 1024 * 1024);
+    workspace_scan(workspace);
+    s32 entry = workspace_find(workspace, keymaps_filename());
+    if (entry < 0)
+        entry = 0;
+
+    keditor_t editor;
+    init_keymaps();
+    if (!keyboard_editor_open(editor, workspace, entry, kcdb, kbdb))
+    {
+        keymaps_t const* keymaps = nullptr;
+        if (!load_keymaps(keymaps))
+        {
+            exit_keymaps();
+            workspace_destroy(workspace);
+            unload_databases();
+            return 1;
+        }
+        keyboard_editor_init(editor, keymaps_filename(), keymaps, kcdb, kbdb);
+    }
+
+    kwriter_t w;
+    bool      ok = writer_open(w, out_file);
+    if (ok)
+    {
+        std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+
+        ok = keyboard_replay_headless(w, input_file, editor, kcdb, kbdb, warmup);
+        if (!writer_close(w))
+        {
+            printf("failed to write %s\n", out_file);
+            ok = false;
+        }
+        else if (ok)
+        {
+            printf("wrote %s in %.3f seconds\n", out_file, seconds_since(start));
+        }
+    }
+    else
+    {
+        printf("failed to open %s\n", out_file);
+    }
+
+    keyboard_editor_exit(editor);
+    workspace_destroy(workspace);
+    exit_keymaps();
+    unload_databases();
+    return ok ? 0 : 1;
+}
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// fingerprint: hashes of the draw lists of keyboard_render for a fixed set of scenes, compared with a golden file
+
+int cmd_fingerprint(int argc, char** argv)
+{
+    const char* golden    = arg_value(argc, argv, "--golden", "fingerprints.txt");
+    const char* out_file  = arg_value(argc, argv, "--out", nullptr);
+    const char* tmpdir    = arg_value(argc, argv, "--tmp", ".");
+    float const tolerance = (float)atof(arg_value(argc, argv, "--tolerance", "0.015625"));
+    bool const  update    = arg_flag(argc, argv, "--update");
+
+    keycodes_t const*   kcdb = nullptr;
+    ckeyboards_t const* kbdb = nullptr;
+    if (!load_databases(kcdb, kbdb))
+    {
+        unload_databases();
+        return 1;
+    }
+
+    kwriter_t w;
+    if (out_file != nullptr && !writer_open(w, out_file))
+    {
+        printf("failed to open %s\n", out_file);
+        unload_databases();
+        return 1;
+    }
+    bool ok = keyboard_fingerprint(out_file != nullptr ? &w : nullptr, kcdb, golden, update, tolerance, tmpdir);
+    if (out_file != nullptr)
+    {
+        if (!writer_close(w))
+        {
+            printf("failed to write %s\n", out_file);
+            ok = false;
+        }
+    }
+
+    unload_databases();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,505 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_files.h"
+#include "qmk-keymap-wiz/keyboard_graph.h"
+#include "qmk-keymap-wiz/keyboard_jobs.h"
+#include "qmk-keymap-wiz/keyboard_headless.h"
+#include "qmk-keymap-wiz/keyboard_writer.h"
+#include "qmk-keymap-wiz/keyboard_export.h"
+#include "qmk-keymap-wiz/keyboard_validate.h"
+#include "qmk-keymap-wiz/keyboard_keycode.h"
+#include "qmk-keymap-wiz/keyboard_cli_commands.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+
+using namespace xcore;
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// render: render every layer of every keymap in a directory to SVG and/or PNG
+
+struct srender_t
+{
+    keycodes_t const*   m_kcdb;
+    ckeyboards_t const* m_kbdb;
+    kfiles_t            m_files;
+    karena_t*           m_arenas; // one per worker
+    const char*         m_outdir;
+    float               m_scale;
+    bool                m_svg;
+    bool                m_png;
+    std::atomic<s32>    m_nb_sheets;
+    std::atomic<s32>    m_nb_errors;
+};
+
+static void render_job(s32 index, s32 worker, void* user)
+{
+    srender_t*  r        = (srender_t*)user;
+    const char* filename = r->m_files.m_files[index];
+
+    keymaps_t const* keymaps = nullptr;
+    if (!load_keymaps(filename, r->m_arenas[worker], keymaps))
+    {
+        printf("failed to load keymaps from %s\n", filename);
+        r->m_nb_errors++;
+        return;
+    }
+    compile_keymaps(r->m_kcdb, const_cast<keymaps_t*>(keymaps));
+
+    char stem[128];
+    file_stem(filename, stem, sizeof(stem));
+
+    for (s32 k = 0; k < keymaps->m_nb_keymaps; k++)
+    {
+        keymap_t const*    km = &keymaps->m_keymaps[k];
+        ckeyboard_t const* kb = find_keyboard(r->m_kbdb, km->m_name);
+        if (kb == nullptr)
+        {
+            printf("%s: keyboard '%s' is not in the keyboard database\n", filename, km->m_name != nullptr ? km->m_name : "");
+            r->m_nb_errors++;
+            continue;
+        }
+
+        for (s32 l = 0; l < km->m_nb_layers; l++)
+        {
+            char layer_name[64];
+            sanitize(km->m_layers[l].m_name, layer_name, sizeof(layer_name));
+
+            char path[1024];
+            if (r->m_svg)
+            {
+                snprintf(path, sizeof(path), "%s/%s-%d-%02d-%s.svg", r->m_outdir, stem, k, l, layer_name);
+                if (!keyboard_render_svg(path, kb, r->m_kcdb, km, l, r->m_scale))
+                    r->m_nb_errors++;
+            }
+            if (r->m_png)
+            {
+                snprintf(path, sizeof(path), "%s/%s-%d-%02d-%s.png", r->m_outdir, stem, k, l, layer_name);
+                if (!keyboard_render_png(path, kb, r->m_kcdb, km, l, r->m_scale))
+                    r->m_nb_errors++;
+            }
+            r->m_nb_sheets++;
+        }
+    }
+}
+
+int cmd_render(int argc, char** argv)
+{
+    const char* keymaps_dir = arg_value(argc, argv, "--keymaps", "keymaps");
+    const char* outdir      = arg_value(argc, argv, "--out", "sheets");
+    float const scale       = (float)atof(arg_value(argc, argv, "--scale", "1.0"));
+    s32 const   threads     = atoi(arg_value(argc, argv, "--threads", "0"));
+
+    srender_t r;
+    r.m_outdir    = outdir;
+    r.m_scale     = scale > 0.0f ? scale : 1.0f;
+    r.m_svg       = arg_flag(argc, argv, "--svg");
+    r.m_png       = arg_flag(argc, argv, "--png");
+    r.m_nb_sheets = 0;
+    r.m_nb_errors = 0;
+    if (!r.m_svg && !r.m_png)
+    {
+        r.m_svg = true;
+        r.m_png = true;
+    }
+
+    if (!load_databases(r.m_kcdb, r.m_kbdb))
+    {
+        unload_databases();
+        return 1;
+    }
+    if (!keyboard_headless_init() && r.m_png)
+        printf("warning: PNG sheets will not contain any labels\n");
+
+    if (!make_dir(outdir))
+    {
+        printf("failed to create directory %s\n", outdir);
+        keyboard_headless_exit();
+        unload_databases();
+        return 1;
+    }
+
+    std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+
+    enumerate_files(keymaps_dir, ".json", false, r.m_files);
+
+    s32 const nb_workers = threads > 0 ? threads : jobs_nb_workers();
+    r.m_arenas           = new karena_t[nb_workers];
+    for (s32 i = 0; i < nb_workers; i++)
+        init_arena(r.m_arenas[i], 4 * 1024 * 1024, 4 * 1024 * 1024);
+
+    jobs_parallel_for(r.m_files.m_nb_files, render_job, &r, nb_workers);
+
+    printf("rendered %d sheets from %d keymap files in %.3f seconds (%d errors)\n", r.m_nb_sheets.load(), r.m_files.m_nb_files, seconds_since(start), r.m_nb_errors.load());
+
+    for (s32 i = 0; i < nb_workers; i++)
+        exit_arena(r.m_arenas[i]);
+    delete[] r.m_arenas;
+    release_files(r.m_files);
+    keyboard_headless_exit();
+    unload_databases();
+    return r.m_nb_errors == 0 ? 0 : 1;
+}
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// export: write keymap.c and layers.h for every keymap in a directory
+
+// Write keymap.c and layers.h of a keymap into <outdir>/<stem>, or <outdir>/<stem>-<k> when the keymap file holds
+// multiple keymaps. Returns the number of errors.
+static s32 export_keymap_files(const char* outdir, const char* stem, s32 k, s32 nb_keymaps, keymap_t const* km, ckeyboard_t const* kb, s64& bytes)
+{
+    char dir[1024];
+    if (nb_keymaps == 1)
+        snprintf(dir, sizeof(dir), "%s/%s", outdir, stem);
+    else
+        snprintf(dir, sizeof(dir), "%s/%s-%d", outdir, stem, k);
+    if (!make_dir(dir))
+    {
+        printf("failed to create directory %s\n", dir);
+        return 1;
+    }
+
+    s32       errors = 0;
+    char      path[1024];
+    kwriter_t w;
+
+    snprintf(path, sizeof(path), "%s/keymap.c", dir);
+    if (writer_open(w, path))
+    {
+        export_keymap_c(w, km, kb);
+        bytes += w.m_written;
+        if (!writer_close(w))
+            errors++;
+    }
+    else
+    {
+        errors++;
+    }
+
+    snprintf(path, sizeof(path), "%s/layers.h", dir);
+    if (writer_open(w, path))
+    {
+        export_layers_h(w, km);
+        bytes += w.m_written;
+        if (!writer_close(w))
+            errors++;
+    }
+    else
+    {
+        errors++;
+    }
+    return errors;
+}
+
+struct sexport_t
+{
+    keycodes_t const*   m_kcdb;
+    ckeyboards_t const* m_kbdb;
+    kfiles_t            m_files;
+    karena_t*           m_arenas; // one per worker
+    const char*         m_outdir;
+    std::atomic<s32>    m_nb_keymaps;
+    std::atomic<s64>    m_nb_bytes;
+    std::atomic<s32>    m_nb_errors;
+};
+
+static void export_job(s32 index, s32 worker, void* user)
+{
+    sexport_t*  e        = (sexport_t*)user;
+    const char* filename = e->m_files.m_files[index];
+
+    keymaps_t const* keymaps = nullptr;
+    if (!load_keymaps(filename, e->m_arenas[worker], keymaps))
+    {
+        printf("failed to load keymaps from %s\n", filename);
+        e->m_nb_errors++;
+        return;
+    }
+    compile_keymaps(e->m_kcdb, const_cast<keymaps_t*>(keymaps));
+
+    char stem[128];
+    file_stem(filename, stem, sizeof(stem));
+
+    for (s32 k = 0; k < keymaps->m_nb_keymaps; k++)
+    {
+        keymap_t const*    km = &keymaps->m_keymaps[k];
+        ckeyboard_t const* kb = find_keyboard(e->m_kbdb, km->m_name);
+        if (kb == nullptr)
+        {
+            printf("%s: keyboard '%s' is not in the keyboard database\n", filename, km->m_name != nullptr ? km->m_name : "");
+            e->m_nb_errors++;
+            continue;
+        }
+
+        s64 bytes = 0;
+        e->m_nb_errors += export_keymap_files(e->m_outdir, stem, k, keymaps->m_nb_keymaps, km, kb, bytes);
+        e->m_nb_bytes += bytes;
+        e->m_nb_keymaps++;
+    }
+}
+
+int cmd_export(int argc, char** argv)
+{
+    const char* keymaps_dir = arg_value(argc, argv, "--keymaps", "keymaps");
+    const char* outdir      = arg_value(argc, argv, "--out", "qmk");
+    s32 const   threads     = atoi(arg_value(argc, argv, "--threads", "0"));
+
+    sexport_t e;
+    e.m_outdir     = outdir;
+    e.m_nb_keymaps = 0;
+    e.m_nb_bytes   = 0;
+    e.m_nb_errors  = 0;
+
+    // the keyboards are only used for formatting the LAYOUT rows, without the keycodes only QMK keycodes compile
+    init_keycodes();
+    init_keyboards();
+    if (!load_keycodes(e.m_kcdb))
+        e.m_kcdb = nullptr;
+    if (!load_keyboards(e.m_kbdb))
+        e.m_kbdb = nullptr;
+
+    if (!make_dir(outdir))
+    {
+        printf("failed to create directory %s\n", outdir);
+        unload_databases();
+        return 1;
+    }
+
+    std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+
+    enumerate_files(keymaps_dir, ".json", false, e.m_files);
+
+    s32 const nb_workers = threads > 0 ? threads : jobs_nb_workers();
+    e.m_arenas           = new karena_t[nb_workers];
+    for (s32 i = 0; i < nb_workers; i++)
+        init_arena(e.m_arenas[i], 4 * 1024 * 1024, 4 * 1024 * 1024);
+
+    jobs_parallel_for(e.m_files.m_nb_files, export_job, &e, nb_workers);
+
+    double const seconds = seconds_since(start);
+    printf("exported %d keymaps from %d keymap files in %.3f seconds, %.1f KB written (%d errors)\n", e.m_nb_keymaps.load(), e.m_files.m_nb_files, seconds, e.m_nb_bytes.load() / 1024.0, e.m_nb_errors.load());
+
+    for (s32 i = 0; i < nb_workers; i++)
+        exit_arena(e.m_arenas[i]);
+    delete[] e.m_arenas;
+    release_files(e.m_files);
+    unload_databases();
+    return e.m_nb_errors == 0 ? 0 : 1;
+}
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// validate: load and check every keymap file under a directory (keys and the layer graph), optionally converting
+// them to keymap.c/layers.h, and write a JSON report with the diagnostics of every file and the throughput
+
+struct svalidate_t
+{
+    keycodes_t const*   m_kcdb;
+    ckeyboards_t const* m_kbdb;
+    kfiles_t            m_files;
+    karena_t*           m_arenas;  // one per worker
+    kwriter_t*          m_reports; // one per file, the JSON object of the file
+    const char*         m_outdir;  // nullptr = no conversion
+    std::atomic<s64>    m_nb_bytes;
+    std::atomic<s32>    m_nb_failed;
+    std::atomic<s32>    m_nb_diags;
+};
+
+struct svalidate_file_t
+{
+    kwriter_t* m_report;
+    s32        m_keymap;
+    s32        m_nb_diags;
+};
+
+static void validate_diag(kdiag_t const& diag, void* user)
+{
+    svalidate_file_t* f = (svalidate_file_t*)user;
+    kwriter_t&        w = *f->m_report;
+    if (f->m_nb_diags++ > 0)
+        writer_char(w, ',');
+    writer_str(w, "\n      {\"code\": ");
+    writer_json_str(w, diag_name(diag.m_code));
+    writer_str(w, ", \"keymap\": ");
+    writer_int(w, f->m_keymap);
+    writer_str(w, ", \"layer\": ");
+    writer_int(w, diag.m_layer);
+    writer_str(w, ", \"key\": ");
+    writer_int(w, diag.m_key);
+    writer_str(w, ", \"detail\": ");
+    writer_json_str(w, diag.m_detail);
+    writer_char(w, '}');
+}
+
+static void validate_job(s32 index, s32 worker, void* user)
+{
+    svalidate_t* v        = (svalidate_t*)user;
+    const char*  filename = v->m_files.m_files[index];
+    kwriter_t&   w        = v->m_reports[index];
+    s64 const    size     = file_size(filename);
+
+    writer_memory(w);
+    writer_str(w, "    {\"file\": ");
+    writer_json_str(w, filename);
+    writer_str(w, ", \"bytes\": ");
+    writer_s64(w, size);
+
+    v->m_nb_bytes += size > 0 ? size : 0;
+    reserve_arena(v->m_arenas[worker], size > 0 ? size : 0);
+
+    keymaps_t const* keymaps       = nullptr;
+    char const*      error_message = nullptr;
+    if (!load_keymaps(filename, v->m_arenas[worker], keymaps, &error_message))
+    {
+        writer_str(w, ", \"ok\": false, \"error\": ");
+        writer_json_str(w, error_message != nullptr ? error_message : "failed to load");
+        writer_char(w, '}');
+        v->m_nb_failed++;
+        return;
+    }
+    compile_keymaps(v->m_kcdb, const_cast<keymaps_t*>(keymaps));
+
+    s32 nb_layers = 0;
+    s32 nb_keys   = 0;
+    for (s32 k = 0; k < keymaps->m_nb_keymaps; k++)
+    {
+        keymap_t const& km = keymaps->m_keymaps[k];
+        nb_layers += km.m_nb_layers;
+        for (s32 l = 0; l < km.m_nb_layers; l++)
+            nb_keys += km.m_layers[l].m_nb_keys;
+    }
+
+    writer_str(w, ", \"keymaps\": ");
+    writer_int(w, keymaps->m_nb_keymaps);
+    writer_str(w, ", \"layers\": ");
+    writer_int(w, nb_layers);
+    writer_str(w, ", \"keys\": ");
+    writer_int(w, nb_keys);
+    writer_str(w, ", \"diagnostics\": [");
+
+    svalidate_file_t f;
+    f.m_report   = &w;
+    f.m_nb_diags = 0;
+    for (s32 k = 0; k < keymaps->m_nb_keymaps; k++)
+    {
+        f.m_keymap = k;
+        validate_keymap(&keymaps->m_keymaps[k], v->m_kcdb, v->m_kbdb, validate_diag, &f);
+        lint_layers(&keymaps->m_keymaps[k], validate_diag, &f);
+    }
+    writer_str(w, f.m_nb_diags > 0 ? "\n    ]" : "]");
+
+    s32 nb_errors = 0;
+    if (v->m_outdir != nullptr)
+    {
+        char stem[128];
+        file_stem(filename, stem, sizeof(stem));
+
+        s64 bytes = 0;
+        for (s32 k = 0; k < keymaps->m_nb_keymaps; k++)
+        {
+            // an unknown keyboard is already a diagnostic of the file, it is not converted
+            keymap_t const*    km = &keymaps->m_keymaps[k];
+            ckeyboard_t const* kb = find_keyboard(v->m_kbdb, km->m_name);
+            if (kb == nullptr)
+                nb_errors++;
+            else
+                nb_errors += export_keymap_files(v->m_outdir, stem, k, keymaps->m_nb_keymaps, km, kb, bytes);
+        }
+        writer_str(w, ", \"converted\": ");
+        writer_str(w, nb_errors == 0 ? "true" : "false");
+    }
+
+    bool const ok = f.m_nb_diags == 0 && nb_errors == 0;
+    writer_str(w, ", \"ok\": ");
+    writer_str(w, ok ? "true" : "false");
+    writer_char(w, '}');
+
+    v->m_nb_diags += f.m_nb_diags;
+    if (!ok)
+        v->m_nb_failed++;
+}
+
+int cmd_validate(int argc, char** argv)
+{
+    const char* keymaps_dir = arg_value(argc, argv, "--keymaps", "keymaps");
+    const char* report_file = arg_value(argc, argv, "--report", "report.json");
+    s32 const   threads     = atoi(arg_value(argc, argv, "--threads", "0"));
+
+    svalidate_t v;
+    v.m_outdir    = arg_value(argc, argv, "--out", nullptr);
+    v.m_nb_bytes  = 0;
+    v.m_nb_failed = 0;
+    v.m_nb_diags  = 0;
+
+    if (!load_databases(v.m_kcdb, v.m_kbdb))
+    {
+        unload_databases();
+        return 1;
+    }
+    if (v.m_outdir != nullptr && !make_dir(v.m_outdir))
+    {
+        printf("failed to create directory %s\n", v.m_outdir);
+        unload_databases();
+        return 1;
+    }
+
+    enumerate_files(keymaps_dir, ".json", true, v.m_files);
+
+    s32 const nb_workers = threads > 0 ? threads : jobs_nb_workers();
+    v.m_arenas           = new karena_t[nb_workers];
+    v.m_reports          = new kwriter_t[v.m_files.m_nb_files > 0 ? v.m_files.m_nb_files : 1];
+
+    std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+    jobs_parallel_for(v.m_files.m_nb_files, validate_job, &v, nb_workers);
+    double const seconds = seconds_since(start);
+
+    double const files_per_second = seconds > 0.0 ? v.m_files.m_nb_files / seconds : 0.0;
+    double const mb_per_second    = seconds > 0.0 ? (v.m_nb_bytes.load() / (1024.0 * 1024.0)) / seconds : 0.0;
+
+    kwriter_t w;
+    bool      ok = writer_open(w, report_file);
+    if (ok)
+    {
+        writer_str(w, "{\n  \"files\": [\n");
+        for (s32 i = 0; i < v.m_files.m_nb_files; i++)
+        {
+            writer_write(w, v.m_reports[i].m_buffer, v.m_reports[i].m_size);
+            writer_str(w, i + 1 < v.m_files.m_nb_files ? ",\n" : "\n");
+        }
+        writer_str(w, "  ],\n  \"summary\": {\"files\": ");
+        writer_int(w, v.m_files.m_nb_files);
+        writer_str(w, ", \"failed\": ");
+        writer_int(w, v.m_nb_failed.load());
+        writer_str(w, ", \"diagnostics\": ");
+        writer_int(w, v.m_nb_diags.load());
+        writer_str(w, ", \"bytes\": ");
+        writer_s64(w, v.m_nb_bytes.load());
+        writer_str(w, ", \"threads\": ");
+        writer_int(w, nb_workers);
+        writer_str(w, ", \"seconds\": ");
+        writer_float(w, (float)seconds, 6);
+        writer_str(w, ", \"files_per_second\": ");
+        writer_float(w, (float)files_per_second, 1);
+        writer_str(w, ", \"mb_per_second\": ");
+        writer_float(w, (float)mb_per_second, 3);
+        writer_str(w, "}\n}\n");
+        ok = writer_close(w);
+    }
+
+    printf("validated %d keymap files (%d failed, %d diagnostics) in %.3f seconds, %.1f files/s, %.2f MB/s\n", v.m_files.m_nb_files, v.m_nb_failed.load(), v.m_nb_diags.load(), seconds, files_per_second, mb_per_second);
+
+    for (s32 i = 0; i < v.m_files.m_nb_files; i++)
+        writer_close(v.m_reports[i]);
+    delete[] v.m_reports;
+    for (s32 i = 0; i < nb_workers; i++)
+        exit_arena(v.m_arenas[i]);
+    delete[] v.m_arenas;
+    release_files(v.m_files);
+    unload_databases();
+    return (ok && v.m_nb_failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,399 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_files.h"
+#include "qmk-keymap-wiz/keyboard_jobs.h"
+#include "qmk-keymap-wiz/keyboard_writer.h"
+#include "qmk-keymap-wiz/keyboard_infojson.h"
+#include "qmk-keymap-wiz/keyboard_keymapc.h"
+#include "qmk-keymap-wiz/keyboard_save.h"
+#include "qmk-keymap-wiz/keyboard_cli_commands.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+
+using namespace xcore;
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// import-info: the layouts of every info.json (and keyboard.json) of a qmk_firmware checkout as keyboards, merged into one
+// keyboards file that load_keyboards reads
+
+struct simport_t
+{
+    s32              m_root_len;
+    kfiles_t         m_files;
+    kwriter_t*       m_outputs;      // one per file, the encoded keyboards of the file
+    s32*             m_nb_keyboards; // one per file
+    std::atomic<s64> m_nb_bytes;
+    std::atomic<s64> m_nb_keys;
+    std::atomic<s32> m_nb_failed;
+};
+
+static void import_job(s32 index, s32, void* user)
+{
+    simport_t*  im       = (simport_t*)user;
+    const char* filename = im->m_files.m_files[index];
+    kwriter_t&  w        = im->m_outputs[index];
+    writer_memory(w);
+    im->m_nb_keyboards[index] = 0;
+
+    // a keyboard is named after its directory, <root>/splitkb/kyria/rev3/info.json -> "splitkb/kyria/rev3"
+    const char* path = filename + im->m_root_len;
+    while (*path == '/' || *path == '\\')
+        path++;
+    s32 const len = (s32)(file_basename(path) - path);
+    char      name[256];
+    snprintf(name, sizeof(name), "%.*s", len > 0 ? len - 1 : 0, path);
+
+    kmapping_t mapping;
+    if (!map_file(filename, mapping))
+    {
+        printf("failed to open %s\n", filename);
+        im->m_nb_failed++;
+        return;
+    }
+    im->m_nb_bytes += mapping.m_size;
+
+    kinfoboards_t boards;
+    const char*   error = nullptr;
+    if (!infojson_import((const char*)mapping.m_data, mapping.m_size, name, boards, &error))
+    {
+        printf("%s: %s\n", filename, error != nullptr ? error : "failed to parse");
+        im->m_nb_failed++;
+    }
+    for (s32 k = 0; k < boards.m_nb_keyboards; ++k)
+    {
+        if (k > 0)
+            writer_str(w, ",\n");
+        encode_keyboard(w, boards.m_keyboards[k]);
+    }
+    im->m_nb_keyboards[index] = boards.m_nb_keyboards;
+    im->m_nb_keys += boards.m_nb_keys;
+    infojson_release(boards);
+    unmap_file(mapping);
+}
+
+int cmd_import_info(int argc, char** argv)
+{
+    const char* root     = arg_value(argc, argv, "--keyboards", "qmk_firmware/keyboards");
+    const char* out_file = arg_value(argc, argv, "--out", "kbdb/imported.json");
+    s32 const   threads  = atoi(arg_value(argc, argv, "--threads", "0"));
+    bool const  check    = arg_flag(argc, argv, "--check");
+
+    simport_t im;
+    im.m_root_len  = (s32)strlen(root);
+    im.m_nb_bytes  = 0;
+    im.m_nb_keys   = 0;
+    im.m_nb_failed = 0;
+
+    std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+
+    // every .json under the root, of which only info.json and keyboard.json describe a keyboard (keymaps and other
+    // data files are JSON as well)
+    if (!enumerate_files(root, ".json", true, im.m_files))
+        return 1;
+    s32 nb_files = 0;
+    for (s32 i = 0; i < im.m_files.m_nb_files; i++)
+    {
+        const char* base = file_basename(im.m_files.m_files[i]);
+        if (strcmp(base, "info.json") == 0 || strcmp(base, "keyboard.json") == 0)
+            im.m_files.m_files[nb_files++] = im.m_files.m_files[i];
+        else
+            ::free(im.m_files.m_files[i]);
+    }
+    im.m_files.m_nb_files = nb_files;
+
+    s32 const nb_workers = threads > 0 ? threads : jobs_nb_workers();
+    im.m_outputs         = new kwriter_t[nb_files > 0 ? nb_files : 1];
+    im.m_nb_keyboards    = (s32*)::malloc(sizeof(s32) * (nb_files > 0 ? nb_files : 1));
+    jobs_parallel_for(nb_files, import_job, &im, nb_workers);
+
+    // the keyboards of the files in path order, so that the catalog is the same for every run
+    s32       nb_keyboards = 0;
+    s32       nb_empty     = 0;
+    kwriter_t w;
+    bool      ok = writer_open(w, out_file);
+    if (ok)
+    {
+        writer_str(w, "{\n    \"keyboards\": [\n");
+        for (s32 i = 0; i < nb_files; i++)
+        {
+            if (im.m_nb_keyboards[i] == 0)
+            {
+                nb_empty += 1;
+                continue;
+            }
+            if (nb_keyboards > 0)
+                writer_str(w, ",\n");
+            writer_write(w, im.m_outputs[i].m_buffer, im.m_outputs[i].m_size);
+            nb_keyboards += im.m_nb_keyboards[i];
+        }
+        writer_str(w, "\n    ]\n}\n");
+        ok = writer_close(w);
+    }
+    if (!ok)
+        printf("failed to write %s\n", out_file);
+    double const seconds = seconds_since(start);
+
+    double const files_per_second = seconds > 0.0 ? nb_files / seconds : 0.0;
+    double const mb_per_second    = seconds > 0.0 ? (im.m_nb_bytes.load() / (1024.0 * 1024.0)) / seconds : 0.0;
+    printf("imported %d keyboards (%lld keys) from %d files (%d failed, %d without layouts) into %s in %.3f seconds, %.1f files/s, %.2f MB/s\n", nb_keyboards, (long long)im.m_nb_keys.load(), nb_files,
+           im.m_nb_failed.load(), nb_empty, out_file, seconds, files_per_second, mb_per_second);
+
+    // the catalog read back the way the application reads a keyboards file
+    if (ok && check)
+    {
+        karena_t arena;
+        reserve_arena(arena, file_size(out_file));
+        ckeyboards_t const* kbs   = nullptr;
+        char const*         error = nullptr;
+        if (!load_keyboards(out_file, arena, kbs, &error))
+        {
+            printf("failed to load %s: %s\n", out_file, error != nullptr ? error : "?");
+            ok = false;
+        }
+        else if (kbs->m_nb_keyboards != nb_keyboards)
+        {
+            printf("%s has %d keyboards, %d were imported\n", out_file, kbs->m_nb_keyboards, nb_keyboards);
+            ok = false;
+        }
+        else
+        {
+            printf("loaded %d keyboards from %s\n", kbs->m_nb_keyboards, out_file);
+        }
+        exit_arena(arena);
+    }
+
+    for (s32 i = 0; i < nb_files; i++)
+        writer_close(im.m_outputs[i]);
+    delete[] im.m_outputs;
+    ::free(im.m_nb_keyboards);
+    release_files(im.m_files);
+    return (ok && im.m_nb_failed == 0) ? 0 : 1;
+}
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// import-keymap: every keymap.c of a qmk_firmware checkout (or of any directory) as a keymaps file per keymap.c, so that a
+// community corpus can be rendered, validated or searched like the keymaps of the editor
+
+struct simportc_t
+{
+    keycodes_t const* m_kcdb;
+    kfiles_t          m_files;
+    char*             m_names;  // per file the keyboard and the output file stem, IMPORTC_NAME bytes each
+    const char*       m_outdir;
+    karena_t*         m_arenas; // one per worker, for --check
+    bool              m_check;
+    std::atomic<s64>  m_nb_bytes;
+    std::atomic<s32>  m_nb_keymaps;
+    std::atomic<s32>  m_nb_layers;
+    std::atomic<s64>  m_nb_keys;
+    std::atomic<s64>  m_nb_unknown;
+    std::atomic<s32>  m_nb_failed;
+};
+
+static const s32 IMPORTC_NAME = 256;
+
+// <root>/splitkb/kyria/keymaps/jurgen/keymap.c is the keymap 'jurgen' of the keyboard "splitkb/kyria", written
+// to <out>/splitkb_kyria_jurgen.json
+static void import_keymapc_names(const char* filename, s32 root_len, char* keyboard, char* stem)
+{
+    const char* path = filename + root_len;
+    while (*path == '/' || *path == '\\')
+        path++;
+    s32 const   dir_len  = (s32)(file_basename(path) - path) - 1;
+    const char* keymaps  = strstr(path, "/keymaps/");
+    s32 const   kb_len   = (keymaps != nullptr && keymaps - path < dir_len) ? (s32)(keymaps - path) : (dir_len > 0 ? dir_len : 0);
+    s32 const   name_pos = kb_len < dir_len ? kb_len + 9 : kb_len;
+    char        name[IMPORTC_NAME];
+    snprintf(keyboard, IMPORTC_NAME, "%.*s", kb_len, path);
+    snprintf(name, sizeof(name), "%s%s%.*s", keyboard, name_pos < dir_len ? "_" : "", name_pos < dir_len ? dir_len - name_pos : 0, path + name_pos);
+    sanitize(name[0] != 0 ? name : "keymap", stem, IMPORTC_NAME);
+}
+
+static int compare_stems(const void* a, const void* b) { return strcmp(*(const char* const*)a, *(const char* const*)b); }
+
+// different paths can sanitize to the same stem ('a/b_c' and 'a_b/c'), the jobs would write the same file at the same
+// time, so the stems that are not unique get a suffix (_2, _3, ..) before the jobs run
+static void import_keymapc_unique(simportc_t& im)
+{
+    s32 const nb_files = im.m_files.m_nb_files;
+    char**    stems    = (char**)::malloc(sizeof(char*) * (nb_files > 0 ? nb_files : 1));
+    for (s32 i = 0; i < nb_files; i++)
+        stems[i] = im.m_names + (i * 2 + 1) * IMPORTC_NAME;
+
+    // a suffix can make a stem that another file already has, so until nothing was renamed
+    bool renamed = true;
+    while (renamed)
+    {
+        renamed = false;
+        qsort(stems, nb_files, sizeof(char*), compare_stems);
+        for (s32 i = 0; i < nb_files;)
+        {
+            s32 j = i + 1;
+            while (j < nb_files && strcmp(stems[i], stems[j]) == 0)
+                j++;
+            for (s32 k = i + 1; k < j; k++)
+            {
+                char stem[IMPORTC_NAME];
+                snprintf(stem, sizeof(stem), "%s", stems[k]);
+                snprintf(stems[k], IMPORTC_NAME, "%.*s_%d", IMPORTC_NAME - 16, stem, k - i + 1);
+                printf("%s: the keymap of another file is also named %s, written as %s.json\n", im.m_files.m_files[(stems[k] - im.m_names) / (2 * IMPORTC_NAME)], stem, stems[k]);
+                renamed = true;
+            }
+            i = j;
+        }
+    }
+    ::free(stems);
+}
+
+static void import_keymapc_job(s32 index, s32 worker, void* user)
+{
+    simportc_t* im       = (simportc_t*)user;
+    const char* filename = im->m_files.m_files[index];
+    const char* keyboard = im->m_names + (index * 2) * IMPORTC_NAME;
+    const char* stem     = im->m_names + (index * 2 + 1) * IMPORTC_NAME;
+
+    kmapping_t mapping;
+    if (!map_file(filename, mapping))
+    {
+        printf("failed to open %s\n", filename);
+        im->m_nb_failed++;
+        return;
+    }
+    im->m_nb_bytes += mapping.m_size;
+
+    kkeymapc_t  keymap;
+    const char* error = nullptr;
+    if (!keymapc_import((const char*)mapping.m_data, mapping.m_size, keyboard, im->m_kcdb, keymap, &error))
+    {
+        printf("%s: %s\n", filename, error != nullptr ? error : "failed to parse");
+        im->m_nb_failed++;
+        unmap_file(mapping);
+        return;
+    }
+    unmap_file(mapping);
+
+    char out[1024];
+    snprintf(out, sizeof(out), "%s/%s.json", im->m_outdir, stem);
+    kwriter_t w;
+    bool      ok = writer_open(w, out);
+    if (ok)
+    {
+        encode_keymaps(w, &keymap.m_keymaps);
+        ok = writer_close(w);
+    }
+    if (!ok)
+        printf("failed to write %s\n", out);
+
+    // the file read back the way the editor reads a keymaps file
+    if (ok && im->m_check)
+    {
+        karena_t& arena = im->m_arenas[worker];
+        reserve_arena(arena, file_size(out));
+        keymaps_t const* loaded        = nullptr;
+        char const*      error_message = nullptr;
+        if (!load_keymaps(out, arena, loaded, &error_message))
+        {
+            printf("failed to load %s: %s\n", out, error_message != nullptr ? error_message : "?");
+            ok = false;
+        }
+        else if (loaded->m_nb_keymaps != 1 || loaded->m_keymaps[0].m_nb_layers != keymap.m_nb_layers)
+        {
+            printf("%s has %d layers, %d were imported\n", out, loaded->m_nb_keymaps == 1 ? loaded->m_keymaps[0].m_nb_layers : 0, keymap.m_nb_layers);
+            ok = false;
+        }
+    }
+
+    if (ok)
+    {
+        im->m_nb_keymaps++;
+        im->m_nb_layers += keymap.m_nb_layers;
+        im->m_nb_keys += keymap.m_nb_keys;
+        im->m_nb_unknown += keymap.m_nb_unknown;
+    }
+    else
+    {
+        im->m_nb_failed++;
+    }
+    keymapc_release(keymap);
+}
+
+int cmd_import_keymap(int argc, char** argv)
+{
+    const char* root    = arg_value(argc, argv, "--keyboards", "qmk_firmware/keyboards");
+    const char* outdir  = arg_value(argc, argv, "--out", "keymaps/imported");
+    s32 const   threads = atoi(arg_value(argc, argv, "--threads", "0"));
+
+    keycodes_t const*   kcdb = nullptr;
+    ckeyboards_t const* kbdb = nullptr;
+    if (!load_databases(kcdb, kbdb))
+    {
+        unload_databases();
+        return 1;
+    }
+    if (!make_dir(outdir))
+    {
+        printf("failed to create directory %s\n", outdir);
+        unload_databases();
+        return 1;
+    }
+
+    simportc_t im;
+    im.m_kcdb       = kcdb;
+    im.m_names      = nullptr;
+    im.m_outdir     = outdir;
+    im.m_check      = arg_flag(argc, argv, "--check");
+    im.m_nb_bytes   = 0;
+    im.m_nb_keymaps = 0;
+    im.m_nb_layers  = 0;
+    im.m_nb_keys    = 0;
+    im.m_nb_unknown = 0;
+    im.m_nb_failed  = 0;
+
+    std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+
+    // every .c under the root, of which only the keymap.c files hold a keymaps array
+    if (!enumerate_files(root, ".c", true, im.m_files))
+    {
+        unload_databases();
+        return 1;
+    }
+    s32 nb_files = 0;
+    for (s32 i = 0; i < im.m_files.m_nb_files; i++)
+    {
+        if (strcmp(file_basename(im.m_files.m_files[i]), "keymap.c") == 0)
+            im.m_files.m_files[nb_files++] = im.m_files.m_files[i];
+        else
+            ::free(im.m_files.m_files[i]);
+    }
+    im.m_files.m_nb_files = nb_files;
+
+    s32 const root_len = (s32)strlen(root);
+    im.m_names         = (char*)::malloc((size_t)(nb_files > 0 ? nb_files : 1) * 2 * IMPORTC_NAME);
+    for (s32 i = 0; i < nb_files; i++)
+        import_keymapc_names(im.m_files.m_files[i], root_len, im.m_names + (i * 2) * IMPORTC_NAME, im.m_names + (i * 2 + 1) * IMPORTC_NAME);
+    import_keymapc_unique(im);
+
+    s32 const nb_workers = threads > 0 ? threads : jobs_nb_workers();
+    im.m_arenas          = new karena_t[nb_workers];
+    jobs_parallel_for(nb_files, import_keymapc_job, &im, nb_workers);
+    double const seconds = seconds_since(start);
+
+    double const files_per_second = seconds > 0.0 ? nb_files / seconds : 0.0;
+    double const mb_per_second    = seconds > 0.0 ? (im.m_nb_bytes.load() / (1024.0 * 1024.0)) / seconds : 0.0;
+    printf("imported %d keymaps (%d layers, %lld keys, %lld unknown keycodes) from %d files (%d failed) into %s in %.3f seconds, %.1f files/s, %.2f MB/s\n", im.m_nb_keymaps.load(),
+           im.m_nb_layers.load(), (long long)im.m_nb_keys.load(), (long long)im.m_nb_unknown.load(), nb_files, im.m_nb_failed.load(), outdir, seconds, files_per_second, mb_per_second);
+
+    for (s32 i = 0; i < nb_workers; i++)
+        exit_arena(im.m_arenas[i]);
+    delete[] im.m_arenas;
+    ::free(im.m_names);
+    release_files(im.m_files);
+    unload_databases();
+    return im.m_nb_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_search.h"
+#include "qmk-keymap-wiz/keyboard_keycode.h"
+#include "qmk-keymap-wiz/keyboard_reverse.h"
+#include "qmk-keymap-wiz/keyboard_cli_commands.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace xcore;
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// search: fuzzy search of the keycode database, prints the best matches and the time per query
+
+int cmd_search(int argc, char** argv)
+{
+    const char* query    = arg_value(argc, argv, "--query", "");
+    s32 const   max_hits = atoi(arg_value(argc, argv, "--max", "10"));
+    s32 const   repeat   = atoi(arg_value(argc, argv, "--repeat", "1000"));
+
+    keycodes_t const*   kcdb = nullptr;
+    ckeyboards_t const* kbdb = nullptr;
+    if (!load_databases(kcdb, kbdb) || max_hits <= 0)
+    {
+        unload_databases();
+        return 1;
+    }
+
+    ksearch_t* search = search_create();
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    search_build(search, kcdb);
+    double const build_seconds = seconds_since(start);
+
+    ksearchhit_t* hits    = (ksearchhit_t*)::malloc(sizeof(ksearchhit_t) * max_hits);
+    s32           nb_hits = 0;
+    start                 = std::chrono::steady_clock::now();
+    for (s32 i = 0; i < (repeat > 0 ? repeat : 1); i++)
+        nb_hits = search_keycodes(search, query, hits, max_hits);
+    double const query_seconds = seconds_since(start) / (repeat > 0 ? repeat : 1);
+
+    ksearch_stats_t stats;
+    search_stats(search, stats);
+    printf("index of %d keycodes, %d trigrams, %d postings, built in %.3f ms\n", stats.m_nb_keycodes, stats.m_nb_trigrams, stats.m_nb_postings, build_seconds * 1000.0);
+    printf("'%s': %d matches in %.3f us\n", query, nb_hits, query_seconds * 1000000.0);
+    for (s32 i = 0; i < nb_hits; i++)
+        printf("  %-24s %6d  %s\n", hits[i].m_keycode->m_code, hits[i].m_score, hits[i].m_keycode->m_descr != nullptr ? hits[i].m_keycode->m_descr : "");
+
+    ::free(hits);
+    search_destroy(search);
+    unload_databases();
+    return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// keycode: parse a keycode expression into its QMK value and compile all keys of a keymap file, with the time it takes
+
+int cmd_keycode(int argc, char** argv)
+{
+    const char* expr     = arg_value(argc, argv, "--expr", nullptr);
+    const char* filename = arg_value(argc, argv, "--keymap", "keymaps/jurgen.json");
+    s32 const   repeat   = atoi(arg_value(argc, argv, "--repeat", "100"));
+
+    keycodes_t const*   kcdb = nullptr;
+    ckeyboards_t const* kbdb = nullptr;
+    if (!load_databases(kcdb, kbdb))
+    {
+        unload_databases();
+        return 1;
+    }
+
+    karena_t arena;
+    init_arena(arena, 4 * 1024 * 1024, 4 * 1024 * 1024);
+    keymaps_t const* keymaps = nullptr;
+    if (!load_keymaps(filename, arena, keymaps))
+    {
+        printf("failed to load keymaps from %s\n", filename);
+        exit_arena(arena);
+        unload_databases();
+        return 1;
+    }
+
+    s32 result = 0;
+    if (expr != nullptr)
+    {
+        // layer names resolve against the first keymap of the file
+        kkeycode_t kc;
+        if (parse_keycode(kcdb, keymaps->m_nb_keymaps > 0 ? &keymaps->m_keymaps[0] : nullptr, expr, kc))
+        {
+            printf("%s = 0x%04X", expr, kc.m_value);
+            if (kc.m_index >= 0)
+                printf(" (%s)", kcdb->m_keycodes[kc.m_index].m_code);
+            printf("\n");
+        }
+        else
+        {
+            printf("%s is not a keycode\n", expr);
+            result = 1;
+        }
+    }
+
+    s32                                   nb_keys    = 0;
+    s32                                   nb_invalid = 0;
+    std::chrono::steady_clock::time_point start      = std::chrono::steady_clock::now();
+    for (s32 i = 0; i < (repeat > 0 ? repeat : 1); i++)
+        compile_keymaps(kcdb, const_cast<keymaps_t*>(keymaps));
+    double const seconds = seconds_since(start) / (repeat > 0 ? repeat : 1);
+
+    for (s32 k = 0; k < keymaps->m_nb_keymaps; k++)
+    {
+        keymap_t const& km = keymaps->m_keymaps[k];
+        for (s32 l = 0; l < km.m_nb_layers; l++)
+        {
+            layer_t const& layer = km.m_layers[l];
+            nb_keys += layer.m_nb_keys;
+            for (s32 j = 0; j < layer.m_nb_keys; j++)
+                nb_invalid += layer.m_keys[j].m_code == KEYCODE_INVALID ? 1 : 0;
+        }
+    }
+    printf("compiled %d keys in %.3f us (%.1f ns per key), %d without a QMK encoding\n", nb_keys, seconds * 1000000.0, nb_keys > 0 ? seconds * 1000000000.0 / nb_keys : 0.0, nb_invalid);
+
+    exit_arena(arena);
+    unload_databases();
+    return result;
+}
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// where: the keys of a keymap that type a character or keycode, with the modifiers and layer switches needed
+
+int cmd_where(int argc, char** argv)
+{
+    const char* query    = arg_value(argc, argv, "--query", nullptr);
+    const char* filename = arg_value(argc, argv, "--keymap", "keymaps/jurgen.json");
+    s32 const   repeat   = atoi(arg_value(argc, argv, "--repeat", "1000"));
+    if (query == nullptr)
+    {
+        printf("where: --query <text> is required\n");
+        return 1;
+    }
+
+    keycodes_t const*   kcdb = nullptr;
+    ckeyboards_t const* kbdb = nullptr;
+    if (!load_databases(kcdb, kbdb))
+    {
+        unload_databases();
+        return 1;
+    }
+
+    karena_t arena;
+    init_arena(arena, 4 * 1024 * 1024, 4 * 1024 * 1024);
+    keymaps_t const* keymaps = nullptr;
+    if (!load_keymaps(filename, arena, keymaps) || keymaps->m_nb_keymaps == 0)
+    {
+        printf("failed to load keymaps from %s\n", filename);
+        exit_arena(arena);
+        unload_databases();
+        return 1;
+    }
+    compile_keymaps(kcdb, const_cast<keymaps_t*>(keymaps));
+    keymap_t const* km = &keymaps->m_keymaps[0];
+
+    std::chrono::steady_clock::time_point start   = std::chrono::steady_clock::now();
+    kreverse_t*                           reverse = reverse_create();
+    reverse_build(reverse, kcdb, km);
+    double const build_seconds = seconds_since(start);
+
+    kreversehit_t hits[32];
+    s32           nb_hits = 0;
+    start                 = std::chrono::steady_clock::now();
+    for (s32 i = 0; i < (repeat > 0 ? repeat : 1); i++)
+        nb_hits = reverse_find(reverse, query, hits, 32);
+    double const query_seconds = seconds_since(start) / (repeat > 0 ? repeat : 1);
+
+    printf("index built in %.3f ms, query in %.3f us, %d hits\n", build_seconds * 1000.0, query_seconds * 1000000.0, nb_hits);
+    for (s32 i = 0; i < nb_hits; i++)
+    {
+        kreversehit_t const& hit = hits[i];
+        printf("  %s key %d", km->m_layers[hit.m_layer].m_name, hit.m_key);
+        for (s32 bit = 0; key_mod_str(bit) != nullptr; bit++)
+        {
+            if ((hit.m_mods & (1 << bit)) != 0)
+                printf(" + %s", key_mod_str(bit));
+        }
+
+        kreversestep_t steps[16];
+        s32 const      nb_steps = reverse_path(reverse, hit.m_layer, steps, 16);
+        if (nb_steps < 0)
+            printf(", layer cannot be reached");
+        for (s32 s = 0; s < nb_steps && s < 16; s++)
+            printf("%s %s key %d", s == 0 ? ", via" : " ->", km->m_layers[steps[s].m_layer].m_name, steps[s].m_key);
+        printf("\n");
+    }
+
+    reverse_destroy(reverse);
+    exit_arena(arena);
+    unload_databases();
+    return nb_hits > 0 ? 0 : 1;
+}
@@ -0,0 +1,220 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_keycode.h"
+#include "qmk-keymap-wiz/keyboard_reverse.h"
+#include "qmk-keymap-wiz/keyboard_corpus.h"
+#include "qmk-keymap-wiz/keyboard_optimize.h"
+#include "qmk-keymap-wiz/keyboard_cli_commands.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace xcore;
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// heatmap: count a text corpus and report the key presses per layer on a keymap, with the throughput
+
+int cmd_heatmap(int argc, char** argv)
+{
+    const char* corpus_file = arg_value(argc, argv, "--corpus", nullptr);
+    const char* filename    = arg_value(argc, argv, "--keymap", "keymaps/jurgen.json");
+    s32 const   nb_threads  = atoi(arg_value(argc, argv, "--threads", "0"));
+    s32 const   top         = atoi(arg_value(argc, argv, "--top", "10"));
+    if (corpus_file == nullptr)
+    {
+        printf("heatmap: --corpus <file> is required\n");
+        return 1;
+    }
+
+    keycodes_t const*   kcdb = nullptr;
+    ckeyboards_t const* kbdb = nullptr;
+    if (!load_databases(kcdb, kbdb))
+    {
+        unload_databases();
+        return 1;
+    }
+
+    karena_t arena;
+    init_arena(arena, 4 * 1024 * 1024, 4 * 1024 * 1024);
+    keymaps_t const* keymaps = nullptr;
+    if (!load_keymaps(filename, arena, keymaps) || keymaps->m_nb_keymaps == 0)
+    {
+        printf("failed to load keymaps from %s\n", filename);
+        exit_arena(arena);
+        unload_databases();
+        return 1;
+    }
+    compile_keymaps(kcdb, const_cast<keymaps_t*>(keymaps));
+    keymap_t const* km = &keymaps->m_keymaps[0];
+
+    kcorpus_t corpus;
+    if (!corpus_load(corpus_file, corpus, nb_threads))
+    {
+        exit_arena(arena);
+        unload_databases();
+        return 1;
+    }
+    printf("%s: %lld bytes in %d chunks, %.3f s (%.2f GB/s)\n", corpus_file, (long long)corpus.m_nb_bytes, corpus.m_nb_chunks, corpus.m_seconds,
+           corpus.m_seconds > 0.0 ? (double)corpus.m_nb_bytes / corpus.m_seconds / 1e9 : 0.0);
+
+    kreverse_t* reverse = reverse_create();
+    reverse_build(reverse, kcdb, km);
+    kheatmap_t* heatmap = heatmap_create();
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    heatmap_compute(heatmap, corpus, reverse, km);
+    printf("heatmap in %.3f ms, %llu bytes typed, %llu without a key\n", seconds_since(start) * 1000.0, (unsigned long long)heatmap_total(heatmap), (unsigned long long)heatmap_unmapped(heatmap));
+
+    u64 const total = heatmap_total(heatmap) > 0 ? heatmap_total(heatmap) : 1;
+    for (s32 l = 0; l < heatmap_nb_layers(heatmap); l++)
+    {
+        u64 const bytes = heatmap_layer_bytes(heatmap, l);
+        printf("  %-16s %6.2f%% of the bytes\n", km->m_layers[l].m_name, 100.0 * (double)bytes / (double)total);
+
+        // the most pressed keys of the layer, a selection of the top n
+        u64 const* presses = heatmap_presses(heatmap, l);
+        s32 const  nb_keys = heatmap_nb_keys(heatmap, l);
+        u64        below   = ~(u64)0;
+        for (s32 n = 0; n < top; n++)
+        {
+            s32 best = -1;
+            for (s32 k = 0; k < nb_keys; k++)
+            {
+                if (presses[k] > 0 && presses[k] < below && (best < 0 || presses[k] > presses[best]))
+                    best = k;
+            }
+            if (best < 0)
+                break;
+            below = presses[best];
+            for (s32 k = 0; k < nb_keys; k++)
+            {
+                if (presses[k] == below)
+                    printf("    key %3d %-16s %10llu %6.2f%%\n", k, km->m_layers[l].m_keys[k].m_keycode_str, (unsigned long long)presses[k], 100.0 * (double)presses[k] / (double)total);
+            }
+        }
+    }
+
+    heatmap_destroy(heatmap);
+    reverse_destroy(reverse);
+    corpus_release(corpus);
+    exit_arena(arena);
+    unload_databases();
+    return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// optimize: rearrange the keys of some layers of a keymap for a text corpus, reports the swap rate and the cost, and
+// prints the keys that move
+
+struct soptimized_t
+{
+    keymap_t const* m_km;
+    s32             m_nb_edits;
+};
+
+static void print_optimized(kedit_t const& edit, void* user)
+{
+    soptimized_t* out = (soptimized_t*)user;
+    printf("  %-16s key %3d %-16s -> %s\n", out->m_km->m_layers[edit.m_layer].m_name, edit.m_key, out->m_km->m_layers[edit.m_layer].m_keys[edit.m_key].m_keycode_str, edit.m_str);
+    out->m_nb_edits += 1;
+}
+
+int cmd_optimize(int argc, char** argv)
+{
+    const char* corpus_file = arg_value(argc, argv, "--corpus", nullptr);
+    const char* filename    = arg_value(argc, argv, "--keymap", "keymaps/jurgen.json");
+    const char* layers      = arg_value(argc, argv, "--layers", "0");
+    s32 const   nb_rounds   = atoi(arg_value(argc, argv, "--rounds", "50"));
+    s32 const   nb_threads  = atoi(arg_value(argc, argv, "--threads", "0"));
+    if (corpus_file == nullptr)
+    {
+        printf("optimize: --corpus <file> is required\n");
+        return 1;
+    }
+
+    keycodes_t const*   kcdb = nullptr;
+    ckeyboards_t const* kbdb = nullptr;
+    if (!load_databases(kcdb, kbdb) || kbdb->m_nb_keyboards == 0)
+    {
+        unload_databases();
+        return 1;
+    }
+
+    karena_t arena;
+    init_arena(arena, 4 * 1024 * 1024, 4 * 1024 * 1024);
+    keymaps_t const* keymaps = nullptr;
+    if (!load_keymaps(filename, arena, keymaps) || keymaps->m_nb_keymaps == 0)
+    {
+        printf("failed to load keymaps from %s\n", filename);
+        exit_arena(arena);
+        unload_databases();
+        return 1;
+    }
+    compile_keymaps(kcdb, const_cast<keymaps_t*>(keymaps));
+    keymap_t const* km = &keymaps->m_keymaps[0];
+
+    // the geometry, home keys and fingers come from the keyboard of the keymap
+    ckeyboard_t const* kb = find_keyboard(kbdb, km->m_name);
+    if (kb == nullptr)
+    {
+        printf("optimize: keyboard '%s' of %s is not in the keyboard database\n", km->m_name ? km->m_name : "", filename);
+        exit_arena(arena);
+        unload_databases();
+        return 1;
+    }
+
+    kcorpus_t corpus;
+    if (!corpus_load(corpus_file, corpus, nb_threads))
+    {
+        exit_arena(arena);
+        unload_databases();
+        return 1;
+    }
+
+    // the layers as a list of indices, e.g. "0,1"
+    koptimize_params_t params;
+    optimize_defaults(params);
+    params.m_layers     = 0;
+    params.m_nb_rounds  = nb_rounds;
+    params.m_nb_workers = nb_threads;
+    for (const char* c = layers; *c != 0;)
+    {
+        char*     end   = nullptr;
+        s32 const layer = (s32)strtol(c, &end, 10);
+        if (end == c)
+            break;
+        if (layer >= 0 && layer < 64)
+            params.m_layers |= (u64)1 << layer;
+        c = *end == ',' ? end + 1 : end;
+    }
+
+    kreverse_t* reverse = reverse_create();
+    reverse_build(reverse, kcdb, km);
+
+    std::chrono::steady_clock::time_point start     = std::chrono::steady_clock::now();
+    koptimizer_t*                         optimizer = optimizer_create(kb, km, reverse, corpus, params);
+    printf("model in %.3f ms\n", seconds_since(start) * 1000.0);
+    optimizer_run(optimizer);
+
+    koptimize_stats_t stats;
+    optimizer_stats(optimizer, stats);
+    printf("%d keys, %lld swaps in %d rounds, %.3f s (%.1f M swaps/s)\n", stats.m_nb_symbols, (long long)stats.m_nb_swaps, stats.m_nb_rounds, stats.m_seconds,
+           stats.m_seconds > 0.0 ? (double)stats.m_nb_swaps / stats.m_seconds / 1000000.0 : 0.0);
+    printf("cost per byte %.4f -> %.4f, %u better layouts\n", stats.m_initial_cost, stats.m_best_cost, stats.m_version);
+
+    soptimized_t out;
+    out.m_km       = km;
+    out.m_nb_edits = 0;
+    optimizer_edits(optimizer, 0, print_optimized, &out);
+    printf("%d keys moved\n", out.m_nb_edits);
+
+    optimizer_destroy(optimizer);
+    reverse_destroy(reverse);
+    corpus_release(corpus);
+    exit_arena(arena);
+    unload_databases();
+    return 0;
+}
@@ -0,0 +1,206 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_writer.h"
+#include "qmk-keymap-wiz/keyboard_keycode.h"
+#include "qmk-keymap-wiz/keyboard_simulate.h"
+#include "qmk-keymap-wiz/keyboard_cli_commands.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace xcore;
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// simulate: the HID reports that a keymap produces for a stream of key events, with the semantics of QMK (layers,
+// tap-hold, one-shot), the reports can be written to a file and compared with the reports of an earlier run
+
+// 'nb_events' (even) events of typing on random keys, some held past the tapping term and some rolled into the next key
+static ksimevent_t* generate_events(s32 nb_keys, s32 nb_events)
+{
+    ksimevent_t* events = (ksimevent_t*)::malloc(sizeof(ksimevent_t) * (nb_events + 1));
+    s32          held_key[4];
+    u32          held_until[4];
+    s32          nb_held = 0;
+    s32          n       = 0;
+    u32          time    = 0;
+    u32          rnd     = 12345;
+    while (n < nb_events)
+    {
+        rnd            = rnd * 1103515245u + 12345u;
+        u32 const next = time + 20 + (rnd >> 8) % 180;
+
+        // release the keys that are up before the next press, the earliest first, and all of them at the end
+        while (nb_held > 0)
+        {
+            s32 first = 0;
+            for (s32 i = 1; i < nb_held; ++i)
+                first = held_until[i] < held_until[first] ? i : first;
+            bool const must = nb_held == 4 || n + nb_held + 2 > nb_events;
+            if (!must && held_until[first] > next)
+                break;
+
+            ksimevent_t& e = events[n++];
+            e.m_time       = held_until[first] > time ? held_until[first] : time;
+            e.m_key        = (s16)held_key[first];
+            e.m_down       = 0;
+            e.m_pad        = 0;
+            time           = e.m_time;
+
+            nb_held -= 1;
+            held_key[first]   = held_key[nb_held];
+            held_until[first] = held_until[nb_held];
+        }
+        if (n + 2 > nb_events)
+            break;
+
+        s32 key = (s32)((rnd >> 16) % (u32)nb_keys);
+        for (s32 i = 0; i < nb_held; ++i)
+        {
+            if (held_key[i] == key)
+            {
+                key = (key + 1) % nb_keys;
+                i   = -1;
+            }
+        }
+        time                = next > time ? next : time;
+        ksimevent_t& e      = events[n++];
+        e.m_time            = time;
+        e.m_key             = (s16)key;
+        e.m_down            = 1;
+        e.m_pad             = 0;
+        held_key[nb_held]   = key;
+        held_until[nb_held] = time + 30 + (rnd >> 4) % 300;
+        nb_held += 1;
+    }
+    return events;
+}
+
+int cmd_simulate(int argc, char** argv)
+{
+    const char* events_file = arg_value(argc, argv, "--events", nullptr);
+    const char* filename    = arg_value(argc, argv, "--keymap", "keymaps/jurgen.json");
+    const char* out_file    = arg_value(argc, argv, "--out", nullptr);
+    const char* expect_file = arg_value(argc, argv, "--expect", nullptr);
+    s32 const   generate    = atoi(arg_value(argc, argv, "--generate", "0"));
+    s32 const   repeat      = atoi(arg_value(argc, argv, "--repeat", "1"));
+
+    ksimparams_t params;
+    params.m_tapping_term            = (u32)atoi(arg_value(argc, argv, "--term", "200"));
+    params.m_tapping_toggle          = atoi(arg_value(argc, argv, "--toggle", "5"));
+    params.m_permissive_hold         = arg_flag(argc, argv, "--permissive");
+    params.m_hold_on_other_key_press = arg_flag(argc, argv, "--hold-on-press");
+    if (events_file == nullptr && generate <= 0)
+    {
+        printf("simulate: --events <file> or --generate <n> is required\n");
+        return 1;
+    }
+
+    keycodes_t const*   kcdb = nullptr;
+    ckeyboards_t const* kbdb = nullptr;
+    if (!load_databases(kcdb, kbdb))
+    {
+        unload_databases();
+        return 1;
+    }
+
+    karena_t arena;
+    init_arena(arena, 4 * 1024 * 1024, 4 * 1024 * 1024);
+    keymaps_t const* keymaps = nullptr;
+    if (!load_keymaps(filename, arena, keymaps) || keymaps->m_nb_keymaps == 0)
+    {
+        printf("failed to load keymaps from %s\n", filename);
+        exit_arena(arena);
+        unload_databases();
+        return 1;
+    }
+    compile_keymaps(kcdb, const_cast<keymaps_t*>(keymaps));
+    keymap_t const* km = &keymaps->m_keymaps[0];
+
+    ksimevent_t* events    = nullptr;
+    s32          nb_events = 0;
+    bool         ok        = true;
+    if (events_file != nullptr)
+        ok = sim_load_events(events_file, events, nb_events);
+    else if (km->m_nb_layers > 0 && km->m_layers[0].m_nb_keys > 0)
+    {
+        nb_events = generate & ~1;
+        events    = generate_events(km->m_layers[0].m_nb_keys, nb_events);
+    }
+
+    // a key event produces at most a few reports, a tap-hold key that is decided sends the held back keys as well
+    s32 const     max_reports = nb_events * 4 + 16;
+    ksimreport_t* reports     = (ksimreport_t*)::malloc(sizeof(ksimreport_t) * max_reports);
+    s32           nb_reports  = 0;
+    ksim_t*       sim         = sim_create(km, params);
+    ksimstats_t   stats;
+    memset(&stats, 0, sizeof(stats));
+
+    std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+    for (s32 r = 0; r < (repeat > 0 ? repeat : 1) && ok; r++)
+    {
+        sim_reset(sim);
+        nb_reports = sim_run(sim, events, nb_events, reports, max_reports);
+        u32 const end = nb_events > 0 ? events[nb_events - 1].m_time + params.m_tapping_term : 0;
+        nb_reports += sim_tick(sim, end, reports + nb_reports, max_reports - nb_reports);
+        sim_stats(sim, stats);
+    }
+    double const seconds = seconds_since(start);
+    double const total   = (double)nb_events * (repeat > 0 ? repeat : 1);
+
+    if (ok)
+    {
+        printf("simulated %d events x %d in %.3f seconds, %.1f M events/s, %d reports (%lld rollover, %lld unhandled keycodes)\n", nb_events, repeat > 0 ? repeat : 1, seconds,
+               seconds > 0.0 ? total / seconds / 1000000.0 : 0.0, nb_reports, (long long)stats.m_nb_rollover, (long long)stats.m_nb_unhandled);
+    }
+
+    if (ok && out_file != nullptr)
+    {
+        kwriter_t w;
+        ok = writer_open(w, out_file);
+        for (s32 i = 0; i < nb_reports && ok; i++)
+        {
+            ksimreport_t const& r = reports[i];
+            char                line[64];
+            snprintf(line, sizeof(line), "%u %02x %02x %02x %02x %02x %02x %02x\n", r.m_time, r.m_mods, r.m_keys[0], r.m_keys[1], r.m_keys[2], r.m_keys[3], r.m_keys[4], r.m_keys[5]);
+            writer_str(w, line);
+        }
+        if (!writer_close(w) || !ok)
+        {
+            printf("failed to write %s\n", out_file);
+            ok = false;
+        }
+    }
+
+    if (ok && expect_file != nullptr)
+    {
+        ksimreport_t* expected    = nullptr;
+        s32           nb_expected = 0;
+        ok                        = sim_load_reports(expect_file, expected, nb_expected);
+        for (s32 i = 0; ok && i < nb_reports && i < nb_expected; i++)
+        {
+            if (reports[i].m_time != expected[i].m_time || !sim_same_report(reports[i], expected[i]))
+            {
+                printf("report %d differs from %s (line %d of the reports)\n", i, expect_file, i + 1);
+                ok = false;
+            }
+        }
+        if (ok && nb_reports != nb_expected)
+        {
+            printf("%d reports, %s has %d\n", nb_reports, expect_file, nb_expected);
+            ok = false;
+        }
+        if (ok)
+            printf("all %d reports match %s\n", nb_reports, expect_file);
+        ::free(expected);
+    }
+
+    sim_destroy(sim);
+    ::free(reports);
+    ::free(events);
+    exit_arena(arena);
+    unload_databases();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,230 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_compose.h"
+#include "qmk-keymap-wiz/keyboard_keycode.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace xcore
+{
+    enum
+    {
+        QK_TRANSPARENT = 0x0001, // the QMK value of KC_TRNS
+    };
+
+    bool is_transparent_key(key_t const& key)
+    {
+        // a compiled key is transparent when its value is KC_TRNS, LT(1, KC_TRNS) or LCTL(KC_TRNS) are not
+        if (key.m_kc != KEYCODE_UNCOMPILED)
+            return key.m_code == QK_TRANSPARENT;
+        return is_transparent_keycode(key.m_keycode_str) && key.m_mod == 0 && !key.m_mod_tap && key.m_layer_switch == 0;
+    }
+
+    struct kcompose_t
+    {
+        keycodes_t const* m_kcdb;
+        keymap_t const*   m_km;
+        s32               m_nb_layers;
+        s32*              m_key_base; // m_nb_layers + 1 entries
+        kcomposedkey_t*   m_keys;
+        u64*              m_stacks; // the active layers below every layer
+        u32               m_version;
+    };
+
+    kcompose_t* compose_create()
+    {
+        kcompose_t* c  = (kcompose_t*)::malloc(sizeof(kcompose_t));
+        c->m_kcdb      = nullptr;
+        c->m_km        = nullptr;
+        c->m_nb_layers = 0;
+        c->m_key_base  = nullptr;
+        c->m_keys      = nullptr;
+        c->m_stacks    = nullptr;
+        c->m_version   = 0;
+        return c;
+    }
+
+    static void compose_free(kcompose_t* c)
+    {
+        ::free(c->m_key_base);
+        ::free(c->m_keys);
+        ::free(c->m_stacks);
+        c->m_key_base  = nullptr;
+        c->m_keys      = nullptr;
+        c->m_stacks    = nullptr;
+        c->m_nb_layers = 0;
+    }
+
+    void compose_destroy(kcompose_t* c)
+    {
+        if (c == nullptr)
+            return;
+        compose_free(c);
+        ::free(c);
+    }
+
+    // the layers below 'layer' that a stack can hold
+    static inline u64 layers_below(s32 layer) { return layer >= 64 ? ~(u64)0 : (((u64)1 << layer) - 1); }
+
+    static inline s32 highest_layer(u64 mask)
+    {
+        s32 layer = -1;
+        while (mask != 0)
+        {
+            mask >>= 1;
+            layer += 1;
+        }
+        return layer;
+    }
+
+    // follow the transparent keys of 'layer' down through its stack
+    static kcomposedkey_t compose_key(kcompose_t* c, keymap_t const* km, s32 layer, s32 key)
+    {
+        u64 const stack = c->m_stacks[layer];
+        s32       l     = layer;
+        while (l >= 0)
+        {
+            layer_t const& kl = km->m_layers[l];
+            if (key < kl.m_nb_keys && !is_transparent_key(kl.m_keys[key]))
+            {
+                kcomposedkey_t ck;
+                ck.m_keycode = key_keycode(c->m_kcdb, kl.m_keys[key]);
+                ck.m_source  = (s16)l;
+                return ck;
+            }
+            l = highest_layer(stack & layers_below(l));
+        }
+
+        kcomposedkey_t ck;
+        ck.m_keycode = nullptr;
+        ck.m_source  = -1;
+        return ck;
+    }
+
+    static void compose_layer_keys(kcompose_t* c, keymap_t const* km, s32 layer)
+    {
+        kcomposedkey_t* keys    = &c->m_keys[c->m_key_base[layer]];
+        s32 const       nb_keys = c->m_key_base[layer + 1] - c->m_key_base[layer];
+        for (s32 k = 0; k < nb_keys; ++k)
+            keys[k] = compose_key(c, km, layer, k);
+    }
+
+    void compose_build(kcompose_t* c, keycodes_t const* kcdb, keymap_t const* km)
+    {
+        // the stacks that were set survive a build as long as the number of layers stays the same
+        u64* stacks = nullptr;
+        if (c->m_nb_layers == km->m_nb_layers)
+        {
+            stacks      = c->m_stacks;
+            c->m_stacks = nullptr;
+        }
+        compose_free(c);
+
+        s32 const L    = km->m_nb_layers;
+        c->m_kcdb      = kcdb;
+        c->m_km        = km;
+        c->m_nb_layers = L;
+
+        c->m_key_base    = (s32*)::malloc(sizeof(s32) * (L + 1));
+        c->m_key_base[0] = 0;
+        for (s32 l = 0; l < L; ++l)
+            c->m_key_base[l + 1] = c->m_key_base[l] + km->m_layers[l].m_nb_keys;
+        c->m_keys = (kcomposedkey_t*)::malloc(sizeof(kcomposedkey_t) * (c->m_key_base[L] + 1));
+
+        if (stacks == nullptr)
+        {
+            stacks = (u64*)::malloc(sizeof(u64) * (L + 1));
+            for (s32 l = 0; l < L; ++l)
+                stacks[l] = layers_below(l);
+        }
+        c->m_stacks = stacks;
+
+        for (s32 l = 0; l < L; ++l)
+            compose_layer_keys(c, km, l);
+        c->m_version += 1;
+    }
+
+    void compose_set_stack(kcompose_t* c, s32 layer, u64 below)
+    {
+        if (layer < 0 || layer >= c->m_nb_layers)
+            return;
+        below &= layers_below(layer);
+        if (c->m_stacks[layer] == below)
+            return;
+        c->m_stacks[layer] = below;
+        compose_layer_keys(c, c->m_km, layer);
+        c->m_version += 1;
+    }
+
+    u64 compose_stack(kcompose_t* c, s32 layer)
+    {
+        if (layer < 0 || layer >= c->m_nb_layers)
+            return 0;
+        return c->m_stacks[layer];
+    }
+
+    bool compose_update(kcompose_t* c, keymap_t const* km, kedit_t const& edit)
+    {
+        if (is_layer_edit(edit.m_op) || edit.m_op == EDIT_KEY_CAPCOLOR || edit.m_op == EDIT_KEY_LEDCOLOR)
+            return false;
+        if (edit.m_layer < 0 || edit.m_layer >= c->m_nb_layers || edit.m_key < 0 || edit.m_key >= c->m_key_base[edit.m_layer + 1] - c->m_key_base[edit.m_layer])
+            return false;
+
+        // only the same key on the edited layer and on the layers above it that have the edited layer in their stack
+        // can change
+        s32 const L       = edit.m_layer;
+        bool      changed = false;
+        c->m_km           = km;
+        for (s32 l = L; l < c->m_nb_layers; ++l)
+        {
+            if (l != L && (L >= 64 || (c->m_stacks[l] & ((u64)1 << L)) == 0))
+                continue;
+            if (edit.m_key >= c->m_key_base[l + 1] - c->m_key_base[l])
+                continue;
+
+            kcomposedkey_t&      old = c->m_keys[c->m_key_base[l] + edit.m_key];
+            kcomposedkey_t const ck  = compose_key(c, km, l, edit.m_key);
+            if (ck.m_keycode != old.m_keycode || ck.m_source != old.m_source)
+            {
+                old     = ck;
+                changed = true;
+            }
+        }
+        if (changed)
+            c->m_version += 1;
+        return changed;
+    }
+
+    s32 compose_nb_layers(kcompose_t* c) { return c->m_nb_layers; }
+
+    s32 compose_nb_keys(kcompose_t* c, s32 layer)
+    {
+        if (layer < 0 || layer >= c->m_nb_layers)
+            return 0;
+        return c->m_key_base[layer + 1] - c->m_key_base[layer];
+    }
+
+    kcomposedkey_t const* compose_layer(kcompose_t* c, s32 layer)
+    {
+        if (layer < 0 || layer >= c->m_nb_layers)
+            return nullptr;
+        return &c->m_keys[c->m_key_base[layer]];
+    }
+
+    u32 compose_version(kcompose_t* c) { return c->m_version; }
+
+    const char* compose_label(kcompose_t* c, kcomposedkey_t const& ck, s32 key)
+    {
+        if (ck.m_source < 0)
+            return nullptr;
+        if (ck.m_keycode != nullptr && ck.m_keycode->m_normal != nullptr)
+            return ck.m_keycode->m_normal;
+        layer_t const& source = c->m_km->m_layers[ck.m_source];
+        if (key < 0 || key >= source.m_nb_keys)
+            return nullptr;
+        return source.m_keys[key].m_keycode_str;
+    }
+
+} // namespace xcore
@@ -0,0 +1,336 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_corpus.h"
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_files.h"
+#include "qmk-keymap-wiz/keyboard_jobs.h"
+#include "qmk-keymap-wiz/keyboard_reverse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+namespace xcore
+{
+    enum
+    {
+        NB_PAIRS   = 256 * 256,
+        CHUNK_SIZE = 8 * 1024 * 1024, // bytes per job, small enough for a u32 histogram
+    };
+
+    void corpus_count(u8 const* data, s64 size, u8 previous, u32* pairs)
+    {
+        // unrolled so that the loads of the next bytes do not wait on the increments of the previous ones
+        u32 prev = previous;
+        s64 i    = 0;
+        for (; i + 8 <= size; i += 8)
+        {
+            u32 const b0 = data[i + 0];
+            u32 const b1 = data[i + 1];
+            u32 const b2 = data[i + 2];
+            u32 const b3 = data[i + 3];
+            u32 const b4 = data[i + 4];
+            u32 const b5 = data[i + 5];
+            u32 const b6 = data[i + 6];
+            u32 const b7 = data[i + 7];
+            pairs[(prev << 8) | b0] += 1;
+            pairs[(b0 << 8) | b1] += 1;
+            pairs[(b1 << 8) | b2] += 1;
+            pairs[(b2 << 8) | b3] += 1;
+            pairs[(b3 << 8) | b4] += 1;
+            pairs[(b4 << 8) | b5] += 1;
+            pairs[(b5 << 8) | b6] += 1;
+            pairs[(b6 << 8) | b7] += 1;
+            prev = b7;
+        }
+        for (; i < size; ++i)
+        {
+            pairs[(prev << 8) | data[i]] += 1;
+            prev = data[i];
+        }
+    }
+
+    struct kcorpusjob_t
+    {
+        u8 const* m_data;
+        s64       m_size;
+        u32*      m_chunk_pairs;  // per worker, NB_PAIRS
+        u64*      m_worker_pairs; // per worker, NB_PAIRS
+    };
+
+    static void corpus_chunk(s32 index, s32 worker, void* user)
+    {
+        kcorpusjob_t* job   = (kcorpusjob_t*)user;
+        s64 const     begin = (s64)index * CHUNK_SIZE;
+        s64 const     end   = begin + CHUNK_SIZE < job->m_size ? begin + CHUNK_SIZE : job->m_size;
+
+        // the pair that crosses into this chunk belongs to this chunk
+        u32* pairs = &job->m_chunk_pairs[(s64)worker * NB_PAIRS];
+        memset(pairs, 0, sizeof(u32) * NB_PAIRS);
+        corpus_count(job->m_data + begin, end - begin, begin > 0 ? job->m_data[begin - 1] : 0, pairs);
+
+        u64* total = &job->m_worker_pairs[(s64)worker * NB_PAIRS];
+        for (s32 i = 0; i < NB_PAIRS; ++i)
+            total[i] += pairs[i];
+    }
+
+    bool corpus_load(const char* filename, kcorpus_t& corpus, s32 nb_workers)
+    {
+        corpus_release(corpus);
+
+        std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+
+        kmapping_t mapping;
+        if (!map_file(filename, mapping))
+        {
+            printf("failed to map corpus %s\n", filename);
+            return false;
+        }
+
+        if (nb_workers <= 0)
+            nb_workers = jobs_nb_workers();
+        s32 const nb_chunks = (s32)((mapping.m_size + CHUNK_SIZE - 1) / CHUNK_SIZE);
+        if (nb_workers > nb_chunks)
+            nb_workers = nb_chunks > 0 ? nb_chunks : 1;
+
+        kcorpusjob_t job;
+        job.m_data         = mapping.m_data;
+        job.m_size         = mapping.m_size;
+        job.m_chunk_pairs  = (u32*)::malloc(sizeof(u32) * NB_PAIRS * nb_workers);
+        job.m_worker_pairs = (u64*)::calloc((size_t)NB_PAIRS * nb_workers, sizeof(u64));
+        jobs_parallel_for(nb_chunks, corpus_chunk, &job, nb_workers);
+
+        corpus.m_pairs = (u64*)::calloc(NB_PAIRS, sizeof(u64));
+        for (s32 w = 0; w < nb_workers; ++w)
+        {
+            u64 const* pairs = &job.m_worker_pairs[(s64)w * NB_PAIRS];
+            for (s32 i = 0; i < NB_PAIRS; ++i)
+                corpus.m_pairs[i] += pairs[i];
+        }
+        ::free(job.m_chunk_pairs);
+        ::free(job.m_worker_pairs);
+        unmap_file(mapping);
+
+        corpus.m_nb_bytes  = job.m_size;
+        corpus.m_nb_chunks = nb_chunks;
+        corpus.m_seconds   = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return true;
+    }
+
+    void corpus_release(kcorpus_t& corpus)
+    {
+        ::free(corpus.m_pairs);
+        corpus = kcorpus_t();
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+
+    enum
+    {
+        MAX_STEPS = 8,
+    };
+
+    // how a byte is typed
+    struct kheatbyte_t
+    {
+        s16            m_layer; // or CORPUS_BYTE_UNMAPPED/CORPUS_BYTE_IGNORED
+        s16            m_key;
+        u16            m_mods;
+        s16            m_nb_steps;
+        kreversestep_t m_steps[MAX_STEPS];
+    };
+
+    struct kheatmap_t
+    {
+        s32  m_nb_layers;
+        s32* m_key_base; // m_nb_layers + 1 entries
+        s32  m_nb_keys;
+        u64* m_presses;
+        u64* m_layer_bytes;
+        u64  m_max;
+        u64  m_total;
+        u64  m_unmapped;
+    };
+
+    kheatmap_t* heatmap_create()
+    {
+        kheatmap_t* h    = (kheatmap_t*)::malloc(sizeof(kheatmap_t));
+        h->m_nb_layers   = 0;
+        h->m_key_base    = nullptr;
+        h->m_nb_keys     = -1;
+        h->m_presses     = nullptr;
+        h->m_layer_bytes = nullptr;
+        h->m_max         = 0;
+        h->m_total       = 0;
+        h->m_unmapped    = 0;
+        return h;
+    }
+
+    void heatmap_destroy(kheatmap_t* h)
+    {
+        if (h == nullptr)
+            return;
+        ::free(h->m_key_base);
+        ::free(h->m_presses);
+        ::free(h->m_layer_bytes);
+        ::free(h);
+    }
+
+    s32 corpus_byte_key(kreverse_t* r, u32 byte, kreversehit_t& hit)
+    {
+        char        text[2] = {(char)byte, 0};
+        const char* query   = nullptr;
+        if (byte == '\r')
+            return CORPUS_BYTE_IGNORED;
+        else if (byte == ' ')
+            query = "KC_SPC";
+        else if (byte == '\n')
+            query = "KC_ENT";
+        else if (byte == '\t')
+            query = "KC_TAB";
+        else if (byte > ' ' && byte < 0x7F)
+            query = text;
+        if (query == nullptr || reverse_find(r, query, &hit, 1) == 0)
+            return CORPUS_BYTE_UNMAPPED;
+        return 0;
+    }
+
+    static void heat_byte(kreverse_t* r, u32 byte, kheatbyte_t& hb)
+    {
+        hb.m_layer    = CORPUS_BYTE_UNMAPPED;
+        hb.m_key      = -1;
+        hb.m_mods     = 0;
+        hb.m_nb_steps = 0;
+
+        kreversehit_t hit;
+        s32 const     result = corpus_byte_key(r, byte, hit);
+        if (result < 0)
+        {
+            hb.m_layer = (s16)result;
+            return;
+        }
+        hb.m_layer = hit.m_layer;
+        hb.m_key   = hit.m_key;
+        hb.m_mods  = hit.m_mods;
+
+        s32 const nb_steps = reverse_path(r, hit.m_layer, hb.m_steps, MAX_STEPS);
+        hb.m_nb_steps      = (s16)(nb_steps < 0 ? 0 : (nb_steps > MAX_STEPS ? MAX_STEPS : nb_steps));
+    }
+
+    static inline void heat_press(kheatmap_t* h, s32 layer, s32 key, u64 count)
+    {
+        if (layer < 0 || layer >= h->m_nb_layers || key < 0 || key >= h->m_key_base[layer + 1] - h->m_key_base[layer])
+            return;
+        h->m_presses[h->m_key_base[layer] + key] += count;
+    }
+
+    void heatmap_compute(kheatmap_t* h, kcorpus_t const& corpus, kreverse_t* r, keymap_t const* km)
+    {
+        s32 const L = km->m_nb_layers;
+        if (h->m_key_base == nullptr || h->m_nb_layers != L)
+        {
+            ::free(h->m_key_base);
+            ::free(h->m_layer_bytes);
+            h->m_nb_layers   = L;
+            h->m_key_base    = (s32*)::malloc(sizeof(s32) * (L + 1));
+            h->m_layer_bytes = (u64*)::malloc(sizeof(u64) * (L + 1));
+        }
+        h->m_key_base[0] = 0;
+        for (s32 l = 0; l < L; ++l)
+            h->m_key_base[l + 1] = h->m_key_base[l] + km->m_layers[l].m_nb_keys;
+        if (h->m_nb_keys != h->m_key_base[L])
+        {
+            ::free(h->m_presses);
+            h->m_nb_keys = h->m_key_base[L];
+            h->m_presses = (u64*)::malloc(sizeof(u64) * (h->m_nb_keys + 1));
+        }
+        memset(h->m_presses, 0, sizeof(u64) * h->m_key_base[L]);
+        memset(h->m_layer_bytes, 0, sizeof(u64) * L);
+        h->m_max      = 0;
+        h->m_total    = 0;
+        h->m_unmapped = 0;
+        if (corpus.m_pairs == nullptr)
+            return;
+
+        kheatbyte_t bytes[256];
+        for (u32 b = 0; b < 256; ++b)
+            heat_byte(r, b, bytes[b]);
+
+        kreversehit_t shift;
+        bool const    has_shift = reverse_find(r, "KC_LSFT", &shift, 1) == 1 || reverse_find(r, "KC_RSFT", &shift, 1) == 1;
+
+        for (u32 pair = 0; pair < NB_PAIRS; ++pair)
+        {
+            u64 const count = corpus.m_pairs[pair];
+            if (count == 0)
+                continue;
+            kheatbyte_t const& cur = bytes[pair & 0xFF];
+            if (cur.m_layer == CORPUS_BYTE_IGNORED)
+                continue;
+            if (cur.m_layer < 0)
+            {
+                h->m_unmapped += count;
+                continue;
+            }
+
+            h->m_total += count;
+            h->m_layer_bytes[cur.m_layer] += count;
+            heat_press(h, cur.m_layer, cur.m_key, count);
+
+            // the layer and modifiers that are still held from the previous byte
+            kheatbyte_t const& prev       = bytes[pair >> 8];
+            s32 const          prev_layer = prev.m_layer >= 0 ? prev.m_layer : 0;
+            u16 const          prev_mods  = prev.m_layer >= 0 ? prev.m_mods : 0;
+            if (cur.m_layer != prev_layer)
+            {
+                // only the switches after the layer that is already active
+                s32 first = 0;
+                for (s32 s = 0; s < cur.m_nb_steps; ++s)
+                {
+                    if (cur.m_steps[s].m_layer == prev_layer)
+                        first = s;
+                }
+                for (s32 s = first; s < cur.m_nb_steps; ++s)
+                    heat_press(h, cur.m_steps[s].m_layer, cur.m_steps[s].m_key, count);
+            }
+            if ((cur.m_mods & (LSFT | RSFT)) != 0 && (prev_mods & (LSFT | RSFT)) == 0 && has_shift)
+                heat_press(h, shift.m_layer, shift.m_key, count);
+        }
+
+        for (s32 i = 0; i < h->m_nb_keys; ++i)
+        {
+            if (h->m_presses[i] > h->m_max)
+                h->m_max = h->m_presses[i];
+        }
+    }
+
+    s32 heatmap_nb_layers(kheatmap_t* h) { return h->m_nb_layers; }
+
+    s32 heatmap_nb_keys(kheatmap_t* h, s32 layer)
+    {
+        if (layer < 0 || layer >= h->m_nb_layers)
+            return 0;
+        return h->m_key_base[layer + 1] - h->m_key_base[layer];
+    }
+
+    u64 const* heatmap_presses(kheatmap_t* h, s32 layer)
+    {
+        if (layer < 0 || layer >= h->m_nb_layers)
+            return nullptr;
+        return &h->m_presses[h->m_key_base[layer]];
+    }
+
+    u64 heatmap_layer_bytes(kheatmap_t* h, s32 layer)
+    {
+        if (layer < 0 || layer >= h->m_nb_layers)
+            return 0;
+        return h->m_layer_bytes[layer];
+    }
+
+    u64 heatmap_max_presses(kheatmap_t* h) { return h->m_max; }
+    u64 heatmap_total(kheatmap_t* h) { return h->m_total; }
+    u64 heatmap_unmapped(kheatmap_t* h) { return h->m_unmapped; }
+
+} // namespace xcore
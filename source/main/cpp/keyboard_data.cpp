@@ -6,6 +6,8 @@
 #include "xjson/x_json_allocator.h"
 
 #include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_keycode.h"
+#include "qmk-keymap-wiz/keyboard_profile.h"
 
 #include "libimgui/imgui.h"
 
@@ -118,6 +120,30 @@ namespace xcore
         color[3] = (xcore::u8)(c.w * 255.0f);
     }
 
+    void init_arena(karena_t& arena, xcore::u32 main_size, xcore::u32 scratch_size)
+    {
+        arena.m_main_size      = main_size;
+        arena.m_scratch_size   = scratch_size;
+        arena.m_main_memory    = ::malloc(main_size);
+        arena.m_scratch_memory = ::malloc(scratch_size);
+    }
+
+    void exit_arena(karena_t& arena)
+    {
+        if (arena.m_main_memory)
+        {
+            ::free(arena.m_main_memory);
+            arena.m_main_memory = nullptr;
+        }
+        if (arena.m_scratch_memory)
+        {
+            ::free(arena.m_scratch_memory);
+            arena.m_scratch_memory = nullptr;
+        }
+        arena.m_main_size    = 0;
+        arena.m_scratch_size = 0;
+    }
+
     struct skeyboards_t
     {
         skeyboards_t()
@@ -181,12 +207,24 @@ namespace xcore
     {
         stat(s_kbds.filename, &s_kbds.file_state);
 
+        karena_t arena;
+        arena.m_main_memory    = s_kbds.main_allocator_memory;
+        arena.m_main_size      = s_kbds.main_allocator_size;
+        arena.m_scratch_memory = s_kbds.scratch_allocator_memory;
+        arena.m_scratch_size   = s_kbds.scratch_allocator_size;
+        return load_keyboards(s_kbds.filename, arena, kbs);
+    }
+
+    bool load_keyboards(const char* filename, karena_t& arena, ckeyboards_t const*& kbs, char const** _error_message)
+    {
+        kprofilescope_t zone(PROFILE_LOAD_KEYBOARDS);
+
         // load the file fully in memory
         // open the file
-        FILE* f = fopen(s_kbds.filename, "rb");
+        FILE* f = fopen(filename, "rb");
         if (!f)
         {
-            printf("failed to open file %s\n", s_kbds.filename);
+            printf("failed to open file %s\n", filename);
             return false;
         }
 
@@ -196,10 +234,10 @@ namespace xcore
         fseek(f, 0, SEEK_SET);
 
         json::JsonAllocator alloc;
-        alloc.Init(s_kbds.main_allocator_memory, s_kbds.main_allocator_size, "JSON allocator");
+        alloc.Init(arena.m_main_memory, arena.m_main_size, "JSON allocator");
 
         json::JsonAllocator scratch;
-        scratch.Init(s_kbds.scratch_allocator_memory, s_kbds.scratch_allocator_size, "JSON scratch allocator");
+        scratch.Init(arena.m_scratch_memory, arena.m_scratch_size, "JSON scratch allocator");
 
         // allocate the buffer
         char* kbdb_json = scratch.AllocateArray<char>(kbdb_json_len + 1);
@@ -228,6 +266,8 @@ namespace xcore
 
         scratch.Reset();
         kbs = kb;
+        if (_error_message != nullptr)
+            *_error_message = error_message;
         return ok;
     }
 
@@ -266,6 +306,18 @@ namespace xcore
         return false;
     }
 
+    ckeyboard_t const* find_keyboard(ckeyboards_t const* kbs, const char* name)
+    {
+        if (kbs == nullptr || name == nullptr)
+            return nullptr;
+        for (s32 i = 0; i < kbs->m_nb_keyboards; ++i)
+        {
+            if (strcmp(kbs->m_keyboards[i].m_name, name) == 0)
+                return &kbs->m_keyboards[i];
+        }
+        return nullptr;
+    }
+
     // --------------------------------------------------------------------------------------------------------------------------
     // --------------------------------------------------------------------------------------------------------------------------
 
@@ -286,11 +338,21 @@ namespace xcore
         m_layer        = 0;
         copy(m_capcolor, sColorDarkGrey);
         copy(m_ledcolor, sColorBlue);
+        m_code         = 0;
+        m_tap          = 0;
+        m_kc           = KEYCODE_UNCOMPILED;
     }
 
     static const char* enum_mod_strs[] = {"LShift", "RShift", "LCtrl", "RCtrl", "LAlt", "RAlt", "LCmd", "RCmd", "MT", "OSM", nullptr};
     static json::JsonEnumTypeDef json_key_mod_enum("key_mod_enum", sizeof(u16), ALIGNOF(u16), enum_mod_strs);
 
+    const char* key_mod_str(s32 bit)
+    {
+        if (bit < 0 || bit >= (s32)(sizeof(enum_mod_strs) / sizeof(enum_mod_strs[0])))
+            return nullptr;
+        return enum_mod_strs[bit];
+    }
+
     template <> void json::JsonObjectTypeRegisterFields<key_t>(key_t& base, json::JsonFieldDescr*& members, s32& member_count)
     {
         // clang-format off
@@ -340,6 +402,7 @@ namespace xcore
     {
         // clang-format off
         static json::JsonFieldDescr s_members[] = {
+            json::JsonFieldDescr("name", base.m_name),
             json::JsonFieldDescr("layers", base.m_layers, base.m_nb_layers, json_layer),
         };
         // clang-format on
@@ -391,22 +454,110 @@ namespace xcore
     }
     static json::JsonObjectTypeDeclr<keycodes_t> json_keycodes("keycodes");
 
-    keycode_t const* find_keycode(keycodes_t const* keycodesDB, const char* keycode_str)
+    static u32 hash_keycode_name(const char* name, s32 len)
     {
-        if (keycodesDB != nullptr)
+        u32 hash = 2166136261u;
+        for (s32 i = 0; i < len; ++i)
+            hash = (hash ^ (u8)name[i]) * 16777619u;
+        return hash;
+    }
+
+    static bool same_keycode_name(const char* a, const char* b, s32 len) { return strncmp(a, b, len) == 0 && a[len] == 0; }
+
+    s32 lookup_keycode_index(keycodes_t const* keycodesDB, const char* name, s32 len)
+    {
+        if (keycodesDB == nullptr || name == nullptr)
+            return -1;
+
+        if (keycodesDB->m_slots != nullptr)
         {
-            for (s32 i = 0; i < keycodesDB->m_nb_keycodes; ++i)
+            u32 const mask = (u32)keycodesDB->m_nb_slots - 1;
+            for (u32 slot = hash_keycode_name(name, len) & mask;; slot = (slot + 1) & mask)
             {
-                keycode_t const* keycode = &keycodesDB->m_keycodes[i];
-                if (strcmp(keycode->m_code, keycode_str) == 0)
-                    return keycode;
-                for (s32 j = 0; j < keycode->m_nb_codes; ++j)
+                keycodeslot_t const& s = keycodesDB->m_slots[slot];
+                if (s.m_name == nullptr)
+                    return -1;
+                if (same_keycode_name(s.m_name, name, len))
+                    return s.m_index;
+            }
+        }
+
+        // no index (a database that was not loaded from file), search all of them
+        for (s32 i = 0; i < keycodesDB->m_nb_keycodes; ++i)
+        {
+            keycode_t const* keycode = &keycodesDB->m_keycodes[i];
+            if (keycode->m_code != nullptr && same_keycode_name(keycode->m_code, name, len))
+                return i;
+            for (s32 j = 0; j < keycode->m_nb_codes; ++j)
+            {
+                if (same_keycode_name(keycode->m_codes[j], name, len))
+                    return i;
+            }
+        }
+        return -1;
+    }
+
+    keycode_t const* lookup_keycode(keycodes_t const* keycodesDB, const char* keycode_str)
+    {
+        if (keycode_str == nullptr)
+            return nullptr;
+        s32 const index = lookup_keycode_index(keycodesDB, keycode_str, (s32)strlen(keycode_str));
+        return index >= 0 ? &keycodesDB->m_keycodes[index] : nullptr;
+    }
+
+    // The first keycode that uses a name wins, the same as the linear search did
+    static void index_keycodes(keycodes_t* kcds, json::JsonAllocator& alloc)
+    {
+        s32 nb_names = 0;
+        for (s32 i = 0; i < kcds->m_nb_keycodes; ++i)
+            nb_names += 1 + kcds->m_keycodes[i].m_nb_codes;
+
+        s32 nb_slots = 16;
+        while (nb_slots < nb_names * 2)
+            nb_slots *= 2;
+
+        keycodeslot_t* slots  = alloc.AllocateArray<keycodeslot_t>(nb_slots);
+        u16*           values = alloc.AllocateArray<u16>(kcds->m_nb_keycodes > 0 ? kcds->m_nb_keycodes : 1);
+        if (slots == nullptr || values == nullptr)
+            return;
+        for (s32 i = 0; i < nb_slots; ++i)
+        {
+            slots[i].m_name  = nullptr;
+            slots[i].m_index = -1;
+        }
+
+        u32 const mask = (u32)nb_slots - 1;
+        for (s32 i = 0; i < kcds->m_nb_keycodes; ++i)
+        {
+            keycode_t const& keycode = kcds->m_keycodes[i];
+            for (s32 j = -1; j < keycode.m_nb_codes; ++j)
+            {
+                const char* name = j < 0 ? keycode.m_code : keycode.m_codes[j];
+                if (name == nullptr)
+                    continue;
+                s32 const len  = (s32)strlen(name);
+                u32       slot = hash_keycode_name(name, len) & mask;
+                while (slots[slot].m_name != nullptr && strcmp(slots[slot].m_name, name) != 0)
+                    slot = (slot + 1) & mask;
+                if (slots[slot].m_name == nullptr)
                 {
-                    if (strcmp(keycode->m_codes[j], keycode_str) == 0)
-                        return keycode;
+                    slots[slot].m_name  = name;
+                    slots[slot].m_index = i;
                 }
             }
         }
+
+        kcds->m_nb_slots = nb_slots;
+        kcds->m_slots    = slots;
+        keycode_values(kcds, values);
+        kcds->m_values = values;
+    }
+
+    keycode_t const* find_keycode(keycodes_t const* keycodesDB, const char* keycode_str)
+    {
+        keycode_t const* keycode = lookup_keycode(keycodesDB, keycode_str);
+        if (keycode != nullptr)
+            return keycode;
         return &keycodesDB->m_keycodes[0];
     }
 
@@ -417,6 +568,8 @@ namespace xcore
             , main_allocator_size(4 * 1024 * 1024)
             , scratch_allocator_size(4 * 1024 * 1024)
         {
+            main1_allocator_memory   = nullptr;
+            main2_allocator_memory   = nullptr;
             scratch_allocator_memory = nullptr;
             main_allocator_memory    = nullptr;
         }
@@ -424,6 +577,8 @@ namespace xcore
         const char* const filename;
         xcore::u32 const  main_allocator_size;
         xcore::u32 const  scratch_allocator_size;
+        void*             main1_allocator_memory;
+        void*             main2_allocator_memory;
         void*             scratch_allocator_memory;
         void*             main_allocator_memory;
 
@@ -439,17 +594,25 @@ namespace xcore
         //
         s_kcdb.last_file_poll = time(nullptr);
 
-        s_kcdb.main_allocator_memory    = ::malloc(s_kcdb.main_allocator_size);
+        s_kcdb.main1_allocator_memory   = ::malloc(s_kcdb.main_allocator_size);
+        s_kcdb.main2_allocator_memory   = ::malloc(s_kcdb.main_allocator_size);
         s_kcdb.scratch_allocator_memory = ::malloc(s_kcdb.scratch_allocator_size);
+        s_kcdb.main_allocator_memory    = s_kcdb.main1_allocator_memory;
     }
 
     void exit_keycodes()
     {
-        if (s_kcdb.main_allocator_memory)
+        if (s_kcdb.main1_allocator_memory)
+        {
+            ::free(s_kcdb.main1_allocator_memory);
+            s_kcdb.main1_allocator_memory = nullptr;
+        }
+        if (s_kcdb.main2_allocator_memory)
         {
-            ::free(s_kcdb.main_allocator_memory);
-            s_kcdb.main_allocator_memory = nullptr;
+            ::free(s_kcdb.main2_allocator_memory);
+            s_kcdb.main2_allocator_memory = nullptr;
         }
+        s_kcdb.main_allocator_memory = nullptr;
         if (s_kcdb.scratch_allocator_memory)
         {
             ::free(s_kcdb.scratch_allocator_memory);
@@ -459,6 +622,7 @@ namespace xcore
 
     bool load_keycodes(keycodes_t const*& _kcds)
     {
+        kprofilescope_t zone(PROFILE_LOAD_KEYCODES);
         stat(s_kcdb.filename, &s_kcdb.file_state);
 
         // load the file fully in memory
@@ -505,12 +669,50 @@ namespace xcore
 
         char const* error_message = nullptr;
         bool        ok            = json::JsonDecode((const char*)kcds_json, (const char*)kcds_json + kcds_json_len, json_root, &alloc, &scratch, error_message);
+        if (ok)
+            index_keycodes(kcds, alloc);
 
         scratch.Reset();
         _kcds = kcds;
         return ok;
     }
 
+    bool reload_keycodes(keycodes_t const*& _kcds)
+    {
+        // only check every second on the clock if the file has changed, the previous database stays valid until the
+        // next reload since the two main allocators are used in turn
+        time_t now = time(nullptr);
+        if (now - s_kcdb.last_file_poll > 1)
+        {
+            struct stat kcdb_file_state_updated;
+            if (stat(s_kcdb.filename, &kcdb_file_state_updated) == 0)
+            {
+                if (kcdb_file_state_updated.st_mtime > s_kcdb.file_state.st_mtime)
+                {
+                    if (s_kcdb.main_allocator_memory == s_kcdb.main1_allocator_memory)
+                    {
+                        s_kcdb.main_allocator_memory = s_kcdb.main2_allocator_memory;
+                    }
+                    else
+                    {
+                        s_kcdb.main_allocator_memory = s_kcdb.main1_allocator_memory;
+                    }
+
+                    s_kcdb.file_state = kcdb_file_state_updated;
+
+                    keycodes_t const* kcds_reloaded = nullptr;
+                    if (load_keycodes(kcds_reloaded))
+                    {
+                        _kcds = kcds_reloaded;
+                        return true;
+                    }
+                }
+            }
+            s_kcdb.last_file_poll = time(nullptr);
+        }
+        return false;
+    }
+
     struct skeymaps_t
     {
         skeymaps_t()
@@ -558,16 +760,29 @@ namespace xcore
         }
     }
 
+    const char* keymaps_filename() { return s_keymaps.filename; }
+
     bool load_keymaps(keymaps_t const*& _keymaps)
     {
         stat(s_keymaps.filename, &s_keymaps.file_state);
 
+        karena_t arena;
+        arena.m_main_memory    = s_keymaps.main_allocator_memory;
+        arena.m_main_size      = s_keymaps.main_allocator_size;
+        arena.m_scratch_memory = s_keymaps.scratch_allocator_memory;
+        arena.m_scratch_size   = s_keymaps.scratch_allocator_size;
+        return load_keymaps(s_keymaps.filename, arena, _keymaps);
+    }
+
+    bool load_keymaps(const char* filename, karena_t& arena, keymaps_t const*& _keymaps, char const** _error_message)
+    {
+        kprofilescope_t zone(PROFILE_LOAD_KEYMAPS);
         // load the file fully in memory
         // open the file
-        FILE* f = fopen(s_keymaps.filename, "rb");
+        FILE* f = fopen(filename, "rb");
         if (!f)
         {
-            printf("failed to open file %s\n", s_keymaps.filename);
+            printf("failed to open file %s\n", filename);
             return false;
         }
 
@@ -577,10 +792,10 @@ namespace xcore
         fseek(f, 0, SEEK_SET);
 
         json::JsonAllocator alloc;
-        alloc.Init(s_keymaps.main_allocator_memory, s_keymaps.main_allocator_size, "JSON allocator");
+        alloc.Init(arena.m_main_memory, arena.m_main_size, "JSON allocator");
 
         json::JsonAllocator scratch;
-        scratch.Init(s_keymaps.scratch_allocator_memory, s_keymaps.scratch_allocator_size, "JSON scratch allocator");
+        scratch.Init(arena.m_scratch_memory, arena.m_scratch_size, "JSON scratch allocator");
 
         // allocate the buffer
         char* kcds_json = scratch.AllocateArray<char>(kcds_json_len + 1);
@@ -609,9 +824,53 @@ namespace xcore
 
         scratch.Reset();
         _keymaps = keymaps;
+        if (_error_message != nullptr)
+            *_error_message = error_message;
         return ok;
     }
 
+    s32 find_layer(keymap_t const* km, const char* name)
+    {
+        if (km == nullptr || name == nullptr)
+            return -1;
+        for (s32 i = 0; i < km->m_nb_layers; ++i)
+        {
+            if (strcmp(km->m_layers[i].m_name, name) == 0)
+                return i;
+        }
+        return -1;
+    }
+
+    bool is_transparent_keycode(const char* keycode)
+    {
+        if (keycode == nullptr)
+            return false;
+        return strcmp(keycode, "KC_TRNS") == 0 || strcmp(keycode, "KC_TRANS") == 0 || strcmp(keycode, "KC_TRANSPARENT") == 0 || strcmp(keycode, "_______") == 0;
+    }
+
+    // the spellings of KC_NO and KC_TRNS, a blank key remembers which one it had so that saving writes it back as is
+    static const char* s_blank_keycodes[] = {"KC_NO", "XXXXXXX", "KC_TRNS", "KC_TRANS", "KC_TRANSPARENT", "_______"};
+
+    s32 blank_kind(key_t const& key)
+    {
+        if (key.m_keycode_str == nullptr || key.m_mod != 0 || key.m_mod_tap || key.m_layer_switch != 0 || key.m_layer != nullptr)
+            return -1;
+        if (memcmp(key.m_capcolor, sColorDarkGrey, 4) != 0 || memcmp(key.m_ledcolor, sColorBlue, 4) != 0)
+            return -1;
+        for (s32 i = 0; i < (s32)(sizeof(s_blank_keycodes) / sizeof(s_blank_keycodes[0])); ++i)
+        {
+            if (strcmp(key.m_keycode_str, s_blank_keycodes[i]) == 0)
+                return i;
+        }
+        return -1;
+    }
+
+    void blank_key(s32 kind, key_t& key)
+    {
+        new (&key) key_t();
+        key.m_keycode_str = s_blank_keycodes[kind];
+    }
+
 } // namespace xcore
 
 using namespace xcore;
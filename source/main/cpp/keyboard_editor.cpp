@@ -0,0 +1,984 @@
+#include "xbase/x_target.h"
+
+#include "qmk-keymap-wiz/keyboard_editor.h"
+#include "qmk-keymap-wiz/keyboard_layout.h"
+
+#include "libimgui/imgui.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace xcore;
+
+// every change of the keymaps, by an edit or by undo/redo, is journaled, marks its layer dirty for the saver,
+// re-validates the key it touched and updates the layer graph, the composed layers and the reverse index
+static void on_edit(kedit_t const& edit, void* user)
+{
+    keditor_t*       editor  = (keditor_t*)user;
+    keymaps_t const* keymaps = model_keymaps(editor->m_model);
+    journal_append(editor->m_journal, edit);
+    saver_mark_dirty(editor->m_saver, edit.m_keymap, edit.m_layer);
+    validator_update(editor->m_validator, keymaps, edit);
+    if (edit.m_keymap >= 0 && edit.m_keymap < editor->m_nb_graphs)
+    {
+        graph_update(editor->m_graphs[edit.m_keymap], &keymaps->m_keymaps[edit.m_keymap], edit);
+        compose_update(editor->m_composes[edit.m_keymap], &keymaps->m_keymaps[edit.m_keymap], edit);
+        if (reverse_update(editor->m_reverses[edit.m_keymap], &keymaps->m_keymaps[edit.m_keymap], edit) && edit.m_keymap == 0)
+            editor->m_find_dirty = true;
+        if (edit.m_keymap == 0)
+        {
+            editor->m_heatmap_dirty   = true;
+            editor->m_optimizer_stale = editor->m_optimizer != nullptr;
+            editor->m_sim_stale       = editor->m_sim != nullptr;
+            editor->m_rgb_dirty       = true;
+        }
+    }
+}
+
+void keyboard_editor_init(keditor_t& editor, const char* filename, keymaps_t const* keymaps, keycodes_t const* kcdb, ckeyboards_t const* kbdb)
+{
+    editor.m_saver   = saver_create(filename);
+    editor.m_journal = journal_open(filename);
+
+    // the keymaps are still private to the caller, the journal is replayed in place before the model copies them
+    journal_replay(editor.m_journal, const_cast<keymaps_t*>(keymaps));
+    editor.m_model = model_create(keymaps);
+    model_compile(editor.m_model, kcdb);
+
+    editor.m_validator = validator_create(kcdb, kbdb);
+    validator_run(editor.m_validator, model_keymaps(editor.m_model));
+
+    keymaps_t const* current = model_keymaps(editor.m_model);
+    editor.m_nb_graphs       = current->m_nb_keymaps;
+    editor.m_graphs          = (kgraph_t**)::malloc(sizeof(kgraph_t*) * (current->m_nb_keymaps + 1));
+    editor.m_composes        = (kcompose_t**)::malloc(sizeof(kcompose_t*) * (current->m_nb_keymaps + 1));
+    editor.m_reverses        = (kreverse_t**)::malloc(sizeof(kreverse_t*) * (current->m_nb_keymaps + 1));
+    for (s32 k = 0; k < current->m_nb_keymaps; ++k)
+    {
+        editor.m_graphs[k] = graph_create();
+        graph_build(editor.m_graphs[k], &current->m_keymaps[k]);
+        editor.m_composes[k] = compose_create();
+        compose_build(editor.m_composes[k], kcdb, &current->m_keymaps[k]);
+        editor.m_reverses[k] = reverse_create();
+        reverse_build(editor.m_reverses[k], kcdb, &current->m_keymaps[k]);
+    }
+    editor.m_show_graph    = false;
+    editor.m_show_composed = false;
+    editor.m_find[0]       = 0;
+    editor.m_find_dirty    = false;
+    editor.m_nb_found      = 0;
+
+    snprintf(editor.m_corpus_path, sizeof(editor.m_corpus_path), "%s", "corpus.txt");
+    editor.m_corpus        = kcorpus_t();
+    editor.m_heatmap       = heatmap_create();
+    editor.m_heatmap_dirty = false;
+    editor.m_show_heatmap  = false;
+
+    editor.m_optimizer       = nullptr;
+    editor.m_optimize_layers = 1;
+    editor.m_optimizer_stale = false;
+    editor.m_show_candidate  = false;
+
+    editor.m_sim        = nullptr;
+    editor.m_sim_params = ksimparams_t();
+    editor.m_simulate   = false;
+    editor.m_sim_stale  = false;
+    editor.m_sim_start  = 0.0;
+    editor.m_sim_key    = -1;
+    editor.m_sim_layer  = -1;
+
+    editor.m_rgb        = nullptr;
+    editor.m_rgb_params = krgbparams_t();
+    editor.m_show_rgb   = false;
+    editor.m_rgb_dirty  = false;
+    editor.m_rgb_layer  = -1;
+
+    editor.m_workspace = nullptr;
+    editor.m_entry     = -1;
+    editor.m_open      = -1;
+
+    editor.m_search = search_create();
+    search_build(editor.m_search, kcdb);
+    editor.m_nb_strings  = 0;
+    editor.m_max_strings = 0;
+    editor.m_strings     = nullptr;
+
+    editor.m_keymap     = 0;
+    editor.m_layer      = -1;
+    editor.m_key        = -1;
+    editor.m_open_popup = false;
+    editor.m_keycode[0] = 0;
+    editor.m_nb_hits    = 0;
+    for (s32 i = 0; i < 2; ++i)
+        editor.m_color_active[i] = false;
+}
+
+void keyboard_editor_exit(keditor_t& editor)
+{
+    optimizer_destroy(editor.m_optimizer);
+    editor.m_optimizer = nullptr;
+    sim_destroy(editor.m_sim);
+    editor.m_sim = nullptr;
+    rgb_destroy(editor.m_rgb);
+    editor.m_rgb = nullptr;
+    journal_close(editor.m_journal);
+    saver_destroy(editor.m_saver);
+    model_destroy(editor.m_model);
+    validator_destroy(editor.m_validator);
+    for (s32 k = 0; k < editor.m_nb_graphs; ++k)
+    {
+        graph_destroy(editor.m_graphs[k]);
+        compose_destroy(editor.m_composes[k]);
+        reverse_destroy(editor.m_reverses[k]);
+    }
+    ::free(editor.m_graphs);
+    ::free(editor.m_composes);
+    ::free(editor.m_reverses);
+    corpus_release(editor.m_corpus);
+    heatmap_destroy(editor.m_heatmap);
+    search_destroy(editor.m_search);
+    for (s32 i = 0; i < editor.m_nb_strings; ++i)
+        ::free(editor.m_strings[i]);
+    ::free(editor.m_strings);
+    editor.m_journal   = nullptr;
+    editor.m_saver     = nullptr;
+    editor.m_model     = nullptr;
+    editor.m_validator = nullptr;
+    editor.m_graphs    = nullptr;
+    editor.m_composes  = nullptr;
+    editor.m_reverses  = nullptr;
+    editor.m_heatmap   = nullptr;
+    editor.m_nb_graphs = 0;
+    editor.m_search    = nullptr;
+    editor.m_strings   = nullptr;
+
+    // the journal was replayed into the decoded keymaps and the saver may have written the file since, the next
+    // open decodes the file again
+    if (editor.m_workspace != nullptr)
+    {
+        workspace_release(editor.m_workspace, editor.m_entry);
+        workspace_evict(editor.m_workspace, editor.m_entry);
+        editor.m_workspace = nullptr;
+        editor.m_entry     = -1;
+    }
+}
+
+bool keyboard_editor_open(keditor_t& editor, kworkspace_t* ws, s32 entry, keycodes_t const* kcdb, ckeyboards_t const* kbdb)
+{
+    keymaps_t const* keymaps = workspace_acquire(ws, entry);
+    if (keymaps == nullptr)
+        return false;
+
+    keyboard_editor_init(editor, workspace_entry(ws, entry)->m_filename, keymaps, kcdb, kbdb);
+    editor.m_workspace = ws;
+    editor.m_entry     = entry;
+    return true;
+}
+
+void keyboard_editor_workspace(keditor_t& editor, float height)
+{
+    kworkspace_t* ws = editor.m_workspace;
+    if (ws == nullptr)
+        return;
+
+    s32 const nb_entries = workspace_nb_entries(ws);
+    ImGui::Text("Keymaps: %d files, %.1f of %.1f MB decoded", nb_entries, (double)workspace_memory(ws) / (1024.0 * 1024.0), (double)workspace_budget(ws) / (1024.0 * 1024.0));
+    if (nb_entries == 0 || !ImGui::BeginListBox("##workspace", ImVec2(-1.0f, height)))
+        return;
+
+    ImGuiListClipper clipper;
+    clipper.Begin(nb_entries);
+    while (clipper.Step())
+    {
+        for (s32 i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
+        {
+            kworkspaceentry_t const* e = workspace_entry(ws, i);
+
+            // '*' marks the files that are in memory, they open without decoding
+            char line[256];
+            if (e->m_failed)
+                snprintf(line, sizeof(line), "  %s: not a keymaps file", e->m_filename);
+            else
+                snprintf(line, sizeof(line), "%c %s: %s, %d layers", e->m_memory > 0 ? '*' : ' ', e->m_name, e->m_keyboard, e->m_nb_layers);
+
+            ImGui::PushID(i);
+            if (ImGui::Selectable(line, i == editor.m_entry, e->m_failed ? ImGuiSelectableFlags_Disabled : 0) && i != editor.m_entry)
+                editor.m_open = i;
+            ImGui::PopID();
+        }
+    }
+    ImGui::EndListBox();
+}
+
+bool keyboard_editor_switch(keditor_t& editor, keycodes_t const* kcdb, ckeyboards_t const* kbdb)
+{
+    s32 const next = editor.m_open;
+    editor.m_open  = -1;
+    if (editor.m_workspace == nullptr || next < 0 || next == editor.m_entry)
+        return false;
+
+    // the next file is decoded before the open one is closed, a file that does not decode leaves the editor as it is
+    kworkspace_t*    ws      = editor.m_workspace;
+    keymaps_t const* keymaps = workspace_acquire(ws, next);
+    if (keymaps == nullptr)
+        return false;
+
+    keyboard_editor_exit(editor);
+    keyboard_editor_init(editor, workspace_entry(ws, next)->m_filename, keymaps, kcdb, kbdb);
+    editor.m_workspace = ws;
+    editor.m_entry     = next;
+    return true;
+}
+
+void keyboard_editor_databases(keditor_t& editor, keycodes_t const* kcdb, ckeyboards_t const* kbdb)
+{
+    // only the keycodes that changed are indexed again
+    search_build(editor.m_search, kcdb);
+    editor.m_nb_hits = 0;
+
+    // the compiled keys hold indices into the previous database, and so do the composed layers
+    model_compile(editor.m_model, kcdb);
+    keymaps_t const* current = model_keymaps(editor.m_model);
+    for (s32 k = 0; k < editor.m_nb_graphs; ++k)
+    {
+        compose_build(editor.m_composes[k], kcdb, &current->m_keymaps[k]);
+        reverse_build(editor.m_reverses[k], kcdb, &current->m_keymaps[k]);
+    }
+    editor.m_find_dirty      = true;
+    editor.m_heatmap_dirty   = true;
+    editor.m_optimizer_stale = editor.m_optimizer != nullptr;
+    editor.m_sim_stale       = editor.m_sim != nullptr;
+    editor.m_rgb_dirty       = true;
+
+    validator_destroy(editor.m_validator);
+    editor.m_validator = validator_create(kcdb, kbdb);
+    validator_run(editor.m_validator, model_keymaps(editor.m_model));
+}
+
+// a copy of 'str' that lives as long as the editor, edits (and the undo history) reference it
+static const char* intern(keditor_t& editor, const char* str)
+{
+    for (s32 i = 0; i < editor.m_nb_strings; ++i)
+    {
+        if (strcmp(editor.m_strings[i], str) == 0)
+            return editor.m_strings[i];
+    }
+    if (editor.m_nb_strings == editor.m_max_strings)
+    {
+        editor.m_max_strings = editor.m_max_strings == 0 ? 64 : editor.m_max_strings * 2;
+        editor.m_strings     = (char**)::realloc(editor.m_strings, sizeof(char*) * editor.m_max_strings);
+    }
+    s32 const len = (s32)strlen(str);
+    char*     dup = (char*)::malloc(len + 1);
+    memcpy(dup, str, len + 1);
+    editor.m_strings[editor.m_nb_strings++] = dup;
+    return dup;
+}
+
+keymaps_t const* keyboard_editor_keymaps(keditor_t& editor) { return model_keymaps(editor.m_model); }
+
+bool keyboard_editor_apply(keditor_t& editor, kedit_t const& edit) { return model_apply(editor.m_model, edit, on_edit, &editor); }
+bool keyboard_editor_undo(keditor_t& editor) { return model_undo(editor.m_model, on_edit, &editor); }
+bool keyboard_editor_redo(keditor_t& editor) { return model_redo(editor.m_model, on_edit, &editor); }
+
+// a new simulator on the current first keymap, all keys up and the first layer active, or none when not simulating
+static void simulate_create(keditor_t& editor)
+{
+    sim_destroy(editor.m_sim);
+    editor.m_sim       = nullptr;
+    editor.m_sim_stale = false;
+    editor.m_sim_start = ImGui::GetTime();
+    editor.m_sim_key   = -1;
+    editor.m_sim_layer = -1;
+    if (editor.m_simulate && editor.m_nb_graphs > 0)
+        editor.m_sim = sim_create(&model_keymaps(editor.m_model)->m_keymaps[0], editor.m_sim_params);
+}
+
+static u32 simulate_time(keditor_t& editor) { return (u32)((ImGui::GetTime() - editor.m_sim_start) * 1000.0); }
+
+static void simulate_event(keditor_t& editor, s32 key, bool down)
+{
+    ksimevent_t e;
+    e.m_time = simulate_time(editor);
+    e.m_key  = (s16)key;
+    e.m_down = down ? 1 : 0;
+    e.m_pad  = 0;
+    sim_run(editor.m_sim, &e, 1, nullptr, 0);
+}
+
+void keyboard_editor_update(keditor_t& editor)
+{
+    ImGuiIO& io = ImGui::GetIO();
+    if (io.KeyCtrl && !io.WantTextInput)
+    {
+        if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Z)))
+        {
+            if (io.KeyShift)
+                keyboard_editor_redo(editor);
+            else
+                keyboard_editor_undo(editor);
+        }
+        else if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Y)))
+        {
+            keyboard_editor_redo(editor);
+        }
+    }
+
+    journal_update(editor.m_journal, editor.m_saver, model_keymaps(editor.m_model));
+
+    // the corpus is already reduced to byte pairs, this is cheap enough to do right after every edit
+    if (editor.m_heatmap_dirty && editor.m_corpus.m_pairs != nullptr && editor.m_nb_graphs > 0)
+    {
+        heatmap_compute(editor.m_heatmap, editor.m_corpus, editor.m_reverses[0], &model_keymaps(editor.m_model)->m_keymaps[0]);
+        editor.m_heatmap_dirty = false;
+    }
+
+    // the optimizer searches on a copy of the keymap before the edit, its layouts no longer apply
+    if (editor.m_optimizer_stale)
+    {
+        optimizer_destroy(editor.m_optimizer);
+        editor.m_optimizer       = nullptr;
+        editor.m_optimizer_stale = false;
+    }
+
+    // the simulator holds a copy of the compiled keys, the key the mouse held is released by the new one
+    if (editor.m_sim_stale)
+        simulate_create(editor);
+    if (editor.m_sim != nullptr)
+    {
+        if (editor.m_sim_key >= 0 && !ImGui::IsMouseDown(ImGuiMouseButton_Left))
+        {
+            simulate_event(editor, editor.m_sim_key, false);
+            editor.m_sim_key = -1;
+        }
+        sim_tick(editor.m_sim, simulate_time(editor), nullptr, 0);
+    }
+}
+
+void keyboard_editor_toolbar(keditor_t& editor)
+{
+    kmodel_stats_t stats;
+    model_stats(editor.m_model, stats);
+
+    if (ImGui::Button("Undo") && model_can_undo(editor.m_model))
+        keyboard_editor_undo(editor);
+    ImGui::SameLine();
+    if (ImGui::Button("Redo") && model_can_redo(editor.m_model))
+        keyboard_editor_redo(editor);
+    ImGui::SameLine();
+    ImGui::Text("%d/%d (%.1f KB)", stats.m_current, stats.m_nb_snapshots - 1, (float)stats.m_nb_bytes / 1024.0f);
+    ImGui::SameLine();
+    ImGui::Checkbox("layer graph", &editor.m_show_graph);
+    ImGui::SameLine();
+    ImGui::Checkbox("resolve transparent", &editor.m_show_composed);
+
+    ImGui::SetNextItemWidth(240.0f);
+    ImGui::InputText("##corpus", editor.m_corpus_path, sizeof(editor.m_corpus_path));
+    ImGui::SameLine();
+    if (ImGui::Button("Load corpus") && corpus_load(editor.m_corpus_path, editor.m_corpus))
+    {
+        editor.m_heatmap_dirty = true;
+        editor.m_show_heatmap  = true;
+    }
+    if (editor.m_corpus.m_pairs != nullptr)
+    {
+        ImGui::SameLine();
+        ImGui::Checkbox("heatmap", &editor.m_show_heatmap);
+        ImGui::SameLine();
+        ImGui::Text("%.1f MB in %.0f ms, %.1f%% unmapped", (float)editor.m_corpus.m_nb_bytes / (1024.0f * 1024.0f), editor.m_corpus.m_seconds * 1000.0,
+                    editor.m_corpus.m_nb_bytes > 0 ? 100.0 * (double)heatmap_unmapped(editor.m_heatmap) / (double)editor.m_corpus.m_nb_bytes : 0.0);
+    }
+}
+
+void keyboard_editor_select(keditor_t& editor, s32 keymap, s32 layer, s32 key)
+{
+    keymaps_t const* keymaps = model_keymaps(editor.m_model);
+    if (keymap < 0 || keymap >= keymaps->m_nb_keymaps)
+        return;
+    keymap_t const& km = keymaps->m_keymaps[keymap];
+    if (layer < 0 || layer >= km.m_nb_layers || key < 0 || key >= km.m_layers[layer].m_nb_keys)
+        return;
+
+    editor.m_keymap     = keymap;
+    editor.m_layer      = layer;
+    editor.m_key        = key;
+    editor.m_open_popup = true;
+    snprintf(editor.m_keycode, sizeof(editor.m_keycode), "%s", km.m_layers[layer].m_keys[key].m_keycode_str);
+    editor.m_nb_hits = search_keycodes(editor.m_search, editor.m_keycode, editor.m_hits, 12);
+}
+
+static void color_edit(keditor_t& editor, const char* label, s32 which, s32 op, u8 const* color)
+{
+    // while the user is dragging the edited color lives in the editor, it becomes an edit when the user is done
+    // instead of one edit (and undo step) for every frame of dragging
+    float* rgba = editor.m_color[which];
+    if (!editor.m_color_active[which])
+    {
+        for (s32 i = 0; i < 4; ++i)
+            rgba[i] = (float)color[i] / 255.0f;
+    }
+    bool const changed           = ImGui::ColorEdit4(label, rgba);
+    editor.m_color_active[which] = ImGui::IsItemActive();
+
+    if (ImGui::IsItemDeactivatedAfterEdit() || (changed && !editor.m_color_active[which]))
+    {
+        kedit_t edit;
+        edit.m_op     = op;
+        edit.m_keymap = editor.m_keymap;
+        edit.m_layer  = editor.m_layer;
+        edit.m_key    = editor.m_key;
+        for (s32 i = 0; i < 4; ++i)
+            edit.m_color[i] = (u8)(rgba[i] * 255.0f + 0.5f);
+        keyboard_editor_apply(editor, edit);
+    }
+}
+
+void keyboard_editor_popup(keditor_t& editor, keycodes_t const* kcdb)
+{
+    if (editor.m_open_popup)
+    {
+        ImGui::OpenPopup("Key Properties");
+        editor.m_open_popup = false;
+    }
+
+    if (!ImGui::BeginPopupModal("Key Properties", NULL, ImGuiWindowFlags_AlwaysAutoResize))
+        return;
+
+    keymaps_t const*    keymaps = model_keymaps(editor.m_model);
+    layer_t const&      layer   = keymaps->m_keymaps[editor.m_keymap].m_layers[editor.m_layer];
+    xcore::key_t const& key     = layer.m_keys[editor.m_key];
+
+    ImGui::Text("Layer: %s, key: %d", layer.m_name, editor.m_key);
+    ImGui::Separator();
+
+    kedit_t edit;
+    edit.m_keymap = editor.m_keymap;
+    edit.m_layer  = editor.m_layer;
+    edit.m_key    = editor.m_key;
+
+    // every change of the text searches the keycode database, only keycodes from the database are accepted, either
+    // by typing one (and pressing enter) or by picking one of the matches
+    keycode_t const* picked = nullptr;
+    if (ImGui::InputText("keycode", editor.m_keycode, sizeof(editor.m_keycode), ImGuiInputTextFlags_CharsUppercase))
+        editor.m_nb_hits = search_keycodes(editor.m_search, editor.m_keycode, editor.m_hits, 12);
+    if (ImGui::IsItemDeactivatedAfterEdit())
+        picked = lookup_keycode(kcdb, editor.m_keycode);
+    if (lookup_keycode(kcdb, editor.m_keycode) == nullptr)
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "unknown keycode");
+
+    if (editor.m_nb_hits > 0 && ImGui::BeginListBox("##matches", ImVec2(-1.0f, 6.0f * ImGui::GetTextLineHeightWithSpacing())))
+    {
+        for (s32 i = 0; i < editor.m_nb_hits; ++i)
+        {
+            keycode_t const* kc = editor.m_hits[i].m_keycode;
+            char             line[160];
+            snprintf(line, sizeof(line), "%-16s %s", kc->m_code, kc->m_descr != nullptr ? kc->m_descr : "");
+            ImGui::PushID(i);
+            if (ImGui::Selectable(line, strcmp(kc->m_code, key.m_keycode_str) == 0))
+                picked = kc;
+            ImGui::PopID();
+        }
+        ImGui::EndListBox();
+    }
+
+    if (picked != nullptr)
+    {
+        snprintf(editor.m_keycode, sizeof(editor.m_keycode), "%s", picked->m_code);
+        edit.m_op  = EDIT_KEYCODE;
+        edit.m_str = intern(editor, picked->m_code);
+        keyboard_editor_apply(editor, edit);
+    }
+
+    int mods = key.m_mod;
+    for (s32 bit = 0; key_mod_str(bit) != nullptr; ++bit)
+    {
+        if ((bit % 4) != 0)
+            ImGui::SameLine();
+        ImGui::CheckboxFlags(key_mod_str(bit), &mods, 1 << bit);
+    }
+    if (mods != key.m_mod)
+    {
+        edit.m_op    = EDIT_MOD;
+        edit.m_value = (u32)mods;
+        keyboard_editor_apply(editor, edit);
+    }
+
+    color_edit(editor, "cap color", 0, EDIT_KEY_CAPCOLOR, key.m_capcolor);
+    color_edit(editor, "led color", 1, EDIT_KEY_LEDCOLOR, key.m_ledcolor);
+
+    ImGui::Separator();
+    if (ImGui::Button("Close"))
+        ImGui::CloseCurrentPopup();
+    ImGui::EndPopup();
+}
+
+void keyboard_editor_diagnostics(keditor_t& editor, float height)
+{
+    s32 const       nb_diags = validator_nb_diags(editor.m_validator);
+    kvdiag_t const* diags    = validator_diags(editor.m_validator);
+
+    ImGui::Text("Diagnostics: %d", nb_diags);
+    if (nb_diags == 0 || !ImGui::BeginListBox("##diagnostics", ImVec2(-1.0f, height)))
+        return;
+
+    keymaps_t const* keymaps = model_keymaps(editor.m_model);
+
+    // only the visible rows are formatted
+    ImGuiListClipper clipper;
+    clipper.Begin(nb_diags);
+    while (clipper.Step())
+    {
+        for (s32 i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
+        {
+            kdiag_t const&  d  = diags[i].m_diag;
+            keymap_t const& km = keymaps->m_keymaps[diags[i].m_keymap];
+
+            char line[256];
+            if (d.m_layer < 0)
+                snprintf(line, sizeof(line), "%s: %s", diag_name(d.m_code), d.m_detail);
+            else if (d.m_key < 0)
+                snprintf(line, sizeof(line), "%s: %s", diag_name(d.m_code), km.m_layers[d.m_layer].m_name);
+            else
+                snprintf(line, sizeof(line), "%s: %s, key %d '%s'", diag_name(d.m_code), km.m_layers[d.m_layer].m_name, d.m_key, d.m_detail);
+
+            ImGui::PushID(i);
+            if (ImGui::Selectable(line) && d.m_key >= 0)
+                keyboard_editor_select(editor, diags[i].m_keymap, d.m_layer, d.m_key);
+            ImGui::PopID();
+        }
+    }
+    ImGui::EndListBox();
+}
+
+void keyboard_editor_find(keditor_t& editor, float height)
+{
+    if (editor.m_nb_graphs == 0)
+        return;
+
+    if (ImGui::InputText("find", editor.m_find, sizeof(editor.m_find)))
+        editor.m_find_dirty = true;
+    if (editor.m_find_dirty)
+    {
+        editor.m_nb_found   = reverse_find(editor.m_reverses[0], editor.m_find, editor.m_found, 64);
+        editor.m_find_dirty = false;
+    }
+    if (editor.m_nb_found == 0 || !ImGui::BeginListBox("##found", ImVec2(-1.0f, height)))
+        return;
+
+    keymap_t const& km = model_keymaps(editor.m_model)->m_keymaps[0];
+    for (s32 i = 0; i < editor.m_nb_found; ++i)
+    {
+        kreversehit_t const& hit = editor.m_found[i];
+
+        // e.g. "Symbols, key 12 + LShift, via Base key 40 (MO)"
+        char line[256];
+        s32  len = snprintf(line, sizeof(line), "%s, key %d", km.m_layers[hit.m_layer].m_name, hit.m_key);
+        for (s32 bit = 0; key_mod_str(bit) != nullptr && len < (s32)sizeof(line); ++bit)
+        {
+            if ((hit.m_mods & (1 << bit)) != 0)
+                len += snprintf(line + len, sizeof(line) - len, " + %s", key_mod_str(bit));
+        }
+
+        kreversestep_t steps[8];
+        s32 const      nb_steps = reverse_path(editor.m_reverses[0], hit.m_layer, steps, 8);
+        if (nb_steps < 0 && len < (s32)sizeof(line))
+            len += snprintf(line + len, sizeof(line) - len, ", layer cannot be reached");
+        for (s32 s = 0; s < nb_steps && s < 8 && len < (s32)sizeof(line); ++s)
+            len += snprintf(line + len, sizeof(line) - len, "%s %s key %d", s == 0 ? ", via" : " ->", km.m_layers[steps[s].m_layer].m_name, steps[s].m_key);
+
+        ImGui::PushID(i);
+        if (ImGui::Selectable(line))
+            keyboard_editor_select(editor, 0, hit.m_layer, hit.m_key);
+        ImGui::PopID();
+    }
+    ImGui::EndListBox();
+}
+
+// the same placement as keyboard_render for the overlays, grows to the largest keyboard seen
+static s32 overlay_places(ckeyboard_t const* kb, float posx, float posy, float globalscale, ckeyplace_t const*& places)
+{
+    static ImVector<ckeyplace_t> s_places;
+    s32 const                    nb_keys = keyboard_nb_keys(kb);
+    if (s_places.Size < nb_keys)
+        s_places.resize(nb_keys);
+    places = s_places.Data;
+    return keyboard_layout(kb, posx, posy, globalscale, s_places.Data, s_places.Size);
+}
+
+void keyboard_editor_find_overlay(keditor_t& editor, ckeyboard_t const* kb, s32 layer, float posx, float posy, float globalscale)
+{
+    if (editor.m_nb_found == 0)
+        return;
+
+    ckeyplace_t const* places    = nullptr;
+    s32 const          nb_places = overlay_places(kb, posx, posy, globalscale, places);
+
+    ImDrawList* draw_list = ImGui::GetWindowDrawList();
+    for (s32 i = 0; i < editor.m_nb_found; ++i)
+    {
+        kreversehit_t const& hit = editor.m_found[i];
+        if (hit.m_layer != layer)
+            continue;
+        for (s32 p = 0; p < nb_places; ++p)
+        {
+            ckeyplace_t const& place = places[p];
+            if (place.m_key->m_index != hit.m_key)
+                continue;
+            ImU32 const color = hit.m_mods == 0 ? IM_COL32(90, 210, 90, 255) : IM_COL32(240, 200, 60, 255);
+            draw_list->AddCircle(ImVec2(place.m_x, place.m_y), (place.m_hw < place.m_hh ? place.m_hw : place.m_hh) * 0.9f, color, 0, 3.0f);
+        }
+    }
+}
+
+static ImU32 edge_color(u32 kinds)
+{
+    if ((kinds & EDGE_SWITCH) != 0)
+        return IM_COL32(240, 200, 60, 255);
+    if ((kinds & EDGE_TOGGLE) != 0)
+        return IM_COL32(90, 210, 90, 255);
+    if ((kinds & EDGE_ONESHOT) != 0)
+        return IM_COL32(190, 120, 240, 255);
+    return IM_COL32(100, 170, 250, 255);
+}
+
+void keyboard_editor_layer_graph(keditor_t& editor, s32 keymap, s32 layer, float posx, float posy, float size)
+{
+    if (!editor.m_show_graph || keymap < 0 || keymap >= editor.m_nb_graphs)
+        return;
+
+    kgraph_t*            g         = editor.m_graphs[keymap];
+    keymap_t const&      km        = model_keymaps(editor.m_model)->m_keymaps[keymap];
+    s32 const            nb_layers = graph_nb_layers(g);
+    kgraphlayer_t const* layers    = graph_layers(g);
+    kgraphedge_t const*  edges     = graph_edges(g);
+    if (nb_layers == 0)
+        return;
+
+    ImDrawList* draw_list = ImGui::GetWindowDrawList();
+    draw_list->AddRectFilled(ImVec2(posx, posy), ImVec2(posx + size, posy + size), IM_COL32(20, 20, 20, 220), 8.0f);
+
+    // the layers on a circle, the base layer at the top
+    float const cx     = posx + size * 0.5f;
+    float const cy     = posy + size * 0.5f;
+    float const radius = size * 0.36f;
+    float const node   = size * 0.06f;
+
+    ImVec2 centers[GRAPH_MAX_LAYERS];
+    for (s32 i = 0; i < nb_layers; ++i)
+    {
+        float const a = -1.5707963f + 6.2831853f * (float)i / (float)nb_layers;
+        centers[i]    = ImVec2(cx + cosf(a) * radius, cy + sinf(a) * radius);
+    }
+
+    for (s32 e = 0; e < graph_nb_edges(g); ++e)
+    {
+        kgraphedge_t const& edge  = edges[e];
+        ImU32 const         color = edge_color(edge.m_kinds);
+        ImVec2 const        from  = centers[edge.m_from];
+        if (edge.m_from == edge.m_to)
+        {
+            // a layer that toggles itself off, a loop on the outside of the node
+            float const dx = from.x - cx;
+            float const dy = from.y - cy;
+            float const d  = sqrtf(dx * dx + dy * dy) + 0.0001f;
+            draw_list->AddCircle(ImVec2(from.x + dx / d * node * 1.4f, from.y + dy / d * node * 1.4f), node * 0.6f, color, 12, 1.5f);
+            continue;
+        }
+
+        // edges in both directions are drawn side by side
+        ImVec2 const to = centers[edge.m_to];
+        float const  dx = to.x - from.x;
+        float const  dy = to.y - from.y;
+        float const  d  = sqrtf(dx * dx + dy * dy) + 0.0001f;
+        float const  ux = dx / d;
+        float const  uy = dy / d;
+        float const  ox = -uy * node * 0.3f;
+        float const  oy = ux * node * 0.3f;
+
+        ImVec2 const a(from.x + ux * node + ox, from.y + uy * node + oy);
+        ImVec2 const b(to.x - ux * node + ox, to.y - uy * node + oy);
+        draw_list->AddLine(a, b, color, edge.m_count > 1 ? 2.5f : 1.5f);
+        draw_list->AddTriangleFilled(b, ImVec2(b.x - ux * 8.0f - uy * 4.0f, b.y - uy * 8.0f + ux * 4.0f), ImVec2(b.x - ux * 8.0f + uy * 4.0f, b.y - uy * 8.0f - ux * 4.0f), color);
+    }
+
+    for (s32 i = 0; i < nb_layers; ++i)
+    {
+        kgraphlayer_t const& gl   = layers[i];
+        ImU32                fill = IM_COL32(40, 60, 110, 255);
+        if (!gl.m_reachable)
+            fill = IM_COL32(70, 70, 70, 255);
+        else if (gl.m_trap)
+            fill = IM_COL32(190, 40, 40, 255);
+        else if (gl.m_cycle >= 0)
+            fill = IM_COL32(210, 120, 30, 255);
+
+        draw_list->AddCircleFilled(centers[i], node, fill, 24);
+        if (i == layer)
+            draw_list->AddCircle(centers[i], node + 2.0f, IM_COL32(255, 255, 255, 255), 24, 2.0f);
+
+        const char*  name = km.m_layers[i].m_name;
+        ImVec2 const td   = ImGui::CalcTextSize(name);
+        draw_list->AddText(ImVec2(centers[i].x - td.x * 0.5f, centers[i].y - td.y * 0.5f), IM_COL32(255, 255, 255, 255), name);
+    }
+
+    // legend
+    static const char* s_kinds[] = {"momentary", "toggle", "to", "one-shot"};
+    float               y        = posy + 6.0f;
+    for (s32 b = 0; b < 4; ++b)
+    {
+        draw_list->AddLine(ImVec2(posx + 6.0f, y + 7.0f), ImVec2(posx + 26.0f, y + 7.0f), edge_color(1 << b), 2.0f);
+        draw_list->AddText(ImVec2(posx + 30.0f, y), IM_COL32(220, 220, 220, 255), s_kinds[b]);
+        y += ImGui::GetTextLineHeight();
+    }
+}
+
+static void apply_optimized(kedit_t const& edit, void* user)
+{
+    keditor_t* editor = (keditor_t*)user;
+    kedit_t    copy   = edit;
+    copy.m_str        = intern(*editor, edit.m_str);
+    keyboard_editor_apply(*editor, copy);
+}
+
+void keyboard_editor_optimizer(keditor_t& editor, ckeyboard_t const* kb)
+{
+    if (editor.m_nb_graphs == 0 || editor.m_corpus.m_pairs == nullptr || kb == nullptr)
+        return;
+
+    keymap_t const& km = model_keymaps(editor.m_model)->m_keymaps[0];
+    for (s32 l = 0; l < km.m_nb_layers && l < 64; ++l)
+    {
+        bool checked = (editor.m_optimize_layers & ((u64)1 << l)) != 0;
+        if (l > 0)
+            ImGui::SameLine();
+        if (ImGui::Checkbox(km.m_layers[l].m_name, &checked))
+            editor.m_optimize_layers ^= (u64)1 << l;
+    }
+
+    koptimize_stats_t stats;
+    if (editor.m_optimizer != nullptr)
+        optimizer_stats(editor.m_optimizer, stats);
+    bool const running = editor.m_optimizer != nullptr && stats.m_running;
+
+    if (!running && ImGui::Button("Optimize"))
+    {
+        // a new search for the current keymap and layers, the previous best layout is gone
+        optimizer_destroy(editor.m_optimizer);
+        koptimize_params_t params;
+        optimize_defaults(params);
+        params.m_layers    = editor.m_optimize_layers;
+        editor.m_optimizer = optimizer_create(kb, &km, editor.m_reverses[0], editor.m_corpus, params);
+        optimizer_start(editor.m_optimizer);
+        editor.m_show_candidate = true;
+    }
+    if (running && ImGui::Button("Stop"))
+        optimizer_stop(editor.m_optimizer);
+    if (editor.m_optimizer == nullptr)
+        return;
+
+    ImGui::SameLine();
+    ImGui::Checkbox("show candidate", &editor.m_show_candidate);
+    ImGui::SameLine();
+    if (ImGui::Button("Apply"))
+    {
+        // every moved key is an edit of its own (journaled one by one), together they are a single undo step
+        optimizer_stop(editor.m_optimizer);
+        model_begin_group(editor.m_model);
+        optimizer_edits(editor.m_optimizer, 0, apply_optimized, &editor);
+        model_end_group(editor.m_model);
+        editor.m_show_candidate = false;
+    }
+    ImGui::Text("%d keys, %.1f M swaps/s, cost per byte %.4f -> %.4f (%u better layouts)", stats.m_nb_symbols, stats.m_seconds > 0.0 ? (double)stats.m_nb_swaps / stats.m_seconds / 1000000.0 : 0.0,
+                stats.m_initial_cost, stats.m_best_cost, stats.m_version);
+}
+
+keymap_t const* keyboard_editor_candidate(keditor_t& editor)
+{
+    if (!editor.m_show_candidate || editor.m_optimizer == nullptr)
+        return nullptr;
+    return optimizer_candidate(editor.m_optimizer);
+}
+
+void keyboard_editor_simulator(keditor_t& editor)
+{
+    if (editor.m_nb_graphs == 0)
+        return;
+
+    if (ImGui::Checkbox("simulate", &editor.m_simulate))
+        simulate_create(editor);
+    if (editor.m_sim == nullptr)
+        return;
+
+    ImGui::SameLine();
+    s32 term = (s32)editor.m_sim_params.m_tapping_term;
+    ImGui::SetNextItemWidth(80.0f);
+    if (ImGui::DragInt("tapping term", &term, 1.0f, 50, 1000, "%d ms"))
+    {
+        editor.m_sim_params.m_tapping_term = (u32)term;
+        simulate_create(editor);
+    }
+    ImGui::SameLine();
+    if (ImGui::Checkbox("permissive hold", &editor.m_sim_params.m_permissive_hold))
+        simulate_create(editor);
+    ImGui::SameLine();
+    if (ImGui::Button("Reset"))
+        simulate_create(editor);
+
+    // the active layers, the highest one (the layer keys resolve on first) in yellow
+    keymap_t const& km     = model_keymaps(editor.m_model)->m_keymaps[0];
+    u32 const       active = sim_layer_state(editor.m_sim) | sim_default_layer_state(editor.m_sim);
+    s32 const       top    = sim_top_layer(editor.m_sim);
+    for (s32 l = 0; l < km.m_nb_layers && l < 32; ++l)
+    {
+        if (l > 0)
+            ImGui::SameLine();
+        ImVec4 const color = l == top ? ImVec4(0.95f, 0.8f, 0.25f, 1.0f) : (active & (1u << l)) != 0 ? ImVec4(0.35f, 0.8f, 0.35f, 1.0f) : ImVec4(0.5f, 0.5f, 0.5f, 1.0f);
+        ImGui::TextColored(color, "%s", km.m_layers[l].m_name);
+    }
+
+    // e.g. "report LCtrl LShift 04 1e"
+    static const char* s_mods[] = {"LCtrl", "LShift", "LAlt", "LGui", "RCtrl", "RShift", "RAlt", "RGui"};
+    ksimreport_t const& r       = sim_report(editor.m_sim);
+    char                line[128];
+    s32                 len = snprintf(line, sizeof(line), "report");
+    for (s32 bit = 0; bit < 8 && len < (s32)sizeof(line); ++bit)
+    {
+        if ((r.m_mods & (1 << bit)) != 0)
+            len += snprintf(line + len, sizeof(line) - len, " %s", s_mods[bit]);
+    }
+    for (s32 i = 0; i < 6 && len < (s32)sizeof(line); ++i)
+    {
+        if (r.m_keys[i] != 0)
+            len += snprintf(line + len, sizeof(line) - len, " %02x", r.m_keys[i]);
+    }
+    if (sim_pending(editor.m_sim) && len < (s32)sizeof(line))
+        snprintf(line + len, sizeof(line) - len, " (tap or hold?)");
+    ImGui::TextUnformatted(line);
+}
+
+bool keyboard_editor_simulate_mouse(keditor_t& editor, s32 key)
+{
+    if (editor.m_sim == nullptr)
+        return false;
+    if (key >= 0 && editor.m_sim_key < 0 && ImGui::IsMouseClicked(ImGuiMouseButton_Left))
+    {
+        simulate_event(editor, key, true);
+        editor.m_sim_key = key;
+    }
+    return true;
+}
+
+u32 keyboard_editor_simulate_layers(keditor_t& editor)
+{
+    if (editor.m_sim == nullptr)
+        return 0;
+    return sim_layer_state(editor.m_sim) | sim_default_layer_state(editor.m_sim);
+}
+
+s32 keyboard_editor_simulate_follow(keditor_t& editor)
+{
+    if (editor.m_sim == nullptr)
+        return -1;
+    s32 const top = sim_top_layer(editor.m_sim);
+    if (top == editor.m_sim_layer)
+        return -1;
+    editor.m_sim_layer = top;
+    return top;
+}
+
+void keyboard_editor_simulate_overlay(keditor_t& editor, ckeyboard_t const* kb, float posx, float posy, float globalscale)
+{
+    if (editor.m_sim == nullptr)
+        return;
+
+    ckeyplace_t const* places    = nullptr;
+    s32 const          nb_places = overlay_places(kb, posx, posy, globalscale, places);
+
+    ImDrawList* draw_list = ImGui::GetWindowDrawList();
+    for (s32 p = 0; p < nb_places; ++p)
+    {
+        ckeyplace_t const& place = places[p];
+        if (!sim_key_down(editor.m_sim, place.m_key->m_index))
+            continue;
+        float const radius = (place.m_hw < place.m_hh ? place.m_hw : place.m_hh) * 0.9f;
+        draw_list->AddCircleFilled(ImVec2(place.m_x, place.m_y), radius, IM_COL32(240, 200, 60, 96));
+    }
+}
+
+void keyboard_editor_rgb(keditor_t& editor)
+{
+    if (editor.m_nb_graphs == 0)
+        return;
+
+    if (ImGui::Checkbox("rgb", &editor.m_show_rgb) && !editor.m_show_rgb)
+    {
+        rgb_destroy(editor.m_rgb);
+        editor.m_rgb = nullptr;
+    }
+    if (!editor.m_show_rgb)
+        return;
+
+    // "solid\0breathing\0...\0\0"
+    static char s_effects[256] = {0};
+    if (s_effects[0] == 0)
+    {
+        s32 len = 0;
+        for (s32 e = 0; e < RGB_NB_EFFECTS; ++e)
+            len += snprintf(s_effects + len, sizeof(s_effects) - len - 1, "%s", rgb_effect_name(e)) + 1;
+        s_effects[len] = 0;
+    }
+
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(140.0f);
+    ImGui::Combo("effect", &editor.m_rgb_params.m_effect, s_effects);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(80.0f);
+    ImGui::DragFloat("speed", &editor.m_rgb_params.m_speed, 0.01f, 0.1f, 4.0f, "%.2f");
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(80.0f);
+    ImGui::DragFloat("brightness", &editor.m_rgb_params.m_brightness, 0.01f, 0.0f, 1.0f, "%.2f");
+}
+
+krgb_t* keyboard_editor_rgb_frame(keditor_t& editor, ckeyboard_t const* kb, s32 layer)
+{
+    if (!editor.m_show_rgb || editor.m_nb_graphs == 0)
+        return nullptr;
+
+    if (editor.m_rgb == nullptr)
+        editor.m_rgb = rgb_create();
+    if (rgb_keyboard(editor.m_rgb) != kb)
+    {
+        rgb_build(editor.m_rgb, kb);
+        editor.m_rgb_dirty = true;
+    }
+    if (editor.m_rgb_dirty || editor.m_rgb_layer != layer)
+    {
+        rgb_colors(editor.m_rgb, &model_keymaps(editor.m_model)->m_keymaps[0], layer);
+        editor.m_rgb_dirty = false;
+        editor.m_rgb_layer = layer;
+    }
+    rgb_update(editor.m_rgb, editor.m_rgb_params, ImGui::GetTime());
+    return editor.m_rgb;
+}
+
+void keyboard_editor_rgb_hit(keditor_t& editor, s32 key)
+{
+    if (editor.m_rgb != nullptr && key >= 0)
+        rgb_hit(editor.m_rgb, key, ImGui::GetTime());
+}
+
+kcompose_t* keyboard_editor_compose(keditor_t& editor, s32 keymap)
+{
+    if (!editor.m_show_composed || keymap < 0 || keymap >= editor.m_nb_graphs)
+        return nullptr;
+    return editor.m_composes[keymap];
+}
+
+kheatmap_t* keyboard_editor_heatmap(keditor_t& editor, s32 keymap)
+{
+    if (!editor.m_show_heatmap || keymap != 0 || editor.m_corpus.m_pairs == nullptr)
+        return nullptr;
+    return editor.m_heatmap;
+}
@@ -0,0 +1,326 @@
+#include "xbase/x_base.h"
+#include "xbase/x_memory.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_keycode.h"
+#include "qmk-keymap-wiz/keyboard_layout.h"
+#include "qmk-keymap-wiz/keyboard_writer.h"
+#include "qmk-keymap-wiz/keyboard_export.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace xcore
+{
+    static const char* s_mod_functions[] = {"LSFT", "RSFT", "LCTL", "RCTL", "LALT", "RALT", "LGUI", "RGUI"};
+    static const char* s_mod_masks[]     = {"MOD_LSFT", "MOD_RSFT", "MOD_LCTL", "MOD_RCTL", "MOD_LALT", "MOD_RALT", "MOD_LGUI", "MOD_RGUI"};
+
+    void export_layer_enum(kwriter_t& w, const char* layer_name)
+    {
+        if (layer_name == nullptr || layer_name[0] == 0)
+        {
+            writer_char(w, '0');
+            return;
+        }
+
+        writer_char(w, '_');
+        for (const char* c = layer_name; *c != 0; ++c)
+        {
+            char ch = *c;
+            if (ch >= 'a' && ch <= 'z')
+                ch = ch - 'a' + 'A';
+            else if (!((ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9')))
+                ch = '_';
+            writer_char(w, ch);
+        }
+    }
+
+    static void export_mod_mask(kwriter_t& w, u16 mods)
+    {
+        bool first = true;
+        for (s32 i = 0; i < 8; ++i)
+        {
+            if (mods & (1 << i))
+            {
+                if (!first)
+                    writer_str(w, " | ");
+                writer_str(w, s_mod_masks[i]);
+                first = false;
+            }
+        }
+    }
+
+    void export_key(kwriter_t& w, key_t const& key)
+    {
+        const char* keycode = (key.m_keycode_str != nullptr && key.m_keycode_str[0] != 0) ? key.m_keycode_str : "KC_NO";
+        u16 const   mods    = key.m_mod & 0xFF;
+
+        // layer switching, only one of them can be active on a key
+        if (key.m_layer_switch != 0)
+        {
+            u16 const ls = key.m_layer_switch;
+            if (ls & LT)
+            {
+                writer_str(w, "LT(");
+                export_layer_enum(w, key.m_layer);
+                writer_str(w, ", ");
+                writer_str(w, keycode);
+                writer_char(w, ')');
+                return;
+            }
+
+            const char* fn = "MO(";
+            if (ls & TG)
+                fn = "TG(";
+            else if (ls & TO)
+                fn = "TO(";
+            else if (ls & TT)
+                fn = "TT(";
+            else if (ls & OSL)
+                fn = "OSL(";
+            writer_str(w, fn);
+            export_layer_enum(w, key.m_layer);
+            writer_char(w, ')');
+            return;
+        }
+
+        if (mods != 0 && (key.m_mod & OSM))
+        {
+            writer_str(w, "OSM(");
+            export_mod_mask(w, mods);
+            writer_char(w, ')');
+            return;
+        }
+
+        if (mods != 0 && ((key.m_mod & MT) || key.m_mod_tap))
+        {
+            writer_str(w, "MT(");
+            export_mod_mask(w, mods);
+            writer_str(w, ", ");
+            writer_str(w, keycode);
+            writer_char(w, ')');
+            return;
+        }
+
+        // plain modifiers wrap the keycode, e.g. LSFT(LCTL(KC_A))
+        s32 depth = 0;
+        for (s32 i = 0; i < 8; ++i)
+        {
+            if (mods & (1 << i))
+            {
+                writer_str(w, s_mod_functions[i]);
+                writer_char(w, '(');
+                depth++;
+            }
+        }
+        writer_str(w, keycode);
+        while (depth-- > 0)
+            writer_char(w, ')');
+    }
+
+    static void export_layer_index(kwriter_t& w, keymap_t const* km, u32 layer)
+    {
+        if (layer < (u32)km->m_nb_layers)
+            export_layer_enum(w, km->m_layers[layer].m_name);
+        else
+            writer_int(w, (s32)layer);
+    }
+
+    void export_key(kwriter_t& w, keymap_t const* km, key_t const& key)
+    {
+        // keys that are not compiled or have no QMK encoding are written from their fields
+        if (key.m_kc == KEYCODE_UNCOMPILED || key.m_code == KEYCODE_INVALID)
+        {
+            export_key(w, key);
+            return;
+        }
+
+        // the keycode on its own, it can be a compound expression itself
+        u16 const   code    = key.m_code;
+        const char* keycode = key.m_keycode_str;
+        if (code == key.m_tap)
+        {
+            writer_str(w, keycode);
+            return;
+        }
+
+        if (code >= QK_LAYER_TAP && code <= QK_LAYER_TAP_MAX)
+        {
+            writer_str(w, "LT(");
+            export_layer_index(w, km, (code >> 8) & 0xF);
+            writer_str(w, ", ");
+            writer_str(w, keycode);
+            writer_char(w, ')');
+            return;
+        }
+        if (code >= QK_TO && code < QK_ONE_SHOT_MOD)
+        {
+            static const char* s_functions[] = {"TO(", "MO(", "DF(", "TG(", "OSL("};
+            writer_str(w, s_functions[(code - QK_TO) >> 5]);
+            export_layer_index(w, km, code & 0x1F);
+            writer_char(w, ')');
+            return;
+        }
+        if (code >= QK_LAYER_TAP_TOGGLE && code < QK_LAYER_TAP_TOGGLE + 0x20)
+        {
+            writer_str(w, "TT(");
+            export_layer_index(w, km, code & 0x1F);
+            writer_char(w, ')');
+            return;
+        }
+        if (code >= QK_ONE_SHOT_MOD && code < QK_ONE_SHOT_MOD + 0x20)
+        {
+            writer_str(w, "OSM(");
+            export_mod_mask(w, emod_from_qmk(code & 0x1F));
+            writer_char(w, ')');
+            return;
+        }
+        if (code >= QK_MOD_TAP && code <= QK_MOD_TAP_MAX)
+        {
+            writer_str(w, "MT(");
+            export_mod_mask(w, emod_from_qmk((code >> 8) & 0x1F));
+            writer_str(w, ", ");
+            writer_str(w, keycode);
+            writer_char(w, ')');
+            return;
+        }
+
+        // the modifiers that the key adds to its keycode, a shifted keycode (KC_EXLM) already holds LSFT itself
+        u16 mods = 0;
+        if (code >= QK_MODS && code <= QK_MODS_MAX)
+        {
+            u8 const all   = (code >> 8) & 0x1F;
+            u8 const own   = key.m_tap <= QK_MODS_MAX ? (key.m_tap >> 8) & 0x1F : 0;
+            u8 const added = all & ~own & 0x0F;
+            if (added != 0)
+                mods = emod_from_qmk(added | (all & QMOD_RIGHT));
+        }
+        s32 depth = 0;
+        for (s32 i = 0; i < 8; ++i)
+        {
+            if (mods & (1 << i))
+            {
+                writer_str(w, s_mod_functions[i]);
+                writer_char(w, '(');
+                depth++;
+            }
+        }
+        writer_str(w, keycode);
+        while (depth-- > 0)
+            writer_char(w, ')');
+    }
+
+    // The column of every key index in the LAYOUT macro, a new row starts (column 0) when the next key is to the
+    // left of the previous one. Without a keyboard the keys are put in rows of 12.
+    static s32 layout_columns(ckeyboard_t const* kb, s32 nb_keys, s32* columns)
+    {
+        float* xs = nullptr;
+        if (kb != nullptr)
+        {
+            s32 const    nb_places = keyboard_nb_keys(kb);
+            ckeyplace_t* places    = (ckeyplace_t*)::malloc(sizeof(ckeyplace_t) * (nb_places > 0 ? nb_places : 1));
+            s32 const    n         = keyboard_layout(kb, 0.0f, 0.0f, 1.0f, places, nb_places);
+
+            xs = (float*)::malloc(sizeof(float) * (nb_keys > 0 ? nb_keys : 1));
+            for (s32 i = 0; i < nb_keys; ++i)
+                xs[i] = 0.0f;
+            for (s32 i = 0; i < n; ++i)
+            {
+                s32 const index = places[i].m_key->m_index;
+                if (index >= 0 && index < nb_keys)
+                    xs[index] = places[i].m_x;
+            }
+            ::free(places);
+        }
+
+        s32 max_columns = 0;
+        s32 column      = 0;
+        for (s32 i = 0; i < nb_keys; ++i)
+        {
+            bool const new_row = (xs != nullptr) ? (i > 0 && xs[i] < xs[i - 1]) : (column == 12);
+            if (new_row)
+                column = 0;
+            columns[i] = column++;
+            if (column > max_columns)
+                max_columns = column;
+        }
+        ::free(xs);
+        return max_columns;
+    }
+
+    bool export_keymap_c(kwriter_t& w, keymap_t const* km, ckeyboard_t const* kb)
+    {
+        writer_str(w, "// Generated by qmk-keymap-wiz, do not edit\n");
+        writer_str(w, "#include QMK_KEYBOARD_H\n");
+        writer_str(w, "#include \"layers.h\"\n\n");
+        writer_str(w, "// clang-format off\n");
+        writer_str(w, "const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {\n");
+
+        for (s32 l = 0; l < km->m_nb_layers; ++l)
+        {
+            layer_t const& layer = km->m_layers[l];
+            s32 const      n     = layer.m_nb_keys;
+
+            s32* columns     = (s32*)::malloc(sizeof(s32) * (n > 0 ? n : 1));
+            s32  max_columns = layout_columns(kb, n, columns);
+            s32* widths      = (s32*)::malloc(sizeof(s32) * (max_columns > 0 ? max_columns : 1));
+            for (s32 c = 0; c < max_columns; ++c)
+                widths[c] = 0;
+
+            // measure every key to align the columns
+            for (s32 k = 0; k < n; ++k)
+            {
+                kwriter_t counter;
+                writer_count(counter);
+                export_key(counter, km, layer.m_keys[k]);
+                if ((s32)counter.m_written > widths[columns[k]])
+                    widths[columns[k]] = (s32)counter.m_written;
+            }
+
+            writer_str(w, "    [");
+            export_layer_enum(w, layer.m_name);
+            writer_str(w, "] = LAYOUT(");
+            for (s32 k = 0; k < n; ++k)
+            {
+                if (columns[k] == 0)
+                    writer_str(w, "\n        ");
+
+                s64 const start = w.m_written;
+                export_key(w, km, layer.m_keys[k]);
+                if (k < n - 1)
+                {
+                    writer_char(w, ',');
+                    bool const last_in_row = (k + 1 < n) && columns[k + 1] == 0;
+                    if (!last_in_row)
+                        writer_spaces(w, 1 + widths[columns[k]] - (s32)(w.m_written - start - 1));
+                }
+            }
+            writer_str(w, "\n    ),\n");
+
+            ::free(widths);
+            ::free(columns);
+        }
+
+        writer_str(w, "};\n");
+        writer_str(w, "// clang-format on\n");
+        return !w.m_error;
+    }
+
+    bool export_layers_h(kwriter_t& w, keymap_t const* km)
+    {
+        writer_str(w, "// Generated by qmk-keymap-wiz, do not edit\n");
+        writer_str(w, "#pragma once\n\n");
+        writer_str(w, "enum layers\n{\n");
+        for (s32 l = 0; l < km->m_nb_layers; ++l)
+        {
+            writer_str(w, "    ");
+            export_layer_enum(w, km->m_layers[l].m_name);
+            if (l == 0)
+                writer_str(w, " = 0");
+            writer_str(w, ",\n");
+        }
+        writer_str(w, "};\n");
+        return !w.m_error;
+    }
+
+} // namespace xcore
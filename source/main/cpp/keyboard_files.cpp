@@ -0,0 +1,273 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_files.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifndef S_ISDIR
+#define S_ISDIR(m) (((m)&S_IFMT) == S_IFDIR)
+#endif
+
+namespace xcore
+{
+    static void add_file(kfiles_t& files, const char* dir, const char* name)
+    {
+        if (files.m_nb_files == files.m_max_files)
+        {
+            files.m_max_files = files.m_max_files == 0 ? 64 : files.m_max_files * 2;
+            files.m_files     = (char**)::realloc(files.m_files, sizeof(char*) * files.m_max_files);
+        }
+
+        size_t const dirlen  = strlen(dir);
+        size_t const namelen = strlen(name);
+        char*        path    = (char*)::malloc(dirlen + 1 + namelen + 1);
+        memcpy(path, dir, dirlen);
+        path[dirlen] = '/';
+        memcpy(path + dirlen + 1, name, namelen + 1);
+        files.m_files[files.m_nb_files++] = path;
+    }
+
+    static bool has_extension(const char* name, const char* ext)
+    {
+        if (ext == nullptr)
+            return true;
+        size_t const namelen = strlen(name);
+        size_t const extlen  = strlen(ext);
+        return namelen >= extlen && strcmp(name + namelen - extlen, ext) == 0;
+    }
+
+    static void scan_dir(const char* dir, const char* ext, bool recursive, kfiles_t& files)
+    {
+#ifdef _WIN32
+        char pattern[MAX_PATH];
+        snprintf(pattern, sizeof(pattern), "%s/*", dir);
+
+        WIN32_FIND_DATAA fd;
+        HANDLE           h = FindFirstFileA(pattern, &fd);
+        if (h == INVALID_HANDLE_VALUE)
+            return;
+        do
+        {
+            if (fd.cFileName[0] == '.')
+                continue;
+            if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            {
+                if (recursive)
+                {
+                    char subdir[MAX_PATH];
+                    snprintf(subdir, sizeof(subdir), "%s/%s", dir, fd.cFileName);
+                    scan_dir(subdir, ext, recursive, files);
+                }
+            }
+            else if (has_extension(fd.cFileName, ext))
+            {
+                add_file(files, dir, fd.cFileName);
+            }
+        } while (FindNextFileA(h, &fd));
+        FindClose(h);
+#else
+        DIR* d = opendir(dir);
+        if (d == nullptr)
+            return;
+        while (struct dirent* e = readdir(d))
+        {
+            if (e->d_name[0] == '.')
+                continue;
+
+            char path[4096];
+            snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+
+            struct stat st;
+            if (stat(path, &st) != 0)
+                continue;
+            if (S_ISDIR(st.st_mode))
+            {
+                if (recursive)
+                    scan_dir(path, ext, recursive, files);
+            }
+            else if (has_extension(e->d_name, ext))
+            {
+                add_file(files, dir, e->d_name);
+            }
+        }
+        closedir(d);
+#endif
+    }
+
+    static int compare_paths(const void* a, const void* b) { return strcmp(*(const char* const*)a, *(const char* const*)b); }
+
+    bool enumerate_files(const char* dir, const char* ext, bool recursive, kfiles_t& files)
+    {
+        struct stat st;
+        if (stat(dir, &st) != 0)
+        {
+            printf("failed to open directory %s\n", dir);
+            return false;
+        }
+
+        scan_dir(dir, ext, recursive, files);
+
+        // directory order is file system specific, sort to keep the output stable
+        if (files.m_nb_files > 1)
+            qsort(files.m_files, files.m_nb_files, sizeof(char*), compare_paths);
+        return true;
+    }
+
+    void release_files(kfiles_t& files)
+    {
+        for (s32 i = 0; i < files.m_nb_files; ++i)
+            ::free(files.m_files[i]);
+        ::free(files.m_files);
+        files.m_nb_files  = 0;
+        files.m_max_files = 0;
+        files.m_files     = nullptr;
+    }
+
+    bool make_dir(const char* dir)
+    {
+        struct stat st;
+        if (stat(dir, &st) == 0)
+            return S_ISDIR(st.st_mode);
+#ifdef _WIN32
+        return _mkdir(dir) == 0;
+#else
+        return mkdir(dir, 0755) == 0;
+#endif
+    }
+
+    bool replace_file(const char* from, const char* to)
+    {
+#ifdef _WIN32
+        return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        return rename(from, to) == 0;
+#endif
+    }
+
+    bool delete_file(const char* filename)
+    {
+        if (file_size(filename) < 0)
+            return true;
+        return remove(filename) == 0;
+    }
+
+    s64 file_size(const char* filename)
+    {
+        struct stat st;
+        if (stat(filename, &st) != 0)
+            return -1;
+        return (s64)st.st_size;
+    }
+
+    bool map_file(const char* filename, kmapping_t& mapping)
+    {
+        mapping = kmapping_t();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size))
+        {
+            CloseHandle(file);
+            return false;
+        }
+        mapping.m_file = file;
+        mapping.m_size = (s64)size.QuadPart;
+        if (mapping.m_size == 0)
+            return true;
+
+        HANDLE map = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (map == nullptr)
+        {
+            unmap_file(mapping);
+            return false;
+        }
+        mapping.m_map  = map;
+        mapping.m_data = (u8 const*)MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+#else
+        int const fd = open(filename, O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            close(fd);
+            return false;
+        }
+        mapping.m_file = (void*)(size_t)(fd + 1); // 0 is no file
+        mapping.m_size = (s64)st.st_size;
+        if (mapping.m_size == 0)
+            return true;
+
+        void* data = mmap(nullptr, (size_t)mapping.m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            // the file is read once from front to back
+            madvise(data, (size_t)mapping.m_size, MADV_SEQUENTIAL);
+            mapping.m_data = (u8 const*)data;
+        }
+#endif
+        if (mapping.m_data == nullptr)
+        {
+            unmap_file(mapping);
+            return false;
+        }
+        return true;
+    }
+
+    void unmap_file(kmapping_t& mapping)
+    {
+#ifdef _WIN32
+        if (mapping.m_data != nullptr)
+            UnmapViewOfFile(mapping.m_data);
+        if (mapping.m_map != nullptr)
+            CloseHandle((HANDLE)mapping.m_map);
+        if (mapping.m_file != nullptr)
+            CloseHandle((HANDLE)mapping.m_file);
+#else
+        if (mapping.m_data != nullptr)
+            munmap((void*)mapping.m_data, (size_t)mapping.m_size);
+        if (mapping.m_file != nullptr)
+            close((int)(size_t)mapping.m_file - 1);
+#endif
+        mapping = kmapping_t();
+    }
+
+    const char* file_basename(const char* path)
+    {
+        const char* name = path;
+        for (const char* c = path; *c != 0; ++c)
+        {
+            if (*c == '/' || *c == '\\')
+                name = c + 1;
+        }
+        return name;
+    }
+
+    void file_stem(const char* path, char* stem, s32 maxlen)
+    {
+        const char* name = file_basename(path);
+        const char* dot  = strrchr(name, '.');
+        s32         len  = dot ? (s32)(dot - name) : (s32)strlen(name);
+        if (len > maxlen - 1)
+            len = maxlen - 1;
+        memcpy(stem, name, len);
+        stem[len] = 0;
+    }
+
+} // namespace xcore
@@ -0,0 +1,369 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_keycode.h"
+#include "qmk-keymap-wiz/keyboard_layout.h"
+#include "qmk-keymap-wiz/keyboard_render.h"
+#include "qmk-keymap-wiz/keyboard_bench.h"
+#include "qmk-keymap-wiz/keyboard_fingerprint.h"
+
+#include "libimgui/imgui.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+using namespace xcore;
+
+struct sfingerprint_t
+{
+    char  m_name[48];
+    s32   m_vertices;
+    s32   m_indices;
+    s32   m_commands;
+    u64   m_exact;
+    u64   m_geometry;
+    float m_mean_x;
+    float m_mean_y;
+    float m_min_x;
+    float m_min_y;
+    float m_max_x;
+    float m_max_y;
+    float m_spread; // root mean square distance to the mean
+};
+
+static const u64 s_fnv_basis = 14695981039346656037ull;
+
+static u64 fnv1a(u64 h, void const* data, s32 size)
+{
+    u8 const* bytes = (u8 const*)data;
+    for (s32 i = 0; i < size; ++i)
+        h = (h ^ bytes[i]) * 1099511628211ull;
+    return h;
+}
+
+static u64 fnv1a_snapped(u64 h, float value, float tolerance)
+{
+    s32 const snapped = (s32)floorf(value / tolerance + 0.5f);
+    return fnv1a(h, &snapped, sizeof(snapped));
+}
+
+static void fingerprint_draw_data(ImDrawData const* draw_data, float tolerance, sfingerprint_t& fp)
+{
+    fp.m_vertices = 0;
+    fp.m_indices  = 0;
+    fp.m_commands = 0;
+    fp.m_exact    = s_fnv_basis;
+    fp.m_geometry = s_fnv_basis;
+
+    double sum_x = 0.0, sum_y = 0.0, sum_sq = 0.0;
+    float  min_x = 0.0f, min_y = 0.0f, max_x = 0.0f, max_y = 0.0f;
+    for (s32 l = 0; l < draw_data->CmdListsCount; ++l)
+    {
+        ImDrawList const* list = draw_data->CmdLists[l];
+        for (s32 c = 0; c < list->CmdBuffer.Size; ++c)
+        {
+            ImDrawCmd const& cmd = list->CmdBuffer[c];
+            if (cmd.ElemCount == 0 && cmd.UserCallback == nullptr)
+                continue;
+            fp.m_commands += 1;
+            fp.m_exact    = fnv1a(fp.m_exact, &cmd.ElemCount, sizeof(cmd.ElemCount));
+            fp.m_geometry = fnv1a_snapped(fp.m_geometry, cmd.ClipRect.x, tolerance);
+            fp.m_geometry = fnv1a_snapped(fp.m_geometry, cmd.ClipRect.y, tolerance);
+            fp.m_geometry = fnv1a_snapped(fp.m_geometry, cmd.ClipRect.z, tolerance);
+            fp.m_geometry = fnv1a_snapped(fp.m_geometry, cmd.ClipRect.w, tolerance);
+        }
+
+        fp.m_exact = fnv1a(fp.m_exact, list->IdxBuffer.Data, list->IdxBuffer.Size * (s32)sizeof(ImDrawIdx));
+        fp.m_indices += list->IdxBuffer.Size;
+
+        for (s32 v = 0; v < list->VtxBuffer.Size; ++v)
+        {
+            ImDrawVert const& vtx = list->VtxBuffer[v];
+            fp.m_exact            = fnv1a(fp.m_exact, &vtx.uv, sizeof(vtx.uv));
+            fp.m_exact            = fnv1a(fp.m_exact, &vtx.col, sizeof(vtx.col));
+            fp.m_geometry         = fnv1a_snapped(fp.m_geometry, vtx.pos.x, tolerance);
+            fp.m_geometry         = fnv1a_snapped(fp.m_geometry, vtx.pos.y, tolerance);
+
+            if (fp.m_vertices == 0)
+            {
+                min_x = max_x = vtx.pos.x;
+                min_y = max_y = vtx.pos.y;
+            }
+            min_x = vtx.pos.x < min_x ? vtx.pos.x : min_x;
+            min_y = vtx.pos.y < min_y ? vtx.pos.y : min_y;
+            max_x = vtx.pos.x > max_x ? vtx.pos.x : max_x;
+            max_y = vtx.pos.y > max_y ? vtx.pos.y : max_y;
+            sum_x += vtx.pos.x;
+            sum_y += vtx.pos.y;
+            sum_sq += (double)vtx.pos.x * vtx.pos.x + (double)vtx.pos.y * vtx.pos.y;
+            fp.m_vertices += 1;
+        }
+    }
+
+    double const n        = fp.m_vertices > 0 ? (double)fp.m_vertices : 1.0;
+    double const mean_x   = sum_x / n;
+    double const mean_y   = sum_y / n;
+    double const variance = sum_sq / n - mean_x * mean_x - mean_y * mean_y;
+    fp.m_mean_x           = (float)mean_x;
+    fp.m_mean_y           = (float)mean_y;
+    fp.m_min_x            = min_x;
+    fp.m_min_y            = min_y;
+    fp.m_max_x            = max_x;
+    fp.m_max_y            = max_y;
+    fp.m_spread           = (float)sqrt(variance > 0.0 ? variance : 0.0);
+}
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// Scenes
+
+enum
+{
+    FINGERPRINT_MAX_SCENES = 64,
+};
+
+struct sfingerprints_t
+{
+    s32            m_nb_scenes;
+    sfingerprint_t m_scenes[FINGERPRINT_MAX_SCENES];
+};
+
+// the frame is built twice, the second one is taken so that nothing of the scene before (hovered window, tooltip)
+// is part of it
+static void fingerprint_scene(ckeyboard_t const* kb, keycodes_t const* kcdb, keymap_t const* km, s32 layer, float scale, float mousex, float mousey, float tolerance, sfingerprint_t& fp)
+{
+    for (s32 pass = 0; pass < 2; ++pass)
+    {
+        ImGui::GetIO().AddMousePosEvent(mousex, mousey);
+        ImGui::NewFrame();
+        ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f));
+        ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+        ImGui::Begin("fingerprint", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoSavedSettings);
+        keyboard_render(kb, kcdb, km, layer, 20.0f, 20.0f, mousex, mousey, scale);
+        ImGui::End();
+        ImGui::Render();
+    }
+    fingerprint_draw_data(ImGui::GetDrawData(), tolerance, fp);
+}
+
+static void fingerprint_size(sfingerprints_t& fps, keycodes_t const* kcdb, kbenchsize_t const& size, float tolerance, const char* tmpdir)
+{
+    char kb_file[512];
+    char km_file[512];
+    snprintf(kb_file, sizeof(kb_file), "%s/fingerprint_keyboards_%d.json", tmpdir, size.m_nb_keys);
+    snprintf(km_file, sizeof(km_file), "%s/fingerprint_keymaps_%d_%d.json", tmpdir, size.m_nb_keys, size.m_nb_layers);
+    if (!keyboard_bench_write(kb_file, km_file, kcdb, size))
+    {
+        printf("failed to write the synthetic data to %s\n", tmpdir);
+        return;
+    }
+
+    karena_t kb_arena;
+    karena_t km_arena;
+    init_arena(kb_arena, 4 * 1024 * 1024, 4 * 1024 * 1024);
+    init_arena(km_arena, 4 * 1024 * 1024, 4 * 1024 * 1024);
+    ckeyboards_t const* kbs = nullptr;
+    keymaps_t const*    kms = nullptr;
+    bool const          ok  = load_keyboards(kb_file, kb_arena, kbs) && load_keymaps(km_file, km_arena, kms) && kbs->m_nb_keyboards > 0 && kms->m_nb_keymaps > 0;
+    remove(kb_file);
+    remove(km_file);
+    if (!ok)
+    {
+        printf("failed to decode the synthetic data of %d keys\n", size.m_nb_keys);
+        exit_arena(kb_arena);
+        exit_arena(km_arena);
+        return;
+    }
+    compile_keymaps(kcdb, const_cast<keymaps_t*>(kms));
+
+    ckeyboard_t const* kb = &kbs->m_keyboards[0];
+    keymap_t const*    km = &kms->m_keymaps[0];
+
+    static const float s_scales[3] = {0.7f, 1.0f, 1.5f};
+    s32 const          layers[3]   = {0, 1, km->m_nb_layers - 1};
+
+    s32 const    nb_places = keyboard_nb_keys(kb);
+    ckeyplace_t* places    = (ckeyplace_t*)::malloc(sizeof(ckeyplace_t) * (nb_places + 1));
+    for (s32 si = 0; si < 3; ++si)
+    {
+        float const scale = s_scales[si];
+        s32 const   n     = keyboard_layout(kb, 20.0f, 20.0f, scale, places, nb_places);
+        for (s32 li = 0; li < 3; ++li)
+        {
+            s32 const layer = layers[li];
+            if (layer < 0 || layer >= km->m_nb_layers || (li > 0 && layer == layers[li - 1]))
+                continue;
+            for (s32 mi = 0; mi < 3 && fps.m_nb_scenes < FINGERPRINT_MAX_SCENES; ++mi)
+            {
+                // nowhere, on the first key and on the last key
+                float     mx = -1000.0f, my = -1000.0f;
+                s32 const key = mi == 1 ? 0 : (mi == 2 ? n - 1 : -1);
+                if (key >= 0 && key < n)
+                {
+                    mx = places[key].m_x;
+                    my = places[key].m_y;
+                }
+
+                sfingerprint_t& fp = fps.m_scenes[fps.m_nb_scenes++];
+                snprintf(fp.m_name, sizeof(fp.m_name), "%dx%d/L%d/s%.2f/%s", size.m_nb_keys, size.m_nb_layers, layer, scale, mi == 0 ? "none" : (mi == 1 ? "first" : "last"));
+                fingerprint_scene(kb, kcdb, km, layer, scale, mx, my, tolerance, fp);
+            }
+        }
+    }
+    ::free(places);
+
+    exit_arena(kb_arena);
+    exit_arena(km_arena);
+}
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// Golden file, a header line and a line per scene
+
+static bool write_golden(const char* filename, sfingerprints_t const& fps, bool fonts, float tolerance)
+{
+    kwriter_t w;
+    if (!writer_open(w, filename))
+        return false;
+    char line[512];
+    snprintf(line, sizeof(line), "# qmk-keymap-wiz fingerprints 1 fonts %d tolerance %g\n", fonts ? 1 : 0, tolerance);
+    writer_str(w, line);
+    for (s32 i = 0; i < fps.m_nb_scenes; ++i)
+    {
+        sfingerprint_t const& fp = fps.m_scenes[i];
+        snprintf(line, sizeof(line), "%s %d %d %d %016llx %016llx %.4f %.4f %.4f %.4f %.4f %.4f %.4f\n", fp.m_name, fp.m_vertices, fp.m_indices, fp.m_commands, (unsigned long long)fp.m_exact, (unsigned long long)fp.m_geometry, fp.m_mean_x,
+                 fp.m_mean_y, fp.m_min_x, fp.m_min_y, fp.m_max_x, fp.m_max_y, fp.m_spread);
+        writer_str(w, line);
+    }
+    return writer_close(w);
+}
+
+static bool read_golden(const char* filename, sfingerprints_t& fps, s32& fonts)
+{
+    fps.m_nb_scenes = 0;
+    fonts           = -1;
+    FILE* f         = fopen(filename, "rb");
+    if (f == nullptr)
+        return false;
+
+    char line[512];
+    while (fgets(line, sizeof(line), f) != nullptr && fps.m_nb_scenes < FINGERPRINT_MAX_SCENES)
+    {
+        if (line[0] == '#')
+        {
+            sscanf(line, "# qmk-keymap-wiz fingerprints 1 fonts %d", &fonts);
+            continue;
+        }
+        sfingerprint_t&    fp = fps.m_scenes[fps.m_nb_scenes];
+        unsigned long long exact, geometry;
+        if (sscanf(line, "%47s %d %d %d %llx %llx %f %f %f %f %f %f %f", fp.m_name, &fp.m_vertices, &fp.m_indices, &fp.m_commands, &exact, &geometry, &fp.m_mean_x, &fp.m_mean_y, &fp.m_min_x, &fp.m_min_y, &fp.m_max_x, &fp.m_max_y,
+                   &fp.m_spread) == 13)
+        {
+            fp.m_exact    = exact;
+            fp.m_geometry = geometry;
+            fps.m_nb_scenes += 1;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+static bool within(float a, float b, float tolerance) { return fabsf(a - b) <= tolerance; }
+
+static const char* compare(sfingerprint_t const& now, sfingerprint_t const* golden, float tolerance)
+{
+    if (golden == nullptr)
+        return "new";
+    if (now.m_vertices != golden->m_vertices || now.m_indices != golden->m_indices || now.m_commands != golden->m_commands || now.m_exact != golden->m_exact)
+        return "changed";
+    if (now.m_geometry == golden->m_geometry)
+        return "identical";
+    bool const close = within(now.m_mean_x, golden->m_mean_x, tolerance) && within(now.m_mean_y, golden->m_mean_y, tolerance) && within(now.m_min_x, golden->m_min_x, tolerance) && within(now.m_min_y, golden->m_min_y, tolerance) &&
+                       within(now.m_max_x, golden->m_max_x, tolerance) && within(now.m_max_y, golden->m_max_y, tolerance) && within(now.m_spread, golden->m_spread, tolerance);
+    return close ? "tolerance" : "changed";
+}
+
+bool keyboard_fingerprint(kwriter_t* out, keycodes_t const* kcdb, const char* golden, bool update, float tolerance, const char* tmpdir)
+{
+    if (tolerance <= 0.0f)
+        tolerance = 1.0f / 64.0f;
+
+    bool const fonts = keyboard_bench_context();
+    if (!fonts)
+        printf("fonts/ not found, the labels are rendered with the default font\n");
+
+    static sfingerprints_t    s_now;
+    static sfingerprints_t    s_golden;
+    static const kbenchsize_t s_sizes[] = {{36, 4}, {360, 8}};
+    s_now.m_nb_scenes                   = 0;
+    for (s32 i = 0; i < 2; ++i)
+        fingerprint_size(s_now, kcdb, s_sizes[i], tolerance, tmpdir);
+    ImGui::DestroyContext();
+
+    if (update)
+    {
+        if (!write_golden(golden, s_now, fonts, tolerance))
+        {
+            printf("failed to write %s\n", golden);
+            return false;
+        }
+        printf("wrote %d fingerprints to %s\n", s_now.m_nb_scenes, golden);
+        return s_now.m_nb_scenes > 0;
+    }
+
+    s32 golden_fonts = -1;
+    if (!read_golden(golden, s_golden, golden_fonts))
+    {
+        printf("failed to read %s, write it with --update\n", golden);
+        return false;
+    }
+    if (golden_fonts >= 0 && golden_fonts != (fonts ? 1 : 0))
+        printf("warning: %s was made %s the fonts, the labels differ\n", golden, golden_fonts ? "with" : "without");
+
+    s32 counts[4] = {0, 0, 0, 0}; // identical, tolerance, changed, new
+    if (out != nullptr)
+        writer_str(*out, "{\n  \"scenes\": [");
+    for (s32 i = 0; i < s_now.m_nb_scenes; ++i)
+    {
+        sfingerprint_t const& now = s_now.m_scenes[i];
+        sfingerprint_t const* old = nullptr;
+        for (s32 g = 0; g < s_golden.m_nb_scenes && old == nullptr; ++g)
+            old = strcmp(s_golden.m_scenes[g].m_name, now.m_name) == 0 ? &s_golden.m_scenes[g] : nullptr;
+
+        const char* status = compare(now, old, tolerance);
+        counts[status[0] == 'i' ? 0 : (status[0] == 't' ? 1 : (status[0] == 'c' ? 2 : 3))] += 1;
+        if (old != nullptr && status[0] != 'i')
+            printf("%-24s %-9s %6d -> %6d vertices %6d -> %6d indices %4d -> %4d commands\n", now.m_name, status, old->m_vertices, now.m_vertices, old->m_indices, now.m_indices, old->m_commands, now.m_commands);
+        else if (old == nullptr)
+            printf("%-24s %-9s %6d vertices %6d indices %4d commands\n", now.m_name, status, now.m_vertices, now.m_indices, now.m_commands);
+
+        if (out != nullptr)
+        {
+            char line[384];
+            snprintf(line, sizeof(line), "%s\n    {\"scene\": \"%s\", \"status\": \"%s\", \"vertices\": %d, \"indices\": %d, \"commands\": %d, \"golden_vertices\": %d, \"golden_indices\": %d, \"golden_commands\": %d}", i == 0 ? "" : ",", now.m_name, status,
+                     now.m_vertices, now.m_indices, now.m_commands, old != nullptr ? old->m_vertices : 0, old != nullptr ? old->m_indices : 0, old != nullptr ? old->m_commands : 0);
+            writer_str(*out, line);
+        }
+    }
+    if (out != nullptr)
+        writer_str(*out, "\n  ]\n}\n");
+
+    // scenes that are in the golden file but were not rendered
+    s32 missing = 0;
+    for (s32 g = 0; g < s_golden.m_nb_scenes; ++g)
+    {
+        bool found = false;
+        for (s32 i = 0; i < s_now.m_nb_scenes && !found; ++i)
+            found = strcmp(s_golden.m_scenes[g].m_name, s_now.m_scenes[i].m_name) == 0;
+        if (!found)
+        {
+            printf("%-24s missing\n", s_golden.m_scenes[g].m_name);
+            missing += 1;
+        }
+    }
+
+    printf("%d scenes: %d identical, %d within a tolerance of %g px, %d changed, %d new, %d missing\n", s_now.m_nb_scenes, counts[0], counts[1], tolerance, counts[2], counts[3], missing);
+    return s_now.m_nb_scenes > 0 && counts[2] == 0 && counts[3] == 0 && missing == 0;
+}
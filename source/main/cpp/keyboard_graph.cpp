@@ -0,0 +1,398 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_graph.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace xcore
+{
+    u32 edge_kinds(u16 layer_switch)
+    {
+        u32 kinds = 0;
+        if ((layer_switch & (MO | LT | TT)) != 0)
+            kinds |= EDGE_MOMENTARY;
+        if ((layer_switch & (TG | TT)) != 0)
+            kinds |= EDGE_TOGGLE;
+        if ((layer_switch & TO) != 0)
+            kinds |= EDGE_SWITCH;
+        if ((layer_switch & OSL) != 0)
+            kinds |= EDGE_ONESHOT;
+        return kinds;
+    }
+
+    enum
+    {
+        NB_KINDS = 4, // bits in eedge
+    };
+
+    // what a single key contributes to the graph
+    struct kgraphkey_t
+    {
+        s16 m_target; // -1 when the key is not a (valid) layer switch
+        u8  m_kinds;
+        u8  m_transparent;
+    };
+
+    struct kgraph_t
+    {
+        keymap_t const* m_km;
+        s32             m_nb_layers;
+        s32*            m_key_base; // m_nb_layers + 1 entries
+        kgraphkey_t*    m_keys;
+        u16*            m_counts; // number of keys per (from, to, kind), m_nb_layers * m_nb_layers * NB_KINDS
+
+        kgraphlayer_t* m_layers;
+        s32            m_nb_edges;
+        kgraphedge_t*  m_edges; // at most m_nb_layers * m_nb_layers
+        s32            m_nb_cycles;
+        u32            m_version;
+    };
+
+    kgraph_t* graph_create()
+    {
+        kgraph_t* g    = (kgraph_t*)::malloc(sizeof(kgraph_t));
+        g->m_km        = nullptr;
+        g->m_nb_layers = 0;
+        g->m_key_base  = nullptr;
+        g->m_keys      = nullptr;
+        g->m_counts    = nullptr;
+        g->m_layers    = nullptr;
+        g->m_nb_edges  = 0;
+        g->m_edges     = nullptr;
+        g->m_nb_cycles = 0;
+        g->m_version   = 0;
+        return g;
+    }
+
+    static void graph_free(kgraph_t* g)
+    {
+        ::free(g->m_key_base);
+        ::free(g->m_keys);
+        ::free(g->m_counts);
+        ::free(g->m_layers);
+        ::free(g->m_edges);
+    }
+
+    void graph_destroy(kgraph_t* g)
+    {
+        if (g == nullptr)
+            return;
+        graph_free(g);
+        ::free(g);
+    }
+
+    static kgraphkey_t graph_key(kgraph_t* g, keymap_t const* km, s32 layer, s32 key)
+    {
+        xcore::key_t const& k = km->m_layers[layer].m_keys[key];
+
+        kgraphkey_t gk;
+        gk.m_target      = -1;
+        gk.m_kinds       = 0;
+        gk.m_transparent = is_transparent_keycode(k.m_keycode_str) ? 1 : 0;
+        if (k.m_layer_switch != 0)
+        {
+            s32 const target = find_layer(km, k.m_layer);
+            if (target >= 0 && target < g->m_nb_layers)
+            {
+                gk.m_target = (s16)target;
+                gk.m_kinds  = (u8)edge_kinds(k.m_layer_switch);
+            }
+        }
+        return gk;
+    }
+
+    static void graph_count(kgraph_t* g, s32 from, kgraphkey_t const& gk, s32 delta)
+    {
+        if (gk.m_target < 0)
+            return;
+        u16* counts = &g->m_counts[(from * g->m_nb_layers + gk.m_target) * NB_KINDS];
+        for (s32 b = 0; b < NB_KINDS; ++b)
+        {
+            if ((gk.m_kinds & (1 << b)) != 0)
+                counts[b] = (u16)(counts[b] + delta);
+        }
+    }
+
+    static inline u64 layer_bit(s32 layer) { return (u64)1 << layer; }
+
+    static void graph_analyze(kgraph_t* g)
+    {
+        s32 const L = g->m_nb_layers;
+
+        // adjacency as bitsets, self edges are left out of these
+        u64 any[GRAPH_MAX_LAYERS];
+        u64 momentary[GRAPH_MAX_LAYERS];
+        u64 to[GRAPH_MAX_LAYERS];
+        u64 persistent_in = 0;
+        u64 self_off      = 0;
+
+        g->m_nb_edges = 0;
+        for (s32 i = 0; i < L; ++i)
+        {
+            any[i]       = 0;
+            momentary[i] = 0;
+            to[i]        = 0;
+            for (s32 j = 0; j < L; ++j)
+            {
+                u16 const* counts = &g->m_counts[(i * L + j) * NB_KINDS];
+                u32        kinds  = 0;
+                u32        count  = 0;
+                for (s32 b = 0; b < NB_KINDS; ++b)
+                {
+                    if (counts[b] != 0)
+                        kinds |= 1 << b;
+                    count += counts[b];
+                }
+                if (kinds == 0)
+                    continue;
+
+                kgraphedge_t& e = g->m_edges[g->m_nb_edges++];
+                e.m_from        = (s16)i;
+                e.m_to          = (s16)j;
+                e.m_kinds       = (u16)kinds;
+                e.m_count       = (u16)(count > 0xffff ? 0xffff : count);
+
+                if (i == j)
+                {
+                    if ((kinds & EDGE_TOGGLE) != 0)
+                        self_off |= layer_bit(i);
+                    continue;
+                }
+                any[i] |= layer_bit(j);
+                if ((kinds & (EDGE_MOMENTARY | EDGE_ONESHOT)) != 0)
+                    momentary[i] |= layer_bit(j);
+                if ((kinds & EDGE_SWITCH) != 0)
+                    to[i] |= layer_bit(j);
+            }
+        }
+
+        // a toggle key that has a transparent key above it on the layer it toggles can also toggle it off
+        for (s32 l = 0; l < L; ++l)
+        {
+            for (s32 k = g->m_key_base[l]; k < g->m_key_base[l + 1]; ++k)
+            {
+                kgraphkey_t const& gk = g->m_keys[k];
+                if (gk.m_target < 0 || gk.m_target == l || (gk.m_kinds & EDGE_TOGGLE) == 0)
+                    continue;
+                s32 const index = k - g->m_key_base[l];
+                s32 const above = g->m_key_base[gk.m_target] + index;
+                if (above < g->m_key_base[gk.m_target + 1] && g->m_keys[above].m_transparent != 0)
+                    self_off |= layer_bit(gk.m_target);
+            }
+        }
+
+        // breadth first from the base layer
+        for (s32 i = 0; i < L; ++i)
+        {
+            kgraphlayer_t& gl = g->m_layers[i];
+            gl.m_reachable    = false;
+            gl.m_trap         = false;
+            gl.m_depth        = -1;
+            gl.m_cycle        = -1;
+            gl.m_via          = 0;
+        }
+        if (L == 0)
+            return;
+
+        s32 queue[GRAPH_MAX_LAYERS];
+        s32 head  = 0;
+        s32 tail  = 0;
+        u64 seen  = layer_bit(0);
+        queue[tail++]          = 0;
+        g->m_layers[0].m_depth = 0;
+        while (head < tail)
+        {
+            s32 const from = queue[head++];
+            for (s32 to_layer = 0; to_layer < L; ++to_layer)
+            {
+                if ((any[from] & layer_bit(to_layer)) == 0 || (seen & layer_bit(to_layer)) != 0)
+                    continue;
+                seen |= layer_bit(to_layer);
+                g->m_layers[to_layer].m_depth = (s16)(g->m_layers[from].m_depth + 1);
+                queue[tail++]                 = to_layer;
+            }
+        }
+
+        for (s32 e = 0; e < g->m_nb_edges; ++e)
+        {
+            kgraphedge_t const& edge = g->m_edges[e];
+            if (edge.m_from != edge.m_to && (seen & layer_bit(edge.m_from)) != 0)
+            {
+                g->m_layers[edge.m_to].m_via |= edge.m_kinds;
+                if ((edge.m_kinds & EDGE_PERSISTENT) != 0)
+                    persistent_in |= layer_bit(edge.m_to);
+            }
+        }
+
+        // the layers with a way back, iterated until nothing changes (at most L rounds)
+        u64 back = layer_bit(0) | self_off;
+        for (s32 i = 1; i < L; ++i)
+        {
+            if ((to[i] & layer_bit(0)) != 0)
+                back |= layer_bit(i);
+        }
+        for (s32 i = 1; i < L; ++i)
+        {
+            for (s32 j = 0; j < L; ++j)
+            {
+                if ((momentary[i] & layer_bit(j)) != 0 && (to[j] & layer_bit(0)) != 0)
+                    back |= layer_bit(i);
+            }
+        }
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (s32 i = 1; i < L; ++i)
+            {
+                if ((back & layer_bit(i)) == 0 && (to[i] & back) != 0)
+                {
+                    back |= layer_bit(i);
+                    changed = true;
+                }
+            }
+        }
+
+        for (s32 i = 0; i < L; ++i)
+        {
+            kgraphlayer_t& gl = g->m_layers[i];
+            gl.m_reachable    = (seen & layer_bit(i)) != 0;
+            gl.m_trap         = i > 0 && gl.m_reachable && (persistent_in & layer_bit(i)) != 0 && (back & layer_bit(i)) == 0;
+        }
+
+        // momentary cycles, the transitive closure (Warshall) on the bitsets, layers that reach each other share a cycle
+        u64 closure[GRAPH_MAX_LAYERS];
+        for (s32 i = 0; i < L; ++i)
+            closure[i] = momentary[i];
+        for (s32 k = 0; k < L; ++k)
+        {
+            for (s32 i = 0; i < L; ++i)
+            {
+                if ((closure[i] & layer_bit(k)) != 0)
+                    closure[i] |= closure[k];
+            }
+        }
+        g->m_nb_cycles = 0;
+        for (s32 i = 0; i < L; ++i)
+        {
+            if (g->m_layers[i].m_cycle >= 0 || (closure[i] & layer_bit(i)) == 0)
+                continue;
+            s16 const cycle = (s16)g->m_nb_cycles++;
+            for (s32 j = i; j < L; ++j)
+            {
+                if ((closure[i] & layer_bit(j)) != 0 && (closure[j] & layer_bit(i)) != 0)
+                    g->m_layers[j].m_cycle = cycle;
+            }
+        }
+    }
+
+    void graph_build(kgraph_t* g, keymap_t const* km)
+    {
+        graph_free(g);
+
+        s32 const L    = km->m_nb_layers < GRAPH_MAX_LAYERS ? km->m_nb_layers : GRAPH_MAX_LAYERS;
+        g->m_km        = km;
+        g->m_nb_layers = L;
+        g->m_key_base  = (s32*)::malloc(sizeof(s32) * (L + 1));
+
+        s32 nb_keys = 0;
+        for (s32 l = 0; l < L; ++l)
+        {
+            g->m_key_base[l] = nb_keys;
+            nb_keys += km->m_layers[l].m_nb_keys;
+        }
+        g->m_key_base[L] = nb_keys;
+
+        g->m_keys   = (kgraphkey_t*)::malloc(sizeof(kgraphkey_t) * (nb_keys + 1));
+        g->m_counts = (u16*)::calloc(L * L * NB_KINDS + 1, sizeof(u16));
+        g->m_layers = (kgraphlayer_t*)::malloc(sizeof(kgraphlayer_t) * (L + 1));
+        g->m_edges  = (kgraphedge_t*)::malloc(sizeof(kgraphedge_t) * (L * L + 1));
+
+        for (s32 l = 0; l < L; ++l)
+        {
+            for (s32 k = 0; k < km->m_layers[l].m_nb_keys; ++k)
+            {
+                kgraphkey_t const gk            = graph_key(g, km, l, k);
+                g->m_keys[g->m_key_base[l] + k] = gk;
+                graph_count(g, l, gk, 1);
+            }
+        }
+
+        graph_analyze(g);
+        g->m_version += 1;
+    }
+
+    bool graph_update(kgraph_t* g, keymap_t const* km, kedit_t const& edit)
+    {
+        if (edit.m_op != EDIT_KEYCODE && edit.m_op != EDIT_LAYER_SWITCH && edit.m_op != EDIT_LAYER)
+            return false;
+        if (edit.m_layer < 0 || edit.m_layer >= g->m_nb_layers || edit.m_key < 0 || edit.m_key >= g->m_key_base[edit.m_layer + 1] - g->m_key_base[edit.m_layer])
+            return false;
+
+        kgraphkey_t&      old = g->m_keys[g->m_key_base[edit.m_layer] + edit.m_key];
+        kgraphkey_t const gk  = graph_key(g, km, edit.m_layer, edit.m_key);
+        if (gk.m_target == old.m_target && gk.m_kinds == old.m_kinds && gk.m_transparent == old.m_transparent)
+            return false;
+
+        graph_count(g, edit.m_layer, old, -1);
+        graph_count(g, edit.m_layer, gk, 1);
+        old     = gk;
+        g->m_km = km;
+
+        graph_analyze(g);
+        g->m_version += 1;
+        return true;
+    }
+
+    s32                  graph_nb_layers(kgraph_t* g) { return g->m_nb_layers; }
+    kgraphlayer_t const* graph_layers(kgraph_t* g) { return g->m_layers; }
+    s32                  graph_nb_edges(kgraph_t* g) { return g->m_nb_edges; }
+    kgraphedge_t const*  graph_edges(kgraph_t* g) { return g->m_edges; }
+    s32                  graph_nb_cycles(kgraph_t* g) { return g->m_nb_cycles; }
+    u32                  graph_version(kgraph_t* g) { return g->m_version; }
+
+    static s32 graph_report(diag_fn fn, void* user, ediag code, s32 layer, const char* name)
+    {
+        if (fn != nullptr)
+        {
+            kdiag_t diag;
+            diag.m_code   = code;
+            diag.m_layer  = layer;
+            diag.m_key    = -1;
+            diag.m_detail = name;
+            fn(diag, user);
+        }
+        return 1;
+    }
+
+    s32 graph_lint(kgraph_t* g, keymap_t const* km, diag_fn fn, void* user)
+    {
+        s32 problems = 0;
+        for (s32 l = 1; l < g->m_nb_layers; ++l)
+        {
+            kgraphlayer_t const& gl = g->m_layers[l];
+            if (!gl.m_reachable)
+                problems += graph_report(fn, user, DIAG_UNREACHABLE, l, km->m_layers[l].m_name);
+            if (gl.m_trap)
+                problems += graph_report(fn, user, DIAG_LAYER_TRAP, l, km->m_layers[l].m_name);
+        }
+        for (s32 l = 0; l < g->m_nb_layers; ++l)
+        {
+            if (g->m_layers[l].m_cycle >= 0)
+                problems += graph_report(fn, user, DIAG_LAYER_CYCLE, l, km->m_layers[l].m_name);
+        }
+        return problems;
+    }
+
+    s32 lint_layers(keymap_t const* km, diag_fn fn, void* user)
+    {
+        kgraph_t* g = graph_create();
+        graph_build(g, km);
+        s32 const problems = graph_lint(g, km, fn, user);
+        graph_destroy(g);
+        return problems;
+    }
+
+} // namespace xcore
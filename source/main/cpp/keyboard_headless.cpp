@@ -0,0 +1,438 @@
+#include "xbase/x_base.h"
+#include "xbase/x_memory.h"
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_layout.h"
+#include "qmk-keymap-wiz/keyboard_image.h"
+#include "qmk-keymap-wiz/keyboard_render.h"
+#include "qmk-keymap-wiz/keyboard_headless.h"
+
+#include "libimgui/imgui.h"
+#include "libimgui/imgui_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h> // floorf, ceilf, sqrtf
+
+using namespace xcore;
+
+struct sheadless_t
+{
+    sheadless_t()
+    {
+        m_atlas        = nullptr;
+        m_fonts[0]     = nullptr;
+        m_fonts[1]     = nullptr;
+        m_fonts[2]     = nullptr;
+        m_fonts[3]     = nullptr;
+        m_atlas_pixels = nullptr;
+        m_atlas_w      = 0;
+        m_atlas_h      = 0;
+    }
+
+    ImFontAtlas*   m_atlas;
+    ImFont*        m_fonts[4];
+    unsigned char* m_atlas_pixels; // alpha8
+    int            m_atlas_w;
+    int            m_atlas_h;
+};
+
+static sheadless_t s_headless;
+
+static const u8 sColorBackground[] = {10, 10, 10, 255};
+
+bool keyboard_headless_init()
+{
+    // the font atlas is built on the CPU, no ImGui context or renderer backend is needed for this
+    s_headless.m_atlas = IM_NEW(ImFontAtlas)();
+    keyboard_addfonts(s_headless.m_atlas, s_headless.m_fonts);
+    if (s_headless.m_fonts[0] == nullptr)
+    {
+        printf("failed to load the keyboard fonts\n");
+        return false;
+    }
+    s_headless.m_atlas->GetTexDataAsAlpha8(&s_headless.m_atlas_pixels, &s_headless.m_atlas_w, &s_headless.m_atlas_h);
+    return true;
+}
+
+void keyboard_headless_exit()
+{
+    if (s_headless.m_atlas)
+    {
+        IM_DELETE(s_headless.m_atlas);
+        s_headless.m_atlas = nullptr;
+    }
+    for (int i = 0; i < 4; i++)
+        s_headless.m_fonts[i] = nullptr;
+    s_headless.m_atlas_pixels = nullptr;
+}
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// Scene, the key placement of a keyboard moved so that it starts at a margin from the top/left corner
+
+struct sscene_t
+{
+    ckeyplace_t* m_places;
+    s32          m_nb_places;
+    float        m_w;
+    float        m_h;
+};
+
+static void scene_layout(sscene_t& scene, ckeyboard_t const* kb, float globalscale)
+{
+    s32 const nb_keys = keyboard_nb_keys(kb);
+    scene.m_places    = (ckeyplace_t*)::malloc(sizeof(ckeyplace_t) * (nb_keys > 0 ? nb_keys : 1));
+    scene.m_nb_places = keyboard_layout(kb, 0.0f, 0.0f, globalscale, scene.m_places, nb_keys);
+
+    float minx = 0.0f, miny = 0.0f, maxx = 0.0f, maxy = 0.0f;
+    for (s32 i = 0; i < scene.m_nb_places; ++i)
+    {
+        ckeyplace_t const& p   = scene.m_places[i];
+        float const        ext = sqrtf(p.m_hw * p.m_hw + p.m_hh * p.m_hh) + p.m_th;
+        if (i == 0 || p.m_x - ext < minx)
+            minx = p.m_x - ext;
+        if (i == 0 || p.m_y - ext < miny)
+            miny = p.m_y - ext;
+        if (i == 0 || p.m_x + ext > maxx)
+            maxx = p.m_x + ext;
+        if (i == 0 || p.m_y + ext > maxy)
+            maxy = p.m_y + ext;
+    }
+
+    float const margin = 20.0f * globalscale;
+    for (s32 i = 0; i < scene.m_nb_places; ++i)
+    {
+        scene.m_places[i].m_x += margin - minx;
+        scene.m_places[i].m_y += margin - miny;
+    }
+    scene.m_w = ceilf((maxx - minx) + 2 * margin);
+    scene.m_h = ceilf((maxy - miny) + 2 * margin);
+}
+
+static void scene_release(sscene_t& scene)
+{
+    ::free(scene.m_places);
+    scene.m_places    = nullptr;
+    scene.m_nb_places = 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// Colors and text, these follow what key_render does with ImGui
+
+struct skeycolors_t
+{
+    float m_cap[4];
+    float m_txt[4];
+    float m_led[3][4]; // the 3 rings of the led glow, outer to inner
+};
+
+static void to_color(u8 const* c, float* color)
+{
+    for (int i = 0; i < 4; i++)
+        color[i] = c[i] / 255.0f;
+}
+
+static void darken_alpha(float const* c, float p, float a, float* color)
+{
+    color[0] = c[0] - (c[0] * p);
+    color[1] = c[1] - (c[1] * p);
+    color[2] = c[2] - (c[2] * p);
+    color[3] = c[3] - (c[2] * a);
+    if (color[3] < 0.0f)
+        color[3] = 0.0f;
+}
+
+static void key_colors(ckeyplace_t const& place, skeycolors_t& colors)
+{
+    to_color(place.m_capcolor, colors.m_cap);
+    to_color(place.m_txtcolor, colors.m_txt);
+    to_color(place.m_ledcolor, colors.m_led[2]);
+    darken_alpha(colors.m_led[2], 0.2f, 0.5f, colors.m_led[0]);
+    darken_alpha(colors.m_led[2], 0.1f, 0.25f, colors.m_led[1]);
+}
+
+static float key_rounding(ckeyplace_t const& place)
+{
+    float r = place.m_rounding;
+    if (r > place.m_hw - 1.0f)
+        r = place.m_hw - 1.0f;
+    if (r > place.m_hh - 1.0f)
+        r = place.m_hh - 1.0f;
+    return r < 0.0f ? 0.0f : r;
+}
+
+// split a label on spaces into at most 4 lines, returns the number of lines
+static int split_label(const char* key_label, char* text, int maxlen, const char** lines)
+{
+    int num_lines      = 0;
+    int i              = 0;
+    lines[num_lines++] = text;
+    text[0]            = 0;
+    while (key_label[i] != 0 && num_lines < 4 && i < maxlen - 2)
+    {
+        if (key_label[i] == ' ')
+        {
+            text[i]            = 0;
+            lines[num_lines++] = (text + i + 1);
+            text[i + 1]        = 0;
+        }
+        else
+        {
+            text[i]     = key_label[i];
+            text[i + 1] = 0;
+        }
+        i++;
+    }
+    return num_lines;
+}
+
+struct stextsize_t
+{
+    ImFont const* m_font;
+    float         m_size;
+    float         m_w;
+    float         m_h;
+    float         m_ascent;
+};
+
+// select the largest font for which the text still fits on the key
+static void select_font(const char* txt, float kw, float globalscale, stextsize_t& ts)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        ImFont const* font = s_headless.m_fonts[i];
+        if (font == nullptr)
+        {
+            // no fonts, estimate the text size
+            ts.m_font   = nullptr;
+            ts.m_size   = (28.0f - 4.0f * i) * globalscale;
+            ts.m_w      = 0.5f * ts.m_size * (float)strlen(txt);
+            ts.m_h      = ts.m_size;
+            ts.m_ascent = 0.8f * ts.m_size;
+        }
+        else
+        {
+            ImVec2 const td = font->CalcTextSizeA(font->FontSize * globalscale, FLT_MAX, 0.0f, txt);
+            ts.m_font       = font;
+            ts.m_size       = font->FontSize * globalscale;
+            ts.m_w          = floorf(td.x + 0.99999f);
+            ts.m_h          = td.y;
+            ts.m_ascent     = font->Ascent * globalscale;
+        }
+        if ((ts.m_w * 1.1f) < kw)
+            break;
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// SVG
+
+static void svg_color(FILE* f, const char* attr, float const* color)
+{
+    fprintf(f, " %s=\"#%02x%02x%02x\"", attr, (int)(color[0] * 255.0f + 0.5f), (int)(color[1] * 255.0f + 0.5f), (int)(color[2] * 255.0f + 0.5f));
+    if (color[3] < 1.0f)
+        fprintf(f, " %s-opacity=\"%.3f\"", attr, color[3]);
+}
+
+static void svg_text(FILE* f, float x, float y, stextsize_t const& ts, float const* color, const char* txt)
+{
+    fprintf(f, "    <text x=\"%.2f\" y=\"%.2f\" font-size=\"%.2f\" text-anchor=\"middle\"", x, y + ts.m_ascent, ts.m_size);
+    svg_color(f, "fill", color);
+    fprintf(f, ">");
+    for (const char* c = txt; *c != 0; ++c)
+    {
+        switch (*c)
+        {
+            case '&': fputs("&amp;", f); break;
+            case '<': fputs("&lt;", f); break;
+            case '>': fputs("&gt;", f); break;
+            case '"': fputs("&quot;", f); break;
+            case '\'': fputs("&apos;", f); break;
+            default: fputc(*c, f); break;
+        }
+    }
+    fprintf(f, "</text>\n");
+}
+
+bool keyboard_render_svg(const char* filename, ckeyboard_t const* kb, keycodes_t const* kcdb, keymap_t const* km, s32 layer, float globalscale)
+{
+    FILE* f = fopen(filename, "wb");
+    if (!f)
+    {
+        printf("failed to open file %s\n", filename);
+        return false;
+    }
+
+    sscene_t scene;
+    scene_layout(scene, kb, globalscale);
+
+    float background[4];
+    to_color(sColorBackground, background);
+
+    fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    fprintf(f, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" viewBox=\"0 0 %d %d\">\n", (int)scene.m_w, (int)scene.m_h, (int)scene.m_w, (int)scene.m_h);
+    fprintf(f, "  <title>%s - %s</title>\n", kb->m_name, (km != nullptr && layer < km->m_nb_layers) ? km->m_layers[layer].m_name : "");
+    fprintf(f, "  <rect width=\"100%%\" height=\"100%%\"");
+    svg_color(f, "fill", background);
+    fprintf(f, "/>\n");
+    fprintf(f, "  <g font-family=\"Roboto, FreeSerif, FontAwesome, sans-serif\" font-weight=\"500\">\n");
+
+    for (s32 i = 0; i < scene.m_nb_places; ++i)
+    {
+        ckeyplace_t const& place = scene.m_places[i];
+
+        skeycolors_t colors;
+        key_colors(place, colors);
+
+        float const x        = place.m_x;
+        float const y        = place.m_y;
+        float const hw       = place.m_hw;
+        float const hh       = place.m_hh;
+        float const th       = place.m_th;
+        float const rounding = key_rounding(place);
+
+        fprintf(f, "   <g transform=\"rotate(%.3f %.2f %.2f)\">\n", place.m_rad * 180.0f / 3.141592653f, x, y);
+
+        float const thickness[3] = {th / 1.0f, th / 2.0f, th / 3.0f};
+        for (int r = 0; r < 3; r++)
+        {
+            fprintf(f, "    <rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" rx=\"%.2f\" fill=\"none\" stroke-width=\"%.2f\"", x - hw, y - hh, 2 * hw, 2 * hh, rounding, thickness[r]);
+            svg_color(f, "stroke", colors.m_led[r]);
+            fprintf(f, "/>\n");
+        }
+        fprintf(f, "    <rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" rx=\"%.2f\"", x - hw, y - hh, 2 * hw, 2 * hh, rounding);
+        svg_color(f, "fill", colors.m_cap);
+        fprintf(f, "/>\n");
+
+        const char* key_label = keyplace_label(place, kcdb, km, layer);
+        if (key_label != nullptr)
+        {
+            char        text[128];
+            const char* lines[4]  = {nullptr, nullptr, nullptr, nullptr};
+            int const   num_lines = split_label(key_label, text, sizeof(text), lines);
+
+            stextsize_t ts;
+            if (num_lines == 1 && key_label[0] != 0)
+            {
+                select_font(key_label, 2 * hw, globalscale, ts);
+                svg_text(f, x, y - (ts.m_h / 2), ts, colors.m_txt, key_label);
+            }
+            else if (num_lines == 2)
+            {
+                select_font(lines[0], 2 * hw, globalscale, ts);
+                svg_text(f, x, y - (ts.m_h * 1.1f), ts, colors.m_txt, lines[0]);
+                select_font(lines[1], 2 * hw, globalscale, ts);
+                svg_text(f, x, y + (ts.m_h * 0.1f), ts, colors.m_txt, lines[1]);
+            }
+        }
+
+        if (place.m_key->m_nob)
+            fprintf(f, "    <line x1=\"%.2f\" y1=\"%.2f\" x2=\"%.2f\" y2=\"%.2f\" stroke=\"#ffffff\" stroke-width=\"2\"/>\n", x - (hw * 0.125f), y + 0.5f * hh, x + (hw * 0.125f), y + 0.5f * hh);
+
+        fprintf(f, "   </g>\n");
+    }
+
+    fprintf(f, "  </g>\n</svg>\n");
+
+    scene_release(scene);
+    bool const ok = ferror(f) == 0;
+    fclose(f);
+    return ok;
+}
+
+// --------------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------------------------------------------------------------------------------
+// PNG
+
+static void png_text(kimage_t& img, ckeyplace_t const& place, float ox, float oy, stextsize_t const& ts, float const* color, const char* txt)
+{
+    ImFont const* font = ts.m_font;
+    if (font == nullptr || s_headless.m_atlas_pixels == nullptr)
+        return;
+
+    // glyph quads are positioned relative to the center of the key, which is the pivot of the rotation
+    float const scale = ts.m_size / font->FontSize;
+    float       x     = floorf(place.m_x + ox) - place.m_x;
+    float const y     = floorf(place.m_y + oy) - place.m_y;
+    const char* s     = txt;
+    while (*s != 0)
+    {
+        unsigned int c = 0;
+        s += ImTextCharFromUtf8(&c, s, nullptr);
+        if (c == 0)
+            break;
+        ImFontGlyph const* glyph = font->FindGlyph((ImWchar)c);
+        if (glyph == nullptr)
+            continue;
+        if (glyph->Visible)
+        {
+            image_mask(img, place.m_x, place.m_y, place.m_rad, x + glyph->X0 * scale, y + glyph->Y0 * scale, x + glyph->X1 * scale, y + glyph->Y1 * scale, s_headless.m_atlas_pixels, s_headless.m_atlas_w, s_headless.m_atlas_h, glyph->U0, glyph->V0, glyph->U1, glyph->V1,
+                       color);
+        }
+        x += glyph->AdvanceX * scale;
+    }
+}
+
+bool keyboard_render_png(const char* filename, ckeyboard_t const* kb, keycodes_t const* kcdb, keymap_t const* km, s32 layer, float globalscale)
+{
+    sscene_t scene;
+    scene_layout(scene, kb, globalscale);
+
+    kimage_t img;
+    init_image(img, (s32)scene.m_w, (s32)scene.m_h, sColorBackground);
+
+    static const float sWhite[] = {1.0f, 1.0f, 1.0f, 1.0f};
+
+    for (s32 i = 0; i < scene.m_nb_places; ++i)
+    {
+        ckeyplace_t const& place = scene.m_places[i];
+
+        skeycolors_t colors;
+        key_colors(place, colors);
+
+        float const x        = place.m_x;
+        float const y        = place.m_y;
+        float const hw       = place.m_hw;
+        float const hh       = place.m_hh;
+        float const th       = place.m_th;
+        float const rounding = key_rounding(place);
+
+        image_roundrect(img, x, y, place.m_rad, 0.0f, 0.0f, hw, hh, rounding, th / 1.0f, colors.m_led[0]);
+        image_roundrect(img, x, y, place.m_rad, 0.0f, 0.0f, hw, hh, rounding, th / 2.0f, colors.m_led[1]);
+        image_roundrect(img, x, y, place.m_rad, 0.0f, 0.0f, hw, hh, rounding, th / 3.0f, colors.m_led[2]);
+        image_roundrect(img, x, y, place.m_rad, 0.0f, 0.0f, hw, hh, rounding, 0.0f, colors.m_cap);
+
+        const char* key_label = keyplace_label(place, kcdb, km, layer);
+        if (key_label != nullptr)
+        {
+            char        text[128];
+            const char* lines[4]  = {nullptr, nullptr, nullptr, nullptr};
+            int const   num_lines = split_label(key_label, text, sizeof(text), lines);
+
+            stextsize_t ts;
+            if (num_lines == 1 && key_label[0] != 0)
+            {
+                select_font(key_label, 2 * hw, globalscale, ts);
+                png_text(img, place, -(ts.m_w / 2), -(ts.m_h / 2), ts, colors.m_txt, key_label);
+            }
+            else if (num_lines == 2)
+            {
+                select_font(lines[0], 2 * hw, globalscale, ts);
+                png_text(img, place, -(ts.m_w / 2), -(ts.m_h * 1.1f), ts, colors.m_txt, lines[0]);
+                select_font(lines[1], 2 * hw, globalscale, ts);
+                png_text(img, place, -(ts.m_w / 2), (ts.m_h * 0.1f), ts, colors.m_txt, lines[1]);
+            }
+        }
+
+        if (place.m_key->m_nob)
+            image_roundrect(img, x, y, place.m_rad, 0.0f, 0.5f * hh, hw * 0.125f, 1.0f, 0.0f, 0.0f, sWhite);
+    }
+
+    bool const ok = write_png(filename, img);
+    exit_image(img);
+    scene_release(scene);
+    return ok;
+}
@@ -0,0 +1,443 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_image.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h> // sqrtf, sinf, cosf, floorf, ceilf
+
+namespace xcore
+{
+    void init_image(kimage_t& img, s32 w, s32 h, u8 const* clear_color)
+    {
+        img.m_w      = w;
+        img.m_h      = h;
+        img.m_pixels = (u8*)::malloc((size_t)w * h * 4);
+        for (s32 i = 0; i < w * h; ++i)
+        {
+            img.m_pixels[i * 4 + 0] = clear_color[0];
+            img.m_pixels[i * 4 + 1] = clear_color[1];
+            img.m_pixels[i * 4 + 2] = clear_color[2];
+            img.m_pixels[i * 4 + 3] = clear_color[3];
+        }
+    }
+
+    void exit_image(kimage_t& img)
+    {
+        ::free(img.m_pixels);
+        img.m_w      = 0;
+        img.m_h      = 0;
+        img.m_pixels = nullptr;
+    }
+
+    static inline float clamp01(float v) { return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v); }
+
+    // source-over blend of a non pre-multiplied color with coverage 'cov'
+    static inline void blend(u8* dst, float const* color, float cov)
+    {
+        float const sa = color[3] * cov;
+        if (sa <= 0.0f)
+            return;
+        float const da = dst[3] * (1.0f / 255.0f);
+        float const oa = sa + da * (1.0f - sa);
+        float const fd = da * (1.0f - sa);
+        for (s32 c = 0; c < 3; ++c)
+        {
+            float const v = (color[c] * sa + dst[c] * (1.0f / 255.0f) * fd) / oa;
+            dst[c]        = (u8)(clamp01(v) * 255.0f + 0.5f);
+        }
+        dst[3] = (u8)(clamp01(oa) * 255.0f + 0.5f);
+    }
+
+    struct sbounds_t
+    {
+        s32 x0, y0, x1, y1;
+    };
+
+    static bool clip_bounds(kimage_t const& img, float cx, float cy, float ext, sbounds_t& b)
+    {
+        b.x0 = (s32)floorf(cx - ext);
+        b.y0 = (s32)floorf(cy - ext);
+        b.x1 = (s32)ceilf(cx + ext);
+        b.y1 = (s32)ceilf(cy + ext);
+        if (b.x0 < 0)
+            b.x0 = 0;
+        if (b.y0 < 0)
+            b.y0 = 0;
+        if (b.x1 > img.m_w)
+            b.x1 = img.m_w;
+        if (b.y1 > img.m_h)
+            b.y1 = img.m_h;
+        return b.x0 < b.x1 && b.y0 < b.y1;
+    }
+
+    void image_roundrect(kimage_t& img, float px, float py, float rad, float cx, float cy, float hw, float hh, float rounding, float stroke, float const* color)
+    {
+        float const s = sinf(rad);
+        float const c = cosf(rad);
+
+        // the outline is drawn on a path that is inset by half a pixel, the same as ImGui does
+        if (stroke > 0.0f)
+        {
+            hw -= 0.5f;
+            hh -= 0.5f;
+        }
+        float r = rounding;
+        if (r > hw - 1.0f)
+            r = hw - 1.0f;
+        if (r > hh - 1.0f)
+            r = hh - 1.0f;
+        if (r < 0.0f)
+            r = 0.0f;
+
+        // center of the shape in image space
+        float const wx  = px + (cx * c - cy * s);
+        float const wy  = py + (cx * s + cy * c);
+        float const ext = sqrtf(hw * hw + hh * hh) + stroke + 1.0f;
+
+        sbounds_t b;
+        if (!clip_bounds(img, wx, wy, ext, b))
+            return;
+
+        for (s32 y = b.y0; y < b.y1; ++y)
+        {
+            u8* row = img.m_pixels + ((size_t)y * img.m_w * 4);
+            for (s32 x = b.x0; x < b.x1; ++x)
+            {
+                // pixel center into the local space of the shape
+                float const dx = (x + 0.5f) - px;
+                float const dy = (y + 0.5f) - py;
+                float const lx = (dx * c + dy * s) - cx;
+                float const ly = (-dx * s + dy * c) - cy;
+
+                // signed distance to the rounded rectangle
+                float const qx = fabsf(lx) - (hw - r);
+                float const qy = fabsf(ly) - (hh - r);
+                float const ox = qx > 0.0f ? qx : 0.0f;
+                float const oy = qy > 0.0f ? qy : 0.0f;
+                float const in = qx > qy ? qx : qy;
+                float const d  = sqrtf(ox * ox + oy * oy) + (in < 0.0f ? in : 0.0f) - r;
+
+                float const cov = (stroke > 0.0f) ? clamp01(stroke * 0.5f + 0.5f - fabsf(d)) : clamp01(0.5f - d);
+                if (cov > 0.0f)
+                    blend(row + x * 4, color, cov);
+            }
+        }
+    }
+
+    void image_mask(kimage_t& img, float px, float py, float rad, float x0, float y0, float x1, float y1, u8 const* mask, s32 mask_w, s32 mask_h, float u0, float v0, float u1, float v1, float const* color)
+    {
+        if (x1 <= x0 || y1 <= y0)
+            return;
+
+        float const s = sinf(rad);
+        float const c = cosf(rad);
+
+        float const cx  = (x0 + x1) * 0.5f;
+        float const cy  = (y0 + y1) * 0.5f;
+        float const wx  = px + (cx * c - cy * s);
+        float const wy  = py + (cx * s + cy * c);
+        float const ext = sqrtf((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0)) * 0.5f + 1.0f;
+
+        sbounds_t b;
+        if (!clip_bounds(img, wx, wy, ext, b))
+            return;
+
+        float const du = (u1 - u0) * mask_w / (x1 - x0);
+        float const dv = (v1 - v0) * mask_h / (y1 - y0);
+
+        for (s32 y = b.y0; y < b.y1; ++y)
+        {
+            u8* row = img.m_pixels + ((size_t)y * img.m_w * 4);
+            for (s32 x = b.x0; x < b.x1; ++x)
+            {
+                float const dx = (x + 0.5f) - px;
+                float const dy = (y + 0.5f) - py;
+                float const lx = dx * c + dy * s;
+                float const ly = -dx * s + dy * c;
+                if (lx < x0 || lx >= x1 || ly < y0 || ly >= y1)
+                    continue;
+
+                // bilinear sample of the mask
+                float const tu = u0 * mask_w + (lx - x0) * du - 0.5f;
+                float const tv = v0 * mask_h + (ly - y0) * dv - 0.5f;
+                s32 const   iu = (s32)floorf(tu);
+                s32 const   iv = (s32)floorf(tv);
+                float const fu = tu - iu;
+                float const fv = tv - iv;
+
+                float texels[4];
+                for (s32 t = 0; t < 4; ++t)
+                {
+                    s32 const su = iu + (t & 1);
+                    s32 const sv = iv + (t >> 1);
+                    texels[t]    = (su >= 0 && sv >= 0 && su < mask_w && sv < mask_h) ? mask[sv * mask_w + su] * (1.0f / 255.0f) : 0.0f;
+                }
+                float const top = texels[0] + (texels[1] - texels[0]) * fu;
+                float const bot = texels[2] + (texels[3] - texels[2]) * fu;
+                float const cov = top + (bot - top) * fv;
+                if (cov > 0.0f)
+                    blend(row + x * 4, color, cov);
+            }
+        }
+    }
+
+    // --------------------------------------------------------------------------------------------------------------------------
+    // --------------------------------------------------------------------------------------------------------------------------
+    // PNG encoding, a minimal deflate encoder (greedy LZ77, fixed Huffman codes) which does well on the large flat
+    // areas of a rendered keyboard.
+
+    struct sbits_t
+    {
+        u8* m_data;
+        s32 m_size;
+        s32 m_cap;
+        u32 m_bits;
+        s32 m_nbits;
+    };
+
+    static void bits_byte(sbits_t& bs, u8 b)
+    {
+        if (bs.m_size == bs.m_cap)
+        {
+            bs.m_cap  = bs.m_cap == 0 ? 65536 : bs.m_cap * 2;
+            bs.m_data = (u8*)::realloc(bs.m_data, bs.m_cap);
+        }
+        bs.m_data[bs.m_size++] = b;
+    }
+
+    static void bits_write(sbits_t& bs, u32 value, s32 count)
+    {
+        bs.m_bits |= value << bs.m_nbits;
+        bs.m_nbits += count;
+        while (bs.m_nbits >= 8)
+        {
+            bits_byte(bs, (u8)(bs.m_bits & 0xFF));
+            bs.m_bits >>= 8;
+            bs.m_nbits -= 8;
+        }
+    }
+
+    static void bits_flush(sbits_t& bs)
+    {
+        if (bs.m_nbits > 0)
+            bits_write(bs, 0, 8 - bs.m_nbits);
+    }
+
+    // Huffman codes are stored most significant bit first
+    static void bits_huff(sbits_t& bs, u32 code, s32 count)
+    {
+        u32 rev = 0;
+        for (s32 i = 0; i < count; ++i)
+            rev |= ((code >> i) & 1) << (count - 1 - i);
+        bits_write(bs, rev, count);
+    }
+
+    static void huff_literal(sbits_t& bs, u32 v)
+    {
+        if (v < 144)
+            bits_huff(bs, 0x30 + v, 8);
+        else if (v < 256)
+            bits_huff(bs, 0x190 + (v - 144), 9);
+        else if (v < 280)
+            bits_huff(bs, v - 256, 7);
+        else
+            bits_huff(bs, 0xC0 + (v - 280), 8);
+    }
+
+    static const u16 s_len_base[]  = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static const u8  s_len_extra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    static const u16 s_dst_base[]  = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    static const u8  s_dst_extra[] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+    static void huff_match(sbits_t& bs, s32 len, s32 dist)
+    {
+        s32 l = 0;
+        while (l < 28 && s_len_base[l + 1] <= len)
+            ++l;
+        huff_literal(bs, 257 + l);
+        if (s_len_extra[l])
+            bits_write(bs, len - s_len_base[l], s_len_extra[l]);
+
+        s32 d = 0;
+        while (d < 29 && s_dst_base[d + 1] <= dist)
+            ++d;
+        bits_huff(bs, d, 5);
+        if (s_dst_extra[d])
+            bits_write(bs, dist - s_dst_base[d], s_dst_extra[d]);
+    }
+
+    static inline s32 match_length(u8 const* data, s32 a, s32 b, s32 max)
+    {
+        s32 len = 0;
+        while (len < max && data[a + len] == data[b + len])
+            ++len;
+        return len;
+    }
+
+    static void zlib_compress(sbits_t& bs, u8 const* data, s32 size, s32 stride)
+    {
+        const s32 window    = 32768;
+        const s32 hash_bits = 15;
+
+        // zlib header (deflate, 32K window, no dictionary) and a single fixed Huffman block
+        bits_byte(bs, 0x78);
+        bits_byte(bs, 0x01);
+        bits_write(bs, 1, 1);
+        bits_write(bs, 1, 2);
+
+        s32* table = (s32*)::malloc(sizeof(s32) << hash_bits);
+        for (s32 i = 0; i < (1 << hash_bits); ++i)
+            table[i] = -window - 1;
+
+        s32 i = 0;
+        while (i < size)
+        {
+            s32 best_len  = 0;
+            s32 best_dist = 0;
+            s32 const max = (size - i) < 258 ? (size - i) : 258;
+            if (max >= 3)
+            {
+                u32 const h = ((data[i] << 16) | (data[i + 1] << 8) | data[i + 2]) * 2654435761u >> (32 - hash_bits);
+
+                // candidates: the last position with the same hash, the previous pixel and the pixel above
+                s32 const candidates[3] = {table[h], i - 4, i - stride};
+                for (s32 c = 0; c < 3; ++c)
+                {
+                    s32 const p = candidates[c];
+                    if (p < 0 || i - p > window || p >= i)
+                        continue;
+                    s32 const len = match_length(data, p, i, max);
+                    if (len > best_len)
+                    {
+                        best_len  = len;
+                        best_dist = i - p;
+                    }
+                }
+                table[h] = i;
+            }
+
+            if (best_len >= 3)
+            {
+                huff_match(bs, best_len, best_dist);
+                i += best_len;
+            }
+            else
+            {
+                huff_literal(bs, data[i]);
+                i += 1;
+            }
+        }
+        huff_literal(bs, 256);
+        bits_flush(bs);
+        ::free(table);
+
+        u32 a = 1, b = 0;
+        for (s32 j = 0; j < size; ++j)
+        {
+            a = (a + data[j]) % 65521;
+            b = (b + a) % 65521;
+        }
+        u32 const adler = (b << 16) | a;
+        bits_byte(bs, (u8)(adler >> 24));
+        bits_byte(bs, (u8)(adler >> 16));
+        bits_byte(bs, (u8)(adler >> 8));
+        bits_byte(bs, (u8)(adler));
+    }
+
+    struct scrc32table_t
+    {
+        scrc32table_t()
+        {
+            for (u32 n = 0; n < 256; ++n)
+            {
+                u32 c = n;
+                for (s32 k = 0; k < 8; ++k)
+                    c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+                m_table[n] = c;
+            }
+        }
+
+        u32 m_table[256];
+    };
+
+    static u32 crc32_update(u32 crc, u8 const* data, s32 size)
+    {
+        // PNGs are written from the workers of jobs_parallel_for, the initialization of a local static is thread-safe
+        static scrc32table_t const s_crc;
+        for (s32 i = 0; i < size; ++i)
+            crc = s_crc.m_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return crc;
+    }
+
+    static void write_u32(FILE* f, u32 v)
+    {
+        u8 const b[4] = {(u8)(v >> 24), (u8)(v >> 16), (u8)(v >> 8), (u8)v};
+        fwrite(b, 1, 4, f);
+    }
+
+    static void write_chunk(FILE* f, const char* type, u8 const* data, s32 size)
+    {
+        write_u32(f, (u32)size);
+        fwrite(type, 1, 4, f);
+        if (size > 0)
+            fwrite(data, 1, size, f);
+        u32 crc = crc32_update(0xFFFFFFFFu, (u8 const*)type, 4);
+        crc     = crc32_update(crc, data, size);
+        write_u32(f, crc ^ 0xFFFFFFFFu);
+    }
+
+    bool write_png(const char* filename, kimage_t const& img)
+    {
+        // raw scanlines, each prefixed with filter type 0 (none)
+        s32 const stride = 1 + img.m_w * 4;
+        s32 const size   = stride * img.m_h;
+        u8*       raw    = (u8*)::malloc(size);
+        for (s32 y = 0; y < img.m_h; ++y)
+        {
+            raw[y * stride] = 0;
+            memcpy(raw + y * stride + 1, img.m_pixels + (size_t)y * img.m_w * 4, img.m_w * 4);
+        }
+
+        sbits_t bs;
+        memset(&bs, 0, sizeof(bs));
+        zlib_compress(bs, raw, size, stride);
+        ::free(raw);
+
+        FILE* f = fopen(filename, "wb");
+        if (!f)
+        {
+            printf("failed to open file %s\n", filename);
+            ::free(bs.m_data);
+            return false;
+        }
+
+        static const u8 s_signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        fwrite(s_signature, 1, sizeof(s_signature), f);
+
+        u8 ihdr[13];
+        ihdr[0]  = (u8)(img.m_w >> 24);
+        ihdr[1]  = (u8)(img.m_w >> 16);
+        ihdr[2]  = (u8)(img.m_w >> 8);
+        ihdr[3]  = (u8)(img.m_w);
+        ihdr[4]  = (u8)(img.m_h >> 24);
+        ihdr[5]  = (u8)(img.m_h >> 16);
+        ihdr[6]  = (u8)(img.m_h >> 8);
+        ihdr[7]  = (u8)(img.m_h);
+        ihdr[8]  = 8; // bit depth
+        ihdr[9]  = 6; // color type RGBA
+        ihdr[10] = 0; // compression
+        ihdr[11] = 0; // filter
+        ihdr[12] = 0; // interlace
+        write_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+        write_chunk(f, "IDAT", bs.m_data, bs.m_size);
+        write_chunk(f, "IEND", nullptr, 0);
+
+        bool const ok = ferror(f) == 0;
+        fclose(f);
+        ::free(bs.m_data);
+        return ok;
+    }
+
+} // namespace xcore
@@ -0,0 +1,597 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_infojson.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace xcore
+{
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // A pull parser for the parts of JSON that the importer needs, everything else is skipped without building
+    // anything. After an error the cursor is at the end, so every loop stops.
+    struct kjson_t
+    {
+        const char* m_cursor;
+        const char* m_end;
+        const char* m_error; // nullptr while ok
+    };
+
+    static void json_fail(kjson_t& j, const char* error)
+    {
+        if (j.m_error == nullptr)
+            j.m_error = error;
+        j.m_cursor = j.m_end;
+    }
+
+    // white space, and the // # and /* */ comments of hjson
+    static void json_skip_ws(kjson_t& j)
+    {
+        while (j.m_cursor < j.m_end)
+        {
+            char const c    = *j.m_cursor;
+            char const next = j.m_cursor + 1 < j.m_end ? j.m_cursor[1] : 0;
+            if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+            {
+                j.m_cursor++;
+            }
+            else if (c == '#' || (c == '/' && next == '/'))
+            {
+                while (j.m_cursor < j.m_end && *j.m_cursor != '\n')
+                    j.m_cursor++;
+            }
+            else if (c == '/' && next == '*')
+            {
+                j.m_cursor += 2;
+                while (j.m_cursor + 1 < j.m_end && !(j.m_cursor[0] == '*' && j.m_cursor[1] == '/'))
+                    j.m_cursor++;
+                j.m_cursor = j.m_cursor + 1 < j.m_end ? j.m_cursor + 2 : j.m_end;
+            }
+            else
+            {
+                break;
+            }
+        }
+    }
+
+    static bool json_accept(kjson_t& j, char c)
+    {
+        json_skip_ws(j);
+        if (j.m_cursor >= j.m_end || *j.m_cursor != c)
+            return false;
+        j.m_cursor++;
+        return true;
+    }
+
+    static u32 json_hex4(kjson_t& j)
+    {
+        u32 value = 0;
+        for (s32 i = 0; i < 4; ++i)
+        {
+            char const c = j.m_cursor < j.m_end ? *j.m_cursor++ : 0;
+            if (c >= '0' && c <= '9')
+                value = (value << 4) | (u32)(c - '0');
+            else if (c >= 'a' && c <= 'f')
+                value = (value << 4) | (u32)(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F')
+                value = (value << 4) | (u32)(c - 'A' + 10);
+            else
+                return '?';
+        }
+        return value;
+    }
+
+    static s32 utf8_encode(u32 cp, char* out)
+    {
+        if (cp < 0x80)
+        {
+            out[0] = (char)cp;
+            return 1;
+        }
+        if (cp < 0x800)
+        {
+            out[0] = (char)(0xC0 | (cp >> 6));
+            out[1] = (char)(0x80 | (cp & 0x3F));
+            return 2;
+        }
+        if (cp < 0x10000)
+        {
+            out[0] = (char)(0xE0 | (cp >> 12));
+            out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+            out[2] = (char)(0x80 | (cp & 0x3F));
+            return 3;
+        }
+        out[0] = (char)(0xF0 | (cp >> 18));
+        out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+        out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[3] = (char)(0x80 | (cp & 0x3F));
+        return 4;
+    }
+
+    // a string into 'out' with the escapes decoded, truncated to 'maxlen' - 1 characters, 'out' may be nullptr
+    static bool json_string(kjson_t& j, char* out, s32 maxlen)
+    {
+        if (!json_accept(j, '"'))
+        {
+            json_fail(j, "expected a string");
+            return false;
+        }
+
+        s32 len = 0;
+        while (j.m_cursor < j.m_end && *j.m_cursor != '"')
+        {
+            char utf8[4];
+            s32  n  = 1;
+            utf8[0] = *j.m_cursor++;
+            if (utf8[0] == '\\' && j.m_cursor < j.m_end)
+            {
+                char const e = *j.m_cursor++;
+                switch (e)
+                {
+                    case 'n': utf8[0] = '\n'; break;
+                    case 'r': utf8[0] = '\r'; break;
+                    case 't': utf8[0] = '\t'; break;
+                    case 'b': utf8[0] = '\b'; break;
+                    case 'f': utf8[0] = '\f'; break;
+                    case 'u':
+                    {
+                        u32 cp = json_hex4(j);
+                        if (cp >= 0xD800 && cp < 0xDC00 && j.m_cursor + 1 < j.m_end && j.m_cursor[0] == '\\' && j.m_cursor[1] == 'u')
+                        {
+                            j.m_cursor += 2;
+                            u32 const low = json_hex4(j);
+                            cp            = (low >= 0xDC00 && low < 0xE000) ? 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00) : '?';
+                        }
+                        n = utf8_encode(cp, utf8);
+                        break;
+                    }
+                    default: utf8[0] = e; break;
+                }
+            }
+            if (out != nullptr && len + n < maxlen)
+            {
+                memcpy(out + len, utf8, n);
+                len += n;
+            }
+        }
+        if (j.m_cursor >= j.m_end)
+        {
+            json_fail(j, "unterminated string");
+            return false;
+        }
+        j.m_cursor++;
+        if (out != nullptr && maxlen > 0)
+            out[len] = 0;
+        return true;
+    }
+
+    static bool json_number(kjson_t& j, float& value)
+    {
+        json_skip_ws(j);
+        double sign = 1.0;
+        if (j.m_cursor < j.m_end && (*j.m_cursor == '-' || *j.m_cursor == '+'))
+            sign = *j.m_cursor++ == '-' ? -1.0 : 1.0;
+
+        double v         = 0.0;
+        s32    nb_digits = 0;
+        for (; j.m_cursor < j.m_end && *j.m_cursor >= '0' && *j.m_cursor <= '9'; ++j.m_cursor, ++nb_digits)
+            v = v * 10.0 + (*j.m_cursor - '0');
+        if (j.m_cursor < j.m_end && *j.m_cursor == '.')
+        {
+            double scale = 0.1;
+            for (++j.m_cursor; j.m_cursor < j.m_end && *j.m_cursor >= '0' && *j.m_cursor <= '9'; ++j.m_cursor, ++nb_digits, scale *= 0.1)
+                v += (*j.m_cursor - '0') * scale;
+        }
+        if (nb_digits == 0)
+        {
+            json_fail(j, "expected a number");
+            return false;
+        }
+        if (j.m_cursor < j.m_end && (*j.m_cursor == 'e' || *j.m_cursor == 'E'))
+        {
+            ++j.m_cursor;
+            s32 esign = 1;
+            if (j.m_cursor < j.m_end && (*j.m_cursor == '-' || *j.m_cursor == '+'))
+                esign = *j.m_cursor++ == '-' ? -1 : 1;
+            s32 e = 0;
+            for (; j.m_cursor < j.m_end && *j.m_cursor >= '0' && *j.m_cursor <= '9'; ++j.m_cursor)
+                e = e < 1000 ? e * 10 + (*j.m_cursor - '0') : e;
+            v *= pow(10.0, esign * e);
+        }
+        value = (float)(sign * v);
+        return true;
+    }
+
+    // any value, objects and arrays with everything in them
+    static void json_skip(kjson_t& j)
+    {
+        s32 depth = 0;
+        do
+        {
+            json_skip_ws(j);
+            if (j.m_cursor >= j.m_end)
+            {
+                json_fail(j, "unexpected end of the file");
+                return;
+            }
+            char const c = *j.m_cursor;
+            if (c == '"')
+            {
+                json_string(j, nullptr, 0);
+            }
+            else if (c == '{' || c == '[')
+            {
+                depth++;
+                j.m_cursor++;
+            }
+            else if (c == '}' || c == ']')
+            {
+                depth--;
+                j.m_cursor++;
+            }
+            else if (c == ',' || c == ':')
+            {
+                j.m_cursor++;
+            }
+            else
+            {
+                // numbers, true, false, null
+                while (j.m_cursor < j.m_end && strchr(",:{}[]\" \t\r\n", *j.m_cursor) == nullptr)
+                    j.m_cursor++;
+            }
+        } while (depth > 0);
+    }
+
+    // the next member of an object, its key in 'key', false at the end of the object, 'first' is true before the
+    // first call, a trailing comma is accepted
+    static bool json_member(kjson_t& j, bool& first, char* key, s32 maxlen)
+    {
+        if (first)
+        {
+            first = false;
+            if (!json_accept(j, '{'))
+            {
+                json_fail(j, "expected an object");
+                return false;
+            }
+        }
+        else if (!json_accept(j, ','))
+        {
+            if (!json_accept(j, '}'))
+                json_fail(j, "expected ',' or '}'");
+            return false;
+        }
+        if (json_accept(j, '}'))
+            return false;
+        if (!json_string(j, key, maxlen))
+            return false;
+        if (!json_accept(j, ':'))
+        {
+            json_fail(j, "expected ':'");
+            return false;
+        }
+        return true;
+    }
+
+    // the next element of an array, like json_member
+    static bool json_element(kjson_t& j, bool& first)
+    {
+        if (first)
+        {
+            first = false;
+            if (!json_accept(j, '['))
+            {
+                json_fail(j, "expected an array");
+                return false;
+            }
+        }
+        else if (!json_accept(j, ','))
+        {
+            if (!json_accept(j, ']'))
+                json_fail(j, "expected ',' or ']'");
+            return false;
+        }
+        return !json_accept(j, ']');
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // The layouts as they are in the file, the strings in one text buffer
+
+    struct sinfokey_t
+    {
+        float m_x, m_y, m_w, m_h;
+        float m_r, m_rx, m_ry;
+        s32   m_label; // offset in the text, -1 when none
+    };
+
+    struct sinfolayout_t
+    {
+        s32 m_name; // offset in the text
+        s32 m_first_key;
+        s32 m_nb_keys;
+    };
+
+    struct sinfoparse_t
+    {
+        s32            m_nb_keys;
+        s32            m_max_keys;
+        sinfokey_t*    m_keys;
+        s32            m_nb_layouts;
+        s32            m_max_layouts;
+        sinfolayout_t* m_layouts;
+        s32            m_text_size;
+        s32            m_text_max;
+        char*          m_text;
+    };
+
+    static s32 add_text(sinfoparse_t& p, const char* str)
+    {
+        s32 const len = (s32)strlen(str) + 1;
+        if (p.m_text_size + len > p.m_text_max)
+        {
+            p.m_text_max = (p.m_text_size + len) * 2;
+            p.m_text     = (char*)::realloc(p.m_text, p.m_text_max);
+        }
+        s32 const offset = p.m_text_size;
+        memcpy(p.m_text + offset, str, len);
+        p.m_text_size += len;
+        return offset;
+    }
+
+    static void parse_keys(kjson_t& j, sinfoparse_t& p)
+    {
+        bool first = true;
+        while (json_element(j, first))
+        {
+            sinfokey_t k = {0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, -1};
+
+            char member[16];
+            bool first_member = true;
+            while (json_member(j, first_member, member, sizeof(member)))
+            {
+                if (strcmp(member, "x") == 0)
+                    json_number(j, k.m_x);
+                else if (strcmp(member, "y") == 0)
+                    json_number(j, k.m_y);
+                else if (strcmp(member, "w") == 0)
+                    json_number(j, k.m_w);
+                else if (strcmp(member, "h") == 0)
+                    json_number(j, k.m_h);
+                else if (strcmp(member, "r") == 0)
+                    json_number(j, k.m_r);
+                else if (strcmp(member, "rx") == 0)
+                    json_number(j, k.m_rx);
+                else if (strcmp(member, "ry") == 0)
+                    json_number(j, k.m_ry);
+                else if (strcmp(member, "label") == 0)
+                {
+                    char label[64];
+                    if (json_string(j, label, sizeof(label)))
+                        k.m_label = add_text(p, label);
+                }
+                else
+                    json_skip(j);
+            }
+            if (j.m_error != nullptr)
+                return;
+
+            if (p.m_nb_keys == p.m_max_keys)
+            {
+                p.m_max_keys = p.m_max_keys == 0 ? 256 : p.m_max_keys * 2;
+                p.m_keys     = (sinfokey_t*)::realloc(p.m_keys, sizeof(sinfokey_t) * p.m_max_keys);
+            }
+            p.m_keys[p.m_nb_keys++] = k;
+        }
+    }
+
+    // "layouts": { "LAYOUT_split_3x6_3": { "layout": [ { "matrix": [0, 0], "x": 0, "y": 0.25 }, ... ] }, ... }
+    static void parse_layouts(kjson_t& j, sinfoparse_t& p)
+    {
+        char name[128];
+        bool first = true;
+        while (json_member(j, first, name, sizeof(name)))
+        {
+            s32 const first_key = p.m_nb_keys;
+
+            char member[32];
+            bool first_member = true;
+            while (json_member(j, first_member, member, sizeof(member)))
+            {
+                if (strcmp(member, "layout") == 0 && p.m_nb_keys == first_key)
+                    parse_keys(j, p);
+                else
+                    json_skip(j);
+            }
+            if (j.m_error != nullptr || p.m_nb_keys == first_key)
+                continue;
+
+            if (p.m_nb_layouts == p.m_max_layouts)
+            {
+                p.m_max_layouts = p.m_max_layouts == 0 ? 8 : p.m_max_layouts * 2;
+                p.m_layouts     = (sinfolayout_t*)::realloc(p.m_layouts, sizeof(sinfolayout_t) * p.m_max_layouts);
+            }
+            sinfolayout_t& layout = p.m_layouts[p.m_nb_layouts++];
+            layout.m_name         = add_text(p, name);
+            layout.m_first_key    = first_key;
+            layout.m_nb_keys      = p.m_nb_keys - first_key;
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // From keys to keygroups
+
+    static inline bool same_value(float a, float b) { return fabsf(a - b) < 0.001f; }
+
+    // 'b' continues the row of 'a', a rotated row only when the keys are square since keyboard_layout steps by the
+    // key width along x and by the key height along y
+    static bool same_row(sinfokey_t const& a, sinfokey_t const& b)
+    {
+        return same_value(a.m_y, b.m_y) && same_value(a.m_w, b.m_w) && same_value(a.m_h, b.m_h) && same_value(a.m_r, b.m_r) && same_value(a.m_rx, b.m_rx) && same_value(a.m_ry, b.m_ry) &&
+               same_value(b.m_x, a.m_x + a.m_w) && (same_value(a.m_r, 0.0f) || same_value(a.m_w, a.m_h));
+    }
+
+    // the number of keys of the row that starts at 'first'
+    static s32 row_length(sinfokey_t const* keys, s32 first, s32 end)
+    {
+        s32 k = first + 1;
+        while (k < end && k - first < 0x7FFF && same_row(keys[k - 1], keys[k]))
+            k++;
+        return k - first;
+    }
+
+    static s32 count_rows(sinfoparse_t const& p, sinfolayout_t const& layout)
+    {
+        s32       nb_rows = 0;
+        s32 const end     = layout.m_first_key + layout.m_nb_keys;
+        for (s32 k = layout.m_first_key; k < end; k += row_length(p.m_keys, k, end))
+            nb_rows++;
+        return nb_rows;
+    }
+
+    static void make_keyboard(sinfoparse_t const& p, sinfolayout_t const& layout, const char* text, const char* name, ckeygroup_t* groups, ckey_t* keys, ckeyboard_t& kb)
+    {
+        new (&kb) ckeyboard_t();
+        kb.m_name         = name;
+        kb.m_nb_keygroups = 0;
+        kb.m_keygroups    = groups;
+
+        s32 const end = layout.m_first_key + layout.m_nb_keys;
+        for (s32 k = layout.m_first_key; k < end;)
+        {
+            s32 const         n  = row_length(p.m_keys, k, end);
+            sinfokey_t const& ik = p.m_keys[k];
+
+            // keyboard_layout places a keygroup at the center of its first key and rotates it around that
+            float cx = ik.m_x + ik.m_w * 0.5f;
+            float cy = ik.m_y + ik.m_h * 0.5f;
+            if (!same_value(ik.m_r, 0.0f))
+            {
+                float const rad = ik.m_r * 3.141592653f / 180.0f;
+                float const s   = sinf(rad);
+                float const c   = cosf(rad);
+                float const dx  = cx - ik.m_rx;
+                float const dy  = cy - ik.m_ry;
+                cx              = ik.m_rx + dx * c - dy * s;
+                cy              = ik.m_ry + dx * s + dy * c;
+            }
+
+            ckeygroup_t& kg = *new (&groups[kb.m_nb_keygroups++]) ckeygroup_t();
+            kg.m_x          = cx;
+            kg.m_y          = cy;
+            kg.m_w          = ik.m_w;
+            kg.m_h          = ik.m_h;
+            kg.m_r          = 1;
+            kg.m_c          = (s16)n;
+            kg.m_a          = (s16)floorf(ik.m_r + 0.5f);
+            kg.m_nb_keys    = (s16)n;
+            kg.m_keys       = keys;
+            for (s32 i = 0; i < n; ++i)
+            {
+                ckey_t& key = *new (&keys[i]) ckey_t();
+                key.m_index = (s16)(k + i - layout.m_first_key);
+                key.m_label = p.m_keys[k + i].m_label >= 0 ? text + p.m_keys[k + i].m_label : "";
+            }
+            keys += n;
+            k += n;
+        }
+    }
+
+    static void release_parse(sinfoparse_t& p)
+    {
+        ::free(p.m_keys);
+        ::free(p.m_layouts);
+        ::free(p.m_text);
+    }
+
+    bool infojson_import(const char* json, s64 size, const char* name, kinfoboards_t& boards, const char** error)
+    {
+        boards = kinfoboards_t();
+
+        kjson_t j;
+        j.m_cursor = json;
+        j.m_end    = json + size;
+        j.m_error  = nullptr;
+
+        sinfoparse_t p;
+        memset(&p, 0, sizeof(p));
+
+        char member[64];
+        bool first = true;
+        while (json_member(j, first, member, sizeof(member)))
+        {
+            if (strcmp(member, "layouts") == 0)
+                parse_layouts(j, p);
+            else
+                json_skip(j);
+        }
+        if (j.m_error != nullptr)
+        {
+            if (error != nullptr)
+                *error = j.m_error;
+            release_parse(p);
+            return false;
+        }
+
+        // a layout with more keys than a keymap can index is not a keyboard that can be edited
+        s32    nb_keyboards = 0;
+        s32    nb_groups    = 0;
+        s32    nb_keys      = 0;
+        size_t names_size   = 0;
+        for (s32 l = 0; l < p.m_nb_layouts; ++l)
+        {
+            sinfolayout_t const& layout = p.m_layouts[l];
+            if (layout.m_nb_keys > 0x7FFF)
+                continue;
+            nb_keyboards += 1;
+            nb_groups += count_rows(p, layout);
+            nb_keys += layout.m_nb_keys;
+            names_size += strlen(name) + 1 + strlen(p.m_text + layout.m_name) + 1;
+        }
+
+        size_t const size_keyboards = sizeof(ckeyboard_t) * nb_keyboards;
+        size_t const size_groups    = sizeof(ckeygroup_t) * nb_groups;
+        size_t const size_keys      = sizeof(ckey_t) * nb_keys;
+        u8*          memory         = (u8*)::malloc(size_keyboards + size_groups + size_keys + p.m_text_size + names_size + 1);
+        ckeyboard_t* keyboards      = (ckeyboard_t*)memory;
+        ckeygroup_t* groups         = (ckeygroup_t*)(memory + size_keyboards);
+        ckey_t*      keys           = (ckey_t*)(memory + size_keyboards + size_groups);
+        char*        text           = (char*)(memory + size_keyboards + size_groups + size_keys);
+        char*        names          = text + p.m_text_size;
+        if (p.m_text_size > 0)
+            memcpy(text, p.m_text, p.m_text_size);
+
+        s32 kb = 0;
+        for (s32 l = 0; l < p.m_nb_layouts; ++l)
+        {
+            sinfolayout_t const& layout = p.m_layouts[l];
+            if (layout.m_nb_keys > 0x7FFF)
+                continue;
+            s32 const len = sprintf(names, name[0] != 0 ? "%s %s" : "%s%s", name, p.m_text + layout.m_name);
+            make_keyboard(p, layout, text, names, groups, keys, keyboards[kb]);
+            groups += keyboards[kb].m_nb_keygroups;
+            keys += layout.m_nb_keys;
+            names += len + 1;
+            kb += 1;
+        }
+
+        boards.m_nb_keyboards = nb_keyboards;
+        boards.m_keyboards    = keyboards;
+        boards.m_nb_keys      = nb_keys;
+        boards.m_memory       = memory;
+        release_parse(p);
+        return true;
+    }
+
+    void infojson_release(kinfoboards_t& boards)
+    {
+        ::free(boards.m_memory);
+        boards = kinfoboards_t();
+    }
+
+} // namespace xcore
@@ -0,0 +1,130 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_jobs.h"
+
+#include <mutex>
+#include <thread>
+
+namespace xcore
+{
+    s32 jobs_nb_workers()
+    {
+        s32 const n = (s32)std::thread::hardware_concurrency();
+        return n > 0 ? n : 1;
+    }
+
+    // Every worker owns a range of job indices, it takes jobs from the front of its own range. A worker that runs
+    // out of jobs steals the back half of the range of another worker, so uneven job durations (e.g. file sizes)
+    // are balanced without a shared queue that all workers contend on.
+    struct sworker_t
+    {
+        std::mutex m_lock;
+        s32        m_begin;
+        s32        m_end;
+        char       m_pad[64]; // keep the ranges of the workers on separate cache lines
+    };
+
+    struct sjobs_t
+    {
+        sworker_t* m_workers;
+        s32        m_nb_workers;
+        job_fn     m_fn;
+        void*      m_user;
+    };
+
+    static bool jobs_take(sworker_t& w, s32& index)
+    {
+        std::lock_guard<std::mutex> lock(w.m_lock);
+        if (w.m_begin >= w.m_end)
+            return false;
+        index = w.m_begin++;
+        return true;
+    }
+
+    static bool jobs_steal(sjobs_t* jobs, s32 thief)
+    {
+        for (s32 i = 1; i < jobs->m_nb_workers; ++i)
+        {
+            sworker_t& victim = jobs->m_workers[(thief + i) % jobs->m_nb_workers];
+
+            s32 begin, end;
+            {
+                std::lock_guard<std::mutex> lock(victim.m_lock);
+                s32 const n = victim.m_end - victim.m_begin;
+                if (n <= 0)
+                    continue;
+                s32 const half = (n + 1) / 2;
+                begin          = victim.m_end - half;
+                end            = victim.m_end;
+                victim.m_end   = begin;
+            }
+
+            // the range of the thief is empty, so nobody can be stealing from it
+            sworker_t&                  w = jobs->m_workers[thief];
+            std::lock_guard<std::mutex> lock(w.m_lock);
+            w.m_begin = begin;
+            w.m_end   = end;
+            return true;
+        }
+        return false;
+    }
+
+    static void jobs_worker(sjobs_t* jobs, s32 worker)
+    {
+        sworker_t& w = jobs->m_workers[worker];
+        while (true)
+        {
+            s32 index;
+            if (jobs_take(w, index))
+            {
+                jobs->m_fn(index, worker, jobs->m_user);
+            }
+            else if (!jobs_steal(jobs, worker))
+            {
+                break;
+            }
+        }
+    }
+
+    void jobs_parallel_for(s32 count, job_fn fn, void* user, s32 nb_workers)
+    {
+        if (nb_workers <= 0)
+            nb_workers = jobs_nb_workers();
+        if (nb_workers > count)
+            nb_workers = count;
+        if (nb_workers < 1)
+            nb_workers = 1;
+
+        sjobs_t jobs;
+        jobs.m_workers    = new sworker_t[nb_workers];
+        jobs.m_nb_workers = nb_workers;
+        jobs.m_fn         = fn;
+        jobs.m_user       = user;
+
+        // initial distribution, every worker gets an equal slice of the jobs
+        for (s32 i = 0; i < nb_workers; ++i)
+        {
+            jobs.m_workers[i].m_begin = (s32)(((s64)count * i) / nb_workers);
+            jobs.m_workers[i].m_end   = (s32)(((s64)count * (i + 1)) / nb_workers);
+        }
+
+        if (nb_workers == 1)
+        {
+            jobs_worker(&jobs, 0);
+        }
+        else
+        {
+            // the calling thread is worker 0
+            std::thread* threads = new std::thread[nb_workers - 1];
+            for (s32 i = 1; i < nb_workers; ++i)
+                threads[i - 1] = std::thread(jobs_worker, &jobs, i);
+            jobs_worker(&jobs, 0);
+            for (s32 i = 1; i < nb_workers; ++i)
+                threads[i - 1].join();
+            delete[] threads;
+        }
+
+        delete[] jobs.m_workers;
+    }
+
+} // namespace xcore
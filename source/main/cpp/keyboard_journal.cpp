@@ -0,0 +1,473 @@
+#include "xbase/x_target.h"
+
+#include "qmk-keymap-wiz/keyboard_journal.h"
+#include "qmk-keymap-wiz/keyboard_save.h"
+#include "qmk-keymap-wiz/keyboard_files.h"
+#include "qmk-keymap-wiz/keyboard_writer.h"
+
+#include <chrono>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace xcore
+{
+    bool apply_key_edit(key_t& key, kedit_t const& edit)
+    {
+        switch (edit.m_op)
+        {
+            case EDIT_KEYCODE: key.m_keycode_str = edit.m_str != nullptr ? edit.m_str : "KC_NO"; break;
+            case EDIT_MOD: key.m_mod = (u16)edit.m_value; break;
+            case EDIT_MOD_TAP: key.m_mod_tap = edit.m_value != 0; break;
+            case EDIT_LAYER_SWITCH: key.m_layer_switch = (u16)edit.m_value; break;
+            case EDIT_LAYER: key.m_layer = edit.m_str; break;
+            case EDIT_KEY_CAPCOLOR:
+                for (s32 i = 0; i < 4; ++i)
+                    key.m_capcolor[i] = edit.m_color[i];
+                break;
+            case EDIT_KEY_LEDCOLOR:
+                for (s32 i = 0; i < 4; ++i)
+                    key.m_ledcolor[i] = edit.m_color[i];
+                break;
+            default: return false;
+        }
+
+        // the compiled form is stale, the owner of the keymaps compiles the key again (see keyboard_keycode.h)
+        if (edit.m_op != EDIT_KEY_CAPCOLOR && edit.m_op != EDIT_KEY_LEDCOLOR)
+            key.m_kc = KEYCODE_UNCOMPILED;
+        return true;
+    }
+
+    bool apply_layer_edit(layer_t& layer, kedit_t const& edit)
+    {
+        if (edit.m_op != EDIT_LAYER_CAPCOLOR && edit.m_op != EDIT_LAYER_LEDCOLOR)
+            return false;
+        u8* color = edit.m_op == EDIT_LAYER_CAPCOLOR ? layer.m_capcolor : layer.m_ledcolor;
+        for (s32 i = 0; i < 4; ++i)
+            color[i] = edit.m_color[i];
+        return true;
+    }
+
+    bool apply_edit(keymaps_t* keymaps, kedit_t const& edit)
+    {
+        if (keymaps == nullptr || edit.m_keymap < 0 || edit.m_keymap >= keymaps->m_nb_keymaps)
+            return false;
+        keymap_t& km = keymaps->m_keymaps[edit.m_keymap];
+        if (edit.m_layer < 0 || edit.m_layer >= km.m_nb_layers)
+            return false;
+        layer_t& layer = km.m_layers[edit.m_layer];
+        if (is_layer_edit(edit.m_op))
+            return apply_layer_edit(layer, edit);
+        if (edit.m_key < 0 || edit.m_key >= layer.m_nb_keys)
+            return false;
+        return apply_key_edit(layer.m_keys[edit.m_key], edit);
+    }
+
+    // --------------------------------------------------------------------------------------------------------------------------
+    // --------------------------------------------------------------------------------------------------------------------------
+    // File layout:
+    //   header : 'K' 'M' 'J' '1'
+    //   record : u8 op, u8 payload length, u16 keymap, u16 layer, u16 key, payload, u32 checksum
+    // All numbers are little endian, the checksum (FNV-1a) covers the record up to the checksum. A string payload
+    // holds the characters without a terminator, a value payload is 4 bytes and so is a color payload.
+    static const char s_journal_magic[4] = {'K', 'M', 'J', '1'};
+    static const s32  s_record_header    = 8;
+    static const s32  s_record_max       = s_record_header + 255 + 4;
+
+    static const s64 s_flush_bytes   = 4 * 1024;   // flush when this many bytes are pending
+    static const s64 s_flush_millis  = 250;        // or when the oldest pending edit is this old
+    static const s64 s_compact_bytes = 256 * 1024; // compact the journal into the keymaps file beyond this size
+
+    static u32 checksum(u8 const* data, s32 size)
+    {
+        u32 hash = 2166136261u;
+        for (s32 i = 0; i < size; ++i)
+        {
+            hash ^= data[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    static void put_u16(u8* p, u32 v)
+    {
+        p[0] = (u8)(v);
+        p[1] = (u8)(v >> 8);
+    }
+
+    static void put_u32(u8* p, u32 v)
+    {
+        p[0] = (u8)(v);
+        p[1] = (u8)(v >> 8);
+        p[2] = (u8)(v >> 16);
+        p[3] = (u8)(v >> 24);
+    }
+
+    static u32 get_u16(u8 const* p) { return (u32)p[0] | ((u32)p[1] << 8); }
+    static u32 get_u32(u8 const* p) { return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24); }
+
+    static bool is_string_op(s32 op) { return op == EDIT_KEYCODE || op == EDIT_LAYER; }
+    static bool is_color_op(s32 op) { return op == EDIT_KEY_CAPCOLOR || op == EDIT_KEY_LEDCOLOR || op == EDIT_LAYER_CAPCOLOR || op == EDIT_LAYER_LEDCOLOR; }
+
+    // returns the size of the encoded record, 0 when the edit cannot be encoded
+    static s32 encode_edit(kedit_t const& edit, u8* record)
+    {
+        if (edit.m_op < 0 || edit.m_op >= EDIT_COUNT)
+            return 0;
+        if (edit.m_keymap < 0 || edit.m_keymap > 0xFFFF || edit.m_layer < 0 || edit.m_layer > 0xFFFF || edit.m_key < 0 || edit.m_key > 0xFFFF)
+            return 0;
+
+        u8* payload = record + s_record_header;
+        s32 len     = 4;
+        if (is_string_op(edit.m_op))
+        {
+            // the string as apply_key_edit applies it, a keycode without a string is "KC_NO"
+            const char* str = edit.m_str;
+            if (str == nullptr)
+                str = edit.m_op == EDIT_KEYCODE ? "KC_NO" : "";
+            len = (s32)strlen(str);
+            if (len > 255)
+                return 0;
+            memcpy(payload, str, len);
+        }
+        else if (is_color_op(edit.m_op))
+        {
+            memcpy(payload, edit.m_color, 4);
+        }
+        else
+        {
+            put_u32(payload, edit.m_value);
+        }
+
+        record[0] = (u8)edit.m_op;
+        record[1] = (u8)len;
+        put_u16(record + 2, (u32)edit.m_keymap);
+        put_u16(record + 4, (u32)edit.m_layer);
+        put_u16(record + 6, (u32)edit.m_key);
+        s32 const size = s_record_header + len;
+        put_u32(record + size, checksum(record, size));
+        return size + 4;
+    }
+
+    // returns the size of the decoded record, 0 when the record is incomplete or corrupt
+    static s32 decode_edit(u8 const* data, s32 size, kedit_t& edit, const char*& str, s32& str_len)
+    {
+        if (size < s_record_header + 4)
+            return 0;
+        s32 const len = data[1];
+        if (size < s_record_header + len + 4)
+            return 0;
+        if (checksum(data, s_record_header + len) != get_u32(data + s_record_header + len))
+            return 0;
+        s32 const op = data[0];
+        if (op >= EDIT_COUNT || (!is_string_op(op) && len != 4))
+            return 0;
+
+        u8 const* payload = data + s_record_header;
+        edit              = kedit_t();
+        edit.m_op         = op;
+        edit.m_keymap     = (s32)get_u16(data + 2);
+        edit.m_layer      = (s32)get_u16(data + 4);
+        edit.m_key        = (s32)get_u16(data + 6);
+        str               = nullptr;
+        str_len           = 0;
+        if (is_string_op(op))
+        {
+            str     = (const char*)payload;
+            str_len = len;
+        }
+        else if (is_color_op(op))
+        {
+            memcpy(edit.m_color, payload, 4);
+        }
+        else
+        {
+            edit.m_value = get_u32(payload);
+        }
+        return s_record_header + len + 4;
+    }
+
+    // --------------------------------------------------------------------------------------------------------------------------
+    // --------------------------------------------------------------------------------------------------------------------------
+    typedef std::chrono::steady_clock kclock_t;
+
+    struct kjournal_t
+    {
+        char* m_filename; // <file>.journal
+        char* m_oldname;  // <file>.journal.old
+
+        kwriter_t m_writer;
+        bool      m_open;
+        s64       m_base_size; // size of the journal file when the writer was opened
+        s64       m_synced;    // bytes written by the writer that are on disk
+
+        kclock_t::time_point m_first_pending;
+
+        bool m_compacting;
+        s32  m_compact_saves;
+        s32  m_compact_errors;
+
+        // strings of replayed edits, the keymaps point into these
+        s32    m_nb_strs;
+        s32    m_max_strs;
+        char** m_strs;
+    };
+
+    static char* dup_path(const char* str, const char* suffix)
+    {
+        s32   len1 = (s32)strlen(str);
+        s32   len2 = (s32)strlen(suffix);
+        char* dup  = (char*)::malloc(len1 + len2 + 1);
+        memcpy(dup, str, len1);
+        memcpy(dup + len1, suffix, len2 + 1);
+        return dup;
+    }
+
+    static const char* keep_str(kjournal_t* journal, const char* str, s32 len)
+    {
+        if (journal->m_nb_strs == journal->m_max_strs)
+        {
+            journal->m_max_strs = journal->m_max_strs == 0 ? 64 : journal->m_max_strs * 2;
+            journal->m_strs     = (char**)::realloc(journal->m_strs, sizeof(char*) * journal->m_max_strs);
+        }
+        char* dup = (char*)::malloc(len + 1);
+        memcpy(dup, str, len);
+        dup[len]                              = 0;
+        journal->m_strs[journal->m_nb_strs++] = dup;
+        return dup;
+    }
+
+    kjournal_t* journal_open(const char* filename)
+    {
+        kjournal_t* journal       = new (::malloc(sizeof(kjournal_t))) kjournal_t();
+        journal->m_filename       = dup_path(filename, ".journal");
+        journal->m_oldname        = dup_path(filename, ".journal.old");
+        journal->m_open           = false;
+        journal->m_base_size      = 0;
+        journal->m_synced         = 0;
+        journal->m_compacting     = false;
+        journal->m_compact_saves  = 0;
+        journal->m_compact_errors = 0;
+        journal->m_nb_strs        = 0;
+        journal->m_max_strs       = 0;
+        journal->m_strs           = nullptr;
+        return journal;
+    }
+
+    static bool journal_close_writer(kjournal_t* journal)
+    {
+        if (!journal->m_open)
+            return true;
+        bool ok         = writer_sync(journal->m_writer);
+        ok              = writer_close(journal->m_writer) && ok;
+        journal->m_open = false;
+        return ok;
+    }
+
+    void journal_close(kjournal_t* journal)
+    {
+        if (journal == nullptr)
+            return;
+        journal_close_writer(journal);
+        for (s32 i = 0; i < journal->m_nb_strs; ++i)
+            ::free(journal->m_strs[i]);
+        ::free(journal->m_strs);
+        ::free(journal->m_filename);
+        ::free(journal->m_oldname);
+        journal->~kjournal_t();
+        ::free(journal);
+    }
+
+    static u8* read_file(const char* filename, s32& size)
+    {
+        size       = 0;
+        FILE* file = fopen(filename, "rb");
+        if (file == nullptr)
+            return nullptr;
+        fseek(file, 0, SEEK_END);
+        long const len = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        u8* data = (u8*)::malloc(len > 0 ? len : 1);
+        size     = (s32)fread(data, 1, len > 0 ? len : 0, file);
+        fclose(file);
+        return data;
+    }
+
+    // keep only the first 'size' bytes of the file
+    static bool truncate_file(const char* filename, u8 const* data, s32 size)
+    {
+        char*     tmpname = dup_path(filename, ".tmp");
+        kwriter_t w;
+        bool      ok = writer_open(w, tmpname);
+        if (ok)
+        {
+            writer_write(w, (const char*)data, size);
+            ok = writer_sync(w);
+            ok = writer_close(w) && ok;
+            ok = ok && replace_file(tmpname, filename);
+        }
+        ::free(tmpname);
+        return ok;
+    }
+
+    static s32 replay_file(kjournal_t* journal, const char* filename, keymaps_t* keymaps)
+    {
+        s32 size = 0;
+        u8* data = read_file(filename, size);
+        if (data == nullptr)
+            return 0;
+
+        s32 nb_edits = 0;
+        s32 cursor   = 0;
+        if (size < 4 || memcmp(data, s_journal_magic, 4) != 0)
+        {
+            printf("error: '%s' is not a keymap journal, ignored\n", filename);
+            ::free(data);
+            return 0;
+        }
+
+        cursor = 4;
+        while (cursor < size)
+        {
+            kedit_t     edit;
+            const char* str    = nullptr;
+            s32         str_len = 0;
+            s32 const   len     = decode_edit(data + cursor, size - cursor, edit, str, str_len);
+            if (len == 0)
+                break;
+            if (str != nullptr)
+                edit.m_str = keep_str(journal, str, str_len);
+            if (apply_edit(keymaps, edit))
+                nb_edits += 1;
+            cursor += len;
+        }
+
+        if (cursor < size)
+        {
+            printf("warning: discarding %d bytes at the end of '%s'\n", size - cursor, filename);
+            truncate_file(filename, data, cursor);
+        }
+
+        ::free(data);
+        return nb_edits;
+    }
+
+    s32 journal_replay(kjournal_t* journal, keymaps_t* keymaps)
+    {
+        // the old journal (an interrupted compaction) holds the edits that came before the current journal
+        s32 nb_edits = 0;
+        nb_edits += replay_file(journal, journal->m_oldname, keymaps);
+        nb_edits += replay_file(journal, journal->m_filename, keymaps);
+        return nb_edits;
+    }
+
+    static bool journal_open_writer(kjournal_t* journal)
+    {
+        if (journal->m_open)
+            return true;
+        s64 const size = file_size(journal->m_filename);
+        if (!writer_append(journal->m_writer, journal->m_filename))
+            return false;
+        journal->m_open      = true;
+        journal->m_base_size = size > 0 ? size : 0;
+        journal->m_synced    = 0;
+        if (size <= 0)
+            writer_write(journal->m_writer, s_journal_magic, 4);
+        return true;
+    }
+
+    void journal_append(kjournal_t* journal, kedit_t const& edit)
+    {
+        u8        record[s_record_max];
+        s32 const len = encode_edit(edit, record);
+        if (len == 0)
+        {
+            printf("error: edit cannot be journaled (op %d, keymap %d, layer %d, key %d)\n", edit.m_op, edit.m_keymap, edit.m_layer, edit.m_key);
+            return;
+        }
+        if (!journal_open_writer(journal))
+            return;
+        if (journal->m_writer.m_written == journal->m_synced)
+            journal->m_first_pending = kclock_t::now();
+        writer_write(journal->m_writer, (const char*)record, len);
+    }
+
+    bool journal_flush(kjournal_t* journal)
+    {
+        if (!journal->m_open || journal->m_writer.m_written == journal->m_synced)
+            return true;
+        bool const ok     = writer_sync(journal->m_writer);
+        journal->m_synced = journal->m_writer.m_written;
+        return ok;
+    }
+
+    s64 journal_size(kjournal_t* journal)
+    {
+        if (journal->m_open)
+            return journal->m_base_size + journal->m_writer.m_written;
+        s64 const size = file_size(journal->m_filename);
+        return size > 0 ? size : 0;
+    }
+
+    static void journal_compact(kjournal_t* journal, ksaver_t* saver, keymaps_t const* keymaps)
+    {
+        // Every edit in the journal is part of the keymaps we are about to save. When an older journal is still
+        // around (a previous save failed) the current journal is kept as is, it is removed by the next compaction.
+        journal_flush(journal);
+        if (file_size(journal->m_oldname) < 0)
+        {
+            journal_close_writer(journal);
+            if (!replace_file(journal->m_filename, journal->m_oldname))
+            {
+                printf("error: unable to rotate journal '%s'\n", journal->m_filename);
+                return;
+            }
+        }
+
+        ksaver_stats_t stats;
+        saver_stats(saver, stats);
+        journal->m_compacting     = true;
+        journal->m_compact_saves  = stats.m_nb_saves;
+        journal->m_compact_errors = stats.m_nb_errors;
+
+        // the journal does not know which layers the caller has marked dirty, compaction is rare enough to just
+        // encode everything
+        saver_mark_all_dirty(saver);
+        saver_save(saver, keymaps);
+    }
+
+    void journal_update(kjournal_t* journal, ksaver_t* saver, keymaps_t const* keymaps)
+    {
+        if (journal->m_open && journal->m_writer.m_written > journal->m_synced)
+        {
+            s64 const pending = journal->m_writer.m_written - journal->m_synced;
+            s64 const millis  = std::chrono::duration_cast<std::chrono::milliseconds>(kclock_t::now() - journal->m_first_pending).count();
+            if (pending >= s_flush_bytes || millis >= s_flush_millis)
+                journal_flush(journal);
+        }
+
+        if (saver == nullptr || keymaps == nullptr)
+            return;
+
+        if (journal->m_compacting)
+        {
+            ksaver_stats_t stats;
+            saver_stats(saver, stats);
+            if (stats.m_nb_saves > journal->m_compact_saves)
+            {
+                delete_file(journal->m_oldname);
+                journal->m_compacting = false;
+            }
+            else if (stats.m_nb_errors > journal->m_compact_errors)
+            {
+                journal->m_compacting = false;
+            }
+            return;
+        }
+
+        if (journal_size(journal) >= s_compact_bytes)
+            journal_compact(journal, saver, keymaps);
+    }
+
+} // namespace xcore
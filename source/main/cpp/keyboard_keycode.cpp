@@ -0,0 +1,541 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_keycode.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace xcore
+{
+    struct kqmkname_t
+    {
+        const char* m_name;
+        u16         m_value;
+    };
+
+    // The basic keycodes of QMK with their HID usage, followed by the shifted keycodes (LSFT of a basic keycode)
+    static const kqmkname_t s_basic_keycodes[] = {
+        {"KC_NO", 0x0000}, {"KC_TRNS", 0x0001}, {"KC_A", 0x0004}, {"KC_B", 0x0005}, {"KC_C", 0x0006}, {"KC_D", 0x0007},
+        {"KC_E", 0x0008}, {"KC_F", 0x0009}, {"KC_G", 0x000A}, {"KC_H", 0x000B}, {"KC_I", 0x000C}, {"KC_J", 0x000D},
+        {"KC_K", 0x000E}, {"KC_L", 0x000F}, {"KC_M", 0x0010}, {"KC_N", 0x0011}, {"KC_O", 0x0012}, {"KC_P", 0x0013},
+        {"KC_Q", 0x0014}, {"KC_R", 0x0015}, {"KC_S", 0x0016}, {"KC_T", 0x0017}, {"KC_U", 0x0018}, {"KC_V", 0x0019},
+        {"KC_W", 0x001A}, {"KC_X", 0x001B}, {"KC_Y", 0x001C}, {"KC_Z", 0x001D}, {"KC_1", 0x001E}, {"KC_2", 0x001F},
+        {"KC_3", 0x0020}, {"KC_4", 0x0021}, {"KC_5", 0x0022}, {"KC_6", 0x0023}, {"KC_7", 0x0024}, {"KC_8", 0x0025},
+        {"KC_9", 0x0026}, {"KC_0", 0x0027}, {"KC_ENT", 0x0028}, {"KC_ESC", 0x0029}, {"KC_BSPC", 0x002A},
+        {"KC_TAB", 0x002B}, {"KC_SPC", 0x002C}, {"KC_MINS", 0x002D}, {"KC_EQL", 0x002E}, {"KC_LBRC", 0x002F},
+        {"KC_RBRC", 0x0030}, {"KC_BSLS", 0x0031}, {"KC_NUHS", 0x0032}, {"KC_SCLN", 0x0033}, {"KC_QUOT", 0x0034},
+        {"KC_GRV", 0x0035}, {"KC_COMM", 0x0036}, {"KC_DOT", 0x0037}, {"KC_SLSH", 0x0038}, {"KC_CAPS", 0x0039},
+        {"KC_F1", 0x003A}, {"KC_F2", 0x003B}, {"KC_F3", 0x003C}, {"KC_F4", 0x003D}, {"KC_F5", 0x003E},
+        {"KC_F6", 0x003F}, {"KC_F7", 0x0040}, {"KC_F8", 0x0041}, {"KC_F9", 0x0042}, {"KC_F10", 0x0043},
+        {"KC_F11", 0x0044}, {"KC_F12", 0x0045}, {"KC_PSCR", 0x0046}, {"KC_SCRL", 0x0047}, {"KC_PAUS", 0x0048},
+        {"KC_INS", 0x0049}, {"KC_HOME", 0x004A}, {"KC_PGUP", 0x004B}, {"KC_DEL", 0x004C}, {"KC_END", 0x004D},
+        {"KC_PGDN", 0x004E}, {"KC_RGHT", 0x004F}, {"KC_LEFT", 0x0050}, {"KC_DOWN", 0x0051}, {"KC_UP", 0x0052},
+        {"KC_NUM", 0x0053}, {"KC_PSLS", 0x0054}, {"KC_PAST", 0x0055}, {"KC_PMNS", 0x0056}, {"KC_PPLS", 0x0057},
+        {"KC_PENT", 0x0058}, {"KC_P1", 0x0059}, {"KC_P2", 0x005A}, {"KC_P3", 0x005B}, {"KC_P4", 0x005C},
+        {"KC_P5", 0x005D}, {"KC_P6", 0x005E}, {"KC_P7", 0x005F}, {"KC_P8", 0x0060}, {"KC_P9", 0x0061},
+        {"KC_P0", 0x0062}, {"KC_PDOT", 0x0063}, {"KC_NUBS", 0x0064}, {"KC_APP", 0x0065}, {"KC_KB_POWER", 0x0066},
+        {"KC_PEQL", 0x0067}, {"KC_F13", 0x0068}, {"KC_F14", 0x0069}, {"KC_F15", 0x006A}, {"KC_F16", 0x006B},
+        {"KC_F17", 0x006C}, {"KC_F18", 0x006D}, {"KC_F19", 0x006E}, {"KC_F20", 0x006F}, {"KC_F21", 0x0070},
+        {"KC_F22", 0x0071}, {"KC_F23", 0x0072}, {"KC_F24", 0x0073}, {"KC_EXEC", 0x0074}, {"KC_HELP", 0x0075},
+        {"KC_MENU", 0x0076}, {"KC_SLCT", 0x0077}, {"KC_STOP", 0x0078}, {"KC_AGIN", 0x0079}, {"KC_UNDO", 0x007A},
+        {"KC_CUT", 0x007B}, {"KC_COPY", 0x007C}, {"KC_PSTE", 0x007D}, {"KC_FIND", 0x007E}, {"KC_KB_MUTE", 0x007F},
+        {"KC_KB_VOLUME_UP", 0x0080}, {"KC_KB_VOLUME_DOWN", 0x0081}, {"KC_LCAP", 0x0082}, {"KC_LNUM", 0x0083},
+        {"KC_LSCR", 0x0084}, {"KC_PCMM", 0x0085}, {"KC_KP_EQUAL_AS400", 0x0086}, {"KC_INT1", 0x0087},
+        {"KC_INT2", 0x0088}, {"KC_INT3", 0x0089}, {"KC_INT4", 0x008A}, {"KC_INT5", 0x008B}, {"KC_INT6", 0x008C},
+        {"KC_INT7", 0x008D}, {"KC_INT8", 0x008E}, {"KC_INT9", 0x008F}, {"KC_LNG1", 0x0090}, {"KC_LNG2", 0x0091},
+        {"KC_LNG3", 0x0092}, {"KC_LNG4", 0x0093}, {"KC_LNG5", 0x0094}, {"KC_LNG6", 0x0095}, {"KC_LNG7", 0x0096},
+        {"KC_LNG8", 0x0097}, {"KC_LNG9", 0x0098}, {"KC_ERAS", 0x0099}, {"KC_SYRQ", 0x009A}, {"KC_CNCL", 0x009B},
+        {"KC_CLR", 0x009C}, {"KC_PRIR", 0x009D}, {"KC_RETN", 0x009E}, {"KC_SEPR", 0x009F}, {"KC_OUT", 0x00A0},
+        {"KC_OPER", 0x00A1}, {"KC_CLAG", 0x00A2}, {"KC_CRSL", 0x00A3}, {"KC_EXSL", 0x00A4}, {"KC_PWR", 0x00A5},
+        {"KC_SLEP", 0x00A6}, {"KC_WAKE", 0x00A7}, {"KC_MUTE", 0x00A8}, {"KC_VOLU", 0x00A9}, {"KC_VOLD", 0x00AA},
+        {"KC_MNXT", 0x00AB}, {"KC_MPRV", 0x00AC}, {"KC_MSTP", 0x00AD}, {"KC_MPLY", 0x00AE}, {"KC_MSEL", 0x00AF},
+        {"KC_EJCT", 0x00B0}, {"KC_MAIL", 0x00B1}, {"KC_CALC", 0x00B2}, {"KC_MYCM", 0x00B3}, {"KC_WSCH", 0x00B4},
+        {"KC_WHOM", 0x00B5}, {"KC_WBAK", 0x00B6}, {"KC_WFWD", 0x00B7}, {"KC_WSTP", 0x00B8}, {"KC_WREF", 0x00B9},
+        {"KC_WFAV", 0x00BA}, {"KC_MFFD", 0x00BB}, {"KC_MRWD", 0x00BC}, {"KC_BRIU", 0x00BD}, {"KC_BRID", 0x00BE},
+        {"KC_MS_U", 0x00CD}, {"KC_MS_D", 0x00CE}, {"KC_MS_L", 0x00CF}, {"KC_MS_R", 0x00D0}, {"KC_BTN1", 0x00D1},
+        {"KC_BTN2", 0x00D2}, {"KC_BTN3", 0x00D3}, {"KC_BTN4", 0x00D4}, {"KC_BTN5", 0x00D5}, {"KC_BTN6", 0x00D6},
+        {"KC_BTN7", 0x00D7}, {"KC_BTN8", 0x00D8}, {"KC_WH_U", 0x00D9}, {"KC_WH_D", 0x00DA}, {"KC_WH_L", 0x00DB},
+        {"KC_WH_R", 0x00DC}, {"KC_ACL0", 0x00DD}, {"KC_ACL1", 0x00DE}, {"KC_ACL2", 0x00DF}, {"KC_LCTL", 0x00E0},
+        {"KC_LSFT", 0x00E1}, {"KC_LALT", 0x00E2}, {"KC_LGUI", 0x00E3}, {"KC_RCTL", 0x00E4}, {"KC_RSFT", 0x00E5},
+        {"KC_RALT", 0x00E6}, {"KC_RGUI", 0x00E7}, {"KC_TILD", 0x0235}, {"KC_EXLM", 0x021E}, {"KC_AT", 0x021F},
+        {"KC_HASH", 0x0220}, {"KC_DLR", 0x0221}, {"KC_PERC", 0x0222}, {"KC_CIRC", 0x0223}, {"KC_AMPR", 0x0224},
+        {"KC_ASTR", 0x0225}, {"KC_LPRN", 0x0226}, {"KC_RPRN", 0x0227}, {"KC_UNDS", 0x022D}, {"KC_PLUS", 0x022E},
+        {"KC_LCBR", 0x022F}, {"KC_RCBR", 0x0230}, {"KC_PIPE", 0x0231}, {"KC_COLN", 0x0233}, {"KC_DQUO", 0x0234},
+        {"KC_LABK", 0x0236}, {"KC_RABK", 0x0237}, {"KC_QUES", 0x0238},
+        // names from before QMK 0.19 that older keymaps still use
+        {"KC_TRANS", 0x0001}, {"KC_BSPACE", 0x002A}, {"KC_LBRACKET", 0x002F}, {"KC_RBRACKET", 0x0030}, {"KC_BSLASH", 0x0031},
+        {"KC_SCOLON", 0x0033}, {"KC_PGDOWN", 0x004E}, {"KC_LCTRL", 0x00E0}, {"KC_LSHIFT", 0x00E1}, {"KC_RCTRL", 0x00E4}, {"KC_RSHIFT", 0x00E5},
+    };
+
+    static const kqmkname_t s_mod_names[] = {
+        {"LCTL", QMOD_CTL}, {"C", QMOD_CTL}, {"CTL", QMOD_CTL}, {"LSFT", QMOD_SFT}, {"S", QMOD_SFT}, {"SFT", QMOD_SFT},
+        {"LALT", QMOD_ALT}, {"A", QMOD_ALT}, {"ALT", QMOD_ALT}, {"LOPT", QMOD_ALT}, {"OPT", QMOD_ALT},
+        {"LGUI", QMOD_GUI}, {"G", QMOD_GUI}, {"GUI", QMOD_GUI}, {"LCMD", QMOD_GUI}, {"CMD", QMOD_GUI}, {"LWIN", QMOD_GUI}, {"WIN", QMOD_GUI},
+        {"RCTL", QMOD_RIGHT | QMOD_CTL}, {"RSFT", QMOD_RIGHT | QMOD_SFT}, {"RALT", QMOD_RIGHT | QMOD_ALT}, {"ROPT", QMOD_RIGHT | QMOD_ALT},
+        {"ALGR", QMOD_RIGHT | QMOD_ALT}, {"RGUI", QMOD_RIGHT | QMOD_GUI}, {"RCMD", QMOD_RIGHT | QMOD_GUI}, {"RWIN", QMOD_RIGHT | QMOD_GUI},
+        {"LCS", QMOD_CTL | QMOD_SFT}, {"C_S", QMOD_CTL | QMOD_SFT}, {"LCA", QMOD_CTL | QMOD_ALT}, {"LCG", QMOD_CTL | QMOD_GUI},
+        {"LSA", QMOD_SFT | QMOD_ALT}, {"LSG", QMOD_SFT | QMOD_GUI}, {"SGUI", QMOD_SFT | QMOD_GUI}, {"SCMD", QMOD_SFT | QMOD_GUI},
+        {"SWIN", QMOD_SFT | QMOD_GUI}, {"LAG", QMOD_ALT | QMOD_GUI}, {"LCAG", QMOD_CTL | QMOD_ALT | QMOD_GUI},
+        {"MEH", QMOD_CTL | QMOD_SFT | QMOD_ALT}, {"HYPR", QMOD_CTL | QMOD_SFT | QMOD_ALT | QMOD_GUI}, {"ALL", QMOD_CTL | QMOD_SFT | QMOD_ALT | QMOD_GUI},
+    };
+
+    static const kqmkname_t s_mod_masks[] = {
+        {"MOD_LCTL", QMOD_CTL},
+        {"MOD_LSFT", QMOD_SFT},
+        {"MOD_LALT", QMOD_ALT},
+        {"MOD_LGUI", QMOD_GUI},
+        {"MOD_RCTL", QMOD_RIGHT | QMOD_CTL},
+        {"MOD_RSFT", QMOD_RIGHT | QMOD_SFT},
+        {"MOD_RALT", QMOD_RIGHT | QMOD_ALT},
+        {"MOD_RGUI", QMOD_RIGHT | QMOD_GUI},
+        {"MOD_MEH", QMOD_CTL | QMOD_SFT | QMOD_ALT},
+        {"MOD_HYPR", QMOD_CTL | QMOD_SFT | QMOD_ALT | QMOD_GUI},
+    };
+
+    static const kqmkname_t s_layer_functions[] = {
+        {"MO", QK_MOMENTARY}, {"TG", QK_TOGGLE_LAYER}, {"TO", QK_TO}, {"TT", QK_LAYER_TAP_TOGGLE}, {"OSL", QK_ONE_SHOT_LAYER}, {"DF", QK_DEF_LAYER},
+    };
+
+    template <s32 N> static s32 find_name(kqmkname_t const (&names)[N], const char* name, s32 len)
+    {
+        for (s32 i = 0; i < N; ++i)
+        {
+            if (strncmp(names[i].m_name, name, len) == 0 && names[i].m_name[len] == 0)
+                return i;
+        }
+        return -1;
+    }
+
+    // --------------------------------------------------------------------------------------------------------------------------
+    // --------------------------------------------------------------------------------------------------------------------------
+    static const u16 s_left_mods  = LSFT | LCTL | LALT | LGUI;
+    static const u16 s_right_mods = RSFT | RCTL | RALT | RGUI;
+
+    bool qmk_mods(u16 mods, u8& qmods)
+    {
+        mods &= 0xFF;
+        qmods = 0;
+        if ((mods & s_left_mods) != 0 && (mods & s_right_mods) != 0)
+            return false;
+        if (mods & s_right_mods)
+        {
+            qmods = QMOD_RIGHT;
+            mods  = mods >> 1;
+        }
+        if (mods & LCTL)
+            qmods |= QMOD_CTL;
+        if (mods & LSFT)
+            qmods |= QMOD_SFT;
+        if (mods & LALT)
+            qmods |= QMOD_ALT;
+        if (mods & LGUI)
+            qmods |= QMOD_GUI;
+        return true;
+    }
+
+    u16 emod_from_qmk(u8 qmods)
+    {
+        u16 mods = 0;
+        if (qmods & QMOD_CTL)
+            mods |= LCTL;
+        if (qmods & QMOD_SFT)
+            mods |= LSFT;
+        if (qmods & QMOD_ALT)
+            mods |= LALT;
+        if (qmods & QMOD_GUI)
+            mods |= LGUI;
+        if (qmods & QMOD_RIGHT)
+            mods = mods << 1;
+        return mods;
+    }
+
+    // the QMK value of a keycode of the database, false for a user keycode
+    static bool basic_value(keycode_t const& keycode, u16& value)
+    {
+        for (s32 j = -1; j < keycode.m_nb_codes; ++j)
+        {
+            const char* name = j < 0 ? keycode.m_code : keycode.m_codes[j];
+            if (name == nullptr)
+                continue;
+            s32 const b = find_name(s_basic_keycodes, name, (s32)strlen(name));
+            if (b >= 0)
+            {
+                value = s_basic_keycodes[b].m_value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void keycode_values(keycodes_t const* kcdb, u16* values)
+    {
+        u16 user = QK_USER;
+        for (s32 i = 0; i < kcdb->m_nb_keycodes; ++i)
+        {
+            if (!basic_value(kcdb->m_keycodes[i], values[i]))
+            {
+                values[i] = user;
+                if (user < QK_USER_MAX)
+                    user++;
+            }
+        }
+    }
+
+    static u16 keycode_value(keycodes_t const* kcdb, s32 index)
+    {
+        if (kcdb->m_values != nullptr)
+            return kcdb->m_values[index];
+        u16 value = QK_USER;
+        basic_value(kcdb->m_keycodes[index], value);
+        return value;
+    }
+
+    // --------------------------------------------------------------------------------------------------------------------------
+    // --------------------------------------------------------------------------------------------------------------------------
+    struct kparser_t
+    {
+        keycodes_t const* m_kcdb;
+        keymap_t const*   m_km;
+        const char*       m_cursor;
+    };
+
+    static inline bool is_ident_char(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_'; }
+    static inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+    static void skip_spaces(kparser_t& p)
+    {
+        while (*p.m_cursor == ' ' || *p.m_cursor == '\t')
+            p.m_cursor++;
+    }
+
+    static bool expect(kparser_t& p, char c)
+    {
+        skip_spaces(p);
+        if (*p.m_cursor != c)
+            return false;
+        p.m_cursor++;
+        return true;
+    }
+
+    static s32 parse_ident(kparser_t& p, const char*& name)
+    {
+        skip_spaces(p);
+        name = p.m_cursor;
+        while (is_ident_char(*p.m_cursor))
+            p.m_cursor++;
+        return (s32)(p.m_cursor - name);
+    }
+
+    static bool parse_number(kparser_t& p, u32& number)
+    {
+        skip_spaces(p);
+        if (!is_digit(*p.m_cursor))
+            return false;
+        // decimal or 0x hexadecimal, a leading zero is not octal ("08" is layer 8)
+        bool const          hex = p.m_cursor[0] == '0' && (p.m_cursor[1] == 'x' || p.m_cursor[1] == 'X');
+        char*               end = nullptr;
+        unsigned long const n   = strtoul(p.m_cursor, &end, hex ? 16 : 10);
+        if (end == p.m_cursor || n > 0xFFFF)
+            return false;
+        p.m_cursor = end;
+        number     = (u32)n;
+        return true;
+    }
+
+    // the layer name as it is written in layers.h, e.g. "Nav 2" -> "_NAV_2", see export_layer_enum
+    static bool same_layer_enum(const char* layer_name, const char* name, s32 len)
+    {
+        if (len < 2 || name[0] != '_')
+            return false;
+        s32 i = 1;
+        for (const char* c = layer_name; *c != 0; ++c, ++i)
+        {
+            char ch = *c;
+            if (ch >= 'a' && ch <= 'z')
+                ch = ch - 'a' + 'A';
+            else if (!((ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9')))
+                ch = '_';
+            if (i >= len || name[i] != ch)
+                return false;
+        }
+        return i == len;
+    }
+
+    static s32 resolve_layer(keymap_t const* km, const char* name, s32 len)
+    {
+        if (km == nullptr)
+            return -1;
+        for (s32 l = 0; l < km->m_nb_layers; ++l)
+        {
+            const char* layer_name = km->m_layers[l].m_name;
+            if (layer_name == nullptr)
+                continue;
+            if ((strncmp(layer_name, name, len) == 0 && layer_name[len] == 0) || same_layer_enum(layer_name, name, len))
+                return l;
+        }
+        return -1;
+    }
+
+    static bool parse_layer(kparser_t& p, u32& layer)
+    {
+        if (parse_number(p, layer))
+            return true;
+        const char* name;
+        s32 const   len = parse_ident(p, name);
+        s32 const   l   = len > 0 ? resolve_layer(p.m_km, name, len) : -1;
+        if (l < 0)
+            return false;
+        layer = (u32)l;
+        return true;
+    }
+
+    // MOD_LCTL | MOD_LSFT, or a number
+    static bool parse_mods(kparser_t& p, u32& mods)
+    {
+        mods = 0;
+        do
+        {
+            u32 term = 0;
+            if (!parse_number(p, term))
+            {
+                const char* name;
+                s32 const   len = parse_ident(p, name);
+                s32 const   m   = find_name(s_mod_masks, name, len);
+                if (m < 0)
+                    return false;
+                term = s_mod_masks[m].m_value;
+            }
+            mods |= term;
+        } while (expect(p, '|'));
+        return mods <= 0x1F;
+    }
+
+    static bool parse_expr(kparser_t& p, kkeycode_t& out);
+
+    static bool parse_tap(kparser_t& p, kkeycode_t& out)
+    {
+        return parse_expr(p, out) && out.m_value <= QK_BASIC_MAX;
+    }
+
+    static bool parse_function(kparser_t& p, const char* name, s32 len, kkeycode_t& out)
+    {
+        u32 layer = 0;
+        u32 mods  = 0;
+
+        s32 const f = find_name(s_layer_functions, name, len);
+        if (f >= 0)
+        {
+            if (!parse_layer(p, layer) || layer > 31)
+                return false;
+            out.m_value = (u16)(s_layer_functions[f].m_value | layer);
+            out.m_index = -1;
+            return true;
+        }
+
+        if (len == 2 && strncmp(name, "LT", 2) == 0)
+        {
+            if (!parse_layer(p, layer) || layer > 15 || !expect(p, ',') || !parse_tap(p, out))
+                return false;
+            out.m_value = (u16)(QK_LAYER_TAP | (layer << 8) | out.m_value);
+            return true;
+        }
+        if (len == 2 && strncmp(name, "LM", 2) == 0)
+        {
+            if (!parse_layer(p, layer) || layer > 15 || !expect(p, ',') || !parse_mods(p, mods))
+                return false;
+            out.m_value = (u16)(QK_LAYER_MOD | (layer << 5) | mods);
+            out.m_index = -1;
+            return true;
+        }
+        if (len == 3 && strncmp(name, "OSM", 3) == 0)
+        {
+            if (!parse_mods(p, mods))
+                return false;
+            out.m_value = (u16)(QK_ONE_SHOT_MOD | mods);
+            out.m_index = -1;
+            return true;
+        }
+        if (len == 2 && strncmp(name, "MT", 2) == 0)
+        {
+            if (!parse_mods(p, mods) || !expect(p, ',') || !parse_tap(p, out))
+                return false;
+            out.m_value = (u16)(QK_MOD_TAP | (mods << 8) | out.m_value);
+            return true;
+        }
+
+        // mod-tap, e.g. LCTL_T(kc)
+        if (len > 2 && name[len - 2] == '_' && name[len - 1] == 'T')
+        {
+            s32 const m = find_name(s_mod_names, name, len - 2);
+            if (m < 0 || !parse_tap(p, out))
+                return false;
+            out.m_value = (u16)(QK_MOD_TAP | (s_mod_names[m].m_value << 8) | out.m_value);
+            return true;
+        }
+
+        // modifier wrapper, e.g. LCTL(kc), wrappers can be nested as long as they agree on left/right
+        s32 const m = find_name(s_mod_names, name, len);
+        if (m < 0 || !parse_expr(p, out) || out.m_value > QK_MODS_MAX)
+            return false;
+        u32 const inner = (out.m_value >> 8) & 0x1F;
+        u32 const outer = s_mod_names[m].m_value;
+        if (inner != 0 && ((inner ^ outer) & QMOD_RIGHT) != 0)
+            return false;
+        out.m_value = (u16)(out.m_value | (outer << 8));
+        return true;
+    }
+
+    static bool parse_expr(kparser_t& p, kkeycode_t& out)
+    {
+        u32 number = 0;
+        if (parse_number(p, number))
+        {
+            out.m_value = (u16)number;
+            out.m_index = -1;
+            return true;
+        }
+
+        const char* name;
+        s32 const   len = parse_ident(p, name);
+        if (len == 0)
+            return false;
+
+        if (expect(p, '('))
+            return parse_function(p, name, len, out) && expect(p, ')');
+
+        s32 const index = lookup_keycode_index(p.m_kcdb, name, len);
+        if (index >= 0)
+        {
+            out.m_value = keycode_value(p.m_kcdb, index);
+            out.m_index = (s16)index;
+            return true;
+        }
+
+        // a QMK keycode that is not in the database
+        s32 const b = find_name(s_basic_keycodes, name, len);
+        if (b < 0)
+            return false;
+        out.m_value = s_basic_keycodes[b].m_value;
+        out.m_index = -1;
+        return true;
+    }
+
+    bool parse_keycode(keycodes_t const* kcdb, keymap_t const* km, const char* expr, kkeycode_t& out)
+    {
+        out.m_value = 0;
+        out.m_index = -1;
+        if (expr == nullptr)
+            return false;
+
+        kparser_t p;
+        p.m_kcdb   = kcdb;
+        p.m_km     = km;
+        p.m_cursor = expr;
+        if (!parse_expr(p, out))
+            return false;
+        skip_spaces(p);
+        return *p.m_cursor == 0;
+    }
+
+    // --------------------------------------------------------------------------------------------------------------------------
+    // --------------------------------------------------------------------------------------------------------------------------
+    static u16 compile_switch(keymap_t const* km, key_t const& key, u16 tap)
+    {
+        // the layer name (which can hold any character), its enum or its number; a switch without a layer does not
+        // compile (it is not MO(0)), the validator reports it as a missing layer
+        if (key.m_layer == nullptr || key.m_layer[0] == 0)
+            return KEYCODE_INVALID;
+        s32 layer = resolve_layer(km, key.m_layer, (s32)strlen(key.m_layer));
+        if (layer < 0)
+        {
+            kparser_t p;
+            p.m_kcdb   = nullptr;
+            p.m_km     = km;
+            p.m_cursor = key.m_layer;
+            u32 number = 0;
+            if (!parse_layer(p, number) || (skip_spaces(p), *p.m_cursor != 0))
+                return KEYCODE_INVALID;
+            layer = (s32)number;
+        }
+
+        // the same precedence as export_key, only one of the switches can be active on a key
+        u16 const ls = key.m_layer_switch;
+        if (ls & LT)
+            return (layer <= 15 && tap <= QK_BASIC_MAX) ? (u16)(QK_LAYER_TAP | (layer << 8) | tap) : (u16)KEYCODE_INVALID;
+        if (layer > 31)
+            return KEYCODE_INVALID;
+        if (ls & TG)
+            return (u16)(QK_TOGGLE_LAYER | layer);
+        if (ls & TO)
+            return (u16)(QK_TO | layer);
+        if (ls & TT)
+            return (u16)(QK_LAYER_TAP_TOGGLE | layer);
+        if (ls & OSL)
+            return (u16)(QK_ONE_SHOT_LAYER | layer);
+        return (u16)(QK_MOMENTARY | layer);
+    }
+
+    bool compile_key(keycodes_t const* kcdb, keymap_t const* km, key_t& key)
+    {
+        kkeycode_t kc;
+        bool const known = parse_keycode(kcdb, km, key.m_keycode_str, kc);
+
+        key.m_kc   = known ? kc.m_index : (s16)KEYCODE_UNKNOWN;
+        key.m_tap  = known ? kc.m_value : (u16)KEYCODE_INVALID;
+        key.m_code = KEYCODE_INVALID;
+        if (!known)
+            return false;
+
+        u8 qmods = 0;
+        if (!qmk_mods(key.m_mod, qmods))
+            return false;
+
+        u16 const tap = kc.m_value;
+        if (key.m_layer_switch != 0)
+            key.m_code = compile_switch(km, key, tap);
+        else if (qmods != 0 && (key.m_mod & OSM))
+            key.m_code = (u16)(QK_ONE_SHOT_MOD | qmods);
+        else if (qmods != 0 && ((key.m_mod & MT) || key.m_mod_tap))
+            key.m_code = tap <= QK_BASIC_MAX ? (u16)(QK_MOD_TAP | (qmods << 8) | tap) : (u16)KEYCODE_INVALID;
+        else if (qmods != 0)
+        {
+            u32 const inner = (tap >> 8) & 0x1F;
+            if (tap <= QK_MODS_MAX && (inner == 0 || ((inner ^ qmods) & QMOD_RIGHT) == 0))
+                key.m_code = (u16)(tap | (qmods << 8));
+        }
+        else
+            key.m_code = tap;
+        return key.m_code != KEYCODE_INVALID;
+    }
+
+    void compile_keymap(keycodes_t const* kcdb, keymap_t* km)
+    {
+        for (s32 l = 0; l < km->m_nb_layers; ++l)
+        {
+            layer_t& layer = km->m_layers[l];
+            for (s32 k = 0; k < layer.m_nb_keys; ++k)
+                compile_key(kcdb, km, layer.m_keys[k]);
+        }
+    }
+
+    void compile_keymaps(keycodes_t const* kcdb, keymaps_t* keymaps)
+    {
+        for (s32 i = 0; i < keymaps->m_nb_keymaps; ++i)
+            compile_keymap(kcdb, &keymaps->m_keymaps[i]);
+    }
+
+    keycode_t const* key_keycode(keycodes_t const* kcdb, key_t const& key)
+    {
+        if (kcdb == nullptr)
+            return nullptr;
+        s32 index = key.m_kc;
+        if (index == KEYCODE_UNCOMPILED)
+        {
+            kkeycode_t kc;
+            index = parse_keycode(kcdb, nullptr, key.m_keycode_str, kc) ? kc.m_index : -1;
+        }
+        return (index >= 0 && index < kcdb->m_nb_keycodes) ? &kcdb->m_keycodes[index] : nullptr;
+    }
+
+} // namespace xcore
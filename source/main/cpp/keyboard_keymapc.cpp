@@ -0,0 +1,1009 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_keycode.h"
+#include "qmk-keymap-wiz/keyboard_keymapc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace xcore
+{
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // Tokens, a token points into the source (or into the text of a #define, which is the same source)
+    enum etoken
+    {
+        TOKEN_IDENT,
+        TOKEN_NUMBER,
+        TOKEN_STRING, // also a character literal
+        TOKEN_PUNCT,  // one character
+    };
+
+    struct stoken_t
+    {
+        const char* m_str;
+        s32         m_len;
+        s32         m_type;
+    };
+
+    static inline bool token_is(stoken_t const& t, char c) { return t.m_type == TOKEN_PUNCT && t.m_str[0] == c; }
+    static inline bool token_is(stoken_t const& t, const char* ident) { return t.m_type == TOKEN_IDENT && strncmp(t.m_str, ident, t.m_len) == 0 && ident[t.m_len] == 0; }
+    static inline bool same_token(stoken_t const& a, stoken_t const& b) { return a.m_len == b.m_len && strncmp(a.m_str, b.m_str, a.m_len) == 0; }
+
+    template <typename T> struct sarray_t
+    {
+        s32 m_nb;
+        s32 m_max;
+        T*  m_items;
+    };
+
+    template <typename T> static void push(sarray_t<T>& a, T const& item)
+    {
+        if (a.m_nb == a.m_max)
+        {
+            a.m_max   = a.m_max == 0 ? 256 : a.m_max * 2;
+            a.m_items = (T*)::realloc(a.m_items, sizeof(T) * a.m_max);
+        }
+        a.m_items[a.m_nb++] = item;
+    }
+
+    template <typename T> static void release(sarray_t<T>& a)
+    {
+        ::free(a.m_items);
+        a.m_nb    = 0;
+        a.m_max   = 0;
+        a.m_items = nullptr;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // The lexer, only as much C as a keymap.c needs
+    struct slexer_t
+    {
+        const char* m_cursor;
+        const char* m_end;
+    };
+
+    static inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+    static inline bool is_ident_char(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || is_digit(c) || c == '_'; }
+
+    // white space, comments and escaped newlines, returns true when a newline was passed; with 'line' the scan stops
+    // at the end of the line, the end of a preprocessor directive
+    static bool lex_space(slexer_t& lx, bool line)
+    {
+        bool newline = false;
+        while (lx.m_cursor < lx.m_end)
+        {
+            char const c    = *lx.m_cursor;
+            char const next = lx.m_cursor + 1 < lx.m_end ? lx.m_cursor[1] : 0;
+            if (c == '\n')
+            {
+                if (line)
+                    break;
+                newline = true;
+                lx.m_cursor++;
+            }
+            else if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v')
+            {
+                lx.m_cursor++;
+            }
+            else if (c == '\\' && (next == '\n' || next == '\r'))
+            {
+                lx.m_cursor += 2;
+                if (next == '\r' && lx.m_cursor < lx.m_end && *lx.m_cursor == '\n')
+                    lx.m_cursor++;
+            }
+            else if (c == '/' && next == '/')
+            {
+                while (lx.m_cursor < lx.m_end && *lx.m_cursor != '\n')
+                    lx.m_cursor++;
+            }
+            else if (c == '/' && next == '*')
+            {
+                lx.m_cursor += 2;
+                while (lx.m_cursor + 1 < lx.m_end && !(lx.m_cursor[0] == '*' && lx.m_cursor[1] == '/'))
+                    lx.m_cursor++;
+                lx.m_cursor = lx.m_cursor + 1 < lx.m_end ? lx.m_cursor + 2 : lx.m_end;
+            }
+            else
+            {
+                break;
+            }
+        }
+        return newline;
+    }
+
+    // the next token, false at the end of the source (or of the line)
+    static bool lex_token(slexer_t& lx, bool line, stoken_t& tok)
+    {
+        lex_space(lx, line);
+        if (lx.m_cursor >= lx.m_end || *lx.m_cursor == '\n')
+            return false;
+
+        const char* start = lx.m_cursor;
+        char const  c     = *start;
+        char const  next  = start + 1 < lx.m_end ? start[1] : 0;
+        if (is_ident_char(c) && !is_digit(c))
+        {
+            while (lx.m_cursor < lx.m_end && is_ident_char(*lx.m_cursor))
+                lx.m_cursor++;
+            tok.m_type = TOKEN_IDENT;
+        }
+        else if (is_digit(c) || (c == '.' && is_digit(next)))
+        {
+            while (lx.m_cursor < lx.m_end && (is_ident_char(*lx.m_cursor) || *lx.m_cursor == '.'))
+                lx.m_cursor++;
+            tok.m_type = TOKEN_NUMBER;
+        }
+        else if (c == '"' || c == '\'')
+        {
+            lx.m_cursor++;
+            while (lx.m_cursor < lx.m_end && *lx.m_cursor != c && *lx.m_cursor != '\n')
+                lx.m_cursor += (*lx.m_cursor == '\\' && lx.m_cursor + 1 < lx.m_end) ? 2 : 1;
+            if (lx.m_cursor < lx.m_end && *lx.m_cursor == c)
+                lx.m_cursor++;
+            tok.m_type = TOKEN_STRING;
+        }
+        else
+        {
+            lx.m_cursor++;
+            tok.m_type = TOKEN_PUNCT;
+        }
+        tok.m_str = start;
+        tok.m_len = (s32)(lx.m_cursor - start);
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // The parse of a keymap.c, the strings of the keymap in one text buffer
+
+    struct sdefine_t
+    {
+        stoken_t m_name;
+        s32      m_nb_params; // -1 for an object-like macro
+        s32      m_params;    // index of the first parameter in m_macro
+        s32      m_body;      // index of the first token of the replacement in m_macro
+        s32      m_nb_body;
+        bool     m_active; // being expanded, a macro does not expand itself
+    };
+
+    struct senum_t
+    {
+        stoken_t m_name;
+        s32      m_value; // -1 when it is not known, e.g. '= SAFE_RANGE'
+        s32      m_enum;  // the enum it is in, the enums are numbered in the order of the file
+    };
+
+    struct sarg_t
+    {
+        s32 m_first;
+        s32 m_nb;
+    };
+
+    struct sentry_t
+    {
+        s32      m_index;     // the layer
+        stoken_t m_name;      // the enumerator of the designator, m_len is 0 when there is none
+        stoken_t m_layout;    // the LAYOUT macro
+        s32      m_first_arg; // in m_args
+        s32      m_nb_args;
+    };
+
+    enum ekeykind
+    {
+        KEY_EXPR,         // kept as the expression
+        KEY_LAYER_TAP,    // LT(layer, kc)
+        KEY_LAYER,        // MO/TG/TO/TT/OSL(layer)
+        KEY_MOD_TAP,      // MT(mods, kc), LCTL_T(kc), ...
+        KEY_ONE_SHOT_MOD, // OSM(mods)
+        KEY_MODS,         // LCTL(kc), S(kc), ...
+    };
+
+    struct skey_t
+    {
+        s32 m_expr;   // offset in the text
+        s32 m_tap;    // offset in the text of the keycode that the key wraps, -1 when none
+        u16 m_switch; // elayer_switch of KEY_LAYER
+        u8  m_kind;
+    };
+
+    struct sparse_t
+    {
+        sarray_t<stoken_t>  m_code;  // the tokens outside of the preprocessor lines
+        sarray_t<stoken_t>  m_macro; // the parameters and replacements of the #define's
+        sarray_t<sdefine_t> m_defines;
+        s32*                m_hash; // index in m_defines by name, open addressing, -1 for an empty slot
+        u32                 m_hash_mask;
+        sarray_t<senum_t>   m_enums;
+        s32                 m_layer_enum; // the enum of the layer names, -1 when the layers are numbers
+        sarray_t<stoken_t>  m_expanded; // the entries of the keymaps array after macro expansion
+        sarray_t<sarg_t>    m_args;     // the arguments of the LAYOUT macros, tokens in m_expanded
+        sarray_t<sentry_t>  m_entries;
+        sarray_t<skey_t>    m_keys;
+        sarray_t<char>      m_text;
+        const char*         m_error;
+    };
+
+    enum
+    {
+        MAX_EXPANSION_DEPTH = 32,
+        MAX_EXPANDED_TOKENS = 1 << 20, // per file, so that a macro that explodes does not take all memory
+        MAX_LAYERS          = 32,
+        MAX_ARGS            = 0x7FFFFFFF,
+    };
+
+    static stoken_t const s_va_args = {"__VA_ARGS__", 11, TOKEN_IDENT};
+
+    static void release_parse(sparse_t& p)
+    {
+        release(p.m_code);
+        release(p.m_macro);
+        release(p.m_defines);
+        ::free(p.m_hash);
+        release(p.m_enums);
+        release(p.m_expanded);
+        release(p.m_args);
+        release(p.m_entries);
+        release(p.m_keys);
+        release(p.m_text);
+    }
+
+    static s32 add_text(sparse_t& p, const char* str, s32 len)
+    {
+        s32 const offset = p.m_text.m_nb;
+        for (s32 i = 0; i < len; ++i)
+            push(p.m_text, str[i]);
+        return offset;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // Preprocessor, only #define is looked at
+
+    static void directive(slexer_t& lx, sparse_t& p)
+    {
+        stoken_t tok;
+        if (lex_token(lx, true, tok) && token_is(tok, "define") && lex_token(lx, true, tok) && tok.m_type == TOKEN_IDENT)
+        {
+            sdefine_t d;
+            d.m_name      = tok;
+            d.m_nb_params = -1;
+            d.m_params    = p.m_macro.m_nb;
+            d.m_active    = false;
+
+            // a function-like macro has the '(' right after the name
+            if (lx.m_cursor < lx.m_end && *lx.m_cursor == '(')
+            {
+                lx.m_cursor++;
+                d.m_nb_params = 0;
+                bool variadic = false;
+                while (lex_token(lx, true, tok) && !token_is(tok, ')'))
+                {
+                    if (tok.m_type == TOKEN_IDENT)
+                    {
+                        push(p.m_macro, tok);
+                        d.m_nb_params++;
+                    }
+                    else if (token_is(tok, '.') && !variadic)
+                    {
+                        push(p.m_macro, s_va_args);
+                        d.m_nb_params++;
+                        variadic = true;
+                    }
+                }
+            }
+
+            d.m_body = p.m_macro.m_nb;
+            while (lex_token(lx, true, tok))
+                push(p.m_macro, tok);
+            d.m_nb_body = p.m_macro.m_nb - d.m_body;
+            push(p.m_defines, d);
+            return;
+        }
+        while (lex_token(lx, true, tok))
+        {
+        }
+    }
+
+    static void tokenize(const char* src, s64 size, sparse_t& p)
+    {
+        slexer_t lx;
+        lx.m_cursor = src;
+        lx.m_end    = src + size;
+
+        bool line_start = true;
+        while (true)
+        {
+            if (lex_space(lx, false))
+                line_start = true;
+            if (lx.m_cursor >= lx.m_end)
+                break;
+            if (line_start && *lx.m_cursor == '#')
+            {
+                lx.m_cursor++;
+                directive(lx, p);
+            }
+            else
+            {
+                stoken_t tok;
+                lex_token(lx, false, tok);
+                push(p.m_code, tok);
+            }
+            line_start = false;
+        }
+    }
+
+    static u32 hash_name(stoken_t const& t)
+    {
+        u32 h = 2166136261u;
+        for (s32 i = 0; i < t.m_len; ++i)
+            h = (h ^ (u8)t.m_str[i]) * 16777619u;
+        return h;
+    }
+
+    static void hash_defines(sparse_t& p)
+    {
+        u32 size = 16;
+        while (size < (u32)p.m_defines.m_nb * 2)
+            size *= 2;
+        p.m_hash      = (s32*)::malloc(sizeof(s32) * size);
+        p.m_hash_mask = size - 1;
+        memset(p.m_hash, 0xFF, sizeof(s32) * size);
+
+        // a later #define of a name replaces the earlier one
+        for (s32 d = 0; d < p.m_defines.m_nb; ++d)
+        {
+            stoken_t const& name = p.m_defines.m_items[d].m_name;
+            u32             slot = hash_name(name) & p.m_hash_mask;
+            while (p.m_hash[slot] >= 0 && !same_token(p.m_defines.m_items[p.m_hash[slot]].m_name, name))
+                slot = (slot + 1) & p.m_hash_mask;
+            p.m_hash[slot] = d;
+        }
+    }
+
+    static s32 find_define(sparse_t const& p, stoken_t const& name)
+    {
+        u32 slot = hash_name(name) & p.m_hash_mask;
+        while (p.m_hash[slot] >= 0)
+        {
+            if (same_token(p.m_defines.m_items[p.m_hash[slot]].m_name, name))
+                return p.m_hash[slot];
+            slot = (slot + 1) & p.m_hash_mask;
+        }
+        return -1;
+    }
+
+    // the index of the ')' that closes the '(' at 'open', -1 when it is not closed
+    static s32 closing(stoken_t const* tokens, s32 open, s32 nb)
+    {
+        s32 depth = 0;
+        for (s32 i = open; i < nb; ++i)
+        {
+            if (token_is(tokens[i], '('))
+                depth++;
+            else if (token_is(tokens[i], ')') && --depth == 0)
+                return i;
+        }
+        return -1;
+    }
+
+    // the tokens [first, end) split at the commas outside of parentheses, into at most 'max' arguments
+    static void split_args(stoken_t const* tokens, s32 first, s32 end, s32 max, sarray_t<sarg_t>& args)
+    {
+        if (first >= end)
+            return;
+        s32    depth = 0;
+        sarg_t arg;
+        arg.m_first = first;
+        for (s32 i = first; i < end; ++i)
+        {
+            if (token_is(tokens[i], '('))
+                depth++;
+            else if (token_is(tokens[i], ')'))
+                depth--;
+            else if (depth == 0 && token_is(tokens[i], ',') && args.m_nb + 1 < max)
+            {
+                arg.m_nb = i - arg.m_first;
+                push(args, arg);
+                arg.m_first = i + 1;
+            }
+        }
+        arg.m_nb = end - arg.m_first;
+        push(args, arg);
+    }
+
+    // Macro expansion into 'out'. The arguments of a function-like macro are put into its replacement as they are
+    // and expanded with it, which for the macros of a keymap gives the same result as expanding them first.
+    static void expand(sparse_t& p, stoken_t const* tokens, s32 nb, sarray_t<stoken_t>& out, s32 depth)
+    {
+        for (s32 i = 0; i < nb; ++i)
+        {
+            stoken_t const& tok = tokens[i];
+            s32 const       d   = (tok.m_type == TOKEN_IDENT && depth < MAX_EXPANSION_DEPTH) ? find_define(p, tok) : -1;
+            if (d < 0 || p.m_defines.m_items[d].m_active || out.m_nb > MAX_EXPANDED_TOKENS)
+            {
+                push(out, tok);
+                continue;
+            }
+
+            sdefine_t&      def  = p.m_defines.m_items[d];
+            stoken_t const* body = p.m_macro.m_items + def.m_body;
+            if (def.m_nb_params < 0)
+            {
+                def.m_active = true;
+                expand(p, body, def.m_nb_body, out, depth + 1);
+                def.m_active = false;
+                continue;
+            }
+
+            // the name of a function-like macro without arguments is just a name
+            s32 const close = (i + 1 < nb && token_is(tokens[i + 1], '(')) ? closing(tokens, i + 1, nb) : -1;
+            if (close < 0)
+            {
+                push(out, tok);
+                continue;
+            }
+
+            stoken_t const*  params   = p.m_macro.m_items + def.m_params;
+            bool const       variadic = def.m_nb_params > 0 && same_token(params[def.m_nb_params - 1], s_va_args);
+            sarray_t<sarg_t> args     = {0, 0, nullptr};
+            split_args(tokens, i + 2, close, variadic ? def.m_nb_params : (s32)MAX_ARGS, args);
+
+            sarray_t<stoken_t> replaced = {0, 0, nullptr};
+            for (s32 b = 0; b < def.m_nb_body; ++b)
+            {
+                s32 param = -1;
+                if (body[b].m_type == TOKEN_IDENT)
+                {
+                    for (s32 a = 0; a < def.m_nb_params && param < 0; ++a)
+                        param = same_token(body[b], params[a]) ? a : -1;
+                }
+                if (param < 0)
+                    push(replaced, body[b]);
+                else if (param < args.m_nb)
+                {
+                    for (s32 t = 0; t < args.m_items[param].m_nb; ++t)
+                        push(replaced, tokens[args.m_items[param].m_first + t]);
+                }
+            }
+
+            def.m_active = true;
+            expand(p, replaced.m_items, replaced.m_nb, out, depth + 1);
+            def.m_active = false;
+            release(replaced);
+            release(args);
+            i = close;
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // Enums and the keymaps array
+
+    static s32 parse_number(stoken_t const& t)
+    {
+        char buffer[32];
+        if (t.m_len >= (s32)sizeof(buffer))
+            return -1;
+        memcpy(buffer, t.m_str, t.m_len);
+        buffer[t.m_len] = 0;
+        char*      end  = nullptr;
+        long const n    = strtol(buffer, &end, 0);
+        while (*end == 'u' || *end == 'U' || *end == 'l' || *end == 'L')
+            end++;
+        return (*end == 0 && n >= 0 && n <= 0x7FFFFFFF) ? (s32)n : -1;
+    }
+
+    static senum_t const* find_enum(sparse_t const& p, stoken_t const& name)
+    {
+        for (s32 i = p.m_enums.m_nb - 1; i >= 0; --i)
+        {
+            if (same_token(p.m_enums.m_items[i].m_name, name))
+                return &p.m_enums.m_items[i];
+        }
+        return nullptr;
+    }
+
+    // a number, or an enumerator, after macro expansion; -1 for anything else
+    static s32 eval_value(sparse_t& p, stoken_t const* tokens, s32 nb)
+    {
+        sarray_t<stoken_t> e = {0, 0, nullptr};
+        expand(p, tokens, nb, e, 0);
+        s32 value = -1;
+        if (e.m_nb == 1 && e.m_items[0].m_type == TOKEN_NUMBER)
+            value = parse_number(e.m_items[0]);
+        else if (e.m_nb == 1 && e.m_items[0].m_type == TOKEN_IDENT)
+        {
+            senum_t const* enumerator = find_enum(p, e.m_items[0]);
+            value                     = enumerator != nullptr ? enumerator->m_value : -1;
+        }
+        release(e);
+        return value;
+    }
+
+    static void parse_enums(sparse_t& p)
+    {
+        stoken_t const* code    = p.m_code.m_items;
+        s32 const       nb      = p.m_code.m_nb;
+        s32             nb_enum = 0;
+        for (s32 i = 0; i < nb; ++i)
+        {
+            if (!token_is(code[i], "enum"))
+                continue;
+            s32 j = i + 1;
+            if (j < nb && code[j].m_type == TOKEN_IDENT)
+                j++;
+            if (j >= nb || !token_is(code[j], '{'))
+                continue;
+
+            s32 value = 0;
+            for (j++; j < nb && !token_is(code[j], '}');)
+            {
+                if (code[j].m_type != TOKEN_IDENT)
+                {
+                    j++;
+                    continue;
+                }
+                senum_t e;
+                e.m_name = code[j++];
+                if (j < nb && token_is(code[j], '='))
+                {
+                    s32 const first = ++j;
+                    while (j < nb && !token_is(code[j], ',') && !token_is(code[j], '}'))
+                        j++;
+                    value = eval_value(p, code + first, j - first);
+                }
+                e.m_value = value;
+                e.m_enum  = nb_enum;
+                push(p.m_enums, e);
+                value = value >= 0 ? value + 1 : -1;
+                if (j < nb && token_is(code[j], ','))
+                    j++;
+            }
+            i = j;
+            nb_enum += 1;
+        }
+    }
+
+    // [_NAV] = LAYOUT_xxx(k, k, ...), or LAYOUT_xxx(...) for the layer after the previous one
+    static bool parse_entry(sparse_t& p, stoken_t const* tokens, s32 nb, s32& next_index)
+    {
+        if (nb == 0)
+            return true;
+
+        s32 const first = p.m_expanded.m_nb;
+        expand(p, tokens, nb, p.m_expanded, 0);
+        stoken_t const* e  = p.m_expanded.m_items + first;
+        s32 const       ne = p.m_expanded.m_nb - first;
+        if (ne == 0)
+            return true; // an entry of macros that expand to nothing
+
+        sentry_t entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.m_index = next_index;
+
+        s32 i = 0;
+        if (token_is(e[0], '['))
+        {
+            while (i < ne && !token_is(e[i], ']'))
+                i++;
+            if (i + 1 >= ne || !token_is(e[i + 1], '='))
+            {
+                p.m_error = "an entry of the keymaps array has a bad designator";
+                return false;
+            }
+            // an enumerator from another file (layers.h) is taken to be the layer after the previous one
+            s32 const index = eval_value(p, e + 1, i - 1);
+            entry.m_index   = index >= 0 ? index : next_index;
+            if (nb >= 3 && tokens[1].m_type == TOKEN_IDENT && token_is(tokens[2], ']'))
+                entry.m_name = tokens[1];
+            i += 2;
+        }
+        if (entry.m_index >= MAX_LAYERS)
+        {
+            p.m_error = "a layer index of the keymaps array is over 31";
+            return false;
+        }
+
+        s32 const close = (i + 1 < ne && e[i].m_type == TOKEN_IDENT && token_is(e[i + 1], '(')) ? closing(e, i + 1, ne) : -1;
+        if (close != ne - 1)
+        {
+            p.m_error = "an entry of the keymaps array is not a LAYOUT(...)";
+            return false;
+        }
+        entry.m_layout    = e[i];
+        entry.m_first_arg = p.m_args.m_nb;
+        split_args(p.m_expanded.m_items, first + i + 2, first + close, MAX_ARGS, p.m_args);
+        entry.m_nb_args = p.m_args.m_nb - entry.m_first_arg;
+        if (entry.m_nb_args > 0x7FFF)
+        {
+            p.m_error = "a layer of the keymaps array has too many keys";
+            return false;
+        }
+
+        for (s32 l = 0; l < p.m_entries.m_nb; ++l)
+        {
+            if (p.m_entries.m_items[l].m_index == entry.m_index)
+            {
+                p.m_error = "a layer is in the keymaps array twice";
+                return false;
+            }
+        }
+        push(p.m_entries, entry);
+        next_index = entry.m_index + 1;
+        return true;
+    }
+
+    // const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = { entry, entry, ... };
+    static bool parse_keymaps(sparse_t& p)
+    {
+        stoken_t const* code = p.m_code.m_items;
+        s32 const       nb   = p.m_code.m_nb;
+
+        s32 i = 0;
+        while (i + 1 < nb && !(token_is(code[i], "keymaps") && token_is(code[i + 1], '[')))
+            i++;
+        if (i + 1 >= nb)
+        {
+            p.m_error = "there is no keymaps array";
+            return false;
+        }
+        while (i < nb && !token_is(code[i], '='))
+            i++;
+        if (i + 1 >= nb || !token_is(code[i + 1], '{'))
+        {
+            p.m_error = "the keymaps array has no initializer";
+            return false;
+        }
+
+        s32 next_index = 0;
+        for (i += 2; i < nb && !token_is(code[i], '}');)
+        {
+            // an entry ends at a comma, or the closing brace, outside of parentheses, brackets and braces
+            s32 const first = i;
+            s32       depth = 0;
+            for (; i < nb; ++i)
+            {
+                if (token_is(code[i], '(') || token_is(code[i], '[') || token_is(code[i], '{'))
+                    depth++;
+                else if (token_is(code[i], ')') || token_is(code[i], ']') || token_is(code[i], '}'))
+                {
+                    if (depth == 0)
+                        break;
+                    depth--;
+                }
+                else if (depth == 0 && token_is(code[i], ','))
+                    break;
+            }
+            if (!parse_entry(p, code + first, i - first, next_index))
+                return false;
+            if (i < nb && token_is(code[i], ','))
+                i++;
+        }
+        if (p.m_entries.m_nb == 0)
+        {
+            p.m_error = "the keymaps array is empty";
+            return false;
+        }
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // Keys
+
+    // the leading underscores of a layer enumerator, '_NAV' -> "NAV"
+    static s32 skip_underscores(stoken_t const& name)
+    {
+        s32 i = 0;
+        while (i < name.m_len && name.m_str[i] == '_')
+            i++;
+        return i < name.m_len ? i : 0;
+    }
+
+    // a designator of the keymaps array or an enumerator of the same enum
+    static bool is_layer_name(sparse_t const& p, stoken_t const& t)
+    {
+        for (s32 e = 0; e < p.m_entries.m_nb; ++e)
+        {
+            if (p.m_entries.m_items[e].m_name.m_len > 0 && same_token(p.m_entries.m_items[e].m_name, t))
+                return true;
+        }
+        senum_t const* enumerator = p.m_layer_enum >= 0 ? find_enum(p, t) : nullptr;
+        return enumerator != nullptr && enumerator->m_enum == p.m_layer_enum;
+    }
+
+    // the enumerator of a layer that the keymaps array does not have, e.g. a layer the keymap only uses in
+    // layer_state_set_user
+    static senum_t const* find_layer_enum(sparse_t const& p, s32 index)
+    {
+        for (s32 i = 0; i < p.m_enums.m_nb && p.m_layer_enum >= 0; ++i)
+        {
+            if (p.m_enums.m_items[i].m_enum == p.m_layer_enum && p.m_enums.m_items[i].m_value == index)
+                return &p.m_enums.m_items[i];
+        }
+        return nullptr;
+    }
+
+    // the tokens as one expression, 'LT(_NAV,KC_SPC)' -> "LT(NAV, KC_SPC)"
+    static s32 add_expr(sparse_t& p, stoken_t const* tokens, s32 nb)
+    {
+        s32 const offset = p.m_text.m_nb;
+        for (s32 i = 0; i < nb; ++i)
+        {
+            stoken_t const& t = tokens[i];
+            if (i > 0)
+            {
+                stoken_t const& prev  = tokens[i - 1];
+                bool const      words = (prev.m_type == TOKEN_IDENT || prev.m_type == TOKEN_NUMBER) && (t.m_type == TOKEN_IDENT || t.m_type == TOKEN_NUMBER);
+                if (words || token_is(prev, ',') || token_is(prev, '|') || token_is(t, '|'))
+                    push(p.m_text, ' ');
+            }
+            s32 const skip = (t.m_type == TOKEN_IDENT && is_layer_name(p, t)) ? skip_underscores(t) : 0;
+            add_text(p, t.m_str + skip, t.m_len - skip);
+        }
+        push(p.m_text, '\0');
+        return offset;
+    }
+
+    struct sswitchname_t
+    {
+        const char* m_name;
+        u16         m_switch;
+    };
+
+    static const sswitchname_t s_switch_names[] = {
+        {"MO", MO}, {"TG", TG}, {"TO", TO}, {"TT", TT}, {"OSL", OSL},
+    };
+
+    // what the key looks like, the keycode it wraps is checked when the key is taken apart
+    static void classify_key(sparse_t& p, stoken_t const* tokens, s32 nb, skey_t& key)
+    {
+        key.m_kind   = KEY_EXPR;
+        key.m_tap    = -1;
+        key.m_switch = 0;
+        if (nb < 3 || tokens[0].m_type != TOKEN_IDENT || !token_is(tokens[1], '(') || closing(tokens, 1, nb) != nb - 1)
+            return;
+
+        sarray_t<sarg_t> args = {0, 0, nullptr};
+        split_args(tokens, 2, nb - 1, MAX_ARGS, args);
+        stoken_t const& name = tokens[0];
+        sarg_t          tap  = {-1, 0};
+        if (args.m_nb == 2 && token_is(name, "LT"))
+        {
+            key.m_kind   = KEY_LAYER_TAP;
+            key.m_switch = LT;
+            tap          = args.m_items[1];
+        }
+        else if (args.m_nb == 2 && token_is(name, "MT"))
+        {
+            key.m_kind = KEY_MOD_TAP;
+            tap        = args.m_items[1];
+        }
+        else if (args.m_nb == 1 && token_is(name, "OSM"))
+        {
+            key.m_kind = KEY_ONE_SHOT_MOD;
+        }
+        else if (args.m_nb == 1)
+        {
+            for (s32 s = 0; s < (s32)(sizeof(s_switch_names) / sizeof(s_switch_names[0])); ++s)
+            {
+                if (token_is(name, s_switch_names[s].m_name))
+                {
+                    key.m_kind   = KEY_LAYER;
+                    key.m_switch = s_switch_names[s].m_switch;
+                }
+            }
+            tap = args.m_items[0];
+            if (key.m_kind == KEY_LAYER)
+                tap.m_first = -1;
+            else if (name.m_len > 2 && name.m_str[name.m_len - 2] == '_' && name.m_str[name.m_len - 1] == 'T')
+                key.m_kind = KEY_MOD_TAP;
+            else
+            {
+                // modifier wrappers, LCTL(LSFT(kc)) -> kc
+                key.m_kind = KEY_MODS;
+                while (tap.m_nb >= 3 && tokens[tap.m_first].m_type == TOKEN_IDENT && token_is(tokens[tap.m_first + 1], '(') && closing(tokens, tap.m_first + 1, tap.m_first + tap.m_nb) == tap.m_first + tap.m_nb - 1)
+                {
+                    sarray_t<sarg_t> inner = {0, 0, nullptr};
+                    split_args(tokens, tap.m_first + 2, tap.m_first + tap.m_nb - 1, MAX_ARGS, inner);
+                    bool const one = inner.m_nb == 1;
+                    if (one)
+                        tap = inner.m_items[0];
+                    release(inner);
+                    if (!one)
+                        break;
+                }
+            }
+        }
+        if (tap.m_first >= 0)
+            key.m_tap = add_expr(p, tokens + tap.m_first, tap.m_nb);
+        release(args);
+    }
+
+    // the key as keycode, modifiers and layer switch, the way the editor makes it, when that compiles to the same
+    // value as the expression
+    static void take_apart(keycodes_t const* kcdb, keymap_t const* km, skey_t const& sk, const char* text, key_t& key)
+    {
+        if (sk.m_kind == KEY_EXPR || key.m_code == KEYCODE_INVALID)
+            return;
+
+        u16 const code  = key.m_code;
+        key_t     k     = key;
+        s32       layer = -1;
+        k.m_keycode_str = sk.m_tap >= 0 ? text + sk.m_tap : "KC_NO";
+        switch (sk.m_kind)
+        {
+            case KEY_LAYER_TAP:
+                k.m_layer_switch = LT;
+                layer            = (code >> 8) & 0x0F;
+                break;
+            case KEY_LAYER:
+                k.m_layer_switch = sk.m_switch;
+                layer            = code & 0x1F;
+                break;
+            case KEY_MOD_TAP: k.m_mod = emod_from_qmk((code >> 8) & 0x1F) | MT; break;
+            case KEY_ONE_SHOT_MOD: k.m_mod = emod_from_qmk(code & 0x1F) | OSM; break;
+            case KEY_MODS:
+            {
+                // the modifiers that the keycode has itself are not repeated, LCTL(KC_EXLM) -> KC_EXLM + LCtrl
+                kkeycode_t tap;
+                u32        mods = (code >> 8) & 0x1F;
+                if (parse_keycode(kcdb, km, k.m_keycode_str, tap) && (((tap.m_value >> 8) ^ mods) & QMOD_RIGHT) == 0)
+                    mods &= ~((tap.m_value >> 8) & 0x0F);
+                k.m_mod = (mods & 0x0F) != 0 ? emod_from_qmk((u8)mods) : 0;
+                break;
+            }
+        }
+        if (layer >= 0)
+        {
+            if (layer >= km->m_nb_layers)
+                return;
+            k.m_layer = km->m_layers[layer].m_name;
+        }
+        if (compile_key(kcdb, km, k) && k.m_code == code)
+            key = k;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+
+    bool keymapc_import(const char* src, s64 size, const char* keyboard, keycodes_t const* kcdb, kkeymapc_t& keymap, const char** error)
+    {
+        keymap = kkeymapc_t();
+
+        sparse_t p;
+        memset(&p, 0, sizeof(p));
+        tokenize(src, size, p);
+        hash_defines(p);
+        parse_enums(p);
+        if (!parse_keymaps(p))
+        {
+            if (error != nullptr)
+                *error = p.m_error;
+            release_parse(p);
+            return false;
+        }
+
+        // the layers in index order, the index is what LT(), MO(), .. refer to
+        s32 layer_entry[MAX_LAYERS];
+        s32 nb_layers = 0;
+        for (s32 l = 0; l < MAX_LAYERS; ++l)
+            layer_entry[l] = -1;
+        p.m_layer_enum = -1;
+        for (s32 e = 0; e < p.m_entries.m_nb; ++e)
+        {
+            sentry_t const& entry = p.m_entries.m_items[e];
+            layer_entry[entry.m_index] = e;
+            nb_layers = entry.m_index >= nb_layers ? entry.m_index + 1 : nb_layers;
+
+            senum_t const* enumerator = (p.m_layer_enum < 0 && entry.m_name.m_len > 0) ? find_enum(p, entry.m_name) : nullptr;
+            if (enumerator != nullptr)
+                p.m_layer_enum = enumerator->m_enum;
+        }
+
+        // the strings, the keymap is named after the keyboard and the layout of the first layer
+        stoken_t const& layout = p.m_entries.m_items[0].m_layout;
+        s32 const       name   = add_text(p, keyboard, (s32)strlen(keyboard));
+        if (keyboard[0] != 0)
+            push(p.m_text, ' ');
+        add_text(p, layout.m_str, layout.m_len);
+        push(p.m_text, '\0');
+
+        s32 layer_names[MAX_LAYERS];
+        for (s32 l = 0; l < nb_layers; ++l)
+        {
+            s32 const      e          = layer_entry[l];
+            senum_t const* enumerator = e < 0 ? find_layer_enum(p, l) : nullptr;
+            if ((e >= 0 && p.m_entries.m_items[e].m_name.m_len > 0) || enumerator != nullptr)
+            {
+                stoken_t const& ident = e >= 0 ? p.m_entries.m_items[e].m_name : enumerator->m_name;
+                s32 const       skip  = skip_underscores(ident);
+                layer_names[l]        = add_text(p, ident.m_str + skip, ident.m_len - skip);
+                push(p.m_text, '\0');
+            }
+            else
+            {
+                char      number[32];
+                s32 const len  = snprintf(number, sizeof(number), "Layer %d", l);
+                layer_names[l] = add_text(p, number, len + 1);
+            }
+
+            if (e < 0)
+                continue;
+            sentry_t const& entry = p.m_entries.m_items[e];
+            for (s32 a = 0; a < entry.m_nb_args; ++a)
+            {
+                sarg_t const    arg    = p.m_args.m_items[entry.m_first_arg + a];
+                stoken_t const* tokens = p.m_expanded.m_items + arg.m_first;
+                skey_t          key;
+                key.m_expr = add_expr(p, tokens, arg.m_nb);
+                classify_key(p, tokens, arg.m_nb, key);
+                push(p.m_keys, key);
+            }
+        }
+
+        // the keymap, layers, keys and strings in one allocation
+        s32 const    nb_keys     = p.m_keys.m_nb;
+        size_t const size_keymap = sizeof(keymap_t);
+        size_t const size_layers = sizeof(layer_t) * nb_layers;
+        size_t const size_keys   = sizeof(key_t) * nb_keys;
+        u8*          memory      = (u8*)::malloc(size_keymap + size_layers + size_keys + p.m_text.m_nb);
+        keymap_t*    km          = new (memory) keymap_t();
+        layer_t*     layers      = (layer_t*)(memory + size_keymap);
+        key_t*       keys        = (key_t*)(memory + size_keymap + size_layers);
+        char*        text        = (char*)(memory + size_keymap + size_layers + size_keys);
+        memcpy(text, p.m_text.m_items, p.m_text.m_nb);
+
+        km->m_name      = text + name;
+        km->m_nb_layers = nb_layers;
+        km->m_layers    = layers;
+        s32 k           = 0;
+        for (s32 l = 0; l < nb_layers; ++l)
+        {
+            layer_t* layer   = new (&layers[l]) layer_t();
+            layer->m_name    = text + layer_names[l];
+            layer->m_index   = (s16)l;
+            layer->m_nb_keys = layer_entry[l] >= 0 ? (s16)p.m_entries.m_items[layer_entry[l]].m_nb_args : 0;
+            layer->m_keys    = &keys[k];
+            for (s32 i = 0; i < layer->m_nb_keys; ++i, ++k)
+            {
+                new (&keys[k]) key_t();
+                keys[k].m_keycode_str = text + p.m_keys.m_items[k].m_expr;
+            }
+        }
+
+        // compile, and take apart what the editor has fields for, after all the layers have their name
+        s32 nb_unknown = 0;
+        if (kcdb != nullptr)
+        {
+            for (s32 i = 0; i < nb_keys; ++i)
+            {
+                if (!compile_key(kcdb, km, keys[i]))
+                    nb_unknown += 1;
+                else
+                    take_apart(kcdb, km, p.m_keys.m_items[i], text, keys[i]);
+            }
+        }
+
+        keymap.m_keymaps.m_nb_keymaps = 1;
+        keymap.m_keymaps.m_keymaps    = km;
+        keymap.m_nb_layers            = nb_layers;
+        keymap.m_nb_keys              = nb_keys;
+        keymap.m_nb_unknown           = nb_unknown;
+        keymap.m_nb_defines           = p.m_defines.m_nb;
+        keymap.m_memory               = memory;
+        release_parse(p);
+        return true;
+    }
+
+    void keymapc_release(kkeymapc_t& keymap)
+    {
+        ::free(keymap.m_memory);
+        keymap = kkeymapc_t();
+    }
+
+} // namespace xcore
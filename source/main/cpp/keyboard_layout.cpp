@@ -0,0 +1,143 @@
+#include "xbase/x_base.h"
+#include "xbase/x_memory.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_keycode.h"
+#include "qmk-keymap-wiz/keyboard_layout.h"
+
+#include <math.h> // sinf, cosf
+
+namespace xcore
+{
+    s32 keyboard_nb_keys(ckeyboard_t const* kb)
+    {
+        s32 nb_keys = 0;
+        for (s32 g = 0; g < kb->m_nb_keygroups; g++)
+        {
+            ckeygroup_t const& kg = kb->m_keygroups[g];
+            s32 const          n  = kg.m_r * kg.m_c;
+            nb_keys += (n < kg.m_nb_keys) ? n : kg.m_nb_keys;
+        }
+        return nb_keys;
+    }
+
+    s32 keyboard_layout(ckeyboard_t const* kb, float posx, float posy, float globalscale, ckeyplace_t* places, s32 max_places)
+    {
+        // origin = left/top corner
+        float const ox = posx + (kb->m_w / 2);
+        float const oy = posy + (kb->m_h / 2);
+
+        s32 nb_places = 0;
+        for (s32 g = 0; g < kb->m_nb_keygroups; g++)
+        {
+            ckeygroup_t const& kg = kb->m_keygroups[g];
+
+            float const gx = ox + (kg.m_x * kb->m_scale * globalscale);
+            float const gy = oy + (kg.m_y * kb->m_scale * globalscale);
+
+            // the keygroup down and right coordinate vectors
+            float xdirx = 1.0f, xdiry = 0.0f;
+            float ydirx = 0.0f, ydiry = 1.0f;
+
+            float rrad = 0.0f;
+            if (kg.m_a > 0 || kg.m_a < 0)
+            {
+                rrad          = (float)3.141592653f * kg.m_a / 180.0f;
+                float const s = (float)sin(rrad);
+                float const c = (float)cos(rrad);
+                xdirx         = c;
+                xdiry         = s;
+                ydirx         = -s;
+                ydiry         = c;
+            }
+
+            u8 const* capcolor = kg.m_capcolor ? kg.m_capcolor : kb->m_capcolor;
+            u8 const* txtcolor = kg.m_txtcolor ? kg.m_txtcolor : kb->m_txtcolor;
+            u8 const* ledcolor = kg.m_ledcolor ? kg.m_ledcolor : kb->m_ledcolor;
+
+            float const stepx = (kb->m_w * kg.m_w) * kb->m_scale * globalscale;
+            float const stepy = (kb->m_h * kg.m_h) * kb->m_scale * globalscale;
+
+            float rx = gx;
+            float ry = gy;
+            s32   k  = 0;
+            for (s32 r = 0; r < kg.m_r; r++)
+            {
+                float cx = rx;
+                float cy = ry;
+
+                for (s32 c = 0; c < kg.m_c && k < kg.m_nb_keys; c++)
+                {
+                    ckey_t const& ckey = kg.m_keys[k++];
+                    if (nb_places == max_places)
+                        return nb_places;
+
+                    float const sw = ckey.m_sw * kg.m_sw * kb->m_sw * kb->m_scale * globalscale;
+                    float const sh = ckey.m_sh * kg.m_sh * kb->m_sh * kb->m_scale * globalscale;
+                    float const kw = (ckey.m_w * kg.m_w * kb->m_w * kb->m_scale * globalscale) - (2 * sw);
+                    float const kh = (ckey.m_h * kg.m_h * kb->m_h * kb->m_scale * globalscale) - (2 * sh);
+
+                    ckeyplace_t& place = places[nb_places++];
+                    place.m_group      = &kg;
+                    place.m_key        = &ckey;
+                    place.m_x          = cx;
+                    place.m_y          = cy;
+                    place.m_hw         = kw / 2;
+                    place.m_hh         = kh / 2;
+                    place.m_rounding   = kw / sw;
+                    place.m_th         = 10.0f * globalscale;
+                    place.m_rad        = rrad;
+                    place.m_capcolor   = ckey.m_capcolor ? ckey.m_capcolor : capcolor;
+                    place.m_txtcolor   = ckey.m_txtcolor ? ckey.m_txtcolor : txtcolor;
+                    place.m_ledcolor   = ckey.m_ledcolor ? ckey.m_ledcolor : ledcolor;
+
+                    cx += xdirx * stepx;
+                    cy += xdiry * stepy;
+                }
+
+                rx += ydirx * stepx;
+                ry += ydiry * stepy;
+            }
+        }
+        return nb_places;
+    }
+
+    bool keyplace_contains(ckeyplace_t const& place, float px, float py)
+    {
+        // rotate the point into the coordinate system of the key
+        float dx = px - place.m_x;
+        float dy = py - place.m_y;
+        if (place.m_rad > 0.0f || place.m_rad < 0.0f)
+        {
+            float const s  = (float)sin(-place.m_rad);
+            float const c  = (float)cos(-place.m_rad);
+            float const rx = dx * c - dy * s;
+            float const ry = dx * s + dy * c;
+            dx             = rx;
+            dy             = ry;
+        }
+        return dx >= -place.m_hw && dx <= place.m_hw && dy >= -place.m_hh && dy <= place.m_hh;
+    }
+
+    const char* keyplace_label(ckeyplace_t const& place, keycodes_t const* kcdb, keymap_t const* km, s32 layer)
+    {
+        if (km == nullptr || layer < 0 || layer >= km->m_nb_layers)
+            return place.m_key->m_label;
+
+        layer_t const* l = &km->m_layers[layer];
+        if (place.m_key->m_index < 0 || place.m_key->m_index >= l->m_nb_keys)
+            return place.m_key->m_label;
+
+        // the compiled key holds the index of its keycode in the database, the text to display comes from there
+        key_t const*     key     = &l->m_keys[place.m_key->m_index];
+        keycode_t const* keycode = key_keycode(kcdb, *key);
+        if (keycode == nullptr)
+            keycode = &kcdb->m_keycodes[0];
+
+        const char* key_label = keycode->m_normal;
+        if (key_label == nullptr)
+            key_label = key->m_keycode_str;
+        return key_label;
+    }
+
+} // namespace xcore
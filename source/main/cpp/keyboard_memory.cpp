@@ -0,0 +1,58 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_app.h"
+#include "qmk-keymap-wiz/keyboard_profile.h"
+
+#include "libimgui/imgui.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+
+// The global operator new and delete, every C++ allocation of the application and the libraries (std::thread,
+// std::function, containers) is counted in the innermost profiling zone, and so is every allocation of ImGui through
+// the functions that keyboard_profile_allocators (at the bottom) installs. The code of this application allocates
+// with ::malloc, at load time and when an edit is made, and those allocations are not counted. Exceptions are not
+// used, running out of memory aborts.
+
+static void* counted_alloc(size_t size)
+{
+    xcore::profile_alloc(size);
+    void* ptr = ::malloc(size > 0 ? size : 1);
+    if (ptr == nullptr)
+    {
+        printf("out of memory (%llu bytes)\n", (unsigned long long)size);
+        abort();
+    }
+    return ptr;
+}
+
+void* operator new(size_t size) { return counted_alloc(size); }
+void* operator new[](size_t size) { return counted_alloc(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    xcore::profile_alloc(size);
+    return ::malloc(size > 0 ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    xcore::profile_alloc(size);
+    return ::malloc(size > 0 ? size : 1);
+}
+
+void operator delete(void* ptr) noexcept { ::free(ptr); }
+void operator delete[](void* ptr) noexcept { ::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { ::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { ::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { ::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { ::free(ptr); }
+
+static void* profile_imgui_alloc(size_t size, void*)
+{
+    xcore::profile_alloc(size);
+    return ::malloc(size);
+}
+
+static void profile_imgui_free(void* ptr, void*) { ::free(ptr); }
+
+void keyboard_profile_allocators() { ImGui::SetAllocatorFunctions(profile_imgui_alloc, profile_imgui_free, nullptr); }
@@ -0,0 +1,597 @@
+#include "xbase/x_target.h"
+
+#include "qmk-keymap-wiz/keyboard_model.h"
+#include "qmk-keymap-wiz/keyboard_keycode.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace xcore
+{
+    // Keys of a layer are stored in blocks, an edit of a key copies only the block that holds it.
+    // A block is sparse, it only holds the keys that are not blank (see blank_kind), in order, a blank key is a bit
+    // in m_stored and the kind of blank in m_blank. Layers that are mostly KC_NO/KC_TRNS take little memory.
+    static const s32 s_keys_per_block = 16;
+
+    struct kkeyblock_t
+    {
+        s32   m_refs;
+        s16   m_nb_keys;
+        u16   m_stored;                  // bit per key, set when the key is in m_keys
+        u8    m_blank[s_keys_per_block]; // blank kind of the keys that are not stored
+        key_t m_keys[1];                 // the stored keys
+    };
+
+    struct klayernode_t
+    {
+        s32          m_refs;
+        layer_t      m_layer; // name, index and colors, m_keys is not used
+        s32          m_nb_blocks;
+        kkeyblock_t* m_blocks[1];
+    };
+
+    struct kkeymapnode_t
+    {
+        s32           m_refs;
+        const char*   m_name;
+        s32           m_nb_layers;
+        klayernode_t* m_layers[1];
+    };
+
+    struct ksnapshot_t
+    {
+        s32            m_refs;
+        s32            m_nb_keymaps;
+        kkeymapnode_t* m_keymaps[1];
+    };
+
+    struct kmodel_t
+    {
+        keymaps_t         m_keymaps; // the current snapshot as plain keymaps
+        keycodes_t const* m_kcdb;    // the plain keys are compiled for this database, nullptr when not
+        s32               m_nb_snapshots;
+        s32               m_max_snapshots;
+        s32               m_current;
+        s32               m_group; // the snapshot a group of edits started from, -1 when not grouping
+        ksnapshot_t**     m_snapshots;
+        s64               m_nb_nodes;
+        s64               m_nb_bytes;
+    };
+
+    static void* node_alloc(kmodel_t* model, s32 size)
+    {
+        model->m_nb_nodes += 1;
+        model->m_nb_bytes += size;
+        return ::malloc(size);
+    }
+
+    static void node_free(kmodel_t* model, void* node, s32 size)
+    {
+        model->m_nb_nodes -= 1;
+        model->m_nb_bytes -= size;
+        ::free(node);
+    }
+
+    static s32 count_bits(u32 bits)
+    {
+        s32 count = 0;
+        for (; bits != 0; bits &= bits - 1)
+            count++;
+        return count;
+    }
+
+    // nodes end with an array of child pointers (or keys), the struct already holds one
+    static s32 block_size(s32 nb_stored) { return (s32)sizeof(kkeyblock_t) + (nb_stored > 1 ? nb_stored - 1 : 0) * (s32)sizeof(key_t); }
+    static s32 block_size(kkeyblock_t const* block) { return block_size(count_bits(block->m_stored)); }
+    static s32 layer_size(s32 nb_blocks) { return (s32)sizeof(klayernode_t) + (nb_blocks > 1 ? nb_blocks - 1 : 0) * (s32)sizeof(kkeyblock_t*); }
+    static s32 keymap_size(s32 nb_layers) { return (s32)sizeof(kkeymapnode_t) + (nb_layers > 1 ? nb_layers - 1 : 0) * (s32)sizeof(klayernode_t*); }
+    static s32 snapshot_size(s32 nb_keymaps) { return (s32)sizeof(ksnapshot_t) + (nb_keymaps > 1 ? nb_keymaps - 1 : 0) * (s32)sizeof(kkeymapnode_t*); }
+
+    static void release_block(kmodel_t* model, kkeyblock_t* block)
+    {
+        if (--block->m_refs == 0)
+            node_free(model, block, block_size(block));
+    }
+
+    static void release_layer(kmodel_t* model, klayernode_t* layer)
+    {
+        if (--layer->m_refs > 0)
+            return;
+        for (s32 b = 0; b < layer->m_nb_blocks; ++b)
+            release_block(model, layer->m_blocks[b]);
+        node_free(model, layer, layer_size(layer->m_nb_blocks));
+    }
+
+    static void release_keymap(kmodel_t* model, kkeymapnode_t* keymap)
+    {
+        if (--keymap->m_refs > 0)
+            return;
+        for (s32 l = 0; l < keymap->m_nb_layers; ++l)
+            release_layer(model, keymap->m_layers[l]);
+        node_free(model, keymap, keymap_size(keymap->m_nb_layers));
+    }
+
+    static void release_snapshot(kmodel_t* model, ksnapshot_t* snapshot)
+    {
+        if (--snapshot->m_refs > 0)
+            return;
+        for (s32 k = 0; k < snapshot->m_nb_keymaps; ++k)
+            release_keymap(model, snapshot->m_keymaps[k]);
+        node_free(model, snapshot, snapshot_size(snapshot->m_nb_keymaps));
+    }
+
+    static void block_key(kkeyblock_t const* block, s32 i, key_t& key)
+    {
+        u32 const bit = 1u << i;
+        if (block->m_stored & bit)
+            key = block->m_keys[count_bits(block->m_stored & (bit - 1))];
+        else
+            blank_key(block->m_blank[i], key);
+    }
+
+    // a block of the keys [begin, begin + nb_keys), only the keys that are not blank are copied
+    static kkeyblock_t* make_block(kmodel_t* model, key_t const* keys, s32 nb_keys)
+    {
+        u16 stored = 0;
+        u8  blank[s_keys_per_block];
+        for (s32 i = 0; i < nb_keys; ++i)
+        {
+            s32 const kind = blank_kind(keys[i]);
+            blank[i]       = kind >= 0 ? (u8)kind : 0;
+            if (kind < 0)
+                stored |= (u16)(1u << i);
+        }
+
+        kkeyblock_t* block = (kkeyblock_t*)node_alloc(model, block_size(count_bits(stored)));
+        block->m_refs      = 1;
+        block->m_nb_keys   = (s16)nb_keys;
+        block->m_stored    = stored;
+        memset(block->m_blank, 0, sizeof(block->m_blank));
+        memcpy(block->m_blank, blank, nb_keys);
+        s32 n = 0;
+        for (s32 i = 0; i < nb_keys; ++i)
+        {
+            if (stored & (1u << i))
+                memcpy((void*)&block->m_keys[n++], (void const*)&keys[i], sizeof(key_t));
+        }
+        return block;
+    }
+
+    // a copy of the block with key 'i' replaced
+    static kkeyblock_t* edit_block(kmodel_t* model, kkeyblock_t const* block, s32 i, key_t const& key)
+    {
+        key_t keys[s_keys_per_block];
+        for (s32 k = 0; k < block->m_nb_keys; ++k)
+            block_key(block, k, keys[k]);
+        keys[i] = key;
+        return make_block(model, keys, block->m_nb_keys);
+    }
+
+    // shallow copies, the children are shared
+
+    static klayernode_t* copy_layer(kmodel_t* model, klayernode_t const* layer)
+    {
+        s32 const     size = layer_size(layer->m_nb_blocks);
+        klayernode_t* copy = (klayernode_t*)node_alloc(model, size);
+        memcpy((void*)copy, (void const*)layer, size);
+        copy->m_refs = 1;
+        for (s32 b = 0; b < copy->m_nb_blocks; ++b)
+            copy->m_blocks[b]->m_refs += 1;
+        return copy;
+    }
+
+    static kkeymapnode_t* copy_keymap(kmodel_t* model, kkeymapnode_t const* keymap)
+    {
+        s32 const      size = keymap_size(keymap->m_nb_layers);
+        kkeymapnode_t* copy = (kkeymapnode_t*)node_alloc(model, size);
+        memcpy((void*)copy, (void const*)keymap, size);
+        copy->m_refs = 1;
+        for (s32 l = 0; l < copy->m_nb_layers; ++l)
+            copy->m_layers[l]->m_refs += 1;
+        return copy;
+    }
+
+    static ksnapshot_t* copy_snapshot(kmodel_t* model, ksnapshot_t const* snapshot)
+    {
+        s32 const    size = snapshot_size(snapshot->m_nb_keymaps);
+        ksnapshot_t* copy = (ksnapshot_t*)node_alloc(model, size);
+        memcpy((void*)copy, (void const*)snapshot, size);
+        copy->m_refs = 1;
+        for (s32 k = 0; k < copy->m_nb_keymaps; ++k)
+            copy->m_keymaps[k]->m_refs += 1;
+        return copy;
+    }
+
+    // --------------------------------------------------------------------------------------------------------------------------
+    // --------------------------------------------------------------------------------------------------------------------------
+    static bool same_str(const char* a, const char* b)
+    {
+        if (a == b)
+            return true;
+        if (a == nullptr || b == nullptr)
+            return false;
+        return strcmp(a, b) == 0;
+    }
+
+    static bool same_color(u8 const* a, u8 const* b) { return memcmp(a, b, 4) == 0; }
+
+    static bool same_key(key_t const& a, key_t const& b)
+    {
+        return same_str(a.m_keycode_str, b.m_keycode_str) && a.m_mod == b.m_mod && a.m_mod_tap == b.m_mod_tap && a.m_layer_switch == b.m_layer_switch && same_str(a.m_layer, b.m_layer) &&
+               same_color(a.m_capcolor, b.m_capcolor) && same_color(a.m_ledcolor, b.m_ledcolor);
+    }
+
+    // call 'fn' with the edits that turn key 'a' into key 'b'
+    static void diff_key(key_t const& a, key_t const& b, kedit_t& edit, edit_fn fn, void* user)
+    {
+        if (!same_str(a.m_keycode_str, b.m_keycode_str))
+        {
+            edit.m_op  = EDIT_KEYCODE;
+            edit.m_str = b.m_keycode_str;
+            fn(edit, user);
+        }
+        if (a.m_mod != b.m_mod)
+        {
+            edit.m_op    = EDIT_MOD;
+            edit.m_value = b.m_mod;
+            fn(edit, user);
+        }
+        if (a.m_mod_tap != b.m_mod_tap)
+        {
+            edit.m_op    = EDIT_MOD_TAP;
+            edit.m_value = b.m_mod_tap ? 1 : 0;
+            fn(edit, user);
+        }
+        if (a.m_layer_switch != b.m_layer_switch)
+        {
+            edit.m_op    = EDIT_LAYER_SWITCH;
+            edit.m_value = b.m_layer_switch;
+            fn(edit, user);
+        }
+        if (!same_str(a.m_layer, b.m_layer))
+        {
+            edit.m_op  = EDIT_LAYER;
+            edit.m_str = b.m_layer;
+            fn(edit, user);
+        }
+        if (!same_color(a.m_capcolor, b.m_capcolor))
+        {
+            edit.m_op = EDIT_KEY_CAPCOLOR;
+            memcpy(edit.m_color, b.m_capcolor, 4);
+            fn(edit, user);
+        }
+        if (!same_color(a.m_ledcolor, b.m_ledcolor))
+        {
+            edit.m_op = EDIT_KEY_LEDCOLOR;
+            memcpy(edit.m_color, b.m_ledcolor, 4);
+            fn(edit, user);
+        }
+    }
+
+    static void diff_layer(layer_t const& a, layer_t const& b, kedit_t& edit, edit_fn fn, void* user)
+    {
+        if (!same_color(a.m_capcolor, b.m_capcolor))
+        {
+            edit.m_op = EDIT_LAYER_CAPCOLOR;
+            memcpy(edit.m_color, b.m_capcolor, 4);
+            fn(edit, user);
+        }
+        if (!same_color(a.m_ledcolor, b.m_ledcolor))
+        {
+            edit.m_op = EDIT_LAYER_LEDCOLOR;
+            memcpy(edit.m_color, b.m_ledcolor, 4);
+            fn(edit, user);
+        }
+    }
+
+    // a key that was copied into the plain keymaps, the keys in the snapshots are not compiled
+    static void compile_plain_key(kmodel_t* model, keymap_t* km, key_t& key)
+    {
+        if (model->m_kcdb != nullptr)
+            compile_key(model->m_kcdb, km, key);
+        else
+            key.m_kc = KEYCODE_UNCOMPILED;
+    }
+
+    static void no_edit(kedit_t const&, void*) {}
+
+    // Bring the plain keymaps from snapshot 'from' to snapshot 'to'. Nodes that are shared by both snapshots are
+    // identical, so only the layers and blocks that differ by pointer have to be visited.
+    static void switch_snapshot(kmodel_t* model, ksnapshot_t const* from, ksnapshot_t const* to, edit_fn fn, void* user)
+    {
+        if (fn == nullptr)
+            fn = no_edit;
+
+        for (s32 k = 0; k < to->m_nb_keymaps; ++k)
+        {
+            kkeymapnode_t const* kfrom = from->m_keymaps[k];
+            kkeymapnode_t const* kto   = to->m_keymaps[k];
+            if (kfrom == kto)
+                continue;
+
+            keymap_t& km = model->m_keymaps.m_keymaps[k];
+            for (s32 l = 0; l < kto->m_nb_layers; ++l)
+            {
+                klayernode_t const* lfrom = kfrom->m_layers[l];
+                klayernode_t const* lto   = kto->m_layers[l];
+                if (lfrom == lto)
+                    continue;
+
+                kedit_t edit;
+                edit.m_keymap = k;
+                edit.m_layer  = l;
+                edit.m_key    = 0;
+
+                // the plain keymaps are updated before 'fn' is called, so it sees the new state
+                layer_t& layer = km.m_layers[l];
+                memcpy(layer.m_capcolor, lto->m_layer.m_capcolor, 4);
+                memcpy(layer.m_ledcolor, lto->m_layer.m_ledcolor, 4);
+                diff_layer(lfrom->m_layer, lto->m_layer, edit, fn, user);
+
+                for (s32 b = 0; b < lto->m_nb_blocks; ++b)
+                {
+                    kkeyblock_t const* bfrom = lfrom->m_blocks[b];
+                    kkeyblock_t const* bto   = lto->m_blocks[b];
+                    if (bfrom == bto)
+                        continue;
+                    for (s32 i = 0; i < bto->m_nb_keys; ++i)
+                    {
+                        key_t kfrom, kto;
+                        block_key(bfrom, i, kfrom);
+                        block_key(bto, i, kto);
+                        if (same_key(kfrom, kto))
+                            continue;
+                        edit.m_key               = b * s_keys_per_block + i;
+                        layer.m_keys[edit.m_key] = kto;
+                        compile_plain_key(model, &km, layer.m_keys[edit.m_key]);
+                        diff_key(kfrom, kto, edit, fn, user);
+                    }
+                }
+            }
+        }
+    }
+
+    // --------------------------------------------------------------------------------------------------------------------------
+    // --------------------------------------------------------------------------------------------------------------------------
+    kmodel_t* model_create(keymaps_t const* keymaps)
+    {
+        kmodel_t* model        = (kmodel_t*)::malloc(sizeof(kmodel_t));
+        model->m_nb_snapshots  = 0;
+        model->m_max_snapshots = 64;
+        model->m_current       = -1;
+        model->m_group         = -1;
+        model->m_snapshots     = (ksnapshot_t**)::malloc(sizeof(ksnapshot_t*) * model->m_max_snapshots);
+        model->m_nb_nodes      = 0;
+        model->m_nb_bytes      = 0;
+        model->m_kcdb          = nullptr;
+
+        s32 const nb_keymaps          = keymaps != nullptr ? keymaps->m_nb_keymaps : 0;
+        model->m_keymaps.m_nb_keymaps = nb_keymaps;
+        model->m_keymaps.m_keymaps    = (keymap_t*)::malloc(sizeof(keymap_t) * (nb_keymaps > 0 ? nb_keymaps : 1));
+
+        ksnapshot_t* snapshot  = (ksnapshot_t*)node_alloc(model, snapshot_size(nb_keymaps));
+        snapshot->m_refs       = 1;
+        snapshot->m_nb_keymaps = nb_keymaps;
+
+        for (s32 k = 0; k < nb_keymaps; ++k)
+        {
+            keymap_t const& src = keymaps->m_keymaps[k];
+            keymap_t&       dst = model->m_keymaps.m_keymaps[k];
+            dst.m_name          = src.m_name;
+            dst.m_nb_layers     = src.m_nb_layers;
+            dst.m_layers        = (layer_t*)::malloc(sizeof(layer_t) * (src.m_nb_layers > 0 ? src.m_nb_layers : 1));
+
+            kkeymapnode_t* knode   = (kkeymapnode_t*)node_alloc(model, keymap_size(src.m_nb_layers));
+            knode->m_refs          = 1;
+            knode->m_name          = src.m_name;
+            knode->m_nb_layers     = src.m_nb_layers;
+            snapshot->m_keymaps[k] = knode;
+
+            for (s32 l = 0; l < src.m_nb_layers; ++l)
+            {
+                layer_t const& lsrc = src.m_layers[l];
+                layer_t&       ldst = dst.m_layers[l];
+                memcpy((void*)&ldst, (void const*)&lsrc, sizeof(layer_t));
+                ldst.m_keys = (key_t*)::malloc(sizeof(key_t) * (lsrc.m_nb_keys > 0 ? lsrc.m_nb_keys : 1));
+                memcpy((void*)ldst.m_keys, (void const*)lsrc.m_keys, sizeof(key_t) * lsrc.m_nb_keys);
+
+                s32 const     nb_blocks = (lsrc.m_nb_keys + s_keys_per_block - 1) / s_keys_per_block;
+                klayernode_t* lnode     = (klayernode_t*)node_alloc(model, layer_size(nb_blocks));
+                lnode->m_refs           = 1;
+                memcpy((void*)&lnode->m_layer, (void const*)&lsrc, sizeof(layer_t));
+                lnode->m_layer.m_keys = nullptr;
+                lnode->m_nb_blocks    = nb_blocks;
+                knode->m_layers[l]    = lnode;
+
+                for (s32 b = 0; b < nb_blocks; ++b)
+                {
+                    s32 nb_keys = lsrc.m_nb_keys - b * s_keys_per_block;
+                    if (nb_keys > s_keys_per_block)
+                        nb_keys = s_keys_per_block;
+                    lnode->m_blocks[b] = make_block(model, &lsrc.m_keys[b * s_keys_per_block], nb_keys);
+                }
+            }
+        }
+
+        model->m_snapshots[model->m_nb_snapshots++] = snapshot;
+        model->m_current                             = 0;
+        return model;
+    }
+
+    void model_destroy(kmodel_t* model)
+    {
+        if (model == nullptr)
+            return;
+        for (s32 i = 0; i < model->m_nb_snapshots; ++i)
+            release_snapshot(model, model->m_snapshots[i]);
+        ::free(model->m_snapshots);
+        for (s32 k = 0; k < model->m_keymaps.m_nb_keymaps; ++k)
+        {
+            keymap_t& km = model->m_keymaps.m_keymaps[k];
+            for (s32 l = 0; l < km.m_nb_layers; ++l)
+                ::free(km.m_layers[l].m_keys);
+            ::free(km.m_layers);
+        }
+        ::free(model->m_keymaps.m_keymaps);
+        ::free(model);
+    }
+
+    keymaps_t const* model_keymaps(kmodel_t* model) { return &model->m_keymaps; }
+
+    void model_compile(kmodel_t* model, keycodes_t const* kcdb)
+    {
+        model->m_kcdb = kcdb;
+        if (kcdb != nullptr)
+            compile_keymaps(kcdb, &model->m_keymaps);
+    }
+
+    static void push_snapshot(kmodel_t* model, ksnapshot_t* snapshot)
+    {
+        // a new edit discards the redo history
+        for (s32 i = model->m_current + 1; i < model->m_nb_snapshots; ++i)
+            release_snapshot(model, model->m_snapshots[i]);
+        model->m_nb_snapshots = model->m_current + 1;
+
+        if (model->m_nb_snapshots == model->m_max_snapshots)
+        {
+            model->m_max_snapshots *= 2;
+            model->m_snapshots = (ksnapshot_t**)::realloc(model->m_snapshots, sizeof(ksnapshot_t*) * model->m_max_snapshots);
+        }
+        model->m_snapshots[model->m_nb_snapshots++] = snapshot;
+        model->m_current                             = model->m_nb_snapshots - 1;
+    }
+
+    bool model_apply(kmodel_t* model, kedit_t const& edit, edit_fn fn, void* user)
+    {
+        ksnapshot_t* current = model->m_snapshots[model->m_current];
+        if (edit.m_keymap < 0 || edit.m_keymap >= current->m_nb_keymaps)
+            return false;
+        kkeymapnode_t* knode = current->m_keymaps[edit.m_keymap];
+        if (edit.m_layer < 0 || edit.m_layer >= knode->m_nb_layers)
+            return false;
+        klayernode_t* lnode      = knode->m_layers[edit.m_layer];
+        bool const    layer_edit = is_layer_edit(edit.m_op);
+
+        // apply the edit to a copy first to see if it changes anything
+        s32 const b = edit.m_key / s_keys_per_block;
+        s32 const i = edit.m_key % s_keys_per_block;
+        key_t     key;
+        if (layer_edit)
+        {
+            layer_t layer = lnode->m_layer;
+            if (!apply_layer_edit(layer, edit))
+                return false;
+            if (same_color(layer.m_capcolor, lnode->m_layer.m_capcolor) && same_color(layer.m_ledcolor, lnode->m_layer.m_ledcolor))
+                return false;
+        }
+        else
+        {
+            if (edit.m_key < 0 || b >= lnode->m_nb_blocks || i >= lnode->m_blocks[b]->m_nb_keys)
+                return false;
+            key_t current;
+            block_key(lnode->m_blocks[b], i, current);
+            key = current;
+            if (!apply_key_edit(key, edit) || same_key(key, current))
+                return false;
+        }
+
+        // copy the path from the root to the edited key, everything else is shared
+        ksnapshot_t*   snapshot = copy_snapshot(model, current);
+        kkeymapnode_t* kcopy    = copy_keymap(model, knode);
+        klayernode_t*  lcopy    = copy_layer(model, lnode);
+        release_keymap(model, snapshot->m_keymaps[edit.m_keymap]);
+        snapshot->m_keymaps[edit.m_keymap] = kcopy;
+        release_layer(model, kcopy->m_layers[edit.m_layer]);
+        kcopy->m_layers[edit.m_layer] = lcopy;
+
+        if (layer_edit)
+        {
+            apply_layer_edit(lcopy->m_layer, edit);
+        }
+        else
+        {
+            kkeyblock_t* bcopy = edit_block(model, lnode->m_blocks[b], i, key);
+            release_block(model, lcopy->m_blocks[b]);
+            lcopy->m_blocks[b] = bcopy;
+        }
+
+        push_snapshot(model, snapshot);
+        apply_edit(&model->m_keymaps, edit);
+        if (!layer_edit)
+        {
+            keymap_t& km = model->m_keymaps.m_keymaps[edit.m_keymap];
+            compile_plain_key(model, &km, km.m_layers[edit.m_layer].m_keys[edit.m_key]);
+        }
+        if (fn != nullptr)
+            fn(edit, user);
+        return true;
+    }
+
+    void model_begin_group(kmodel_t* model) { model->m_group = model->m_current; }
+
+    void model_end_group(kmodel_t* model)
+    {
+        // keep only the last snapshot of the group, undo and redo diff two snapshots so the ones in between are not needed
+        s32 const group = model->m_group;
+        model->m_group  = -1;
+        if (group < 0 || model->m_current <= group + 1)
+            return;
+
+        ksnapshot_t* last = model->m_snapshots[model->m_current];
+        for (s32 i = group + 1; i < model->m_nb_snapshots; ++i)
+        {
+            if (i != model->m_current)
+                release_snapshot(model, model->m_snapshots[i]);
+        }
+        model->m_snapshots[group + 1] = last;
+        model->m_nb_snapshots         = group + 2;
+        model->m_current              = group + 1;
+    }
+
+    bool model_can_undo(kmodel_t* model) { return model->m_current > 0; }
+    bool model_can_redo(kmodel_t* model) { return model->m_current + 1 < model->m_nb_snapshots; }
+
+    bool model_undo(kmodel_t* model, edit_fn fn, void* user)
+    {
+        if (!model_can_undo(model))
+            return false;
+        switch_snapshot(model, model->m_snapshots[model->m_current], model->m_snapshots[model->m_current - 1], fn, user);
+        model->m_current -= 1;
+        return true;
+    }
+
+    bool model_redo(kmodel_t* model, edit_fn fn, void* user)
+    {
+        if (!model_can_redo(model))
+            return false;
+        switch_snapshot(model, model->m_snapshots[model->m_current], model->m_snapshots[model->m_current + 1], fn, user);
+        model->m_current += 1;
+        return true;
+    }
+
+    void model_stats(kmodel_t* model, kmodel_stats_t& stats)
+    {
+        stats.m_nb_snapshots = model->m_nb_snapshots;
+        stats.m_current      = model->m_current;
+        stats.m_nb_nodes     = model->m_nb_nodes;
+        stats.m_nb_bytes     = model->m_nb_bytes;
+        stats.m_nb_keys      = 0;
+        stats.m_nb_stored    = 0;
+
+        ksnapshot_t const* current = model->m_snapshots[model->m_current];
+        for (s32 k = 0; k < current->m_nb_keymaps; ++k)
+        {
+            kkeymapnode_t const* knode = current->m_keymaps[k];
+            for (s32 l = 0; l < knode->m_nb_layers; ++l)
+            {
+                klayernode_t const* lnode = knode->m_layers[l];
+                for (s32 b = 0; b < lnode->m_nb_blocks; ++b)
+                {
+                    stats.m_nb_keys += lnode->m_blocks[b]->m_nb_keys;
+                    stats.m_nb_stored += count_bits(lnode->m_blocks[b]->m_stored);
+                }
+            }
+        }
+    }
+
+} // namespace xcore
@@ -0,0 +1,669 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_compose.h"
+#include "qmk-keymap-wiz/keyboard_jobs.h"
+#include "qmk-keymap-wiz/keyboard_layout.h"
+#include "qmk-keymap-wiz/keyboard_optimize.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+namespace xcore
+{
+    void optimize_defaults(koptimize_params_t& params)
+    {
+        params.m_layers          = 1;
+        params.m_nb_chains       = 0;
+        params.m_nb_workers      = 0;
+        params.m_swaps_per_round = 200000;
+        params.m_nb_rounds       = 0;
+        params.m_effort_weight   = 1.0f;
+        params.m_sfb_weight      = 3.0f;
+        params.m_layer_weight    = 2.0f;
+        params.m_t_min           = 0.0005f;
+        params.m_t_max           = 0.05f;
+        params.m_seed            = 0x9E3779B9u;
+    }
+
+    enum
+    {
+        FINGER_INDEX  = 0,
+        FINGER_MIDDLE = 1,
+        FINGER_RING   = 2,
+        FINGER_PINKY  = 3,
+        FINGER_THUMB  = 4,
+        NB_FINGERS    = 5, // per hand
+    };
+
+    static const float s_finger_weight[NB_FINGERS] = {1.0f, 1.0f, 1.3f, 1.6f, 1.1f};
+
+    // a key that the cost model knows about, either one of the slots whose key moves or the fixed position of a
+    // byte that is typed on a key that does not move
+    struct koptpos_t
+    {
+        s16   m_layer;
+        s16   m_key;
+        s16   m_finger; // hand * NB_FINGERS + finger, -1 when the key has no place on the keyboard
+        float m_x;      // in keys
+        float m_y;
+    };
+
+    struct koptchain_t
+    {
+        s32*   m_pos;  // position of every symbol
+        s32*   m_sym;  // symbol at every movable position
+        s32*   m_best; // m_pos of the best layout of the chain
+        double m_cost;
+        double m_best_cost;
+        float  m_temperature;
+        u32    m_rnd;
+        s64    m_nb_swaps;
+        char   m_pad[64]; // chains are written by different workers
+    };
+
+    struct koptimizer_t
+    {
+        koptimize_params_t m_params;
+
+        // the keymap the optimizer was created for, the keys are copied, the strings are referenced
+        keymap_t m_km;
+        keymap_t m_candidate;
+        u32      m_candidate_version;
+
+        s32        m_nb_movable; // symbols [0, m_nb_movable) move between positions [0, m_nb_movable)
+        s32        m_nb_symbols; // the others stay at their own position
+        koptpos_t* m_positions;
+        float*     m_effort;  // per position
+        float*     m_bigram;  // per position pair
+        float*     m_unigram; // per symbol, fraction of the corpus
+        float*     m_pairs;   // per symbol pair, fraction of the corpus, symmetric
+        s32        m_nb_active;
+        s32*       m_active; // movable symbols that are typed at all
+
+        s32          m_nb_chains;
+        koptchain_t* m_chains;
+
+        std::mutex        m_lock; // m_best, m_best_cost, m_version, the stats
+        s32*              m_best;
+        double            m_initial_cost;
+        double            m_best_cost;
+        u32               m_version;
+        s64               m_nb_swaps;
+        s32               m_nb_rounds;
+        double            m_seconds;
+        std::atomic<bool> m_stop;
+        std::atomic<bool> m_running;
+        std::thread       m_thread;
+    };
+
+    static inline u32 opt_random(u32& state)
+    {
+        // xorshift32
+        u32 x = state;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        state = x;
+        return x;
+    }
+
+    static inline float opt_random01(u32& state) { return (float)(opt_random(state) >> 8) * (1.0f / 16777216.0f); }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // geometry
+
+    struct kopthand_t
+    {
+        float m_x; // home of the index finger
+        float m_y;
+        float m_inward; // +1 when the center of the keyboard is to the right of the hand, -1 otherwise
+    };
+
+    static void finger_of(kopthand_t const* hands, float center, float x, float y, s16& finger, float& hx, float& hy)
+    {
+        s32 const         hand = x < center ? 0 : 1;
+        kopthand_t const& h    = hands[hand];
+
+        s32         f  = FINGER_INDEX;
+        float const dx = (x - h.m_x) * h.m_inward;
+        if (y - h.m_y > 2.5f)
+            f = FINGER_THUMB;
+        else if (dx >= -0.5f)
+            f = FINGER_INDEX;
+        else if (dx >= -1.5f)
+            f = FINGER_MIDDLE;
+        else if (dx >= -2.5f)
+            f = FINGER_RING;
+        else
+            f = FINGER_PINKY;
+
+        finger = (s16)(hand * NB_FINGERS + f);
+        if (f == FINGER_THUMB)
+        {
+            hx = h.m_x + h.m_inward;
+            hy = h.m_y + 3.0f;
+        }
+        else
+        {
+            hx = h.m_x - h.m_inward * (float)f;
+            hy = h.m_y;
+        }
+    }
+
+    // the place (in keys) and finger of every key of the keymap, keys without a place get finger -1
+    static void place_keys(ckeyboard_t const* kb, s32 nb_keys, koptpos_t* keys, float* effort)
+    {
+        for (s32 k = 0; k < nb_keys; ++k)
+        {
+            keys[k].m_finger = -1;
+            keys[k].m_x      = 0.0f;
+            keys[k].m_y      = 0.0f;
+            effort[k]        = 4.0f;
+        }
+
+        s32 const    nb_places = keyboard_nb_keys(kb);
+        ckeyplace_t* places    = (ckeyplace_t*)::malloc(sizeof(ckeyplace_t) * (nb_places + 1));
+        keyboard_layout(kb, 0.0f, 0.0f, 1.0f, places, nb_places);
+
+        float const unit = kb->m_w * kb->m_scale > 0.0f ? kb->m_w * kb->m_scale : 1.0f;
+        float       minx = 0.0f, maxx = 0.0f;
+        for (s32 p = 0; p < nb_places; ++p)
+        {
+            places[p].m_x /= unit;
+            places[p].m_y /= unit;
+            minx = (p == 0 || places[p].m_x < minx) ? places[p].m_x : minx;
+            maxx = (p == 0 || places[p].m_x > maxx) ? places[p].m_x : maxx;
+        }
+        float const center = (minx + maxx) * 0.5f;
+
+        // the home key of the index finger is the home key (nob) of a hand that is closest to the center, without
+        // one it is the average of the keys of the hand
+        kopthand_t hands[2];
+        for (s32 h = 0; h < 2; ++h)
+        {
+            hands[h].m_inward = h == 0 ? 1.0f : -1.0f;
+            s32   nob         = -1;
+            float sx = 0.0f, sy = 0.0f;
+            s32   n  = 0;
+            for (s32 p = 0; p < nb_places; ++p)
+            {
+                if ((places[p].m_x < center) != (h == 0))
+                    continue;
+                sx += places[p].m_x;
+                sy += places[p].m_y;
+                n += 1;
+                if (places[p].m_key->m_nob && (nob < 0 || fabsf(places[p].m_x - center) < fabsf(places[nob].m_x - center)))
+                    nob = p;
+            }
+            hands[h].m_x = nob >= 0 ? places[nob].m_x : (n > 0 ? sx / n : center);
+            hands[h].m_y = nob >= 0 ? places[nob].m_y : (n > 0 ? sy / n : 0.0f);
+        }
+
+        for (s32 p = 0; p < nb_places; ++p)
+        {
+            s32 const k = places[p].m_key->m_index;
+            if (k < 0 || k >= nb_keys)
+                continue;
+            float hx, hy;
+            finger_of(hands, center, places[p].m_x, places[p].m_y, keys[k].m_finger, hx, hy);
+            keys[k].m_x = places[p].m_x;
+            keys[k].m_y = places[p].m_y;
+
+            float const dx = places[p].m_x - hx;
+            float const dy = places[p].m_y - hy;
+            effort[k]      = s_finger_weight[keys[k].m_finger % NB_FINGERS] * (1.0f + sqrtf(dx * dx + dy * dy));
+        }
+        ::free(places);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // cost
+
+    static inline bool is_movable(key_t const& key) { return key.m_layer_switch == 0 && key.m_mod == 0 && !key.m_mod_tap && !is_transparent_key(key); }
+
+    static double layout_cost(koptimizer_t* o, s32 const* pos)
+    {
+        s32 const S     = o->m_nb_symbols;
+        s32 const P     = o->m_nb_symbols;
+        double    total = 0.0;
+        for (s32 s = 0; s < S; ++s)
+        {
+            total += (double)o->m_unigram[s] * o->m_effort[pos[s]];
+            float const* pairs  = &o->m_pairs[(s64)s * S];
+            float const* bigram = &o->m_bigram[(s64)pos[s] * P];
+            for (s32 t = s + 1; t < S; ++t)
+                total += (double)pairs[t] * bigram[pos[t]];
+        }
+        return total;
+    }
+
+    // the change in cost when symbols i and j exchange their positions
+    static inline float swap_delta(koptimizer_t* o, s32 const* pos, s32 i, s32 j)
+    {
+        s32 const    S  = o->m_nb_symbols;
+        s32 const    a  = pos[i];
+        s32 const    b  = pos[j];
+        float const* wi = &o->m_pairs[(s64)i * S];
+        float const* wj = &o->m_pairs[(s64)j * S];
+        float const* ba = &o->m_bigram[(s64)a * S];
+        float const* bb = &o->m_bigram[(s64)b * S];
+
+        float delta = (o->m_unigram[i] - o->m_unigram[j]) * (o->m_effort[b] - o->m_effort[a]);
+        for (s32 k = 0; k < S; ++k)
+        {
+            s32 const pk = pos[k];
+            delta += (wi[k] - wj[k]) * (bb[pk] - ba[pk]);
+        }
+
+        // the loop included k = i and k = j, the pair (i, j) itself keeps its distance
+        delta -= (wi[i] - wj[i]) * (bb[a] - ba[a]);
+        delta -= (wi[j] - wj[j]) * (bb[b] - ba[b]);
+        return delta;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+
+    static void copy_keymap(keymap_t const* from, keymap_t& to)
+    {
+        to.m_name      = from->m_name;
+        to.m_nb_layers = from->m_nb_layers;
+        to.m_layers    = (layer_t*)::malloc(sizeof(layer_t) * (from->m_nb_layers + 1));
+        for (s32 l = 0; l < from->m_nb_layers; ++l)
+        {
+            to.m_layers[l]        = from->m_layers[l];
+            to.m_layers[l].m_keys = (key_t*)::malloc(sizeof(key_t) * (from->m_layers[l].m_nb_keys + 1));
+            memcpy(to.m_layers[l].m_keys, from->m_layers[l].m_keys, sizeof(key_t) * from->m_layers[l].m_nb_keys);
+        }
+    }
+
+    static void free_keymap(keymap_t& km)
+    {
+        for (s32 l = 0; l < km.m_nb_layers; ++l)
+            ::free(km.m_layers[l].m_keys);
+        ::free(km.m_layers);
+        km.m_layers    = nullptr;
+        km.m_nb_layers = 0;
+    }
+
+    koptimizer_t* optimizer_create(ckeyboard_t const* kb, keymap_t const* km, kreverse_t* r, kcorpus_t const& corpus, koptimize_params_t const& params)
+    {
+        koptimizer_t* o = new koptimizer_t();
+        o->m_params     = params;
+        copy_keymap(km, o->m_km);
+        copy_keymap(km, o->m_candidate);
+        o->m_candidate_version = 0;
+
+        // the keys of the keymap, a position is a (layer, key)
+        s32 nb_keys = 0;
+        for (s32 l = 0; l < km->m_nb_layers; ++l)
+            nb_keys = km->m_layers[l].m_nb_keys > nb_keys ? km->m_layers[l].m_nb_keys : nb_keys;
+        koptpos_t* keys   = (koptpos_t*)::malloc(sizeof(koptpos_t) * (nb_keys + 1));
+        float*     effort = (float*)::malloc(sizeof(float) * (nb_keys + 1));
+        place_keys(kb, nb_keys, keys, effort);
+
+        // the movable slots come first, every slot holds its own key (symbol) at the start
+        s32 const max_positions = km->m_nb_layers * nb_keys + 256;
+        o->m_positions          = (koptpos_t*)::malloc(sizeof(koptpos_t) * max_positions);
+        s32* slot_of            = (s32*)::malloc(sizeof(s32) * (km->m_nb_layers * nb_keys + 1)); // (layer, key) -> slot
+        o->m_nb_movable         = 0;
+        for (s32 l = 0; l < km->m_nb_layers; ++l)
+        {
+            layer_t const& layer = km->m_layers[l];
+            for (s32 k = 0; k < nb_keys; ++k)
+            {
+                slot_of[l * nb_keys + k] = -1;
+                if (l >= 64 || (params.m_layers & ((u64)1 << l)) == 0 || k >= layer.m_nb_keys || keys[k].m_finger < 0 || !is_movable(layer.m_keys[k]))
+                    continue;
+                koptpos_t& p = o->m_positions[o->m_nb_movable];
+                p            = keys[k];
+                p.m_layer    = (s16)l;
+                p.m_key      = (s16)k;
+                slot_of[l * nb_keys + k] = o->m_nb_movable++;
+            }
+        }
+
+        // every byte is a symbol, the symbol of a movable key or a fixed symbol at the key that types it
+        s32 symbol_of[256];
+        o->m_nb_symbols = o->m_nb_movable;
+        for (u32 b = 0; b < 256; ++b)
+        {
+            symbol_of[b] = -1;
+            kreversehit_t hit;
+            if (corpus_byte_key(r, b, hit) < 0 || hit.m_layer >= km->m_nb_layers || hit.m_key >= nb_keys)
+                continue;
+            s32 const slot = slot_of[hit.m_layer * nb_keys + hit.m_key];
+            if (slot >= 0)
+            {
+                symbol_of[b] = slot;
+                continue;
+            }
+            for (s32 s = o->m_nb_movable; s < o->m_nb_symbols && symbol_of[b] < 0; ++s)
+            {
+                if (o->m_positions[s].m_layer == hit.m_layer && o->m_positions[s].m_key == hit.m_key)
+                    symbol_of[b] = s;
+            }
+            if (symbol_of[b] < 0)
+            {
+                koptpos_t& p = o->m_positions[o->m_nb_symbols];
+                p            = keys[hit.m_key];
+                p.m_layer    = hit.m_layer;
+                p.m_key      = hit.m_key;
+                symbol_of[b] = o->m_nb_symbols++;
+            }
+        }
+        ::free(slot_of);
+
+        // the depth of a layer is paid on every byte typed on it
+        s32 const S = o->m_nb_symbols;
+        o->m_effort = (float*)::malloc(sizeof(float) * (S + 1));
+        o->m_bigram = (float*)::malloc(sizeof(float) * ((s64)S * S + 1));
+        for (s32 p = 0; p < S; ++p)
+        {
+            koptpos_t const& pp = o->m_positions[p];
+            kreversestep_t   steps[1];
+            s32 const        depth = reverse_path(r, pp.m_layer, steps, 0);
+            o->m_effort[p]         = params.m_effort_weight * (pp.m_finger >= 0 ? effort[pp.m_key] : 4.0f) + 0.5f * params.m_layer_weight * (float)(depth < 0 ? 2 : depth);
+            for (s32 q = 0; q < S; ++q)
+            {
+                koptpos_t const& pq   = o->m_positions[q];
+                float            cost = 0.0f;
+                if (pp.m_finger >= 0 && pp.m_finger == pq.m_finger && pp.m_key != pq.m_key)
+                {
+                    float const dx = pp.m_x - pq.m_x;
+                    float const dy = pp.m_y - pq.m_y;
+                    cost += params.m_sfb_weight * (1.0f + sqrtf(dx * dx + dy * dy));
+                }
+                if (pp.m_layer != pq.m_layer)
+                    cost += params.m_layer_weight;
+                o->m_bigram[(s64)p * S + q] = cost;
+            }
+        }
+        ::free(keys);
+        ::free(effort);
+
+        // the corpus as symbols, per byte typed
+        o->m_unigram = (float*)::calloc(S + 1, sizeof(float));
+        o->m_pairs   = (float*)::calloc((s64)S * S + 1, sizeof(float));
+        double total = 0.0;
+        if (corpus.m_pairs != nullptr)
+        {
+            for (u32 pair = 0; pair < 256 * 256; ++pair)
+            {
+                s32 const t = symbol_of[pair & 0xFF];
+                if (t >= 0)
+                    total += (double)corpus.m_pairs[pair];
+            }
+            double const scale = total > 0.0 ? 1.0 / total : 0.0;
+            for (u32 pair = 0; pair < 256 * 256; ++pair)
+            {
+                s32 const s = symbol_of[pair >> 8];
+                s32 const t = symbol_of[pair & 0xFF];
+                if (t < 0 || corpus.m_pairs[pair] == 0)
+                    continue;
+                float const f = (float)((double)corpus.m_pairs[pair] * scale);
+                o->m_unigram[t] += f;
+                if (s < 0 || s == t)
+                    continue;
+                o->m_pairs[(s64)s * S + t] += f;
+                o->m_pairs[(s64)t * S + s] += f;
+            }
+        }
+
+        // swaps pick at least one key that is typed, moving two untyped keys changes nothing
+        o->m_active    = (s32*)::malloc(sizeof(s32) * (o->m_nb_movable + 1));
+        o->m_nb_active = 0;
+        for (s32 s = 0; s < o->m_nb_movable; ++s)
+        {
+            if (o->m_unigram[s] > 0.0f)
+                o->m_active[o->m_nb_active++] = s;
+        }
+
+        s32 const nb_workers = params.m_nb_workers > 0 ? params.m_nb_workers : jobs_nb_workers();
+        o->m_nb_chains       = params.m_nb_chains > 0 ? params.m_nb_chains : 2 * nb_workers;
+        if (o->m_nb_chains < 2)
+            o->m_nb_chains = 2;
+        o->m_chains = (koptchain_t*)::malloc(sizeof(koptchain_t) * o->m_nb_chains);
+        for (s32 c = 0; c < o->m_nb_chains; ++c)
+        {
+            koptchain_t& chain = o->m_chains[c];
+            chain.m_pos        = (s32*)::malloc(sizeof(s32) * (S + 1));
+            chain.m_sym        = (s32*)::malloc(sizeof(s32) * (S + 1));
+            chain.m_best       = (s32*)::malloc(sizeof(s32) * (S + 1));
+            for (s32 s = 0; s < S; ++s)
+            {
+                chain.m_pos[s]  = s;
+                chain.m_sym[s]  = s;
+                chain.m_best[s] = s;
+            }
+            // temperatures from cold to hot on a geometric scale
+            float const t        = o->m_nb_chains > 1 ? (float)c / (float)(o->m_nb_chains - 1) : 0.0f;
+            chain.m_temperature  = params.m_t_min * powf(params.m_t_max / params.m_t_min, t);
+            chain.m_rnd          = params.m_seed + 0x632BE5ABu * (u32)(c + 1);
+            chain.m_cost         = layout_cost(o, chain.m_pos);
+            chain.m_best_cost    = chain.m_cost;
+            chain.m_nb_swaps     = 0;
+        }
+
+        o->m_best = (s32*)::malloc(sizeof(s32) * (S + 1));
+        memcpy(o->m_best, o->m_chains[0].m_pos, sizeof(s32) * S);
+        o->m_initial_cost = o->m_chains[0].m_cost;
+        o->m_best_cost    = o->m_initial_cost;
+        o->m_version      = 0;
+        o->m_nb_swaps     = 0;
+        o->m_nb_rounds    = 0;
+        o->m_seconds      = 0.0;
+        o->m_stop         = false;
+        o->m_running      = false;
+        return o;
+    }
+
+    void optimizer_destroy(koptimizer_t* o)
+    {
+        if (o == nullptr)
+            return;
+        optimizer_stop(o);
+        for (s32 c = 0; c < o->m_nb_chains; ++c)
+        {
+            ::free(o->m_chains[c].m_pos);
+            ::free(o->m_chains[c].m_sym);
+            ::free(o->m_chains[c].m_best);
+        }
+        ::free(o->m_chains);
+        ::free(o->m_best);
+        ::free(o->m_positions);
+        ::free(o->m_effort);
+        ::free(o->m_bigram);
+        ::free(o->m_unigram);
+        ::free(o->m_pairs);
+        ::free(o->m_active);
+        free_keymap(o->m_km);
+        free_keymap(o->m_candidate);
+        delete o;
+    }
+
+    static void chain_round(s32 index, s32, void* user)
+    {
+        koptimizer_t* o     = (koptimizer_t*)user;
+        koptchain_t&  chain = o->m_chains[index];
+        s32 const     M     = o->m_nb_movable;
+        s32 const     S     = o->m_nb_symbols;
+        if (o->m_nb_active == 0 || M < 2)
+            return;
+
+        float const inv_t = 1.0f / chain.m_temperature;
+        u32         rnd   = chain.m_rnd;
+        double      cost  = chain.m_cost;
+        for (s32 n = 0; n < o->m_params.m_swaps_per_round; ++n)
+        {
+            s32 const i = o->m_active[opt_random(rnd) % (u32)o->m_nb_active];
+            s32 const j = (s32)(opt_random(rnd) % (u32)M);
+            if (i == j)
+                continue;
+
+            float const delta = swap_delta(o, chain.m_pos, i, j);
+            if (delta > 0.0f && opt_random01(rnd) >= expf(-delta * inv_t))
+                continue;
+
+            s32 const a     = chain.m_pos[i];
+            s32 const b     = chain.m_pos[j];
+            chain.m_pos[i]  = b;
+            chain.m_pos[j]  = a;
+            chain.m_sym[a]  = j;
+            chain.m_sym[b]  = i;
+            cost           += delta;
+            if (cost < chain.m_best_cost - 1e-9)
+            {
+                chain.m_best_cost = cost;
+                memcpy(chain.m_best, chain.m_pos, sizeof(s32) * S);
+            }
+        }
+        chain.m_nb_swaps += o->m_params.m_swaps_per_round;
+        chain.m_rnd = rnd;
+
+        // the deltas are floats, the exact cost keeps them from drifting
+        chain.m_cost = layout_cost(o, chain.m_pos);
+    }
+
+    // neighbouring chains exchange their layouts with the probability of parallel tempering
+    static void exchange_chains(koptimizer_t* o, u32& rnd)
+    {
+        for (s32 c = 0; c + 1 < o->m_nb_chains; ++c)
+        {
+            koptchain_t& cold = o->m_chains[c];
+            koptchain_t& hot  = o->m_chains[c + 1];
+            double const x    = (1.0 / cold.m_temperature - 1.0 / hot.m_temperature) * (cold.m_cost - hot.m_cost);
+            if (x < 0.0 && opt_random01(rnd) >= exp(x))
+                continue;
+
+            s32* pos    = cold.m_pos;
+            s32* sym    = cold.m_sym;
+            double cost = cold.m_cost;
+            cold.m_pos  = hot.m_pos;
+            cold.m_sym  = hot.m_sym;
+            cold.m_cost = hot.m_cost;
+            hot.m_pos   = pos;
+            hot.m_sym   = sym;
+            hot.m_cost  = cost;
+        }
+    }
+
+    void optimizer_run(koptimizer_t* o)
+    {
+        o->m_running = true;
+        u32 rnd      = o->m_params.m_seed ^ 0xA5A5A5A5u;
+        while (!o->m_stop && (o->m_params.m_nb_rounds <= 0 || o->m_nb_rounds < o->m_params.m_nb_rounds))
+        {
+            std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+            jobs_parallel_for(o->m_nb_chains, chain_round, o, o->m_params.m_nb_workers);
+            exchange_chains(o, rnd);
+
+            s32 best = 0;
+            for (s32 c = 1; c < o->m_nb_chains; ++c)
+            {
+                if (o->m_chains[c].m_best_cost < o->m_chains[best].m_best_cost)
+                    best = c;
+            }
+
+            std::lock_guard<std::mutex> lock(o->m_lock);
+            if (o->m_chains[best].m_best_cost < o->m_best_cost - 1e-9)
+            {
+                memcpy(o->m_best, o->m_chains[best].m_best, sizeof(s32) * o->m_nb_symbols);
+                o->m_best_cost = o->m_chains[best].m_best_cost;
+                o->m_version += 1;
+            }
+            o->m_nb_swaps += (s64)o->m_params.m_swaps_per_round * o->m_nb_chains;
+            o->m_nb_rounds += 1;
+            o->m_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        o->m_running = false;
+    }
+
+    void optimizer_start(koptimizer_t* o)
+    {
+        if (o->m_thread.joinable())
+            return;
+        o->m_stop    = false;
+        o->m_running = true;
+        o->m_thread  = std::thread(optimizer_run, o);
+    }
+
+    void optimizer_stop(koptimizer_t* o)
+    {
+        o->m_stop = true;
+        if (o->m_thread.joinable())
+            o->m_thread.join();
+    }
+
+    void optimizer_stats(koptimizer_t* o, koptimize_stats_t& stats)
+    {
+        std::lock_guard<std::mutex> lock(o->m_lock);
+        stats.m_nb_symbols   = o->m_nb_movable;
+        stats.m_nb_swaps     = o->m_nb_swaps;
+        stats.m_nb_rounds    = o->m_nb_rounds;
+        stats.m_seconds      = o->m_seconds;
+        stats.m_initial_cost = o->m_initial_cost;
+        stats.m_best_cost    = o->m_best_cost;
+        stats.m_version      = o->m_version;
+        stats.m_running      = o->m_running;
+    }
+
+    // the key that ends up in every movable slot, the colors of the slot stay
+    static void place_symbols(koptimizer_t* o, s32 const* best, keymap_t& km)
+    {
+        for (s32 s = 0; s < o->m_nb_movable; ++s)
+        {
+            koptpos_t const& from = o->m_positions[s];
+            koptpos_t const& to   = o->m_positions[best[s]];
+            key_t const&     src  = o->m_km.m_layers[from.m_layer].m_keys[from.m_key];
+            key_t&           dst  = km.m_layers[to.m_layer].m_keys[to.m_key];
+            dst.m_keycode_str     = src.m_keycode_str;
+            dst.m_code            = src.m_code;
+            dst.m_tap             = src.m_tap;
+            dst.m_kc              = src.m_kc;
+        }
+    }
+
+    keymap_t const* optimizer_candidate(koptimizer_t* o)
+    {
+        std::lock_guard<std::mutex> lock(o->m_lock);
+        if (o->m_candidate_version != o->m_version)
+        {
+            place_symbols(o, o->m_best, o->m_candidate);
+            o->m_candidate_version = o->m_version;
+        }
+        return &o->m_candidate;
+    }
+
+    s32 optimizer_edits(koptimizer_t* o, s32 keymap, void (*fn)(kedit_t const& edit, void* user), void* user)
+    {
+        keymap_t const* candidate = optimizer_candidate(o);
+
+        s32 nb_edits = 0;
+        for (s32 s = 0; s < o->m_nb_movable; ++s)
+        {
+            koptpos_t const& p    = o->m_positions[s];
+            key_t const&     from = o->m_km.m_layers[p.m_layer].m_keys[p.m_key];
+            key_t const&     to   = candidate->m_layers[p.m_layer].m_keys[p.m_key];
+            if (from.m_keycode_str == to.m_keycode_str || (from.m_keycode_str != nullptr && to.m_keycode_str != nullptr && strcmp(from.m_keycode_str, to.m_keycode_str) == 0))
+                continue;
+
+            kedit_t edit;
+            edit.m_op     = EDIT_KEYCODE;
+            edit.m_keymap = keymap;
+            edit.m_layer  = p.m_layer;
+            edit.m_key    = p.m_key;
+            edit.m_str    = to.m_keycode_str;
+            if (fn != nullptr)
+                fn(edit, user);
+            nb_edits += 1;
+        }
+        return nb_edits;
+    }
+
+} // namespace xcore
@@ -0,0 +1,265 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_profile.h"
+#include "qmk-keymap-wiz/keyboard_writer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+
+namespace xcore
+{
+    static const char* s_zone_names[PROFILE_NB_ZONES] = {
+        "frame", "load_keycodes", "load_keyboards", "load_keymaps", "reload", "editor_update", "ui", "keyboard_render", "hit_test", "key_render", "text_layout", "rotation", "rgb", "imgui_render",
+    };
+
+    struct kprofileevent_t
+    {
+        u64 m_begin;
+        u64 m_end;
+        s32 m_zone;
+    };
+
+    struct kprofilering_t
+    {
+        std::atomic<bool> m_claimed;
+        std::atomic<u64>  m_head; // number of events ever written, the last one is at (m_head - 1) % PROFILE_RING_SIZE
+        u64               m_read; // the first event that profile_frame has not seen yet
+        kprofileevent_t   m_events[PROFILE_RING_SIZE];
+    };
+
+    static std::atomic<kprofilering_t*> s_rings[PROFILE_MAX_THREADS];
+    static std::atomic<bool>            s_enabled(true);
+
+    static u64   s_epoch = profile_now(); // the trace starts when the application starts
+    static float s_history[PROFILE_NB_ZONES][PROFILE_HISTORY];
+    static u32   s_nb_frames = 0;
+
+    // allocations since the last profile_frame, the last slot is outside of any zone
+    static std::atomic<s64> s_alloc_count[PROFILE_NB_ZONES + 1];
+    static std::atomic<s64> s_alloc_bytes[PROFILE_NB_ZONES + 1];
+    static float            s_alloc_history[PROFILE_NB_ZONES + 1][PROFILE_HISTORY];
+    static s64              s_frame_alloc_count = 0;
+    static s64              s_frame_alloc_bytes = 0;
+
+    static thread_local s32 s_zone = PROFILE_NB_ZONES;
+
+    // the ring of a thread, given back when the thread exits
+    struct kprofileowner_t
+    {
+        kprofileowner_t() { m_ring = nullptr; }
+        ~kprofileowner_t()
+        {
+            if (m_ring != nullptr)
+                m_ring->m_claimed.store(false, std::memory_order_release);
+        }
+
+        kprofilering_t* m_ring;
+    };
+
+    static thread_local kprofileowner_t s_owner;
+
+    static kprofilering_t* claim_ring()
+    {
+        for (s32 i = 0; i < PROFILE_MAX_THREADS; ++i)
+        {
+            kprofilering_t* ring = s_rings[i].load(std::memory_order_acquire);
+            if (ring == nullptr)
+            {
+                kprofilering_t* fresh = (kprofilering_t*)::malloc(sizeof(kprofilering_t));
+                new (&fresh->m_claimed) std::atomic<bool>(true);
+                new (&fresh->m_head) std::atomic<u64>(0);
+                fresh->m_read = 0;
+                if (s_rings[i].compare_exchange_strong(ring, fresh, std::memory_order_acq_rel))
+                    return fresh;
+                ::free(fresh); // another thread took the slot first, 'ring' is that one now
+            }
+            bool expected = false;
+            if (ring->m_claimed.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                return ring;
+        }
+        return nullptr;
+    }
+
+    const char* profile_zone_name(s32 zone)
+    {
+        if (zone == PROFILE_NB_ZONES)
+            return "other";
+        return zone >= 0 && zone < PROFILE_NB_ZONES ? s_zone_names[zone] : "?";
+    }
+
+    u64 profile_now() { return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+    void profile_record(s32 zone, u64 begin, u64 end)
+    {
+        kprofilering_t* ring = s_owner.m_ring;
+        if (ring == nullptr)
+        {
+            // more threads than rings, their zones are not recorded
+            ring = claim_ring();
+            if (ring == nullptr)
+                return;
+            s_owner.m_ring = ring;
+        }
+
+        u64 const        head = ring->m_head.load(std::memory_order_relaxed);
+        kprofileevent_t& e    = ring->m_events[head & (PROFILE_RING_SIZE - 1)];
+        e.m_begin             = begin;
+        e.m_end               = end;
+        e.m_zone              = zone;
+        ring->m_head.store(head + 1, std::memory_order_release);
+    }
+
+    s32 profile_enter(s32 zone)
+    {
+        s32 const outer = s_zone;
+        s_zone          = zone;
+        return outer;
+    }
+
+    void profile_leave(s32 outer) { s_zone = outer; }
+
+    void profile_alloc(u64 size)
+    {
+        s32 const zone = s_zone;
+        s_alloc_count[zone].fetch_add(1, std::memory_order_relaxed);
+        s_alloc_bytes[zone].fetch_add((s64)size, std::memory_order_relaxed);
+    }
+
+    void profile_enable(bool enable) { s_enabled.store(enable, std::memory_order_relaxed); }
+    bool profile_enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    // copies the events [from, head) that are still in the ring, returns the number copied and the index of the
+    // first one, the writer may overwrite the oldest ones while they are copied, those are dropped
+    static s32 copy_events(kprofilering_t* ring, u64 from, kprofileevent_t* events, u64& first, u64& head)
+    {
+        head = ring->m_head.load(std::memory_order_acquire);
+        if (head > PROFILE_RING_SIZE && from < head - PROFILE_RING_SIZE)
+            from = head - PROFILE_RING_SIZE;
+        for (u64 i = from; i < head; ++i)
+            events[i - from] = ring->m_events[i & (PROFILE_RING_SIZE - 1)];
+
+        // event i is overwritten once the writer starts on event i + PROFILE_RING_SIZE
+        u64 const after = ring->m_head.load(std::memory_order_acquire);
+        first           = from;
+        if (after >= PROFILE_RING_SIZE && first < after - PROFILE_RING_SIZE + 1)
+            first = after - PROFILE_RING_SIZE + 1;
+        if (first > head)
+            first = head;
+        if (first > from)
+            memmove(events, events + (first - from), sizeof(kprofileevent_t) * (size_t)(head - first));
+        return (s32)(head - first);
+    }
+
+    void profile_frame()
+    {
+        static kprofileevent_t s_events[PROFILE_RING_SIZE];
+
+        double sums[PROFILE_NB_ZONES];
+        for (s32 z = 0; z < PROFILE_NB_ZONES; ++z)
+            sums[z] = 0.0;
+
+        for (s32 i = 0; i < PROFILE_MAX_THREADS; ++i)
+        {
+            kprofilering_t* ring = s_rings[i].load(std::memory_order_acquire);
+            if (ring == nullptr)
+                continue;
+            u64       first, head;
+            s32 const n = copy_events(ring, ring->m_read, s_events, first, head);
+            for (s32 e = 0; e < n; ++e)
+                sums[s_events[e].m_zone] += (double)(s_events[e].m_end - s_events[e].m_begin);
+            ring->m_read = head;
+        }
+
+        s32 const frame = (s32)(s_nb_frames % PROFILE_HISTORY);
+        for (s32 z = 0; z < PROFILE_NB_ZONES; ++z)
+            s_history[z][frame] = (float)(sums[z] / 1000000.0);
+
+        s_frame_alloc_count = 0;
+        s_frame_alloc_bytes = 0;
+        for (s32 z = 0; z <= PROFILE_NB_ZONES; ++z)
+        {
+            s64 const count           = s_alloc_count[z].exchange(0, std::memory_order_relaxed);
+            s_alloc_history[z][frame] = (float)count;
+            s_frame_alloc_count += count;
+            s_frame_alloc_bytes += s_alloc_bytes[z].exchange(0, std::memory_order_relaxed);
+        }
+        s_nb_frames += 1;
+    }
+
+    float const* profile_history(s32 zone, s32& offset)
+    {
+        offset = (s32)(s_nb_frames % PROFILE_HISTORY);
+        return s_history[zone];
+    }
+
+    float profile_average(s32 zone)
+    {
+        u32 const n = s_nb_frames < (u32)PROFILE_HISTORY ? s_nb_frames : (u32)PROFILE_HISTORY;
+        if (n == 0)
+            return 0.0f;
+        float sum = 0.0f;
+        for (u32 i = 0; i < n; ++i)
+            sum += s_history[zone][i];
+        return sum / (float)n;
+    }
+
+    float const* profile_alloc_history(s32 zone, s32& offset)
+    {
+        offset = (s32)(s_nb_frames % PROFILE_HISTORY);
+        return s_alloc_history[zone];
+    }
+
+    void profile_frame_allocs(s64& count, s64& bytes)
+    {
+        count = s_frame_alloc_count;
+        bytes = s_frame_alloc_bytes;
+    }
+
+    s32 profile_export(const char* filename)
+    {
+        kwriter_t w;
+        if (!writer_open(w, filename))
+        {
+            printf("failed to open %s\n", filename);
+            return -1;
+        }
+
+        kprofileevent_t* events = (kprofileevent_t*)::malloc(sizeof(kprofileevent_t) * PROFILE_RING_SIZE);
+
+        // complete events ("X") in microseconds, the thread is the ring
+        s32  nb_events = 0;
+        char line[256];
+        writer_str(w, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+        for (s32 i = 0; i < PROFILE_MAX_THREADS; ++i)
+        {
+            kprofilering_t* ring = s_rings[i].load(std::memory_order_acquire);
+            if (ring == nullptr)
+                continue;
+            u64       first, head;
+            s32 const n = copy_events(ring, 0, events, first, head);
+            for (s32 e = 0; e < n; ++e)
+            {
+                kprofileevent_t const& ev = events[e];
+                s64 const              ts = (s64)(ev.m_begin - s_epoch);
+                snprintf(line, sizeof(line), "%s\n{\"name\":\"%s\",\"cat\":\"wiz\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", nb_events == 0 ? "" : ",", s_zone_names[ev.m_zone], i,
+                         (double)ts / 1000.0, (double)(ev.m_end - ev.m_begin) / 1000.0);
+                writer_str(w, line);
+                nb_events += 1;
+            }
+        }
+        writer_str(w, "\n]}\n");
+        ::free(events);
+
+        if (!writer_close(w))
+        {
+            printf("failed to write %s\n", filename);
+            return -1;
+        }
+        return nb_events;
+    }
+
+} // namespace xcore
@@ -1,7 +1,12 @@
 #include "xbase/x_base.h"
 #include "xbase/x_context.h"
 #include "xbase/x_memory.h"
+#include "qmk-keymap-wiz/keyboard_compose.h"
 #include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_layout.h"
+#include "qmk-keymap-wiz/keyboard_profile.h"
+#include "qmk-keymap-wiz/keyboard_rgb.h"
+#include "qmk-keymap-wiz/keyboard_render.h"
 
 #include "libimgui/imgui.h"
 #include "libimgui/imgui_internal.h"
@@ -9,6 +14,7 @@
 #include "libimgui/imgui_impl_opengl3.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h> // sqrtf, powf, cosf, sinf, floorf, ceilf
 
 
@@ -56,6 +62,16 @@ static ImVec4 Lighten(ImVec4 const& c, float p)
     return r;
 }
 
+static ImVec4 Mix(ImVec4 const& a, ImVec4 const& b, float t)
+{
+    ImVec4 r;
+    r.x = a.x + (b.x - a.x) * t;
+    r.y = a.y + (b.y - a.y) * t;
+    r.z = a.z + (b.z - a.z) * t;
+    r.w = a.w;
+    return r;
+}
+
 ImVec2 operator-(const ImVec2& l, const ImVec2& r) { return {l.x - r.x, l.y - r.y}; }
 struct ImRotation
 {
@@ -92,19 +108,6 @@ struct ImRotation
     int         m_start;
 };
 
-static bool IsPointInsideKey(xcore::ckeyboard_t const* kb, xcore::ckeygroup_t const& kg, xcore::ckey_t const& key, float globalscale, float x, float y, float px, float py)
-{
-    const float sw = key.m_sw * kg.m_sw * kb->m_sw * kb->m_scale * globalscale;
-    const float sh = key.m_sh * kg.m_sh * kb->m_sh * kb->m_scale * globalscale;
-    const float kw = (key.m_w * kg.m_w * kb->m_w * kb->m_scale * globalscale) - (2 * sw);
-    const float kh = (key.m_h * kg.m_h * kb->m_h * kb->m_scale * globalscale) - (2 * sh);
-    const float hw = kw / 2;
-    const float hh = kh / 2;
-    if (px >= (x - hw) && px <= (x + hw) && py >= (y - hh) && py <= (y + hh))
-        return true;
-    return false;
-}
-
 ImFont* KbFonts[] = {
     nullptr,
     nullptr,
@@ -140,7 +143,7 @@ static ImVec2 SelectFontSize(const char* txt, float kw)
     return td;
 }
 
-void keyboard_loadfonts()
+void keyboard_addfonts(ImFontAtlas* atlas, ImFont** fonts)
 {
     static const ImWchar icon_ranges[] = {
         0xf000,
@@ -161,68 +164,63 @@ void keyboard_loadfonts()
     ImFontConfig config;
     config.MergeMode = true;
 
-    ImGuiIO& io = ImGui::GetIO();
-
-    KbFonts[0] = io.Fonts->AddFontFromFileTTF("fonts/Roboto-Medium.ttf", 28.0f, nullptr, &base_ranges[0]);
-    io.Fonts->AddFontFromFileTTF("fonts/freeserif.ttf", 34.0f, &config, &symbol_ranges[0]);
-    io.Fonts->AddFontFromFileTTF("fonts/fontawesome-webfont.ttf", 28.0f, &config, &icon_ranges[0]);
-    io.Fonts->Build();
-
-    KbFonts[1] = io.Fonts->AddFontFromFileTTF("fonts/Roboto-Medium.ttf", 24.0f, nullptr, &base_ranges[0]);
-    io.Fonts->AddFontFromFileTTF("fonts/freeserif.ttf", 24.0f, &config, &symbol_ranges[0]);
-    io.Fonts->AddFontFromFileTTF("fonts/fontawesome-webfont.ttf", 24.0f, &config, &icon_ranges[0]);
-    io.Fonts->Build();
-
-    KbFonts[2] = io.Fonts->AddFontFromFileTTF("fonts/Roboto-Medium.ttf", 20.0f, nullptr, &base_ranges[0]);
-    io.Fonts->AddFontFromFileTTF("fonts/freeserif.ttf", 20.0f, &config, &symbol_ranges[0]);
-    io.Fonts->AddFontFromFileTTF("fonts/fontawesome-webfont.ttf", 20.0f, &config, &icon_ranges[0]);
-    io.Fonts->Build();
-
-    KbFonts[3] = io.Fonts->AddFontFromFileTTF("fonts/Roboto-Medium.ttf", 16.0f, nullptr, &base_ranges[0]);
-    io.Fonts->AddFontFromFileTTF("fonts/freeserif.ttf", 16.0f, &config, &symbol_ranges[0]);
-    io.Fonts->AddFontFromFileTTF("fonts/fontawesome-webfont.ttf", 16.0f, &config, &icon_ranges[0]);
-    io.Fonts->Build();
+    fonts[0] = atlas->AddFontFromFileTTF("fonts/Roboto-Medium.ttf", 28.0f, nullptr, &base_ranges[0]);
+    atlas->AddFontFromFileTTF("fonts/FreeSerif.ttf", 34.0f, &config, &symbol_ranges[0]);
+    atlas->AddFontFromFileTTF("fonts/fontawesome-webfont.ttf", 28.0f, &config, &icon_ranges[0]);
+    atlas->Build();
+
+    fonts[1] = atlas->AddFontFromFileTTF("fonts/Roboto-Medium.ttf", 24.0f, nullptr, &base_ranges[0]);
+    atlas->AddFontFromFileTTF("fonts/FreeSerif.ttf", 24.0f, &config, &symbol_ranges[0]);
+    atlas->AddFontFromFileTTF("fonts/fontawesome-webfont.ttf", 24.0f, &config, &icon_ranges[0]);
+    atlas->Build();
+
+    fonts[2] = atlas->AddFontFromFileTTF("fonts/Roboto-Medium.ttf", 20.0f, nullptr, &base_ranges[0]);
+    atlas->AddFontFromFileTTF("fonts/FreeSerif.ttf", 20.0f, &config, &symbol_ranges[0]);
+    atlas->AddFontFromFileTTF("fonts/fontawesome-webfont.ttf", 20.0f, &config, &icon_ranges[0]);
+    atlas->Build();
+
+    fonts[3] = atlas->AddFontFromFileTTF("fonts/Roboto-Medium.ttf", 16.0f, nullptr, &base_ranges[0]);
+    atlas->AddFontFromFileTTF("fonts/FreeSerif.ttf", 16.0f, &config, &symbol_ranges[0]);
+    atlas->AddFontFromFileTTF("fonts/fontawesome-webfont.ttf", 16.0f, &config, &icon_ranges[0]);
+    atlas->Build();
+}
 
+void keyboard_loadfonts()
+{
+    ImGuiIO& io = ImGui::GetIO();
+    keyboard_addfonts(io.Fonts, KbFonts);
 }
 
-static void key_render(xcore::ckeyboard_t const* kb, xcore::ckeygroup_t const& kg, xcore::ckey_t const& ckey, xcore::keycodes_t const* kcDB, xcore::keymap_t const* km, xcore::s32 kml, float globalscale, float x, float y, float r, bool highlight)
+static void key_render(xcore::ckeyplace_t const& place, xcore::keycodes_t const* kcDB, xcore::keymap_t const* km, xcore::s32 kml, bool highlight, xcore::kcompose_t* compose, float heat, xcore::u32 const* glow)
 {
-    const float sw       = ckey.m_sw * kg.m_sw * kb->m_sw * kb->m_scale * globalscale;
-    const float sh       = ckey.m_sh * kg.m_sh * kb->m_sh * kb->m_scale * globalscale;
-    const float kw       = (ckey.m_w * kg.m_w * kb->m_w * kb->m_scale * globalscale) - (2 * sw);
-    const float kh       = (ckey.m_h * kg.m_h * kb->m_h * kb->m_scale * globalscale) - (2 * sh);
-    const float rounding = kw / sw;
-    const float hw       = kw / 2;
-    const float hh       = kh / 2;
-    const float th       = 10.0f * globalscale;
-
-    const xcore::u8* capcolor = kb->m_capcolor;
-    const xcore::u8* txtcolor = kb->m_txtcolor;
-    const xcore::u8* ledcolor = kb->m_ledcolor;
-
-    if (kg.m_capcolor)
-        capcolor = kg.m_capcolor;
-    if (kg.m_txtcolor)
-        txtcolor = kg.m_txtcolor;
-    if (kg.m_ledcolor)
-        ledcolor = kg.m_ledcolor;
-
-    if (ckey.m_capcolor)
-        capcolor = ckey.m_capcolor;
-    if (ckey.m_txtcolor)
-        txtcolor = ckey.m_txtcolor;
-    if (ckey.m_ledcolor)
-        ledcolor = ckey.m_ledcolor;
+    xcore::kprofilescope_t zone(xcore::PROFILE_KEY_RENDER);
+
+    const float x        = place.m_x;
+    const float y        = place.m_y;
+    const float kw       = place.m_hw * 2;
+    const float rounding = place.m_rounding;
+    const float hw       = place.m_hw;
+    const float hh       = place.m_hh;
+    const float th       = place.m_th;
+
+    const xcore::u8* capcolor = place.m_capcolor;
+    const xcore::u8* txtcolor = place.m_txtcolor;
+    const xcore::u8* ledcolor = place.m_ledcolor;
 
     ImVec4 dkeycapcolor(capcolor);
     ImVec4 dkeyledcolor(ledcolor);
 
-    const ImU32 rkeycapcolor  = ImColor(capcolor);
+    ImU32       rkeycapcolor  = ImColor(capcolor);
     const ImU32 rkeyhltcolor  = ImColor(Lighten(dkeycapcolor, 0.5f));
-    const ImU32 rkeyledcolor1 = ImColor(DarkenAlpha(dkeyledcolor, 0.2f, 0.5f));
-    const ImU32 rkeyledcolor2 = ImColor(DarkenAlpha(dkeyledcolor, 0.1f, 0.25f));
-    const ImU32 rkeyledcolor3 = ImColor(ledcolor);
-    const ImU32 rkeytxtcolor  = ImColor(txtcolor);
+    // the glow palette of an RGB effect replaces the LED color of the keyboard
+    const ImU32 rkeyledcolor1 = glow != nullptr ? glow[0] : (ImU32)ImColor(DarkenAlpha(dkeyledcolor, 0.2f, 0.5f));
+    const ImU32 rkeyledcolor2 = glow != nullptr ? glow[1] : (ImU32)ImColor(DarkenAlpha(dkeyledcolor, 0.1f, 0.25f));
+    const ImU32 rkeyledcolor3 = glow != nullptr ? glow[2] : (ImU32)ImColor(ledcolor);
+    ImU32       rkeytxtcolor  = ImColor(txtcolor);
+
+    // heat in [0, 1] tints the key cap from its own color to red, a key that is never pressed has no heat (-1)
+    if (heat >= 0.0f)
+        rkeycapcolor = ImColor(Mix(dkeycapcolor, ImVec4(0.85f, 0.15f, 0.1f, 1.0f), 0.15f + 0.75f * heat));
 
     // draw_list->AddRect(ImVec2(x, y), ImVec2(x + sz, y + sz), rkeyledcolor, rounding, ImDrawFlags_RoundCornersAll, th/1.0f);
     ImDrawList* draw_list = ImGui::GetWindowDrawList();
@@ -241,18 +239,25 @@ static void key_render(xcore::ckeyboard_t const* kb, xcore::ckeygroup_t const& k
         draw_list->AddRect(ImVec2(x - (hw - (th / 4.0f)), y - (hh - (th / 4.0f))), ImVec2(x + (hw - (th / 4.0f)), y + (hh - (th / 4.0f))), (rkeyhltcolor), rounding, ImDrawFlags_None, th / 2.0f);
     }
 
-    xcore::layer_t* layer = &km->m_layers[kml];
-    xcore::key_t* key = &layer->m_keys[ckey.m_index];
-
-    // So here we need to do a search into the keycodes database to find the actual text to display in the key
-    xcore::keycode_t const* keycode = find_keycode(kcDB, key->m_keycode_str);
+    const char* key_label = xcore::keyplace_label(place, kcDB, km, kml);
 
-    const char* key_label = keycode->m_normal;
-    if (key_label == nullptr)
-        key_label = key->m_keycode_str;
+    // a transparent key shows the key it falls through to, dimmed, with the index of the layer it comes from
+    xcore::s32 source = kml;
+    if (compose != nullptr && place.m_key->m_index >= 0 && place.m_key->m_index < xcore::compose_nb_keys(compose, kml))
+    {
+        xcore::kcomposedkey_t const& ck = xcore::compose_layer(compose, kml)[place.m_key->m_index];
+        if (ck.m_source != kml)
+        {
+            source       = ck.m_source;
+            key_label    = xcore::compose_label(compose, ck, place.m_key->m_index);
+            rkeytxtcolor = ImColor((int)txtcolor[0], (int)txtcolor[1], (int)txtcolor[2], (int)txtcolor[3] / 2);
+        }
+    }
 
     if (key_label != nullptr)
     {
+        xcore::kprofilescope_t text_zone(xcore::PROFILE_TEXT_LAYOUT);
+
         char  text[128];
         char* lines[4] = {nullptr, nullptr, nullptr, nullptr};
 
@@ -294,114 +299,110 @@ static void key_render(xcore::ckeyboard_t const* kb, xcore::ckeygroup_t const& k
         }
     }
 
-    if (ckey.m_nob)
+    if (source != kml)
+    {
+        char text[8];
+        snprintf(text, sizeof(text), source < 0 ? "-" : "%d", source);
+        ImGui::PushFont(KbFonts[3]);
+        draw_list->AddText(ImVec2(x - hw + th, y - hh + th / 2.0f), rkeytxtcolor, text);
+        ImGui::PopFont();
+    }
+
+    if (place.m_key->m_nob)
         draw_list->AddLine(ImVec2(x - (hw * 0.125), y + 0.5f * hh), ImVec2(x + (hw * 0.125), y + 0.5f * hh), ImColor(255, 255, 255, 255), 2);
 
-    rotation.Apply(r);
+    xcore::kprofilescope_t rotation_zone(xcore::PROFILE_ROTATION);
+    rotation.Apply(place.m_rad);
 }
 
-void keyboard_render(xcore::ckeyboard_t const* kb, xcore::keycodes_t const* kcdb, xcore::keymap_t const* km, xcore::s32 l, float posx, float posy, float mousex, float mousey, float globalscale)
+xcore::s32 keyboard_render(xcore::ckeyboard_t const* kb, xcore::keycodes_t const* kcdb, xcore::keymap_t const* km, xcore::s32 l, float posx, float posy, float mousex, float mousey, float globalscale, xcore::kcompose_t* compose, xcore::kheatmap_t* heatmap, xcore::krgb_t* rgb)
 {
-    // origin = left/top corner
-    float ox = posx + (kb->m_w / 2);
-    float oy = posy + (kb->m_h / 2);
+    xcore::kprofilescope_t zone(xcore::PROFILE_KEYBOARD_RENDER);
 
-    int highlighted_key_index = -1;
+    // the placement of the keys, grows to the largest keyboard seen and is then reused every frame
+    static ImVector<xcore::ckeyplace_t> s_places;
 
-    for (int g = 0; g < kb->m_nb_keygroups; g++)
-    {
-        xcore::ckeygroup_t const& kg = kb->m_keygroups[g];
+    xcore::s32 const nb_keys = xcore::keyboard_nb_keys(kb);
+    if (s_places.Size < nb_keys)
+        s_places.resize(nb_keys);
+    xcore::s32 const nb_places = xcore::keyboard_layout(kb, posx, posy, globalscale, s_places.Data, s_places.Size);
 
-        float gx = ox + (kg.m_x * kb->m_scale * globalscale);
-        float gy = oy + (kg.m_y * kb->m_scale * globalscale);
-
-        // the keygroup down and right coordinate vectors
-        ImVec2 ydir(0.0f, 1.0f);
-        ImVec2 xdir(1.0f, 0.0f);
-
-        // for rotating the mouse x/y into the keygroup's coordinate system
-        ImVec2 mdir(mousex - gx, mousey - gy);
-
-        float rrad = 0.0f;
-        if (kg.m_a > 0 || kg.m_a < 0)
+    int        highlighted_place = -1;
+    xcore::s32 highlighted_key   = -1;
+    {
+        xcore::kprofilescope_t hit_zone(xcore::PROFILE_HIT_TEST);
+        for (int i = 0; i < nb_places; i++)
         {
-            rrad    = (float)3.141592653f * kg.m_a / 180.0f;
-            float s = (float)sin(rrad);
-            float c = (float)cos(rrad);
-            ydir    = ImRotate(ydir, c, s);
-            xdir    = ImRotate(xdir, c, s);
-            s       = (float)sin(-rrad);
-            c       = (float)cos(-rrad);
-            mdir    = ImRotate(mdir, c, s);
+            if (xcore::keyplace_contains(s_places[i], mousex, mousey))
+            {
+                highlighted_place = i;
+                break;
+            }
         }
+    }
 
-        float mx = gx + mdir.x;
-        float my = gy + mdir.y;
+    // presses on a log scale, otherwise only the space bar and a few letters show up
+    xcore::u64 const* presses  = heatmap != nullptr ? xcore::heatmap_presses(heatmap, l) : nullptr;
+    float const       max_heat = heatmap != nullptr ? logf(1.0f + (float)xcore::heatmap_max_presses(heatmap)) : 0.0f;
 
-        float rx = gx;
-        float ry = gy;
-        int   k  = 0;
-        for (int r = 0; r < kg.m_r && highlighted_key_index == -1; r++)
-        {
-            float cx = rx;
-            float cy = ry;
+    // the LEDs of 'rgb' are in the order of keyboard_layout, only when it was built for this keyboard
+    bool const use_rgb = rgb != nullptr && xcore::rgb_keyboard(rgb) == kb && xcore::rgb_nb_leds(rgb) == nb_places;
 
-            for (int c = 0; c < kg.m_c && highlighted_key_index == -1; c++)
-            {
-                xcore::ckey_t const& kc = kg.m_keys[k++];
-                if (IsPointInsideKey(kb, kg, kc, globalscale, cx, cy, mx, my))
-                {
-                    highlighted_key_index = kc.m_index;
-                    break;
-                }
-                cx += (kb->m_w * kg.m_w) * kb->m_scale * globalscale;
-            }
+    for (int i = 0; i < nb_places; i++)
+    {
+        xcore::ckeyplace_t const& place = s_places[i];
 
-            ry += (kb->m_h * kg.m_h) * kb->m_scale * globalscale;
+        float heat = -1.0f;
+        if (presses != nullptr && max_heat > 0.0f && place.m_key->m_index >= 0 && place.m_key->m_index < xcore::heatmap_nb_keys(heatmap, l) && presses[place.m_key->m_index] > 0)
+            heat = logf(1.0f + (float)presses[place.m_key->m_index]) / max_heat;
+        xcore::u32 glow[3];
+        if (use_rgb)
+        {
+            glow[0] = xcore::rgb_glow(rgb, 0)[i];
+            glow[1] = xcore::rgb_glow(rgb, 1)[i];
+            glow[2] = xcore::rgb_glow(rgb, 2)[i];
         }
+        key_render(place, kcdb, km, l, i == highlighted_place, compose, heat, use_rgb ? glow : nullptr);
 
-        rx = gx;
-        ry = gy;
-        k  = 0;
-        for (int r = 0; r < kg.m_r; r++)
+        if (i == highlighted_place)
         {
-            float cx = rx;
-            float cy = ry;
-
-            for (int c = 0; c < kg.m_c; c++)
+            xcore::ckey_t const&      kc = *place.m_key;
+            xcore::ckeygroup_t const& kg = *place.m_group;
+
+            ImGui::BeginTooltip();
+            ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+
+            // should we prepare a full description of the key:
+            // - keyboard name
+            // - layer name
+            // - key label
+            // - modifiers
+            // - full keycode
+            // - keygroup name
+            // - keymap index
+            const char* test = "Keyboard: %s\nLayer: %s\nLabel: %s\nModifiers: %s\nKeycode: %s\nKeygroup: %s\nKeymap index: %d";
+
+            // the index of the key is checked once, a keymap for another keyboard can have fewer keys (see keyplace_label)
+            xcore::layer_t const* layer = &km->m_layers[l];
+            xcore::key_t const*   key   = (kc.m_index >= 0 && kc.m_index < layer->m_nb_keys) ? &layer->m_keys[kc.m_index] : nullptr;
+
+            ImGui::Text(test, kb->m_name, layer->m_name, kc.m_label, "None", key != nullptr ? key->m_keycode_str : "-", kg.m_name, kc.m_index);
+            if (key != nullptr)
             {
-                xcore::ckey_t const& kc = kg.m_keys[k++];
-                key_render(kb, kg, kc, kcdb, km, l, globalscale, cx, cy, rrad, kc.m_index == highlighted_key_index);
-
-                if (kc.m_index == highlighted_key_index)
+                if (compose != nullptr && kc.m_index < xcore::compose_nb_keys(compose, l))
                 {
-                    ImGui::BeginTooltip();
-                    ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
-
-                    // should we prepare a full description of the key:
-                    // - keyboard name
-                    // - layer name
-                    // - key label
-                    // - modifiers
-                    // - full keycode
-                    // - keygroup name
-                    // - keymap index
-                    const char* test = "Keyboard: %s\nLayer: %s\nLabel: %s\nModifiers: %s\nKeycode: %s\nKeygroup: %s\nKeymap index: %d";
-
-                    xcore::layer_t* layer = &km->m_layers[l];
-                    xcore::key_t* key = &layer->m_keys[kc.m_index];
-
-                    ImGui::Text(test, kb->m_name, layer->m_name, kc.m_label, "None", key->m_keycode_str, kg.m_name, kc.m_index);
-                    ImGui::PopTextWrapPos();
-                    ImGui::EndTooltip();
+                    xcore::kcomposedkey_t const& ck = xcore::compose_layer(compose, l)[kc.m_index];
+                    if (ck.m_source != l)
+                        ImGui::Text("Resolves to: %s", ck.m_source < 0 ? "nothing (transparent down to the bottom)" : km->m_layers[ck.m_source].m_name);
                 }
-
-                cx += xdir.x * (kb->m_w * kg.m_w) * kb->m_scale * globalscale;
-                cy += xdir.y * (kb->m_h * kg.m_h) * kb->m_scale * globalscale;
+                if (presses != nullptr && kc.m_index < xcore::heatmap_nb_keys(heatmap, l))
+                    ImGui::Text("Presses: %llu (%.2f%%)", (unsigned long long)presses[kc.m_index], xcore::heatmap_total(heatmap) > 0 ? 100.0 * (double)presses[kc.m_index] / (double)xcore::heatmap_total(heatmap) : 0.0);
             }
+            ImGui::PopTextWrapPos();
+            ImGui::EndTooltip();
 
-            rx += ydir.x * (kb->m_w * kg.m_w) * kb->m_scale * globalscale;
-            ry += ydir.y * (kb->m_h * kg.m_h) * kb->m_scale * globalscale;
+            highlighted_key = kc.m_index;
         }
     }
-}
\ No newline at end of file
+    return highlighted_key;
+}
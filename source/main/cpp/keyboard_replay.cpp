@@ -0,0 +1,284 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_replay.h"
+#include "qmk-keymap-wiz/keyboard_writer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+namespace xcore
+{
+    static const char s_magic[4] = {'Q', 'K', 'W', 'R'};
+    static const u8   s_version  = 1;
+
+    enum
+    {
+        INPUT_DISPLAY = 0x01,
+        INPUT_SCALE   = 0x02,
+        INPUT_MOUSE   = 0x04,
+        INPUT_WHEEL   = 0x08,
+        INPUT_BUTTONS = 0x10,
+        INPUT_KEYS    = 0x20,
+        INPUT_CHARS   = 0x40,
+    };
+
+    void input_clear(kinputframe_t& frame) { memset(&frame, 0, sizeof(frame)); }
+
+    bool input_key(kinputframe_t const& frame, s32 key) { return key >= 0 && key < INPUT_MAX_KEYS && (frame.m_keys[key >> 3] & (1 << (key & 7))) != 0; }
+
+    void input_set_key(kinputframe_t& frame, s32 key, bool down)
+    {
+        if (key < 0 || key >= INPUT_MAX_KEYS)
+            return;
+        if (down)
+            frame.m_keys[key >> 3] |= (u8)(1 << (key & 7));
+        else
+            frame.m_keys[key >> 3] &= (u8)~(1 << (key & 7));
+    }
+
+    bool input_idle(kinputframe_t const& frame, kinputframe_t const& previous)
+    {
+        if (frame.m_wheel_x != 0.0f || frame.m_wheel_y != 0.0f || frame.m_nb_chars > 0)
+            return false;
+        if (frame.m_display_w != previous.m_display_w || frame.m_display_h != previous.m_display_h || frame.m_font_scale != previous.m_font_scale)
+            return false;
+        if (frame.m_mouse_x != previous.m_mouse_x || frame.m_mouse_y != previous.m_mouse_y || frame.m_buttons != previous.m_buttons)
+            return false;
+        return memcmp(frame.m_keys, previous.m_keys, sizeof(frame.m_keys)) == 0;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+
+    struct krecorder_t
+    {
+        kwriter_t     m_writer;
+        kinputframe_t m_previous;
+        s32           m_nb_frames;
+    };
+
+    krecorder_t* recorder_open(const char* filename)
+    {
+        krecorder_t* recorder = (krecorder_t*)::malloc(sizeof(krecorder_t));
+        new (&recorder->m_writer) kwriter_t();
+        if (!writer_open(recorder->m_writer, filename))
+        {
+            ::free(recorder);
+            return nullptr;
+        }
+        input_clear(recorder->m_previous);
+        recorder->m_nb_frames = 0;
+
+        writer_write(recorder->m_writer, s_magic, 4);
+        writer_char(recorder->m_writer, (char)s_version);
+        return recorder;
+    }
+
+    static void write_float(kwriter_t& w, float value) { writer_write(w, (const char*)&value, 4); }
+
+    void recorder_frame(krecorder_t* recorder, kinputframe_t const& frame)
+    {
+        kinputframe_t const& prev = recorder->m_previous;
+
+        // the first frame has everything that differs from a cleared frame
+        s32 nb_toggled = 0;
+        u8  toggled[INPUT_MAX_KEYS];
+        for (s32 k = 0; k < INPUT_MAX_KEYS; ++k)
+        {
+            if (input_key(frame, k) != input_key(prev, k))
+                toggled[nb_toggled++] = (u8)k;
+        }
+        s32 const nb_chars = frame.m_nb_chars < INPUT_MAX_CHARS ? frame.m_nb_chars : INPUT_MAX_CHARS;
+
+        u8 flags = 0;
+        if (recorder->m_nb_frames == 0 || frame.m_display_w != prev.m_display_w || frame.m_display_h != prev.m_display_h)
+            flags |= INPUT_DISPLAY;
+        if (recorder->m_nb_frames == 0 || frame.m_font_scale != prev.m_font_scale)
+            flags |= INPUT_SCALE;
+        if (recorder->m_nb_frames == 0 || frame.m_mouse_x != prev.m_mouse_x || frame.m_mouse_y != prev.m_mouse_y)
+            flags |= INPUT_MOUSE;
+        if (frame.m_wheel_x != 0.0f || frame.m_wheel_y != 0.0f)
+            flags |= INPUT_WHEEL;
+        if (frame.m_buttons != prev.m_buttons)
+            flags |= INPUT_BUTTONS;
+        if (nb_toggled > 0)
+            flags |= INPUT_KEYS;
+        if (nb_chars > 0)
+            flags |= INPUT_CHARS;
+
+        kwriter_t& w = recorder->m_writer;
+        writer_char(w, (char)flags);
+        write_float(w, frame.m_delta_time);
+        if (flags & INPUT_DISPLAY)
+        {
+            write_float(w, frame.m_display_w);
+            write_float(w, frame.m_display_h);
+        }
+        if (flags & INPUT_SCALE)
+            write_float(w, frame.m_font_scale);
+        if (flags & INPUT_MOUSE)
+        {
+            write_float(w, frame.m_mouse_x);
+            write_float(w, frame.m_mouse_y);
+        }
+        if (flags & INPUT_WHEEL)
+        {
+            write_float(w, frame.m_wheel_x);
+            write_float(w, frame.m_wheel_y);
+        }
+        if (flags & INPUT_BUTTONS)
+            writer_char(w, (char)frame.m_buttons);
+        if (flags & INPUT_KEYS)
+        {
+            // at most INPUT_MAX_KEYS toggles, a count of 0 means all of them
+            writer_char(w, (char)(u8)nb_toggled);
+            writer_write(w, (const char*)toggled, nb_toggled);
+        }
+        if (flags & INPUT_CHARS)
+        {
+            writer_char(w, (char)(u8)nb_chars);
+            writer_write(w, (const char*)frame.m_chars, 4 * nb_chars);
+        }
+
+        recorder->m_previous = frame;
+        recorder->m_nb_frames += 1;
+    }
+
+    s32 recorder_nb_frames(krecorder_t* recorder) { return recorder->m_nb_frames; }
+
+    bool recorder_close(krecorder_t* recorder)
+    {
+        bool const ok = writer_close(recorder->m_writer);
+        ::free(recorder);
+        return ok;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+
+    struct kplayer_t
+    {
+        u8*           m_data;
+        s32           m_size;
+        s32           m_cursor;
+        s32           m_nb_frames;
+        kinputframe_t m_previous;
+    };
+
+    static bool read_bytes(kplayer_t* player, void* dst, s32 size)
+    {
+        if (player->m_cursor + size > player->m_size)
+            return false;
+        memcpy(dst, player->m_data + player->m_cursor, size);
+        player->m_cursor += size;
+        return true;
+    }
+
+    static bool read_frame(kplayer_t* player, kinputframe_t& frame)
+    {
+        frame            = player->m_previous;
+        frame.m_wheel_x  = 0.0f;
+        frame.m_wheel_y  = 0.0f;
+        frame.m_nb_chars = 0;
+
+        u8 flags;
+        if (!read_bytes(player, &flags, 1) || !read_bytes(player, &frame.m_delta_time, 4))
+            return false;
+        bool ok = true;
+        if (flags & INPUT_DISPLAY)
+            ok = ok && read_bytes(player, &frame.m_display_w, 4) && read_bytes(player, &frame.m_display_h, 4);
+        if (flags & INPUT_SCALE)
+            ok = ok && read_bytes(player, &frame.m_font_scale, 4);
+        if (flags & INPUT_MOUSE)
+            ok = ok && read_bytes(player, &frame.m_mouse_x, 4) && read_bytes(player, &frame.m_mouse_y, 4);
+        if (flags & INPUT_WHEEL)
+            ok = ok && read_bytes(player, &frame.m_wheel_x, 4) && read_bytes(player, &frame.m_wheel_y, 4);
+        if (flags & INPUT_BUTTONS)
+        {
+            u8 buttons      = 0;
+            ok              = ok && read_bytes(player, &buttons, 1);
+            frame.m_buttons = buttons;
+        }
+        if (ok && (flags & INPUT_KEYS))
+        {
+            u8 count    = 0;
+            ok          = read_bytes(player, &count, 1);
+            s32 const n = count == 0 ? (s32)INPUT_MAX_KEYS : (s32)count;
+            for (s32 i = 0; ok && i < n; ++i)
+            {
+                u8 key = 0;
+                ok     = read_bytes(player, &key, 1);
+                input_set_key(frame, key, !input_key(frame, key));
+            }
+        }
+        if (ok && (flags & INPUT_CHARS))
+        {
+            u8 count         = 0;
+            ok               = read_bytes(player, &count, 1) && count <= INPUT_MAX_CHARS && read_bytes(player, frame.m_chars, 4 * count);
+            frame.m_nb_chars = count;
+        }
+        if (!ok)
+            return false;
+
+        player->m_previous = frame;
+        return true;
+    }
+
+    kplayer_t* player_open(const char* filename)
+    {
+        FILE* file = fopen(filename, "rb");
+        if (file == nullptr)
+        {
+            printf("failed to open %s\n", filename);
+            return nullptr;
+        }
+        fseek(file, 0, SEEK_END);
+        long const len = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        kplayer_t* player = (kplayer_t*)::malloc(sizeof(kplayer_t));
+        player->m_data    = (u8*)::malloc(len > 0 ? len : 1);
+        player->m_size    = (s32)fread(player->m_data, 1, len > 0 ? len : 0, file);
+        fclose(file);
+
+        if (player->m_size < 5 || memcmp(player->m_data, s_magic, 4) != 0 || player->m_data[4] != s_version)
+        {
+            printf("%s is not an input recording (version %d)\n", filename, (s32)s_version);
+            player_close(player);
+            return nullptr;
+        }
+
+        // count the frames, a frame that is cut off at the end (a crash while recording) is not part of it
+        kinputframe_t frame;
+        player_rewind(player);
+        player->m_nb_frames = 0;
+        while (read_frame(player, frame))
+            player->m_nb_frames += 1;
+        player_rewind(player);
+        return player;
+    }
+
+    bool player_next(kplayer_t* player, kinputframe_t& frame)
+    {
+        if (player->m_cursor >= player->m_size)
+            return false;
+        return read_frame(player, frame);
+    }
+
+    void player_rewind(kplayer_t* player)
+    {
+        player->m_cursor = 5;
+        input_clear(player->m_previous);
+    }
+
+    s32 player_nb_frames(kplayer_t* player) { return player->m_nb_frames; }
+
+    void player_close(kplayer_t* player)
+    {
+        ::free(player->m_data);
+        ::free(player);
+    }
+
+} // namespace xcore
@@ -0,0 +1,401 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_keycode.h"
+#include "qmk-keymap-wiz/keyboard_reverse.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace xcore
+{
+    // a key in the list of the keycode it sends
+    struct kreversekey_t
+    {
+        s32 m_next;
+        s32 m_prev;
+        s16 m_kc; // -1 when the key is not in any list
+        s16 m_layer;
+        s16 m_key;
+    };
+
+    // the normal or shifted text of a keycode, chained per hash bucket
+    struct kreversetext_t
+    {
+        const char* m_text;
+        s32         m_next;
+        s16         m_kc;
+        u8          m_shifted;
+    };
+
+    struct kreverse_t
+    {
+        keycodes_t const* m_kcdb;
+        keymap_t const*   m_km;
+        s32               m_nb_layers;
+        s32*              m_key_base; // m_nb_layers + 1 entries
+        kreversekey_t*    m_keys;
+        s32               m_nb_heads;
+        s32*              m_heads; // first key of every keycode, -1 when no key sends it
+
+        s32             m_nb_texts;
+        kreversetext_t* m_texts;
+        s32             m_nb_buckets; // a power of 2
+        s32*            m_buckets;
+
+        s16*            m_depth;  // per layer, -1 when the layer cannot be reached
+        kreversestep_t* m_parent; // per layer, the switch that reaches it first
+
+        s32            m_max_scratch;
+        kreversehit_t* m_scratch; // all hits of a query before they are sorted
+    };
+
+    kreverse_t* reverse_create()
+    {
+        kreverse_t* r    = (kreverse_t*)::malloc(sizeof(kreverse_t));
+        r->m_kcdb        = nullptr;
+        r->m_km          = nullptr;
+        r->m_nb_layers   = 0;
+        r->m_key_base    = nullptr;
+        r->m_keys        = nullptr;
+        r->m_nb_heads    = 0;
+        r->m_heads       = nullptr;
+        r->m_nb_texts    = 0;
+        r->m_texts       = nullptr;
+        r->m_nb_buckets  = 0;
+        r->m_buckets     = nullptr;
+        r->m_depth       = nullptr;
+        r->m_parent      = nullptr;
+        r->m_max_scratch = 0;
+        r->m_scratch     = nullptr;
+        return r;
+    }
+
+    static void reverse_free(kreverse_t* r)
+    {
+        ::free(r->m_key_base);
+        ::free(r->m_keys);
+        ::free(r->m_heads);
+        ::free(r->m_texts);
+        ::free(r->m_buckets);
+        ::free(r->m_depth);
+        ::free(r->m_parent);
+    }
+
+    void reverse_destroy(kreverse_t* r)
+    {
+        if (r == nullptr)
+            return;
+        reverse_free(r);
+        ::free(r->m_scratch);
+        ::free(r);
+    }
+
+    // FNV-1a
+    static u32 hash_text(const char* text)
+    {
+        u32 h = 2166136261u;
+        for (; *text != 0; ++text)
+            h = (h ^ (u8)*text) * 16777619u;
+        return h;
+    }
+
+    static void add_text(kreverse_t* r, const char* text, s32 kc, bool shifted)
+    {
+        if (text == nullptr || text[0] == 0)
+            return;
+        kreversetext_t& t = r->m_texts[r->m_nb_texts];
+        s32&            b = r->m_buckets[hash_text(text) & (r->m_nb_buckets - 1)];
+        t.m_text          = text;
+        t.m_kc            = (s16)kc;
+        t.m_shifted       = shifted ? 1 : 0;
+        t.m_next          = b;
+        b                 = r->m_nb_texts++;
+    }
+
+    static s32 key_keycode_index(kreverse_t* r, xcore::key_t const& key)
+    {
+        if (key.m_kc >= 0)
+            return key.m_kc;
+        if (key.m_kc == KEYCODE_UNCOMPILED && key.m_keycode_str != nullptr)
+            return lookup_keycode_index(r->m_kcdb, key.m_keycode_str, (s32)strlen(key.m_keycode_str));
+        return -1;
+    }
+
+    static void unlink_key(kreverse_t* r, s32 i)
+    {
+        kreversekey_t& k = r->m_keys[i];
+        if (k.m_kc < 0)
+            return;
+        if (k.m_prev >= 0)
+            r->m_keys[k.m_prev].m_next = k.m_next;
+        else
+            r->m_heads[k.m_kc] = k.m_next;
+        if (k.m_next >= 0)
+            r->m_keys[k.m_next].m_prev = k.m_prev;
+        k.m_kc   = -1;
+        k.m_next = -1;
+        k.m_prev = -1;
+    }
+
+    static void link_key(kreverse_t* r, s32 i, s32 kc)
+    {
+        kreversekey_t& k = r->m_keys[i];
+        if (kc < 0 || kc >= r->m_nb_heads)
+            return;
+        k.m_kc   = (s16)kc;
+        k.m_prev = -1;
+        k.m_next = r->m_heads[kc];
+        if (k.m_next >= 0)
+            r->m_keys[k.m_next].m_prev = i;
+        r->m_heads[kc] = i;
+    }
+
+    // breadth first from the base layer, the first switch that reaches a layer is its parent
+    static bool reverse_paths(kreverse_t* r, keymap_t const* km)
+    {
+        s32 const L       = r->m_nb_layers;
+        bool      changed = false;
+        s16*      queue   = (s16*)::malloc(sizeof(s16) * (L + 1));
+
+        s16* depth = (s16*)::malloc(sizeof(s16) * (L + 1));
+        for (s32 l = 0; l < L; ++l)
+            depth[l] = -1;
+
+        kreversestep_t none;
+        none.m_layer  = -1;
+        none.m_key    = -1;
+        none.m_switch = 0;
+
+        s32 head = 0;
+        s32 tail = 0;
+        if (L > 0)
+        {
+            depth[0]      = 0;
+            queue[tail++] = 0;
+        }
+        kreversestep_t* parent = (kreversestep_t*)::malloc(sizeof(kreversestep_t) * (L + 1));
+        for (s32 l = 0; l < L; ++l)
+            parent[l] = none;
+
+        while (head < tail)
+        {
+            s32 const      from  = queue[head++];
+            layer_t const& layer = km->m_layers[from];
+            for (s32 k = 0; k < layer.m_nb_keys; ++k)
+            {
+                xcore::key_t const& key = layer.m_keys[k];
+                if (key.m_layer_switch == 0)
+                    continue;
+                s32 const to = find_layer(km, key.m_layer);
+                if (to < 0 || to >= L || depth[to] >= 0)
+                    continue;
+                depth[to]           = (s16)(depth[from] + 1);
+                parent[to].m_layer  = (s16)from;
+                parent[to].m_key    = (s16)k;
+                parent[to].m_switch = key.m_layer_switch;
+                queue[tail++]       = (s16)to;
+            }
+        }
+
+        if (r->m_depth == nullptr || memcmp(r->m_depth, depth, sizeof(s16) * L) != 0 || memcmp(r->m_parent, parent, sizeof(kreversestep_t) * L) != 0)
+            changed = true;
+        ::free(r->m_depth);
+        ::free(r->m_parent);
+        r->m_depth  = depth;
+        r->m_parent = parent;
+        ::free(queue);
+        return changed;
+    }
+
+    void reverse_build(kreverse_t* r, keycodes_t const* kcdb, keymap_t const* km)
+    {
+        reverse_free(r);
+        r->m_depth  = nullptr;
+        r->m_parent = nullptr;
+
+        s32 const L    = km->m_nb_layers;
+        r->m_kcdb      = kcdb;
+        r->m_km        = km;
+        r->m_nb_layers = L;
+
+        r->m_key_base    = (s32*)::malloc(sizeof(s32) * (L + 1));
+        r->m_key_base[0] = 0;
+        for (s32 l = 0; l < L; ++l)
+            r->m_key_base[l + 1] = r->m_key_base[l] + km->m_layers[l].m_nb_keys;
+
+        r->m_nb_heads = kcdb != nullptr ? kcdb->m_nb_keycodes : 0;
+        r->m_heads    = (s32*)::malloc(sizeof(s32) * (r->m_nb_heads + 1));
+        for (s32 i = 0; i < r->m_nb_heads; ++i)
+            r->m_heads[i] = -1;
+
+        // the keys are linked back to front so that every list is in keymap order
+        r->m_keys = (kreversekey_t*)::malloc(sizeof(kreversekey_t) * (r->m_key_base[L] + 1));
+        for (s32 l = L - 1; l >= 0; --l)
+        {
+            layer_t const& layer = km->m_layers[l];
+            for (s32 k = layer.m_nb_keys - 1; k >= 0; --k)
+            {
+                s32 const      i  = r->m_key_base[l] + k;
+                kreversekey_t& rk = r->m_keys[i];
+                rk.m_kc           = -1;
+                rk.m_next         = -1;
+                rk.m_prev         = -1;
+                rk.m_layer        = (s16)l;
+                rk.m_key          = (s16)k;
+                link_key(r, i, key_keycode_index(r, layer.m_keys[k]));
+            }
+        }
+
+        r->m_nb_buckets = 16;
+        while (r->m_nb_buckets < r->m_nb_heads * 2)
+            r->m_nb_buckets *= 2;
+        r->m_buckets = (s32*)::malloc(sizeof(s32) * r->m_nb_buckets);
+        for (s32 i = 0; i < r->m_nb_buckets; ++i)
+            r->m_buckets[i] = -1;
+        r->m_nb_texts = 0;
+        r->m_texts    = (kreversetext_t*)::malloc(sizeof(kreversetext_t) * (r->m_nb_heads * 2 + 1));
+        for (s32 i = 0; i < r->m_nb_heads; ++i)
+        {
+            keycode_t const& kc = kcdb->m_keycodes[i];
+            add_text(r, kc.m_normal, i, false);
+            if (kc.m_shifted != nullptr && (kc.m_normal == nullptr || strcmp(kc.m_shifted, kc.m_normal) != 0))
+                add_text(r, kc.m_shifted, i, true);
+        }
+
+        reverse_paths(r, km);
+    }
+
+    bool reverse_update(kreverse_t* r, keymap_t const* km, kedit_t const& edit)
+    {
+        if (is_layer_edit(edit.m_op) || edit.m_op == EDIT_KEY_CAPCOLOR || edit.m_op == EDIT_KEY_LEDCOLOR)
+            return false;
+        if (edit.m_layer < 0 || edit.m_layer >= r->m_nb_layers || edit.m_key < 0 || edit.m_key >= r->m_key_base[edit.m_layer + 1] - r->m_key_base[edit.m_layer])
+            return false;
+
+        r->m_km = km;
+
+        bool      changed = false;
+        s32 const i       = r->m_key_base[edit.m_layer] + edit.m_key;
+        s32 const kc      = key_keycode_index(r, km->m_layers[edit.m_layer].m_keys[edit.m_key]);
+        if (kc != r->m_keys[i].m_kc && !(kc < 0 && r->m_keys[i].m_kc < 0))
+        {
+            unlink_key(r, i);
+            link_key(r, i, kc);
+            changed = true;
+        }
+
+        if (edit.m_op == EDIT_LAYER_SWITCH || edit.m_op == EDIT_LAYER)
+            changed = reverse_paths(r, km) || changed;
+        return changed;
+    }
+
+    // the modifiers that a key sends along with its keycode when it is tapped
+    static u16 key_sent_mods(xcore::key_t const& key)
+    {
+        if (key.m_mod_tap || (key.m_mod & (MT | OSM)) != 0)
+            return 0;
+        return key.m_mod & 0xFF;
+    }
+
+    static void add_hits(kreverse_t* r, s32& nb_hits, s32 kc, s32 text_match)
+    {
+        for (s32 i = r->m_heads[kc]; i >= 0; i = r->m_keys[i].m_next)
+        {
+            kreversekey_t const& rk  = r->m_keys[i];
+            xcore::key_t const&  key = r->m_km->m_layers[rk.m_layer].m_keys[rk.m_key];
+
+            // a layer switch only sends its keycode when it is a layer-tap
+            if (key.m_layer_switch != 0 && key.m_layer_switch != LT)
+                continue;
+
+            // text_match is -1 for a keycode query, 0 for the normal and 1 for the shifted text
+            u16 const shifted = key_sent_mods(key) & (LSFT | RSFT);
+            u16       mods    = 0;
+            if (text_match == 0 && shifted != 0)
+                continue;
+            if (text_match == 1 && shifted == 0)
+                mods = LSFT;
+
+            if (nb_hits == r->m_max_scratch)
+            {
+                r->m_max_scratch = r->m_max_scratch == 0 ? 64 : r->m_max_scratch * 2;
+                r->m_scratch     = (kreversehit_t*)::realloc(r->m_scratch, sizeof(kreversehit_t) * r->m_max_scratch);
+            }
+            kreversehit_t& hit = r->m_scratch[nb_hits++];
+            hit.m_layer        = rk.m_layer;
+            hit.m_key          = rk.m_key;
+            hit.m_mods         = mods;
+            hit.m_depth        = r->m_depth[rk.m_layer];
+        }
+    }
+
+    static s32 compare_hits(const void* a, const void* b)
+    {
+        kreversehit_t const* ha = (kreversehit_t const*)a;
+        kreversehit_t const* hb = (kreversehit_t const*)b;
+        u32 const            da = (u32)(s32)ha->m_depth; // unreachable (-1) sorts last
+        u32 const            db = (u32)(s32)hb->m_depth;
+        if (da != db)
+            return da < db ? -1 : 1;
+        if ((ha->m_mods == 0) != (hb->m_mods == 0))
+            return ha->m_mods == 0 ? -1 : 1;
+        if (ha->m_layer != hb->m_layer)
+            return ha->m_layer - hb->m_layer;
+        return ha->m_key - hb->m_key;
+    }
+
+    static s32 sort_hits(kreverse_t* r, s32 nb_hits, kreversehit_t* hits, s32 max_hits)
+    {
+        qsort(r->m_scratch, nb_hits, sizeof(kreversehit_t), compare_hits);
+        if (nb_hits > max_hits)
+            nb_hits = max_hits;
+        memcpy(hits, r->m_scratch, sizeof(kreversehit_t) * nb_hits);
+        return nb_hits;
+    }
+
+    s32 reverse_find_keycode(kreverse_t* r, s32 keycode, kreversehit_t* hits, s32 max_hits)
+    {
+        if (keycode < 0 || keycode >= r->m_nb_heads)
+            return 0;
+        s32 nb_hits = 0;
+        add_hits(r, nb_hits, keycode, -1);
+        return sort_hits(r, nb_hits, hits, max_hits);
+    }
+
+    s32 reverse_find(kreverse_t* r, const char* query, kreversehit_t* hits, s32 max_hits)
+    {
+        if (query == nullptr || query[0] == 0 || r->m_nb_buckets == 0)
+            return 0;
+
+        s32       nb_hits = 0;
+        s32 const kc      = lookup_keycode_index(r->m_kcdb, query, (s32)strlen(query));
+        if (kc >= 0 && kc < r->m_nb_heads)
+            add_hits(r, nb_hits, kc, -1);
+
+        for (s32 t = r->m_buckets[hash_text(query) & (r->m_nb_buckets - 1)]; t >= 0; t = r->m_texts[t].m_next)
+        {
+            kreversetext_t const& text = r->m_texts[t];
+            if (strcmp(text.m_text, query) != 0 || (text.m_kc == kc && text.m_shifted == 0))
+                continue;
+            add_hits(r, nb_hits, text.m_kc, text.m_shifted);
+        }
+        return sort_hits(r, nb_hits, hits, max_hits);
+    }
+
+    s32 reverse_path(kreverse_t* r, s32 layer, kreversestep_t* steps, s32 max_steps)
+    {
+        if (layer < 0 || layer >= r->m_nb_layers || r->m_depth[layer] < 0)
+            return -1;
+
+        // walk back from the layer to the base layer, the steps are written base layer first
+        s32 const nb_steps = r->m_depth[layer];
+        for (s32 l = layer, i = nb_steps - 1; i >= 0; l = r->m_parent[l].m_layer, --i)
+        {
+            if (i < max_steps)
+                steps[i] = r->m_parent[l];
+        }
+        return nb_steps;
+    }
+
+} // namespace xcore
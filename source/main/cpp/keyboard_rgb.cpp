@@ -0,0 +1,455 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_layout.h"
+#include "qmk-keymap-wiz/keyboard_profile.h"
+#include "qmk-keymap-wiz/keyboard_rgb.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QKW_RGB_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace xcore
+{
+    // -----------------------------------------------------------------------------------------------------------------
+    // 4 floats at a time, SSE2 or plain arrays that the compiler may vectorize on its own
+
+#ifdef QKW_RGB_SSE2
+    typedef __m128 f4;
+
+    static inline f4   f4_load(float const* p) { return _mm_loadu_ps(p); }
+    static inline void f4_store(float* p, f4 v) { _mm_storeu_ps(p, v); }
+    static inline f4   f4_set(float v) { return _mm_set1_ps(v); }
+    static inline f4   f4_add(f4 a, f4 b) { return _mm_add_ps(a, b); }
+    static inline f4   f4_sub(f4 a, f4 b) { return _mm_sub_ps(a, b); }
+    static inline f4   f4_mul(f4 a, f4 b) { return _mm_mul_ps(a, b); }
+    static inline f4   f4_min(f4 a, f4 b) { return _mm_min_ps(a, b); }
+    static inline f4   f4_max(f4 a, f4 b) { return _mm_max_ps(a, b); }
+    static inline f4   f4_abs(f4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+    static inline f4   f4_sqrt(f4 a) { return _mm_sqrt_ps(a); }
+    static inline f4   f4_frac(f4 a) { return _mm_sub_ps(a, _mm_cvtepi32_ps(_mm_cvttps_epi32(a))); } // a >= 0
+
+    // IM_COL32 order, red in the low byte
+    static inline void f4_pack(u32* p, f4 r, f4 g, f4 b, f4 a)
+    {
+        f4 const      scale = _mm_set1_ps(255.0f);
+        f4 const      half  = _mm_set1_ps(0.5f);
+        __m128i const ir    = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(r, scale), half));
+        __m128i const ig    = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(g, scale), half));
+        __m128i const ib    = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(b, scale), half));
+        __m128i const ia    = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(a, scale), half));
+        __m128i const c     = _mm_or_si128(_mm_or_si128(ir, _mm_slli_epi32(ig, 8)), _mm_or_si128(_mm_slli_epi32(ib, 16), _mm_slli_epi32(ia, 24)));
+        _mm_storeu_si128((__m128i*)p, c);
+    }
+#else
+    struct f4
+    {
+        float v[4];
+    };
+
+#define QKW_F4_OP(name, expr)                  \
+    static inline f4 name(f4 a, f4 b)          \
+    {                                          \
+        f4 r;                                  \
+        for (s32 i = 0; i < 4; ++i)            \
+            r.v[i] = expr;                     \
+        return r;                              \
+    }
+
+    QKW_F4_OP(f4_add, a.v[i] + b.v[i])
+    QKW_F4_OP(f4_sub, a.v[i] - b.v[i])
+    QKW_F4_OP(f4_mul, a.v[i] * b.v[i])
+    QKW_F4_OP(f4_min, a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+    QKW_F4_OP(f4_max, a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+#undef QKW_F4_OP
+
+    static inline f4 f4_load(float const* p)
+    {
+        f4 r;
+        memcpy(r.v, p, sizeof(r.v));
+        return r;
+    }
+    static inline void f4_store(float* p, f4 v) { memcpy(p, v.v, sizeof(v.v)); }
+    static inline f4   f4_set(float v)
+    {
+        f4 r;
+        for (s32 i = 0; i < 4; ++i)
+            r.v[i] = v;
+        return r;
+    }
+    static inline f4 f4_abs(f4 a)
+    {
+        for (s32 i = 0; i < 4; ++i)
+            a.v[i] = fabsf(a.v[i]);
+        return a;
+    }
+    static inline f4 f4_sqrt(f4 a)
+    {
+        for (s32 i = 0; i < 4; ++i)
+            a.v[i] = sqrtf(a.v[i]);
+        return a;
+    }
+    static inline f4 f4_frac(f4 a)
+    {
+        for (s32 i = 0; i < 4; ++i)
+            a.v[i] = a.v[i] - (float)(s32)a.v[i];
+        return a;
+    }
+    static inline void f4_pack(u32* p, f4 r, f4 g, f4 b, f4 a)
+    {
+        for (s32 i = 0; i < 4; ++i)
+            p[i] = (u32)(r.v[i] * 255.0f + 0.5f) | ((u32)(g.v[i] * 255.0f + 0.5f) << 8) | ((u32)(b.v[i] * 255.0f + 0.5f) << 16) | ((u32)(a.v[i] * 255.0f + 0.5f) << 24);
+    }
+#endif
+
+    static inline f4 f4_sat(f4 a) { return f4_min(f4_max(a, f4_set(0.0f)), f4_set(1.0f)); }
+
+    // -----------------------------------------------------------------------------------------------------------------
+
+    enum
+    {
+        RGB_GRID_W = 224, // the LED grid of QMK's g_led_config
+        RGB_GRID_H = 64,
+    };
+
+    // the rates at speed 1
+    static const float s_cycle_hz       = 0.25f;  // hue cycles per second
+    static const float s_breathing_hz   = 0.5f;   // breaths per second
+    static const float s_reactive_s     = 1.0f;   // fade out of a pressed key
+    static const float s_splash_speed   = 160.0f; // grid units per second
+    static const float s_splash_width   = 24.0f;  // grid units
+    static const float s_splash_s       = 1.5f;   // life of a splash
+    static const float s_never_pressed  = -1.0e6f;
+
+    struct krgb_t
+    {
+        ckeyboard_t const* m_kb;
+        s32                m_nb_leds;
+        s32                m_nb_padded; // a multiple of 4
+
+        // one allocation, m_nb_padded floats per array
+        float* m_block;
+        float* m_x; // 0..224
+        float* m_y; // 0..64
+        float* m_r; // LED color, 0..1
+        float* m_g;
+        float* m_b;
+        float* m_a;
+        float* m_hit; // time of the last press
+        float* m_out_r;
+        float* m_out_g;
+        float* m_out_b;
+        u32*   m_glow; // 3 rings of m_nb_padded colors
+
+        s16* m_led_keys; // the keymap index of every LED
+        s32  m_nb_key_leds;
+        s32* m_key_leds; // the LED of every keymap index, -1 for none
+
+        bool   m_has_epoch;
+        double m_epoch; // time 0 of the float times
+
+        s32   m_next_hit;
+        float m_hit_x[RGB_MAX_HITS];
+        float m_hit_y[RGB_MAX_HITS];
+        float m_hit_t[RGB_MAX_HITS];
+    };
+
+    const char* rgb_effect_name(s32 effect)
+    {
+        static const char* s_names[RGB_NB_EFFECTS] = {"solid", "breathing", "cycle all", "cycle left right", "cycle out in", "reactive", "splash"};
+        return effect >= 0 && effect < RGB_NB_EFFECTS ? s_names[effect] : "?";
+    }
+
+    krgb_t* rgb_create()
+    {
+        krgb_t* rgb = (krgb_t*)::malloc(sizeof(krgb_t));
+        memset(rgb, 0, sizeof(krgb_t));
+        return rgb;
+    }
+
+    static void rgb_free(krgb_t* rgb)
+    {
+        ::free(rgb->m_block);
+        ::free(rgb->m_led_keys);
+        ::free(rgb->m_key_leds);
+        memset(rgb, 0, sizeof(krgb_t));
+    }
+
+    void rgb_destroy(krgb_t* rgb)
+    {
+        if (rgb == nullptr)
+            return;
+        rgb_free(rgb);
+        ::free(rgb);
+    }
+
+    static float rgb_time(krgb_t* rgb, double time)
+    {
+        if (!rgb->m_has_epoch)
+        {
+            rgb->m_has_epoch = true;
+            rgb->m_epoch     = time;
+        }
+        return (float)(time - rgb->m_epoch);
+    }
+
+    void rgb_build(krgb_t* rgb, ckeyboard_t const* kb)
+    {
+        rgb_free(rgb);
+        rgb->m_kb = kb;
+
+        s32 const    max_places = keyboard_nb_keys(kb);
+        ckeyplace_t* places     = (ckeyplace_t*)::malloc(sizeof(ckeyplace_t) * (max_places + 1));
+        s32 const    nb_leds    = keyboard_layout(kb, 0.0f, 0.0f, 1.0f, places, max_places);
+        s32 const    nb_padded  = (nb_leds + 3) & ~3;
+
+        rgb->m_nb_leds   = nb_leds;
+        rgb->m_nb_padded = nb_padded;
+        rgb->m_block     = (float*)::calloc((size_t)nb_padded * 13 + 4, sizeof(float));
+        rgb->m_x         = rgb->m_block;
+        rgb->m_y         = rgb->m_x + nb_padded;
+        rgb->m_r         = rgb->m_y + nb_padded;
+        rgb->m_g         = rgb->m_r + nb_padded;
+        rgb->m_b         = rgb->m_g + nb_padded;
+        rgb->m_a         = rgb->m_b + nb_padded;
+        rgb->m_hit       = rgb->m_a + nb_padded;
+        rgb->m_out_r     = rgb->m_hit + nb_padded;
+        rgb->m_out_g     = rgb->m_out_r + nb_padded;
+        rgb->m_out_b     = rgb->m_out_g + nb_padded;
+        rgb->m_glow      = (u32*)(rgb->m_out_b + nb_padded);
+        rgb->m_led_keys  = (s16*)::malloc(sizeof(s16) * (nb_padded + 1));
+
+        // the key centers scaled to the LED grid, like the coordinates of g_led_config
+        float minx = 0.0f, miny = 0.0f, maxx = 0.0f, maxy = 0.0f;
+        s32   max_index = -1;
+        for (s32 i = 0; i < nb_leds; ++i)
+        {
+            minx      = (i == 0 || places[i].m_x < minx) ? places[i].m_x : minx;
+            miny      = (i == 0 || places[i].m_y < miny) ? places[i].m_y : miny;
+            maxx      = (i == 0 || places[i].m_x > maxx) ? places[i].m_x : maxx;
+            maxy      = (i == 0 || places[i].m_y > maxy) ? places[i].m_y : maxy;
+            max_index = places[i].m_key->m_index > max_index ? places[i].m_key->m_index : max_index;
+        }
+        float const sx = maxx > minx ? (float)RGB_GRID_W / (maxx - minx) : 0.0f;
+        float const sy = maxy > miny ? (float)RGB_GRID_H / (maxy - miny) : 0.0f;
+
+        rgb->m_nb_key_leds = max_index + 1;
+        rgb->m_key_leds    = (s32*)::malloc(sizeof(s32) * (max_index + 2));
+        for (s32 k = 0; k <= max_index; ++k)
+            rgb->m_key_leds[k] = -1;
+
+        for (s32 i = 0; i < nb_padded; ++i)
+        {
+            rgb->m_hit[i]      = s_never_pressed;
+            rgb->m_led_keys[i] = -1;
+        }
+        for (s32 i = 0; i < nb_leds; ++i)
+        {
+            ckeyplace_t const& place = places[i];
+            rgb->m_x[i]              = (place.m_x - minx) * sx;
+            rgb->m_y[i]              = (place.m_y - miny) * sy;
+            rgb->m_r[i]              = (float)place.m_ledcolor[0] / 255.0f;
+            rgb->m_g[i]              = (float)place.m_ledcolor[1] / 255.0f;
+            rgb->m_b[i]              = (float)place.m_ledcolor[2] / 255.0f;
+            rgb->m_a[i]              = (float)place.m_ledcolor[3] / 255.0f;
+            rgb->m_led_keys[i]       = place.m_key->m_index;
+            if (place.m_key->m_index >= 0 && rgb->m_key_leds[place.m_key->m_index] < 0)
+                rgb->m_key_leds[place.m_key->m_index] = i;
+        }
+        ::free(places);
+
+        rgb->m_has_epoch = false;
+        rgb->m_epoch     = 0.0;
+        rgb->m_next_hit  = 0;
+        for (s32 h = 0; h < RGB_MAX_HITS; ++h)
+            rgb->m_hit_t[h] = s_never_pressed;
+    }
+
+    ckeyboard_t const* rgb_keyboard(krgb_t* rgb) { return rgb->m_kb; }
+    s32                rgb_nb_leds(krgb_t* rgb) { return rgb->m_nb_leds; }
+    u32 const*         rgb_glow(krgb_t* rgb, s32 ring) { return rgb->m_glow + (size_t)ring * rgb->m_nb_padded; }
+
+    void rgb_colors(krgb_t* rgb, keymap_t const* km, s32 layer)
+    {
+        if (km == nullptr || layer < 0 || layer >= km->m_nb_layers)
+            return;
+        layer_t const& l = km->m_layers[layer];
+        for (s32 i = 0; i < rgb->m_nb_leds; ++i)
+        {
+            s32 const key   = rgb->m_led_keys[i];
+            u8 const* color = (key >= 0 && key < l.m_nb_keys) ? l.m_keys[key].m_ledcolor : l.m_ledcolor;
+            rgb->m_r[i]     = (float)color[0] / 255.0f;
+            rgb->m_g[i]     = (float)color[1] / 255.0f;
+            rgb->m_b[i]     = (float)color[2] / 255.0f;
+            rgb->m_a[i]     = (float)color[3] / 255.0f;
+        }
+    }
+
+    void rgb_hit(krgb_t* rgb, s32 key, double time)
+    {
+        if (key < 0 || key >= rgb->m_nb_key_leds || rgb->m_key_leds[key] < 0)
+            return;
+        s32 const   led = rgb->m_key_leds[key];
+        float const t   = rgb_time(rgb, time);
+        rgb->m_hit[led] = t;
+
+        s32 const h     = rgb->m_next_hit;
+        rgb->m_hit_x[h] = rgb->m_x[led];
+        rgb->m_hit_y[h] = rgb->m_y[led];
+        rgb->m_hit_t[h] = t;
+        rgb->m_next_hit = (h + 1) % RGB_MAX_HITS;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // the kernels, every one writes m_out_r/g/b for all (padded) LEDs
+
+    // hue 0..1 to a saturated color, branch free
+    static inline void hue_rgb(f4 hue, f4& r, f4& g, f4& b)
+    {
+        f4 const h6 = f4_mul(hue, f4_set(6.0f));
+        r           = f4_sat(f4_sub(f4_abs(f4_sub(h6, f4_set(3.0f))), f4_set(1.0f)));
+        g           = f4_sat(f4_sub(f4_set(2.0f), f4_abs(f4_sub(h6, f4_set(2.0f)))));
+        b           = f4_sat(f4_sub(f4_set(2.0f), f4_abs(f4_sub(h6, f4_set(4.0f)))));
+    }
+
+    static void kernel_scale(krgb_t* rgb, float factor)
+    {
+        f4 const f = f4_set(factor);
+        for (s32 i = 0; i < rgb->m_nb_padded; i += 4)
+        {
+            f4_store(rgb->m_out_r + i, f4_mul(f4_load(rgb->m_r + i), f));
+            f4_store(rgb->m_out_g + i, f4_mul(f4_load(rgb->m_g + i), f));
+            f4_store(rgb->m_out_b + i, f4_mul(f4_load(rgb->m_b + i), f));
+        }
+    }
+
+    // hue = phase + x * kx + distance from the center * kd
+    static void kernel_cycle(krgb_t* rgb, float phase, float kx, float kd)
+    {
+        f4 const cx = f4_set((float)RGB_GRID_W / 2.0f);
+        f4 const cy = f4_set((float)RGB_GRID_H / 2.0f);
+        for (s32 i = 0; i < rgb->m_nb_padded; i += 4)
+        {
+            f4 const dx  = f4_sub(f4_load(rgb->m_x + i), cx);
+            f4 const dy  = f4_sub(f4_load(rgb->m_y + i), cy);
+            f4 const d   = f4_sqrt(f4_add(f4_mul(dx, dx), f4_mul(dy, dy)));
+            f4 const hue = f4_frac(f4_add(f4_add(f4_set(phase), f4_mul(f4_load(rgb->m_x + i), f4_set(kx))), f4_mul(d, f4_set(kd))));
+            f4       r, g, b;
+            hue_rgb(hue, r, g, b);
+            f4_store(rgb->m_out_r + i, r);
+            f4_store(rgb->m_out_g + i, g);
+            f4_store(rgb->m_out_b + i, b);
+        }
+    }
+
+    static void kernel_reactive(krgb_t* rgb, float t, float speed)
+    {
+        f4 const now  = f4_set(t);
+        f4 const fade = f4_set(speed / s_reactive_s);
+        for (s32 i = 0; i < rgb->m_nb_padded; i += 4)
+        {
+            f4 const e = f4_sat(f4_sub(f4_set(1.0f), f4_mul(f4_sub(now, f4_load(rgb->m_hit + i)), fade)));
+            f4_store(rgb->m_out_r + i, f4_mul(f4_load(rgb->m_r + i), e));
+            f4_store(rgb->m_out_g + i, f4_mul(f4_load(rgb->m_g + i), e));
+            f4_store(rgb->m_out_b + i, f4_mul(f4_load(rgb->m_b + i), e));
+        }
+    }
+
+    static void kernel_splash(krgb_t* rgb, float t, float speed)
+    {
+        // the waves that are still going, the rest adds nothing
+        s32   nb_waves = 0;
+        float wx[RGB_MAX_HITS], wy[RGB_MAX_HITS], wr[RGB_MAX_HITS], wf[RGB_MAX_HITS];
+        for (s32 h = 0; h < RGB_MAX_HITS; ++h)
+        {
+            float const age = (t - rgb->m_hit_t[h]) * speed;
+            if (age < 0.0f || age >= s_splash_s)
+                continue;
+            wx[nb_waves] = rgb->m_hit_x[h];
+            wy[nb_waves] = rgb->m_hit_y[h];
+            wr[nb_waves] = age * s_splash_speed;
+            wf[nb_waves] = 1.0f - age / s_splash_s;
+            nb_waves += 1;
+        }
+
+        f4 const inv_width = f4_set(1.0f / s_splash_width);
+        for (s32 i = 0; i < rgb->m_nb_padded; i += 4)
+        {
+            f4 const x = f4_load(rgb->m_x + i);
+            f4 const y = f4_load(rgb->m_y + i);
+            f4       e = f4_set(0.0f);
+            for (s32 w = 0; w < nb_waves; ++w)
+            {
+                f4 const dx    = f4_sub(x, f4_set(wx[w]));
+                f4 const dy    = f4_sub(y, f4_set(wy[w]));
+                f4 const d     = f4_sqrt(f4_add(f4_mul(dx, dx), f4_mul(dy, dy)));
+                f4 const crest = f4_sat(f4_sub(f4_set(1.0f), f4_mul(f4_abs(f4_sub(d, f4_set(wr[w]))), inv_width)));
+                e              = f4_add(e, f4_mul(crest, f4_set(wf[w])));
+            }
+            e = f4_sat(e);
+
+            // the LED color dimmed, the crest of a wave goes towards white
+            f4 const dim   = f4_add(f4_set(0.25f), f4_mul(e, f4_set(0.75f)));
+            f4 const white = f4_mul(e, f4_set(0.5f));
+            f4_store(rgb->m_out_r + i, f4_sat(f4_add(f4_mul(f4_load(rgb->m_r + i), dim), white)));
+            f4_store(rgb->m_out_g + i, f4_sat(f4_add(f4_mul(f4_load(rgb->m_g + i), dim), white)));
+            f4_store(rgb->m_out_b + i, f4_sat(f4_add(f4_mul(f4_load(rgb->m_b + i), dim), white)));
+        }
+    }
+
+    // the three glow rings of keyboard_render, the outer two darker and more transparent
+    static void kernel_glow(krgb_t* rgb, float brightness)
+    {
+        u32* ring0 = rgb->m_glow;
+        u32* ring1 = ring0 + rgb->m_nb_padded;
+        u32* ring2 = ring1 + rgb->m_nb_padded;
+        f4 const v = f4_set(brightness);
+        for (s32 i = 0; i < rgb->m_nb_padded; i += 4)
+        {
+            f4 const r = f4_sat(f4_mul(f4_load(rgb->m_out_r + i), v));
+            f4 const g = f4_sat(f4_mul(f4_load(rgb->m_out_g + i), v));
+            f4 const b = f4_sat(f4_mul(f4_load(rgb->m_out_b + i), v));
+            f4 const a = f4_load(rgb->m_a + i);
+
+            f4 const d0 = f4_set(0.8f);
+            f4 const d1 = f4_set(0.9f);
+            f4_pack(ring0 + i, f4_mul(r, d0), f4_mul(g, d0), f4_mul(b, d0), f4_sat(f4_sub(a, f4_mul(b, f4_set(0.5f)))));
+            f4_pack(ring1 + i, f4_mul(r, d1), f4_mul(g, d1), f4_mul(b, d1), f4_sat(f4_sub(a, f4_mul(b, f4_set(0.25f)))));
+            f4_pack(ring2 + i, r, g, b, a);
+        }
+    }
+
+    void rgb_update(krgb_t* rgb, krgbparams_t const& params, double time)
+    {
+        kprofilescope_t zone(PROFILE_RGB);
+
+        if (rgb->m_nb_leds == 0)
+            return;
+        float const  t     = rgb_time(rgb, time);
+        float const  speed = params.m_speed > 0.0f ? params.m_speed : 0.0f;
+        double const phase = (double)t * speed * s_cycle_hz;
+
+        switch (params.m_effect)
+        {
+            case RGB_BREATHING:
+            {
+                float const s = sinf((float)fmod((double)t * speed * s_breathing_hz, 1.0) * 6.2831853f);
+                kernel_scale(rgb, 0.5f + 0.5f * s);
+                break;
+            }
+            case RGB_CYCLE_ALL: kernel_cycle(rgb, (float)(phase - floor(phase)), 0.0f, 0.0f); break;
+            case RGB_CYCLE_LEFT_RIGHT: kernel_cycle(rgb, (float)(phase - floor(phase)), 1.0f / (float)RGB_GRID_W, 0.0f); break;
+            case RGB_CYCLE_OUT_IN: kernel_cycle(rgb, 1.0f + (float)(phase - floor(phase)), 0.0f, -1.0f / (float)RGB_GRID_W); break;
+            case RGB_REACTIVE: kernel_reactive(rgb, t, speed); break;
+            case RGB_SPLASH: kernel_splash(rgb, t, speed); break;
+            default: kernel_scale(rgb, 1.0f); break;
+        }
+        kernel_glow(rgb, params.m_brightness);
+    }
+
+} // namespace xcore
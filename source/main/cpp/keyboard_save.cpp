@@ -0,0 +1,654 @@
+#include "xbase/x_target.h"
+
+#include "qmk-keymap-wiz/keyboard_save.h"
+#include "qmk-keymap-wiz/keyboard_files.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace xcore
+{
+    static const key_t s_default_key;
+
+    static bool same_color(u8 const* a, u8 const* b) { return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3]; }
+
+    static void encode_color(kwriter_t& w, const char* name, u8 const* color)
+    {
+        writer_str(w, ", \"");
+        writer_str(w, name);
+        writer_str(w, "\": [");
+        for (s32 i = 0; i < 4; ++i)
+        {
+            if (i > 0)
+                writer_char(w, ',');
+            writer_int(w, color[i]);
+        }
+        writer_char(w, ']');
+    }
+
+    void encode_key(kwriter_t& w, key_t const& key)
+    {
+        writer_str(w, "{ \"keycode\": ");
+        writer_json_str(w, key.m_keycode_str != nullptr ? key.m_keycode_str : "KC_NO");
+        if (key.m_mod != 0)
+        {
+            writer_str(w, ", \"mod\": \"");
+            bool first = true;
+            for (s32 bit = 0; key_mod_str(bit) != nullptr; ++bit)
+            {
+                if ((key.m_mod & (1 << bit)) == 0)
+                    continue;
+                if (!first)
+                    writer_char(w, '|');
+                writer_str(w, key_mod_str(bit));
+                first = false;
+            }
+            writer_char(w, '"');
+        }
+        if (key.m_mod_tap)
+            writer_str(w, ", \"mod_tap\": true");
+        if (key.m_layer_switch != 0)
+        {
+            writer_str(w, ", \"layer_switch\": ");
+            writer_int(w, key.m_layer_switch);
+        }
+        if (key.m_layer != nullptr && key.m_layer[0] != '\0')
+        {
+            writer_str(w, ", \"layer\": ");
+            writer_json_str(w, key.m_layer);
+        }
+        if (!same_color(key.m_capcolor, s_default_key.m_capcolor))
+            encode_color(w, "cap_color", key.m_capcolor);
+        if (!same_color(key.m_ledcolor, s_default_key.m_ledcolor))
+            encode_color(w, "led_color", key.m_ledcolor);
+        writer_str(w, " }");
+    }
+
+    static void encode_color_line(kwriter_t& w, const char* name, u8 const* color)
+    {
+        writer_spaces(w, 20);
+        writer_char(w, '"');
+        writer_str(w, name);
+        writer_str(w, "\": [");
+        for (s32 i = 0; i < 4; ++i)
+        {
+            if (i > 0)
+                writer_char(w, ',');
+            writer_int(w, color[i]);
+        }
+        writer_str(w, "],\n");
+    }
+
+    // A layer is written with the indentation it has inside of a keymaps file, so that cached layer fragments can
+    // be concatenated without re-formatting.
+    void encode_layer(kwriter_t& w, layer_t const& layer)
+    {
+        writer_spaces(w, 16);
+        writer_str(w, "{\n");
+        writer_spaces(w, 20);
+        writer_str(w, "\"name\": ");
+        writer_json_str(w, layer.m_name != nullptr ? layer.m_name : "");
+        writer_str(w, ",\n");
+        writer_spaces(w, 20);
+        writer_str(w, "\"index\": ");
+        writer_int(w, layer.m_index);
+        writer_str(w, ",\n");
+        encode_color_line(w, "cap_color", layer.m_capcolor);
+        encode_color_line(w, "led_color", layer.m_ledcolor);
+        writer_spaces(w, 20);
+        writer_str(w, "\"keymap\": [\n");
+        for (s32 i = 0; i < layer.m_nb_keys; ++i)
+        {
+            writer_spaces(w, 20);
+            encode_key(w, layer.m_keys[i]);
+            writer_str(w, i + 1 < layer.m_nb_keys ? ",\n" : "\n");
+        }
+        writer_spaces(w, 20);
+        writer_str(w, "]\n");
+        writer_spaces(w, 16);
+        writer_char(w, '}');
+    }
+
+    static void encode_file_header(kwriter_t& w) { writer_str(w, "{\n    \"keymaps\": [\n"); }
+    static void encode_file_footer(kwriter_t& w) { writer_str(w, "\n    ]\n}\n"); }
+
+    static void encode_keymap_header(kwriter_t& w, keymap_t const& km, bool first)
+    {
+        if (!first)
+            writer_str(w, ",\n");
+        writer_spaces(w, 8);
+        writer_str(w, "{\n");
+        writer_spaces(w, 12);
+        writer_str(w, "\"name\": ");
+        writer_json_str(w, km.m_name != nullptr ? km.m_name : "");
+        writer_str(w, ",\n");
+        writer_spaces(w, 12);
+        writer_str(w, "\"layers\": [\n");
+    }
+
+    static void encode_keymap_footer(kwriter_t& w)
+    {
+        writer_char(w, '\n');
+        writer_spaces(w, 12);
+        writer_str(w, "]\n");
+        writer_spaces(w, 8);
+        writer_char(w, '}');
+    }
+
+    void encode_keymaps(kwriter_t& w, keymaps_t const* keymaps)
+    {
+        encode_file_header(w);
+        for (s32 k = 0; keymaps != nullptr && k < keymaps->m_nb_keymaps; ++k)
+        {
+            keymap_t const& km = keymaps->m_keymaps[k];
+            encode_keymap_header(w, km, k == 0);
+            for (s32 l = 0; l < km.m_nb_layers; ++l)
+            {
+                if (l > 0)
+                    writer_str(w, ",\n");
+                encode_layer(w, km.m_layers[l]);
+            }
+            encode_keymap_footer(w);
+        }
+        encode_file_footer(w);
+    }
+
+    // --------------------------------------------------------------------------------------------------------------------------
+    // --------------------------------------------------------------------------------------------------------------------------
+    static const ckeyboard_t s_default_keyboard;
+    static const ckeygroup_t s_default_keygroup;
+    static const ckey_t      s_default_ckey;
+
+    // at most 4 decimals, without trailing zeros, 1.2500 -> 1.25
+    static void encode_number(kwriter_t& w, float value)
+    {
+        char str[64];
+        s32  len = snprintf(str, sizeof(str), "%.4f", (double)value);
+        while (len > 1 && str[len - 1] == '0')
+            len--;
+        if (len > 1 && str[len - 1] == '.')
+            len--;
+        if (len == 2 && str[0] == '-' && str[1] == '0')
+        {
+            str[0] = '0';
+            len    = 1;
+        }
+        writer_write(w, str, len);
+    }
+
+    static void encode_number_field(kwriter_t& w, const char* name, float value, float default_value)
+    {
+        if (value == default_value)
+            return;
+        writer_str(w, ", \"");
+        writer_str(w, name);
+        writer_str(w, "\": ");
+        encode_number(w, value);
+    }
+
+    static void encode_color_field(kwriter_t& w, const char* name, u8 const* color, s32 size)
+    {
+        if (color == nullptr || size <= 0)
+            return;
+        writer_str(w, ", \"");
+        writer_str(w, name);
+        writer_str(w, "\": [");
+        for (s32 i = 0; i < size; ++i)
+        {
+            if (i > 0)
+                writer_char(w, ',');
+            writer_int(w, color[i]);
+        }
+        writer_char(w, ']');
+    }
+
+    static void encode_ckey(kwriter_t& w, ckey_t const& key)
+    {
+        writer_str(w, "{\"index\": ");
+        writer_int(w, key.m_index);
+        writer_str(w, ", \"label\": ");
+        writer_json_str(w, key.m_label);
+        if (key.m_nob)
+            writer_str(w, ", \"nob\": true");
+        encode_number_field(w, "w", key.m_w, s_default_ckey.m_w);
+        encode_number_field(w, "h", key.m_h, s_default_ckey.m_h);
+        encode_number_field(w, "sw", key.m_sw, s_default_ckey.m_sw);
+        encode_number_field(w, "sh", key.m_sh, s_default_ckey.m_sh);
+        encode_color_field(w, "cap_color", key.m_capcolor, key.m_capcolor_size);
+        encode_color_field(w, "txt_color", key.m_txtcolor, key.m_txtcolor_size);
+        encode_color_field(w, "led_color", key.m_ledcolor, key.m_ledcolor_size);
+        writer_char(w, '}');
+    }
+
+    // a line of the keyboard object, after the line before it
+    static void encode_keyboard_number(kwriter_t& w, const char* name, float value, float default_value)
+    {
+        if (value == default_value)
+            return;
+        writer_str(w, ",\n");
+        writer_spaces(w, 12);
+        writer_char(w, '"');
+        writer_str(w, name);
+        writer_str(w, "\": ");
+        encode_number(w, value);
+    }
+
+    static void encode_keyboard_color(kwriter_t& w, const char* name, u8 const* color, u8 const* default_color)
+    {
+        if (same_color(color, default_color))
+            return;
+        writer_str(w, ",\n");
+        writer_spaces(w, 12);
+        writer_char(w, '"');
+        writer_str(w, name);
+        writer_str(w, "\": [");
+        for (s32 i = 0; i < 4; ++i)
+        {
+            if (i > 0)
+                writer_char(w, ',');
+            writer_int(w, color[i]);
+        }
+        writer_char(w, ']');
+    }
+
+    void encode_keyboard(kwriter_t& w, ckeyboard_t const& kb)
+    {
+        writer_spaces(w, 8);
+        writer_str(w, "{\n");
+        writer_spaces(w, 12);
+        writer_str(w, "\"name\": ");
+        writer_json_str(w, kb.m_name != nullptr ? kb.m_name : "");
+        encode_keyboard_number(w, "scale", kb.m_scale, s_default_keyboard.m_scale);
+        encode_keyboard_number(w, "key_width", kb.m_w, s_default_keyboard.m_w);
+        encode_keyboard_number(w, "key_height", kb.m_h, s_default_keyboard.m_h);
+        encode_keyboard_number(w, "key_spacing_x", kb.m_sw, s_default_keyboard.m_sw);
+        encode_keyboard_number(w, "key_spacing_y", kb.m_sh, s_default_keyboard.m_sh);
+        encode_keyboard_color(w, "cap_color", kb.m_capcolor, s_default_keyboard.m_capcolor);
+        encode_keyboard_color(w, "txt_color", kb.m_txtcolor, s_default_keyboard.m_txtcolor);
+        encode_keyboard_color(w, "led_color", kb.m_ledcolor, s_default_keyboard.m_ledcolor);
+        writer_str(w, ",\n");
+        writer_spaces(w, 12);
+        writer_str(w, "\"keygroups\": [\n");
+        for (s32 g = 0; g < kb.m_nb_keygroups; ++g)
+        {
+            ckeygroup_t const& kg = kb.m_keygroups[g];
+            writer_spaces(w, 16);
+            writer_char(w, '{');
+            if (kg.m_name != nullptr && kg.m_name[0] != 0)
+            {
+                writer_str(w, "\"name\": ");
+                writer_json_str(w, kg.m_name);
+                writer_str(w, ", ");
+            }
+            writer_str(w, "\"x\": ");
+            encode_number(w, kg.m_x);
+            writer_str(w, ", \"y\": ");
+            encode_number(w, kg.m_y);
+            encode_number_field(w, "w", kg.m_w, s_default_keygroup.m_w);
+            encode_number_field(w, "h", kg.m_h, s_default_keygroup.m_h);
+            encode_number_field(w, "sw", kg.m_sw, s_default_keygroup.m_sw);
+            encode_number_field(w, "sh", kg.m_sh, s_default_keygroup.m_sh);
+            writer_str(w, ", \"r\": ");
+            writer_int(w, kg.m_r);
+            writer_str(w, ", \"c\": ");
+            writer_int(w, kg.m_c);
+            if (kg.m_a != 0)
+            {
+                writer_str(w, ", \"a\": ");
+                writer_int(w, kg.m_a);
+            }
+            encode_color_field(w, "cap_color", kg.m_capcolor, kg.m_capcolor_size);
+            encode_color_field(w, "txt_color", kg.m_txtcolor, kg.m_txtcolor_size);
+            encode_color_field(w, "led_color", kg.m_ledcolor, kg.m_ledcolor_size);
+            writer_str(w, ", \"keys\": [");
+            for (s32 k = 0; k < kg.m_nb_keys; ++k)
+            {
+                if (k > 0)
+                    writer_str(w, ", ");
+                encode_ckey(w, kg.m_keys[k]);
+            }
+            writer_str(w, g + 1 < kb.m_nb_keygroups ? "]},\n" : "]}\n");
+        }
+        writer_spaces(w, 12);
+        writer_str(w, "]\n");
+        writer_spaces(w, 8);
+        writer_char(w, '}');
+    }
+
+    // --------------------------------------------------------------------------------------------------------------------------
+    // --------------------------------------------------------------------------------------------------------------------------
+    // An encoded piece of the file, shared between the saver (cache) and the queued write jobs.
+    struct kfragment_t
+    {
+        std::atomic<s32> m_refs;
+        s32              m_size;
+        char*            m_data;
+    };
+
+    // Take the output of a memory writer, the writer is closed.
+    static kfragment_t* fragment_take(kwriter_t& w)
+    {
+        kfragment_t* f = new (::malloc(sizeof(kfragment_t))) kfragment_t();
+        f->m_refs      = 1;
+        f->m_size      = w.m_size;
+        f->m_data      = w.m_buffer;
+        w.m_buffer     = nullptr;
+        writer_close(w);
+        return f;
+    }
+
+    static kfragment_t* fragment_ref(kfragment_t* f)
+    {
+        f->m_refs.fetch_add(1);
+        return f;
+    }
+
+    static void fragment_release(kfragment_t* f)
+    {
+        if (f == nullptr || f->m_refs.fetch_sub(1) != 1)
+            return;
+        ::free(f->m_data);
+        f->~kfragment_t();
+        ::free(f);
+    }
+
+    // The pieces of a file in order, separators are part of the header/footer fragments.
+    struct ksavejob_t
+    {
+        s32           m_nb_fragments;
+        s32           m_max_fragments;
+        kfragment_t** m_fragments;
+    };
+
+    static ksavejob_t* job_create(s32 max_fragments)
+    {
+        ksavejob_t* job      = (ksavejob_t*)::malloc(sizeof(ksavejob_t));
+        job->m_nb_fragments  = 0;
+        job->m_max_fragments = max_fragments;
+        job->m_fragments     = (kfragment_t**)::malloc(sizeof(kfragment_t*) * max_fragments);
+        return job;
+    }
+
+    static void job_add(ksavejob_t* job, kfragment_t* f) { job->m_fragments[job->m_nb_fragments++] = f; }
+
+    static void job_destroy(ksavejob_t* job)
+    {
+        if (job == nullptr)
+            return;
+        for (s32 i = 0; i < job->m_nb_fragments; ++i)
+            fragment_release(job->m_fragments[i]);
+        ::free(job->m_fragments);
+        ::free(job);
+    }
+
+    struct kcachedmap_t
+    {
+        s32           m_nb_layers;
+        kfragment_t** m_layers; // nullptr means dirty
+    };
+
+    struct ksaver_t
+    {
+        char* m_filename;
+        char* m_tmpname;
+
+        keymaps_t const* m_keymaps;
+        s32              m_nb_keymaps;
+        kcachedmap_t*    m_cache;
+
+        std::thread             m_thread;
+        std::mutex              m_mutex;
+        std::condition_variable m_cond;
+        ksavejob_t*             m_pending; // queued, not yet started
+        bool                    m_busy;    // the thread is writing a job
+        bool                    m_quit;
+        ksaver_stats_t          m_stats;
+    };
+
+    static void cache_release(ksaver_t* saver)
+    {
+        for (s32 k = 0; k < saver->m_nb_keymaps; ++k)
+        {
+            kcachedmap_t& cm = saver->m_cache[k];
+            for (s32 l = 0; l < cm.m_nb_layers; ++l)
+                fragment_release(cm.m_layers[l]);
+            ::free(cm.m_layers);
+        }
+        ::free(saver->m_cache);
+        saver->m_cache      = nullptr;
+        saver->m_nb_keymaps = 0;
+        saver->m_keymaps    = nullptr;
+    }
+
+    // (re)build the cache when the shape of the keymaps changed, every layer is dirty after that
+    static void cache_match(ksaver_t* saver, keymaps_t const* keymaps)
+    {
+        bool same = saver->m_keymaps == keymaps && saver->m_nb_keymaps == keymaps->m_nb_keymaps;
+        for (s32 k = 0; same && k < keymaps->m_nb_keymaps; ++k)
+            same = saver->m_cache[k].m_nb_layers == keymaps->m_keymaps[k].m_nb_layers;
+        if (same)
+            return;
+
+        cache_release(saver);
+        saver->m_keymaps    = keymaps;
+        saver->m_nb_keymaps = keymaps->m_nb_keymaps;
+        saver->m_cache      = (kcachedmap_t*)::malloc(sizeof(kcachedmap_t) * (keymaps->m_nb_keymaps > 0 ? keymaps->m_nb_keymaps : 1));
+        for (s32 k = 0; k < keymaps->m_nb_keymaps; ++k)
+        {
+            kcachedmap_t& cm = saver->m_cache[k];
+            cm.m_nb_layers   = keymaps->m_keymaps[k].m_nb_layers;
+            cm.m_layers      = (kfragment_t**)::calloc(cm.m_nb_layers > 0 ? cm.m_nb_layers : 1, sizeof(kfragment_t*));
+        }
+    }
+
+    static bool write_job(ksaver_t* saver, ksavejob_t* job, s64& bytes)
+    {
+        kwriter_t w;
+        if (!writer_open(w, saver->m_tmpname))
+        {
+            printf("error: unable to write '%s'\n", saver->m_tmpname);
+            return false;
+        }
+        for (s32 i = 0; i < job->m_nb_fragments; ++i)
+            writer_write(w, job->m_fragments[i]->m_data, job->m_fragments[i]->m_size);
+        bytes   = w.m_written;
+        bool ok = writer_sync(w);
+        ok      = writer_close(w) && ok;
+        if (ok && !replace_file(saver->m_tmpname, saver->m_filename))
+        {
+            printf("error: unable to replace '%s'\n", saver->m_filename);
+            ok = false;
+        }
+        return ok;
+    }
+
+    static void saver_thread(ksaver_t* saver)
+    {
+        std::unique_lock<std::mutex> lock(saver->m_mutex);
+        while (true)
+        {
+            saver->m_cond.wait(lock, [saver] { return saver->m_pending != nullptr || saver->m_quit; });
+            if (saver->m_pending == nullptr)
+                break;
+
+            ksavejob_t* job  = saver->m_pending;
+            saver->m_pending = nullptr;
+            saver->m_busy    = true;
+            lock.unlock();
+
+            s64  bytes = 0;
+            bool ok    = write_job(saver, job, bytes);
+            job_destroy(job);
+
+            lock.lock();
+            saver->m_busy = false;
+            if (ok)
+            {
+                saver->m_stats.m_nb_saves += 1;
+                saver->m_stats.m_nb_bytes = bytes;
+            }
+            else
+            {
+                saver->m_stats.m_nb_errors += 1;
+            }
+            saver->m_cond.notify_all();
+        }
+    }
+
+    static char* dup_str(const char* str, const char* suffix)
+    {
+        s32   len1 = (s32)strlen(str);
+        s32   len2 = (s32)strlen(suffix);
+        char* dup  = (char*)::malloc(len1 + len2 + 1);
+        memcpy(dup, str, len1);
+        memcpy(dup + len1, suffix, len2 + 1);
+        return dup;
+    }
+
+    ksaver_t* saver_create(const char* filename)
+    {
+        ksaver_t* saver     = new (::malloc(sizeof(ksaver_t))) ksaver_t();
+        saver->m_filename   = dup_str(filename, "");
+        saver->m_tmpname    = dup_str(filename, ".tmp");
+        saver->m_keymaps    = nullptr;
+        saver->m_nb_keymaps = 0;
+        saver->m_cache      = nullptr;
+        saver->m_pending    = nullptr;
+        saver->m_busy       = false;
+        saver->m_quit       = false;
+        memset(&saver->m_stats, 0, sizeof(saver->m_stats));
+        saver->m_thread = std::thread(saver_thread, saver);
+        return saver;
+    }
+
+    void saver_destroy(ksaver_t* saver)
+    {
+        if (saver == nullptr)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(saver->m_mutex);
+            saver->m_quit = true;
+        }
+        saver->m_cond.notify_all();
+        saver->m_thread.join(); // a pending job is still written before the thread exits
+        cache_release(saver);
+        ::free(saver->m_filename);
+        ::free(saver->m_tmpname);
+        saver->~ksaver_t();
+        ::free(saver);
+    }
+
+    void saver_mark_dirty(ksaver_t* saver, s32 keymap, s32 layer)
+    {
+        if (keymap < 0 || keymap >= saver->m_nb_keymaps)
+            return;
+        kcachedmap_t& cm = saver->m_cache[keymap];
+        if (layer < 0 || layer >= cm.m_nb_layers)
+            return;
+        fragment_release(cm.m_layers[layer]);
+        cm.m_layers[layer] = nullptr;
+    }
+
+    void saver_mark_all_dirty(ksaver_t* saver)
+    {
+        for (s32 k = 0; k < saver->m_nb_keymaps; ++k)
+        {
+            kcachedmap_t& cm = saver->m_cache[k];
+            for (s32 l = 0; l < cm.m_nb_layers; ++l)
+            {
+                fragment_release(cm.m_layers[l]);
+                cm.m_layers[l] = nullptr;
+            }
+        }
+    }
+
+    void saver_save(ksaver_t* saver, keymaps_t const* keymaps)
+    {
+        if (keymaps == nullptr)
+            return;
+        cache_match(saver, keymaps);
+
+        s32 nb_fragments = 2;
+        for (s32 k = 0; k < keymaps->m_nb_keymaps; ++k)
+            nb_fragments += 2 + keymaps->m_keymaps[k].m_nb_layers * 2;
+
+        s32         nb_encoded = 0;
+        s32         nb_cached  = 0;
+        ksavejob_t* job        = job_create(nb_fragments);
+
+        kwriter_t w;
+        writer_memory(w);
+        encode_file_header(w);
+        job_add(job, fragment_take(w));
+
+        for (s32 k = 0; k < keymaps->m_nb_keymaps; ++k)
+        {
+            keymap_t const& km = keymaps->m_keymaps[k];
+            kcachedmap_t&   cm = saver->m_cache[k];
+
+            writer_memory(w);
+            encode_keymap_header(w, km, k == 0);
+            job_add(job, fragment_take(w));
+
+            for (s32 l = 0; l < km.m_nb_layers; ++l)
+            {
+                if (l > 0)
+                {
+                    writer_memory(w);
+                    writer_str(w, ",\n");
+                    job_add(job, fragment_take(w));
+                }
+                if (cm.m_layers[l] == nullptr)
+                {
+                    writer_memory(w);
+                    encode_layer(w, km.m_layers[l]);
+                    cm.m_layers[l] = fragment_take(w);
+                    nb_encoded += 1;
+                }
+                else
+                {
+                    nb_cached += 1;
+                }
+                job_add(job, fragment_ref(cm.m_layers[l]));
+            }
+
+            writer_memory(w);
+            encode_keymap_footer(w);
+            job_add(job, fragment_take(w));
+        }
+
+        writer_memory(w);
+        encode_file_footer(w);
+        job_add(job, fragment_take(w));
+
+        ksavejob_t* replaced = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(saver->m_mutex);
+            replaced                           = saver->m_pending;
+            saver->m_pending                   = job;
+            saver->m_stats.m_nb_encoded_layers = nb_encoded;
+            saver->m_stats.m_nb_cached_layers  = nb_cached;
+        }
+        saver->m_cond.notify_all();
+        job_destroy(replaced);
+    }
+
+    void saver_wait(ksaver_t* saver)
+    {
+        std::unique_lock<std::mutex> lock(saver->m_mutex);
+        saver->m_cond.wait(lock, [saver] { return saver->m_pending == nullptr && !saver->m_busy; });
+    }
+
+    void saver_stats(ksaver_t* saver, ksaver_stats_t& stats)
+    {
+        std::lock_guard<std::mutex> lock(saver->m_mutex);
+        stats = saver->m_stats;
+    }
+
+} // namespace xcore
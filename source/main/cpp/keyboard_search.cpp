@@ -0,0 +1,605 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_search.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace xcore
+{
+    // the trigrams of a single keycode
+    struct ksearchdoc_t
+    {
+        u64 m_hash; // of all the text of the keycode, to find it back in the previous build
+        s32 m_offset;
+        s32 m_count;
+        s32 m_codes; // offset in m_text of the lower-case code and aliases, a list of strings ending with ""
+        s32 m_other; // offset in m_text of the lower-case normal, shifted and description text, same format
+    };
+
+    // an entry of the sorted list for prefix searches
+    struct ksearchname_t
+    {
+        const char* m_name; // in m_text
+        s32         m_doc;
+        s32         m_code; // 1 for a code or alias, 0 for the normal or shifted text
+    };
+
+
+    struct ksearch_t
+    {
+        keycodes_t const* m_kcdb;
+
+        s32           m_nb_docs;
+        ksearchdoc_t* m_docs;
+        s32           m_nb_doc_trigrams;
+        u32*          m_doc_trigrams;
+
+        // the index, m_postings[m_offsets[i] .. m_offsets[i + 1]] are the keycodes that contain m_trigrams[i]
+        s32  m_nb_trigrams;
+        u32* m_trigrams;
+        s32* m_offsets;
+        s32  m_nb_postings;
+        s32* m_postings;
+
+        s32            m_nb_names;
+        ksearchname_t* m_names;
+
+        s32   m_text_size;
+        s32   m_text_max;
+        char* m_text;
+
+        // per query state, one counter per keycode, only the touched ones are reset
+        s32* m_counts;
+        s32* m_touched;
+
+        s32 m_nb_reused;
+        s32 m_nb_extracted;
+    };
+
+    ksearch_t* search_create()
+    {
+        ksearch_t* s         = (ksearch_t*)::malloc(sizeof(ksearch_t));
+        s->m_kcdb            = nullptr;
+        s->m_nb_docs         = 0;
+        s->m_docs            = nullptr;
+        s->m_nb_doc_trigrams = 0;
+        s->m_doc_trigrams    = nullptr;
+        s->m_nb_trigrams     = 0;
+        s->m_trigrams        = nullptr;
+        s->m_offsets         = nullptr;
+        s->m_nb_postings     = 0;
+        s->m_postings        = nullptr;
+        s->m_nb_names        = 0;
+        s->m_names           = nullptr;
+        s->m_text_size       = 0;
+        s->m_text_max        = 0;
+        s->m_text            = nullptr;
+        s->m_counts          = nullptr;
+        s->m_touched         = nullptr;
+        s->m_nb_reused       = 0;
+        s->m_nb_extracted    = 0;
+        return s;
+    }
+
+    void search_destroy(ksearch_t* s)
+    {
+        if (s == nullptr)
+            return;
+        ::free(s->m_docs);
+        ::free(s->m_doc_trigrams);
+        ::free(s->m_trigrams);
+        ::free(s->m_offsets);
+        ::free(s->m_postings);
+        ::free(s->m_names);
+        ::free(s->m_text);
+        ::free(s->m_counts);
+        ::free(s->m_touched);
+        ::free(s);
+    }
+
+    static inline char lower(char c) { return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c; }
+
+    static u64 hash_str(u64 h, const char* str)
+    {
+        if (str != nullptr)
+        {
+            while (*str != 0)
+            {
+                h ^= (u8)*str++;
+                h *= 0x100000001b3ull;
+            }
+        }
+        h ^= 0xff; // separator, so that "ab" + "c" differs from "a" + "bc"
+        h *= 0x100000001b3ull;
+        return h;
+    }
+
+    static u64 hash_keycode(keycode_t const& kc)
+    {
+        u64 h = 0xcbf29ce484222325ull;
+        h     = hash_str(h, kc.m_code);
+        for (s32 i = 0; i < kc.m_nb_codes; ++i)
+            h = hash_str(h, kc.m_codes[i]);
+        h = hash_str(h, kc.m_normal);
+        h = hash_str(h, kc.m_shifted);
+        h = hash_str(h, kc.m_descr);
+        return h;
+    }
+
+    static s32 compare_u32(const void* a, const void* b)
+    {
+        u32 const x = *(u32 const*)a;
+        u32 const y = *(u32 const*)b;
+        return x < y ? -1 : (x > y ? 1 : 0);
+    }
+
+    static s32 compare_u64(const void* a, const void* b)
+    {
+        u64 const x = *(u64 const*)a;
+        u64 const y = *(u64 const*)b;
+        return x < y ? -1 : (x > y ? 1 : 0);
+    }
+
+    struct khashindex_t
+    {
+        u64 m_hash;
+        s32 m_index;
+    };
+
+    static s32 compare_hashes(const void* a, const void* b) { return compare_u64(&((khashindex_t const*)a)->m_hash, &((khashindex_t const*)b)->m_hash); }
+
+    // adds the trigrams of a string, returns the new count
+    static s32 add_trigrams(const char* str, u32* trigrams, s32 count, s32 max_count)
+    {
+        if (str == nullptr)
+            return count;
+        s32 const len = (s32)strlen(str);
+        for (s32 i = 0; i + 3 <= len && count < max_count; ++i)
+            trigrams[count++] = ((u32)(u8)lower(str[i]) << 16) | ((u32)(u8)lower(str[i + 1]) << 8) | (u32)(u8)lower(str[i + 2]);
+        return count;
+    }
+
+    static s32 keycode_text_len(keycode_t const& kc)
+    {
+        s32 len = kc.m_code != nullptr ? (s32)strlen(kc.m_code) : 0;
+        for (s32 i = 0; i < kc.m_nb_codes; ++i)
+            len += (s32)strlen(kc.m_codes[i]) + 1;
+        len += kc.m_normal != nullptr ? (s32)strlen(kc.m_normal) : 0;
+        len += kc.m_shifted != nullptr ? (s32)strlen(kc.m_shifted) : 0;
+        len += kc.m_descr != nullptr ? (s32)strlen(kc.m_descr) : 0;
+        return len;
+    }
+
+    static s32 text_append(ksearch_t* s, const char* str)
+    {
+        s32 const offset = s->m_text_size;
+        s32 const len    = str != nullptr ? (s32)strlen(str) : 0;
+        for (s32 i = 0; i < len; ++i)
+            s->m_text[s->m_text_size++] = lower(str[i]);
+        s->m_text[s->m_text_size++] = 0;
+        return offset;
+    }
+
+    static void add_name(ksearch_t* s, s32 offset, s32 doc, s32 code)
+    {
+        ksearchname_t& name = s->m_names[s->m_nb_names++];
+        name.m_name         = s->m_text + offset;
+        name.m_doc          = doc;
+        name.m_code         = code;
+    }
+
+    static s32 compare_names(const void* a, const void* b)
+    {
+        ksearchname_t const* x = (ksearchname_t const*)a;
+        ksearchname_t const* y = (ksearchname_t const*)b;
+        s32 const            c = strcmp(x->m_name, y->m_name);
+        return c != 0 ? c : (x->m_doc - y->m_doc);
+    }
+
+    // the names of the keycodes that were taken from the previous build, in the order of the previous build, returns
+    // the count; the text of such a keycode is identical, only its offset in m_text (and its index) can differ
+    static s32 carry_names(ksearch_t const* s, ksearchname_t const* old_names, s32 old_nb_names, const char* old_text, ksearchdoc_t const* old_docs, s32 const* old_to_new, ksearchname_t* names)
+    {
+        s32 count = 0;
+        for (s32 i = 0; i < old_nb_names; ++i)
+        {
+            ksearchname_t const& old = old_names[i];
+            s32 const            doc = old_to_new[old.m_doc];
+            if (doc < 0)
+                continue;
+            ksearchname_t& name = names[count++];
+            name.m_name         = s->m_text + s->m_docs[doc].m_codes + (s32)(old.m_name - old_text - old_docs[old.m_doc].m_codes);
+            name.m_doc          = doc;
+            name.m_code         = old.m_code;
+        }
+        return count;
+    }
+
+    static void merge_names(ksearchname_t const* a, s32 nb_a, ksearchname_t const* b, s32 nb_b, ksearchname_t* names)
+    {
+        s32 i = 0;
+        s32 j = 0;
+        while (i < nb_a && j < nb_b)
+            *names++ = compare_names(&a[i], &b[j]) <= 0 ? a[i++] : b[j++];
+        while (i < nb_a)
+            *names++ = a[i++];
+        while (j < nb_b)
+            *names++ = b[j++];
+    }
+
+    void search_build(ksearch_t* s, keycodes_t const* kcdb)
+    {
+        s32 const nb_docs = kcdb != nullptr ? kcdb->m_nb_keycodes : 0;
+
+        // the previous build, sorted on hash so that unchanged keycodes can be found back
+        s32 const     old_nb_docs  = s->m_nb_docs;
+        ksearchdoc_t* old_docs     = s->m_docs;
+        u32*          old_trigrams = s->m_doc_trigrams;
+        khashindex_t* old_hashes   = (khashindex_t*)::malloc(sizeof(khashindex_t) * (old_nb_docs + 1));
+        for (s32 i = 0; i < old_nb_docs; ++i)
+        {
+            old_hashes[i].m_hash  = old_docs[i].m_hash;
+            old_hashes[i].m_index = i;
+        }
+        qsort(old_hashes, old_nb_docs, sizeof(khashindex_t), compare_hashes);
+
+        // the sorted names of the previous build, the names of unchanged keycodes keep their order
+        s32 const      old_nb_names = s->m_nb_names;
+        ksearchname_t* old_names    = s->m_names;
+        char*          old_text     = s->m_text;
+        s32*           old_to_new   = (s32*)::malloc(sizeof(s32) * (old_nb_docs + 1));
+        for (s32 i = 0; i < old_nb_docs; ++i)
+            old_to_new[i] = -1;
+
+        s32 text_max = 1;
+        s32 nb_names = 0;
+        s32 max_tris = 0;
+        for (s32 i = 0; i < nb_docs; ++i)
+        {
+            keycode_t const& kc = kcdb->m_keycodes[i];
+            s32 const        len = keycode_text_len(kc);
+            text_max += len + kc.m_nb_codes + 8;
+            nb_names += (kc.m_nb_codes + 1) * 2 + 2;
+            max_tris += len;
+        }
+
+        s->m_kcdb         = kcdb;
+        s->m_nb_docs      = nb_docs;
+        s->m_docs         = (ksearchdoc_t*)::malloc(sizeof(ksearchdoc_t) * (nb_docs + 1));
+        s->m_doc_trigrams = (u32*)::malloc(sizeof(u32) * (max_tris + 1));
+        s->m_text_max     = text_max;
+        s->m_text_size    = 0;
+        s->m_text         = (char*)::malloc(text_max);
+        s->m_names        = (ksearchname_t*)::malloc(sizeof(ksearchname_t) * (nb_names + 1));
+        s->m_nb_names     = 0;
+        s->m_nb_reused    = 0;
+        s->m_nb_extracted = 0;
+
+        s32 nb_doc_trigrams = 0;
+        for (s32 i = 0; i < nb_docs; ++i)
+        {
+            keycode_t const& kc  = kcdb->m_keycodes[i];
+            ksearchdoc_t&    doc = s->m_docs[i];
+            doc.m_hash           = hash_keycode(kc);
+            doc.m_offset         = nb_doc_trigrams;
+
+            s32 lo = 0;
+            s32 hi = old_nb_docs;
+            while (lo < hi)
+            {
+                s32 const mid = (lo + hi) / 2;
+                if (old_hashes[mid].m_hash < doc.m_hash)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            ksearchdoc_t const* old = (lo < old_nb_docs && old_hashes[lo].m_hash == doc.m_hash) ? &old_docs[old_hashes[lo].m_index] : nullptr;
+
+            // only one keycode can take over the names of a previous one, a duplicate adds its own
+            bool const carried = old != nullptr && old_to_new[old_hashes[lo].m_index] < 0;
+            if (carried)
+                old_to_new[old_hashes[lo].m_index] = i;
+
+            if (old != nullptr)
+            {
+                memcpy(s->m_doc_trigrams + nb_doc_trigrams, old_trigrams + old->m_offset, sizeof(u32) * old->m_count);
+                doc.m_count = old->m_count;
+                s->m_nb_reused += 1;
+            }
+            else
+            {
+                u32* tris  = s->m_doc_trigrams + nb_doc_trigrams;
+                s32  count = add_trigrams(kc.m_code, tris, 0, max_tris);
+                for (s32 c = 0; c < kc.m_nb_codes; ++c)
+                    count = add_trigrams(kc.m_codes[c], tris, count, max_tris);
+                count = add_trigrams(kc.m_normal, tris, count, max_tris);
+                count = add_trigrams(kc.m_shifted, tris, count, max_tris);
+                count = add_trigrams(kc.m_descr, tris, count, max_tris);
+
+                qsort(tris, count, sizeof(u32), compare_u32);
+                s32 unique = 0;
+                for (s32 t = 0; t < count; ++t)
+                {
+                    if (unique == 0 || tris[unique - 1] != tris[t])
+                        tris[unique++] = tris[t];
+                }
+                doc.m_count = unique;
+                s->m_nb_extracted += 1;
+            }
+            nb_doc_trigrams += doc.m_count;
+
+            // lower-case text for ranking and the names for prefix searches
+            doc.m_codes = s->m_text_size;
+            for (s32 c = -1; c < kc.m_nb_codes; ++c)
+            {
+                const char* code = c < 0 ? kc.m_code : kc.m_codes[c];
+                if (code == nullptr || code[0] == 0)
+                    continue;
+                s32 const offset = text_append(s, code);
+                if (carried)
+                    continue;
+                add_name(s, offset, i, 1);
+                if (strncmp(s->m_text + offset, "kc_", 3) == 0)
+                    add_name(s, offset + 3, i, 1);
+            }
+            s->m_text[s->m_text_size++] = 0;
+
+            doc.m_other = s->m_text_size;
+            if (kc.m_normal != nullptr && kc.m_normal[0] != 0)
+            {
+                s32 const offset = text_append(s, kc.m_normal);
+                if (!carried)
+                    add_name(s, offset, i, 0);
+            }
+            if (kc.m_shifted != nullptr && kc.m_shifted[0] != 0)
+            {
+                s32 const offset = text_append(s, kc.m_shifted);
+                if (!carried)
+                    add_name(s, offset, i, 0);
+            }
+            if (kc.m_descr != nullptr && kc.m_descr[0] != 0)
+                text_append(s, kc.m_descr);
+            s->m_text[s->m_text_size++] = 0;
+        }
+        s->m_nb_doc_trigrams = nb_doc_trigrams;
+
+        // only the names of the extracted keycodes are sorted, they are merged with the carried ones which are still
+        // sorted unless keycodes with equal names changed their order in the database
+        qsort(s->m_names, s->m_nb_names, sizeof(ksearchname_t), compare_names);
+        ksearchname_t* carry    = (ksearchname_t*)::malloc(sizeof(ksearchname_t) * (nb_names + 1));
+        s32 const      nb_carry = carry_names(s, old_names, old_nb_names, old_text, old_docs, old_to_new, carry);
+        for (s32 i = 1; i < nb_carry; ++i)
+        {
+            if (compare_names(&carry[i - 1], &carry[i]) > 0)
+            {
+                qsort(carry, nb_carry, sizeof(ksearchname_t), compare_names);
+                break;
+            }
+        }
+        ksearchname_t* names = (ksearchname_t*)::malloc(sizeof(ksearchname_t) * (nb_names + 1));
+        merge_names(s->m_names, s->m_nb_names, carry, nb_carry, names);
+        ::free(s->m_names);
+        ::free(carry);
+        s->m_names = names;
+        s->m_nb_names += nb_carry;
+
+        ::free(old_docs);
+        ::free(old_trigrams);
+        ::free(old_hashes);
+        ::free(old_names);
+        ::free(old_text);
+        ::free(old_to_new);
+
+        // the inverted index, (trigram << 16 | keycode) pairs sorted on trigram then keycode
+        u64* pairs = (u64*)::malloc(sizeof(u64) * (nb_doc_trigrams + 1));
+        s32  n     = 0;
+        for (s32 i = 0; i < nb_docs; ++i)
+        {
+            ksearchdoc_t const& doc = s->m_docs[i];
+            for (s32 t = 0; t < doc.m_count; ++t)
+                pairs[n++] = ((u64)s->m_doc_trigrams[doc.m_offset + t] << 32) | (u64)i;
+        }
+        qsort(pairs, n, sizeof(u64), compare_u64);
+
+        s->m_trigrams    = (u32*)::realloc(s->m_trigrams, sizeof(u32) * (n + 1));
+        s->m_offsets     = (s32*)::realloc(s->m_offsets, sizeof(s32) * (n + 2));
+        s->m_postings    = (s32*)::realloc(s->m_postings, sizeof(s32) * (n + 1));
+        s->m_nb_trigrams = 0;
+        s->m_nb_postings = n;
+        for (s32 i = 0; i < n; ++i)
+        {
+            u32 const trigram = (u32)(pairs[i] >> 32);
+            if (s->m_nb_trigrams == 0 || s->m_trigrams[s->m_nb_trigrams - 1] != trigram)
+            {
+                s->m_offsets[s->m_nb_trigrams]  = i;
+                s->m_trigrams[s->m_nb_trigrams] = trigram;
+                s->m_nb_trigrams += 1;
+            }
+            s->m_postings[i] = (s32)(pairs[i] & 0xffffffff);
+        }
+        s->m_offsets[s->m_nb_trigrams] = n;
+        ::free(pairs);
+
+        s->m_counts  = (s32*)::realloc(s->m_counts, sizeof(s32) * (nb_docs + 1));
+        s->m_touched = (s32*)::realloc(s->m_touched, sizeof(s32) * (nb_docs + 1));
+        for (s32 i = 0; i < nb_docs; ++i)
+            s->m_counts[i] = 0;
+    }
+
+    // the lines of 'text' (separated by '\0', ending with an empty line) that 'query' matches
+    static s32 match_lines(const char* text, const char* query, s32 qlen, s32 exact, s32 prefix, s32 contains)
+    {
+        s32 best = 0;
+        while (*text != 0)
+        {
+            s32 const len = (s32)strlen(text);
+            s32       score;
+            if (len == qlen && memcmp(text, query, qlen) == 0)
+                score = exact;
+            else if (strncmp(text, query, qlen) == 0 || (strncmp(text, "kc_", 3) == 0 && strncmp(text + 3, query, qlen) == 0))
+                score = prefix;
+            else if (strstr(text, query) != nullptr)
+                score = contains;
+            else
+                score = 0;
+            if (score > best)
+                best = score;
+            text += len + 1;
+        }
+        return best;
+    }
+
+    // on equal scores the keycode that comes first in the database wins
+    static inline bool better(s32 score, keycode_t const* kc, ksearchhit_t const& hit) { return score > hit.m_score || (score == hit.m_score && kc < hit.m_keycode); }
+
+    static void add_hit(ksearchhit_t* hits, s32& nb_hits, s32 max_hits, keycode_t const* kc, s32 score)
+    {
+        // insertion into the sorted list of the best 'max_hits'
+        s32 i;
+        if (nb_hits < max_hits)
+        {
+            i = nb_hits++;
+        }
+        else
+        {
+            if (!better(score, kc, hits[max_hits - 1]))
+                return;
+            i = max_hits - 1;
+        }
+        while (i > 0 && better(score, kc, hits[i - 1]))
+        {
+            hits[i] = hits[i - 1];
+            --i;
+        }
+        hits[i].m_keycode = kc;
+        hits[i].m_score   = score;
+    }
+
+    s32 search_keycodes(ksearch_t* s, const char* query, ksearchhit_t* hits, s32 max_hits)
+    {
+        if (s->m_kcdb == nullptr || query == nullptr || max_hits <= 0)
+            return 0;
+
+        char q[64];
+        s32  qlen = 0;
+        while (*query == ' ')
+            ++query;
+        while (*query != 0 && qlen < (s32)sizeof(q) - 1)
+            q[qlen++] = lower(*query++);
+        while (qlen > 0 && q[qlen - 1] == ' ')
+            --qlen;
+        q[qlen] = 0;
+        if (qlen == 0)
+            return 0;
+
+        s32 nb_touched = 0;
+        if (qlen < 3)
+        {
+            // prefix search on the sorted names
+            s32 lo = 0;
+            s32 hi = s->m_nb_names;
+            while (lo < hi)
+            {
+                s32 const mid = (lo + hi) / 2;
+                if (strcmp(s->m_names[mid].m_name, q) < 0)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            for (; lo < s->m_nb_names; ++lo)
+            {
+                ksearchname_t const& name = s->m_names[lo];
+                const char*          str  = name.m_name;
+                if (strncmp(str, q, qlen) != 0)
+                    break;
+                s32 const exact = str[qlen] == 0;
+                s32 const score = name.m_code ? (exact ? 1000 : 500) : (exact ? 800 : 200);
+                if (s->m_counts[name.m_doc] == 0)
+                    s->m_touched[nb_touched++] = name.m_doc;
+                if (score > s->m_counts[name.m_doc])
+                    s->m_counts[name.m_doc] = score;
+            }
+        }
+        else
+        {
+            // count the trigrams of the query that every keycode has
+            u32 tris[64];
+            s32 nb_tris = add_trigrams(q, tris, 0, 64);
+            qsort(tris, nb_tris, sizeof(u32), compare_u32);
+            s32 unique = 0;
+            for (s32 t = 0; t < nb_tris; ++t)
+            {
+                if (unique == 0 || tris[unique - 1] != tris[t])
+                    tris[unique++] = tris[t];
+            }
+            nb_tris = unique;
+
+            for (s32 t = 0; t < nb_tris; ++t)
+            {
+                s32 lo = 0;
+                s32 hi = s->m_nb_trigrams;
+                while (lo < hi)
+                {
+                    s32 const mid = (lo + hi) / 2;
+                    if (s->m_trigrams[mid] < tris[t])
+                        lo = mid + 1;
+                    else
+                        hi = mid;
+                }
+                if (lo == s->m_nb_trigrams || s->m_trigrams[lo] != tris[t])
+                    continue;
+                for (s32 p = s->m_offsets[lo]; p < s->m_offsets[lo + 1]; ++p)
+                {
+                    s32 const doc = s->m_postings[p];
+                    if (s->m_counts[doc]++ == 0)
+                        s->m_touched[nb_touched++] = doc;
+                }
+            }
+
+            // a candidate shares at least a third of the trigrams of the query (typos), it is ranked on the fraction
+            // of shared trigrams and on where the query is found as a whole
+            for (s32 i = 0; i < nb_touched; ++i)
+            {
+                s32 const doc    = s->m_touched[i];
+                s32 const shared = s->m_counts[doc];
+                s32       score  = 0;
+                if (shared * 3 >= nb_tris)
+                {
+                    ksearchdoc_t const& d = s->m_docs[doc];
+                    score                 = (shared * 100) / nb_tris;
+                    s32 const in_codes    = match_lines(s->m_text + d.m_codes, q, qlen, 1000, 500, 300);
+                    s32 const in_other    = match_lines(s->m_text + d.m_other, q, qlen, 800, 200, 150);
+                    score += in_codes > in_other ? in_codes : in_other;
+                }
+                s->m_counts[doc] = score > 0 ? score : -1;
+            }
+        }
+
+        s32 nb_hits = 0;
+        for (s32 i = 0; i < nb_touched; ++i)
+        {
+            s32 const doc = s->m_touched[i];
+            if (s->m_counts[doc] > 0)
+            {
+                // shorter codes first among equals, 'KC_A' before 'KC_APP'
+                keycode_t const* kc    = &s->m_kcdb->m_keycodes[doc];
+                s32 const        score = s->m_counts[doc] * 64 - (kc->m_code != nullptr ? (s32)strlen(kc->m_code) : 0);
+                add_hit(hits, nb_hits, max_hits, kc, score);
+            }
+            s->m_counts[doc] = 0;
+        }
+        return nb_hits;
+    }
+
+    void search_stats(ksearch_t* s, ksearch_stats_t& stats)
+    {
+        stats.m_nb_keycodes  = s->m_nb_docs;
+        stats.m_nb_trigrams  = s->m_nb_trigrams;
+        stats.m_nb_postings  = s->m_nb_postings;
+        stats.m_nb_reused    = s->m_nb_reused;
+        stats.m_nb_extracted = s->m_nb_extracted;
+    }
+
+} // namespace xcore
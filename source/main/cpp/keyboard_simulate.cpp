@@ -0,0 +1,698 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_files.h"
+#include "qmk-keymap-wiz/keyboard_keycode.h"
+#include "qmk-keymap-wiz/keyboard_simulate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace xcore
+{
+    enum
+    {
+        SIM_MAX_LAYERS = 32,
+        SIM_MAX_QUEUE  = 64, // events held back while a tap-hold key is undecided
+
+        SIM_KC_NO       = 0x0000,
+        SIM_KC_TRNS     = 0x0001,
+        SIM_KC_FIRST    = 0x0004, // KC_A, the first keycode of the boot keyboard report
+        SIM_KC_LAST     = 0x00A4, // KC_EXSEL
+        SIM_KC_MOD_LCTL = 0x00E0,
+        SIM_KC_MOD_RGUI = 0x00E7,
+
+        SIM_KEY_UP   = 0,
+        SIM_KEY_DOWN = 1,
+        SIM_KEY_HOLD = 2, // a tap-hold key that turned into a hold
+    };
+
+    struct ksim_t
+    {
+        ksimparams_t m_params;
+        s32          m_nb_layers;
+        s32          m_nb_keys;
+        u32          m_layers_mask; // the layers that exist
+        u16*         m_codes;       // m_nb_layers * m_nb_keys, the QMK value of every key
+        u16*         m_pressed;     // the value a key was pressed with
+        u32*         m_presses;     // m_nb_presses when the key was pressed
+        u8*          m_down;        // SIM_KEY_UP, SIM_KEY_DOWN or SIM_KEY_HOLD
+
+        u32  m_now;
+        u32  m_nb_presses;
+        u32  m_layer_state;
+        u32  m_default_state;
+        u8   m_mods;         // modifier keys, mod-taps and one-shot modifiers that are held
+        u8   m_weak_mods;    // modifier wrappers, LCTL(KC_C)
+        u8   m_oneshot_mods; // tapped one-shot modifiers, applied to the next key
+        s32  m_oneshot_layer;
+        bool m_oneshot_held;
+        u8   m_keys[6];
+
+        // the undecided tap-hold key and the events after it
+        s32         m_pending_key;
+        u32         m_pending_time;
+        u16         m_pending_code;
+        s32         m_nb_queued;
+        ksimevent_t m_queue[SIM_MAX_QUEUE];
+
+        // consecutive taps of a TT key
+        s32 m_tap_key;
+        u32 m_tap_time;
+        s32 m_tap_count;
+
+        ksimreport_t  m_report;
+        ksimreport_t* m_out;
+        s32           m_max_out;
+        s32           m_nb_out;
+        ksimstats_t   m_stats;
+    };
+
+    static inline s32 top_bit(u32 mask)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return 31 - __builtin_clz(mask);
+#else
+        s32 bit = 31;
+        while ((mask & (1u << bit)) == 0)
+            bit -= 1;
+        return bit;
+#endif
+    }
+
+    // the 5-bit QMK modifier mask as HID modifier bits, both use the order control, shift, alt, gui
+    static inline u8 hid_mods(u32 qmods) { return (qmods & QMOD_RIGHT) != 0 ? (u8)((qmods & 0x0F) << 4) : (u8)(qmods & 0x0F); }
+
+    static inline bool is_tap_hold(u16 code)
+    {
+        return (code >= QK_MOD_TAP && code <= QK_LAYER_TAP_MAX) || (code >= QK_LAYER_TAP_TOGGLE && code < QK_LAYER_TAP_TOGGLE + 0x20);
+    }
+
+    static inline bool is_one_shot(u16 code) { return code >= QK_ONE_SHOT_LAYER && code < QK_ONE_SHOT_MOD + 0x20; }
+
+    ksim_t* sim_create(keymap_t const* km, ksimparams_t const& params)
+    {
+        s32 const nb_layers = km->m_nb_layers < SIM_MAX_LAYERS ? km->m_nb_layers : SIM_MAX_LAYERS;
+        s32       nb_keys   = 0;
+        for (s32 l = 0; l < nb_layers; ++l)
+            nb_keys = km->m_layers[l].m_nb_keys > nb_keys ? km->m_layers[l].m_nb_keys : nb_keys;
+
+        ksim_t* sim        = (ksim_t*)::malloc(sizeof(ksim_t));
+        sim->m_params      = params;
+        sim->m_nb_layers   = nb_layers;
+        sim->m_nb_keys     = nb_keys;
+        sim->m_layers_mask = nb_layers >= 32 ? ~0u : ((1u << nb_layers) - 1);
+        sim->m_codes       = (u16*)::malloc(sizeof(u16) * ((size_t)nb_layers * nb_keys + 1));
+        sim->m_pressed     = (u16*)::malloc(sizeof(u16) * (nb_keys + 1));
+        sim->m_presses     = (u32*)::malloc(sizeof(u32) * (nb_keys + 1));
+        sim->m_down        = (u8*)::malloc(nb_keys + 1);
+
+        // a key that a layer does not have is transparent, a key without a QMK encoding does nothing
+        for (s32 l = 0; l < nb_layers; ++l)
+        {
+            layer_t const& layer = km->m_layers[l];
+            u16*           codes = &sim->m_codes[(size_t)l * nb_keys];
+            for (s32 k = 0; k < nb_keys; ++k)
+            {
+                if (k >= layer.m_nb_keys)
+                    codes[k] = SIM_KC_TRNS;
+                else
+                    codes[k] = layer.m_keys[k].m_code == KEYCODE_INVALID ? (u16)SIM_KC_NO : layer.m_keys[k].m_code;
+            }
+        }
+
+        sim_reset(sim);
+        return sim;
+    }
+
+    void sim_destroy(ksim_t* sim)
+    {
+        if (sim == nullptr)
+            return;
+        ::free(sim->m_codes);
+        ::free(sim->m_pressed);
+        ::free(sim->m_presses);
+        ::free(sim->m_down);
+        ::free(sim);
+    }
+
+    void sim_reset(ksim_t* sim)
+    {
+        memset(sim->m_down, SIM_KEY_UP, sim->m_nb_keys + 1);
+        memset(sim->m_keys, 0, sizeof(sim->m_keys));
+        memset(&sim->m_report, 0, sizeof(sim->m_report));
+        memset(&sim->m_stats, 0, sizeof(sim->m_stats));
+        sim->m_now           = 0;
+        sim->m_nb_presses    = 0;
+        sim->m_layer_state   = 0;
+        sim->m_default_state = 1;
+        sim->m_mods          = 0;
+        sim->m_weak_mods     = 0;
+        sim->m_oneshot_mods  = 0;
+        sim->m_oneshot_layer = -1;
+        sim->m_oneshot_held  = false;
+        sim->m_pending_key   = -1;
+        sim->m_pending_time  = 0;
+        sim->m_pending_code  = 0;
+        sim->m_nb_queued     = 0;
+        sim->m_tap_key       = -1;
+        sim->m_tap_time      = 0;
+        sim->m_tap_count     = 0;
+        sim->m_out           = nullptr;
+        sim->m_max_out       = 0;
+        sim->m_nb_out        = 0;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // the report, sent when it differs from the last one
+
+    static void emit(ksim_t* sim, u8 extra_mods)
+    {
+        ksimreport_t r;
+        r.m_time = sim->m_now;
+        r.m_mods = sim->m_mods | sim->m_weak_mods | extra_mods;
+        memcpy(r.m_keys, sim->m_keys, sizeof(r.m_keys));
+        r.m_pad = 0;
+        if (sim_same_report(r, sim->m_report))
+            return;
+
+        sim->m_report = r;
+        sim->m_stats.m_nb_reports++;
+        if (sim->m_nb_out < sim->m_max_out)
+            sim->m_out[sim->m_nb_out++] = r;
+        else
+            sim->m_stats.m_nb_dropped++;
+    }
+
+    // a keycode of the boot keyboard report or a modifier key, a key goes into the first free slot
+    static void basic_press(ksim_t* sim, u16 kc)
+    {
+        if (kc >= SIM_KC_MOD_LCTL && kc <= SIM_KC_MOD_RGUI)
+        {
+            sim->m_mods |= (u8)(1 << (kc - SIM_KC_MOD_LCTL));
+            emit(sim, 0);
+            return;
+        }
+        if (kc < SIM_KC_FIRST || kc > SIM_KC_LAST)
+        {
+            if (kc != SIM_KC_NO && kc != SIM_KC_TRNS)
+                sim->m_stats.m_nb_unhandled++;
+            return;
+        }
+
+        s32 free_slot = -1;
+        for (s32 i = 0; i < 6; ++i)
+        {
+            if (sim->m_keys[i] == kc)
+                return;
+            if (sim->m_keys[i] == 0 && free_slot < 0)
+                free_slot = i;
+        }
+        if (free_slot < 0)
+        {
+            sim->m_stats.m_nb_rollover++;
+            return;
+        }
+        sim->m_keys[free_slot] = (u8)kc;
+
+        // tapped one-shot modifiers go out with this key and are gone after it
+        emit(sim, sim->m_oneshot_mods);
+        sim->m_oneshot_mods = 0;
+    }
+
+    static void basic_release(ksim_t* sim, u16 kc)
+    {
+        if (kc >= SIM_KC_MOD_LCTL && kc <= SIM_KC_MOD_RGUI)
+            sim->m_mods &= (u8) ~(1 << (kc - SIM_KC_MOD_LCTL));
+        else
+        {
+            for (s32 i = 0; i < 6; ++i)
+            {
+                if (sim->m_keys[i] == kc)
+                    sim->m_keys[i] = 0;
+            }
+        }
+        emit(sim, 0);
+    }
+
+    static inline void layer_on(ksim_t* sim, s32 layer) { sim->m_layer_state |= 1u << layer; }
+    static inline void layer_off(ksim_t* sim, s32 layer) { sim->m_layer_state &= ~(1u << layer); }
+
+    // the value of a key on the highest active layer that is not transparent
+    static u16 resolve(ksim_t* sim, s32 key)
+    {
+        u32 mask = (sim->m_layer_state | sim->m_default_state) & sim->m_layers_mask;
+        while (mask != 0)
+        {
+            s32 const layer = top_bit(mask);
+            u16 const code  = sim->m_codes[(size_t)layer * sim->m_nb_keys + key];
+            if (code != SIM_KC_TRNS)
+                return code;
+            mask &= ~(1u << layer);
+        }
+        return SIM_KC_NO;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // actions, a tap-hold key only gets here once it is decided to be a hold
+
+    static void action_press(ksim_t* sim, u16 code)
+    {
+        if (code <= QK_BASIC_MAX)
+            basic_press(sim, code);
+        else if (code <= QK_MODS_MAX)
+        {
+            sim->m_weak_mods |= hid_mods((code >> 8) & 0x1F);
+            basic_press(sim, code & 0xFF);
+            emit(sim, 0);
+        }
+        else if (code <= QK_MOD_TAP_MAX)
+        {
+            sim->m_mods |= hid_mods((code >> 8) & 0x1F);
+            emit(sim, 0);
+        }
+        else if (code <= QK_LAYER_TAP_MAX)
+            layer_on(sim, (code >> 8) & 0x0F);
+        else if (code <= QK_LAYER_MOD_MAX)
+        {
+            layer_on(sim, (code >> 5) & 0x0F);
+            sim->m_mods |= hid_mods(code & 0x1F);
+            emit(sim, 0);
+        }
+        else if (code < QK_MOMENTARY)
+            sim->m_layer_state = 1u << (code & 0x1F);
+        else if (code < QK_DEF_LAYER)
+            layer_on(sim, code & 0x1F);
+        else if (code < QK_TOGGLE_LAYER)
+            sim->m_default_state = 1u << (code & 0x1F);
+        else if (code < QK_ONE_SHOT_LAYER)
+            sim->m_layer_state ^= 1u << (code & 0x1F);
+        else if (code < QK_ONE_SHOT_MOD)
+        {
+            layer_on(sim, code & 0x1F);
+            sim->m_oneshot_layer = code & 0x1F;
+            sim->m_oneshot_held  = true;
+        }
+        else if (code < QK_LAYER_TAP_TOGGLE)
+        {
+            sim->m_mods |= hid_mods(code & 0x1F);
+            emit(sim, 0);
+        }
+        else if (code < QK_LAYER_TAP_TOGGLE + 0x20)
+            layer_on(sim, code & 0x1F);
+        else
+            sim->m_stats.m_nb_unhandled++;
+    }
+
+    static void action_release(ksim_t* sim, s32 key, u16 code)
+    {
+        // a one-shot key is tapped when no other key was pressed while it was held
+        bool const alone = sim->m_nb_presses == sim->m_presses[key];
+
+        if (code <= QK_BASIC_MAX)
+            basic_release(sim, code);
+        else if (code <= QK_MODS_MAX)
+        {
+            sim->m_weak_mods &= (u8)~hid_mods((code >> 8) & 0x1F);
+            basic_release(sim, code & 0xFF);
+        }
+        else if (code <= QK_MOD_TAP_MAX)
+        {
+            sim->m_mods &= (u8)~hid_mods((code >> 8) & 0x1F);
+            emit(sim, 0);
+        }
+        else if (code <= QK_LAYER_TAP_MAX)
+            layer_off(sim, (code >> 8) & 0x0F);
+        else if (code <= QK_LAYER_MOD_MAX)
+        {
+            layer_off(sim, (code >> 5) & 0x0F);
+            sim->m_mods &= (u8)~hid_mods(code & 0x1F);
+            emit(sim, 0);
+        }
+        else if (code >= QK_MOMENTARY && code < QK_DEF_LAYER)
+            layer_off(sim, code & 0x1F);
+        else if (code >= QK_ONE_SHOT_LAYER && code < QK_ONE_SHOT_MOD)
+        {
+            sim->m_oneshot_held = false;
+            if (!alone && sim->m_oneshot_layer == (code & 0x1F))
+            {
+                layer_off(sim, code & 0x1F);
+                sim->m_oneshot_layer = -1;
+            }
+        }
+        else if (code >= QK_ONE_SHOT_MOD && code < QK_LAYER_TAP_TOGGLE)
+        {
+            u8 const mods = hid_mods(code & 0x1F);
+            sim->m_mods &= (u8)~mods;
+            if (alone)
+                sim->m_oneshot_mods |= mods;
+            emit(sim, 0);
+        }
+        else if (code >= QK_LAYER_TAP_TOGGLE && code < QK_LAYER_TAP_TOGGLE + 0x20)
+            layer_off(sim, code & 0x1F);
+    }
+
+    static void action_tap(ksim_t* sim, s32 key, u16 code)
+    {
+        if (code < QK_LAYER_TAP_TOGGLE)
+        {
+            // LT and MT send their keycode
+            basic_press(sim, code & 0xFF);
+            basic_release(sim, code & 0xFF);
+            return;
+        }
+
+        // TT, taps in a row within the tapping term of each other count up to the toggle
+        if (sim->m_tap_key == key && sim->m_now - sim->m_tap_time <= sim->m_params.m_tapping_term)
+            sim->m_tap_count += 1;
+        else
+            sim->m_tap_count = 1;
+        sim->m_tap_key  = key;
+        sim->m_tap_time = sim->m_now;
+        if (sim->m_tap_count >= sim->m_params.m_tapping_toggle)
+        {
+            sim->m_layer_state ^= 1u << (code & 0x1F);
+            sim->m_tap_count = 0;
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // events
+
+    static void sim_event(ksim_t* sim, ksimevent_t const& e);
+
+    static void key_press(ksim_t* sim, s32 key)
+    {
+        if (sim->m_down[key] != SIM_KEY_UP)
+            return;
+        sim->m_nb_presses += 1;
+        if (key != sim->m_tap_key)
+            sim->m_tap_key = -1;
+
+        u16 const code = resolve(sim, key);
+
+        // a tapped one-shot layer is used up by the key that is pressed on it
+        if (sim->m_oneshot_layer >= 0 && !sim->m_oneshot_held && !is_one_shot(code))
+        {
+            layer_off(sim, sim->m_oneshot_layer);
+            sim->m_oneshot_layer = -1;
+        }
+
+        sim->m_pressed[key] = code;
+        sim->m_presses[key] = sim->m_nb_presses;
+        sim->m_down[key]    = SIM_KEY_DOWN;
+        if (is_tap_hold(code))
+        {
+            sim->m_pending_key  = key;
+            sim->m_pending_time = sim->m_now;
+            sim->m_pending_code = code;
+            return;
+        }
+        action_press(sim, code);
+    }
+
+    static void key_release(ksim_t* sim, s32 key)
+    {
+        u8 const state = sim->m_down[key];
+        if (state == SIM_KEY_UP)
+            return;
+        sim->m_down[key] = SIM_KEY_UP;
+        u16 const code   = sim->m_pressed[key];
+        if (!is_tap_hold(code) || state == SIM_KEY_HOLD)
+            action_release(sim, key, code);
+    }
+
+    // the undecided key turns into a tap (it was released) or a hold, then the events that were held back follow
+    static void decide(ksim_t* sim, bool hold, u32 time)
+    {
+        s32 const key  = sim->m_pending_key;
+        u16 const code = sim->m_pending_code;
+        sim->m_pending_key = -1;
+        if (sim->m_now < time)
+            sim->m_now = time;
+
+        if (hold)
+        {
+            sim->m_down[key] = SIM_KEY_HOLD;
+            action_press(sim, code);
+        }
+        else
+        {
+            sim->m_down[key] = SIM_KEY_UP;
+            action_tap(sim, key, code);
+        }
+
+        s32 const   nb_queued = sim->m_nb_queued;
+        ksimevent_t queue[SIM_MAX_QUEUE];
+        memcpy(queue, sim->m_queue, sizeof(ksimevent_t) * nb_queued);
+        sim->m_nb_queued = 0;
+        for (s32 i = 0; i < nb_queued; ++i)
+            sim_event(sim, queue[i]);
+    }
+
+    static bool queued_press(ksim_t* sim, s32 key)
+    {
+        for (s32 i = 0; i < sim->m_nb_queued; ++i)
+        {
+            if (sim->m_queue[i].m_key == key && sim->m_queue[i].m_down != 0)
+                return true;
+        }
+        return false;
+    }
+
+    static void sim_event(ksim_t* sim, ksimevent_t const& e)
+    {
+        if (e.m_key < 0 || e.m_key >= sim->m_nb_keys)
+            return;
+
+        // the tapping term passed before this event
+        while (sim->m_pending_key >= 0 && e.m_time - sim->m_pending_time >= sim->m_params.m_tapping_term)
+            decide(sim, true, sim->m_pending_time + sim->m_params.m_tapping_term);
+
+        if (sim->m_pending_key >= 0)
+        {
+            if (e.m_key == sim->m_pending_key && e.m_down == 0)
+            {
+                decide(sim, false, e.m_time);
+                return;
+            }
+
+            bool hold = sim->m_nb_queued == SIM_MAX_QUEUE;
+            if (e.m_down != 0)
+                hold = hold || sim->m_params.m_hold_on_other_key_press;
+            else
+                hold = hold || (sim->m_params.m_permissive_hold && queued_press(sim, e.m_key));
+            if (!hold)
+            {
+                sim->m_queue[sim->m_nb_queued++] = e;
+                return;
+            }
+            decide(sim, true, e.m_time);
+            sim_event(sim, e);
+            return;
+        }
+
+        if (sim->m_now < e.m_time)
+            sim->m_now = e.m_time;
+        if (e.m_down != 0)
+            key_press(sim, e.m_key);
+        else
+            key_release(sim, e.m_key);
+    }
+
+    s32 sim_run(ksim_t* sim, ksimevent_t const* events, s32 nb_events, ksimreport_t* reports, s32 max_reports)
+    {
+        sim->m_out     = reports;
+        sim->m_max_out = reports != nullptr ? max_reports : 0;
+        sim->m_nb_out  = 0;
+        for (s32 i = 0; i < nb_events; ++i)
+            sim_event(sim, events[i]);
+        sim->m_stats.m_nb_events += nb_events;
+        sim->m_out = nullptr;
+        return sim->m_nb_out;
+    }
+
+    s32 sim_tick(ksim_t* sim, u32 time, ksimreport_t* reports, s32 max_reports)
+    {
+        sim->m_out     = reports;
+        sim->m_max_out = reports != nullptr ? max_reports : 0;
+        sim->m_nb_out  = 0;
+        while (sim->m_pending_key >= 0 && time - sim->m_pending_time >= sim->m_params.m_tapping_term)
+            decide(sim, true, sim->m_pending_time + sim->m_params.m_tapping_term);
+        sim->m_out = nullptr;
+        return sim->m_nb_out;
+    }
+
+    u32  sim_layer_state(ksim_t* sim) { return sim->m_layer_state; }
+    u32  sim_default_layer_state(ksim_t* sim) { return sim->m_default_state; }
+    bool sim_key_down(ksim_t* sim, s32 key) { return key >= 0 && key < sim->m_nb_keys && sim->m_down[key] != SIM_KEY_UP; }
+    bool sim_pending(ksim_t* sim) { return sim->m_pending_key >= 0; }
+
+    s32 sim_top_layer(ksim_t* sim)
+    {
+        u32 const mask = (sim->m_layer_state | sim->m_default_state) & sim->m_layers_mask;
+        return mask != 0 ? top_bit(mask) : 0;
+    }
+
+    ksimreport_t const& sim_report(ksim_t* sim) { return sim->m_report; }
+    void                sim_stats(ksim_t* sim, ksimstats_t& stats) { stats = sim->m_stats; }
+
+    bool sim_same_report(ksimreport_t const& a, ksimreport_t const& b) { return a.m_mods == b.m_mods && memcmp(a.m_keys, b.m_keys, sizeof(a.m_keys)) == 0; }
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // event and report files
+
+    struct klines_t
+    {
+        char const* m_cursor;
+        char const* m_end;
+        s32         m_line;
+    };
+
+    static inline void skip_blanks(klines_t& p)
+    {
+        while (p.m_cursor < p.m_end && (*p.m_cursor == ' ' || *p.m_cursor == '\t' || *p.m_cursor == '\r'))
+            p.m_cursor++;
+    }
+
+    static void skip_line(klines_t& p)
+    {
+        while (p.m_cursor < p.m_end && *p.m_cursor != '\n')
+            p.m_cursor++;
+        if (p.m_cursor < p.m_end)
+            p.m_cursor++;
+        p.m_line++;
+    }
+
+    // the next line with content, false at the end of the file
+    static bool next_line(klines_t& p)
+    {
+        for (;;)
+        {
+            skip_blanks(p);
+            if (p.m_cursor == p.m_end)
+                return false;
+            if (*p.m_cursor != '\n' && *p.m_cursor != '#')
+                return true;
+            skip_line(p);
+        }
+    }
+
+    static bool parse_number(klines_t& p, u32 base, u32& value)
+    {
+        skip_blanks(p);
+        value            = 0;
+        char const* from = p.m_cursor;
+        while (p.m_cursor < p.m_end)
+        {
+            char const c = *p.m_cursor;
+            u32        d;
+            if (c >= '0' && c <= '9')
+                d = (u32)(c - '0');
+            else if (base == 16 && c >= 'a' && c <= 'f')
+                d = (u32)(c - 'a' + 10);
+            else if (base == 16 && c >= 'A' && c <= 'F')
+                d = (u32)(c - 'A' + 10);
+            else
+                break;
+            value = value * base + d;
+            p.m_cursor++;
+        }
+        return p.m_cursor != from;
+    }
+
+    template <typename T> static void grow(T*& items, s32 nb, s32& max)
+    {
+        if (nb < max)
+            return;
+        max   = max == 0 ? 1024 : max * 2;
+        items = (T*)::realloc(items, sizeof(T) * max);
+    }
+
+    bool sim_load_events(const char* filename, ksimevent_t*& events, s32& nb_events)
+    {
+        events    = nullptr;
+        nb_events = 0;
+
+        kmapping_t mapping;
+        if (!map_file(filename, mapping))
+        {
+            printf("failed to open events %s\n", filename);
+            return false;
+        }
+
+        klines_t p;
+        p.m_cursor = (char const*)mapping.m_data;
+        p.m_end    = p.m_cursor + mapping.m_size;
+        p.m_line   = 1;
+
+        s32  max_events = 0;
+        bool ok         = true;
+        while (next_line(p))
+        {
+            u32 time = 0, key = 0;
+            ok = parse_number(p, 10, time) && parse_number(p, 10, key) && key < 0x8000;
+            skip_blanks(p);
+            ok = ok && p.m_cursor < p.m_end && (*p.m_cursor == 'd' || *p.m_cursor == 'u');
+            if (!ok)
+            {
+                printf("%s(%d): expected '<time> <key> d|u'\n", filename, p.m_line);
+                break;
+            }
+            grow(events, nb_events, max_events);
+            ksimevent_t& e = events[nb_events++];
+            e.m_time       = time;
+            e.m_key        = (s16)key;
+            e.m_down       = *p.m_cursor == 'd' ? 1 : 0;
+            e.m_pad        = 0;
+            skip_line(p);
+        }
+        unmap_file(mapping);
+        return ok;
+    }
+
+    bool sim_load_reports(const char* filename, ksimreport_t*& reports, s32& nb_reports)
+    {
+        reports    = nullptr;
+        nb_reports = 0;
+
+        kmapping_t mapping;
+        if (!map_file(filename, mapping))
+        {
+            printf("failed to open reports %s\n", filename);
+            return false;
+        }
+
+        klines_t p;
+        p.m_cursor = (char const*)mapping.m_data;
+        p.m_end    = p.m_cursor + mapping.m_size;
+        p.m_line   = 1;
+
+        s32  max_reports = 0;
+        bool ok          = true;
+        while (next_line(p))
+        {
+            u32 time = 0, mods = 0, keys[6];
+            ok = parse_number(p, 10, time) && parse_number(p, 16, mods);
+            for (s32 i = 0; i < 6 && ok; ++i)
+                ok = parse_number(p, 16, keys[i]);
+            if (!ok)
+            {
+                printf("%s(%d): expected '<time> <mods> <key> x 6'\n", filename, p.m_line);
+                break;
+            }
+            grow(reports, nb_reports, max_reports);
+            ksimreport_t& r = reports[nb_reports++];
+            r.m_time        = time;
+            r.m_mods        = (u8)mods;
+            for (s32 i = 0; i < 6; ++i)
+                r.m_keys[i] = (u8)keys[i];
+            r.m_pad = 0;
+            skip_line(p);
+        }
+        unmap_file(mapping);
+        return ok;
+    }
+
+} // namespace xcore
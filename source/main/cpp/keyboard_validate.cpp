@@ -0,0 +1,264 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_keycode.h"
+#include "qmk-keymap-wiz/keyboard_validate.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace xcore
+{
+    static const char* s_diag_names[] = {"unknown_keyboard", "key_count", "unknown_keycode", "missing_layer", "unknown_layer", "invalid_switch", "lt_range", "unreachable", "layer_trap", "layer_cycle"};
+
+    const char* diag_name(ediag code) { return (code >= 0 && code < DIAG_COUNT) ? s_diag_names[code] : "unknown"; }
+
+    static s32 report(diag_fn fn, void* user, ediag code, s32 layer, s32 key, const char* detail)
+    {
+        if (fn != nullptr)
+        {
+            kdiag_t diag;
+            diag.m_code   = code;
+            diag.m_layer  = layer;
+            diag.m_key    = key;
+            diag.m_detail = detail;
+            fn(diag, user);
+        }
+        return 1;
+    }
+
+    s32 keyboard_nb_indices(ckeyboard_t const* kb)
+    {
+        s32 nb_indices = 0;
+        for (s32 g = 0; g < kb->m_nb_keygroups; ++g)
+        {
+            ckeygroup_t const& kg = kb->m_keygroups[g];
+            for (s32 k = 0; k < kg.m_nb_keys; ++k)
+            {
+                if (kg.m_keys[k].m_index >= nb_indices)
+                    nb_indices = kg.m_keys[k].m_index + 1;
+            }
+        }
+        return nb_indices;
+    }
+
+    s32 validate_key(keymap_t const* km, s32 layer, s32 key, keycodes_t const* kcdb, diag_fn fn, void* user)
+    {
+        key_t const& k        = km->m_layers[layer].m_keys[key];
+        s32          problems = 0;
+
+        if (key_keycode(kcdb, k) == nullptr)
+            problems += report(fn, user, DIAG_UNKNOWN_KEYCODE, layer, key, k.m_keycode_str);
+
+        if (k.m_layer_switch != 0)
+        {
+            // exactly one of the switch flags
+            u32 const ls = k.m_layer_switch;
+            if ((ls & ~(u32)(MO | LT | TG | TO | TT | OSL)) != 0 || (ls & (ls - 1)) != 0)
+                problems += report(fn, user, DIAG_INVALID_SWITCH, layer, key, k.m_keycode_str);
+
+            if (k.m_layer == nullptr || k.m_layer[0] == 0)
+            {
+                problems += report(fn, user, DIAG_MISSING_LAYER, layer, key, "");
+            }
+            else
+            {
+                s32 const target = find_layer(km, k.m_layer);
+                if (target < 0)
+                    problems += report(fn, user, DIAG_UNKNOWN_LAYER, layer, key, k.m_layer);
+                else if ((ls & LT) != 0 && target > 15)
+                    problems += report(fn, user, DIAG_LT_RANGE, layer, key, k.m_layer);
+            }
+        }
+        return problems;
+    }
+
+    s32 validate_keymap(keymap_t const* km, keycodes_t const* kcdb, ckeyboards_t const* kbdb, diag_fn fn, void* user)
+    {
+        s32 problems = 0;
+
+        s32                nb_indices = -1;
+        ckeyboard_t const* kb         = find_keyboard(kbdb, km->m_name);
+        if (kb == nullptr)
+            problems += report(fn, user, DIAG_UNKNOWN_KEYBOARD, -1, -1, km->m_name);
+        else
+            nb_indices = keyboard_nb_indices(kb);
+
+        for (s32 l = 0; l < km->m_nb_layers; ++l)
+        {
+            layer_t const& layer = km->m_layers[l];
+            if (nb_indices >= 0 && layer.m_nb_keys != nb_indices)
+                problems += report(fn, user, DIAG_KEY_COUNT, l, -1, layer.m_name);
+
+            for (s32 k = 0; k < layer.m_nb_keys; ++k)
+                problems += validate_key(km, l, k, kcdb, fn, user);
+        }
+        return problems;
+    }
+
+    // --------------------------------------------------------------------------------------------------------------------------
+    // --------------------------------------------------------------------------------------------------------------------------
+    struct kvalidator_t
+    {
+        keycodes_t const*   m_kcdb;
+        ckeyboards_t const* m_kbdb;
+
+        // per key a mask of its diagnostics (1 << ediag), indexed by m_key_base[layer_base[keymap] + layer] + key
+        s32  m_nb_keymaps;
+        s32* m_layer_base;
+        s32* m_key_base;
+        u32* m_masks;
+
+        s32       m_nb_diags;
+        s32       m_max_diags;
+        kvdiag_t* m_diags;
+        u32       m_version;
+    };
+
+    kvalidator_t* validator_create(keycodes_t const* kcdb, ckeyboards_t const* kbdb)
+    {
+        kvalidator_t* v = (kvalidator_t*)::malloc(sizeof(kvalidator_t));
+        v->m_kcdb       = kcdb;
+        v->m_kbdb       = kbdb;
+        v->m_nb_keymaps = 0;
+        v->m_layer_base = nullptr;
+        v->m_key_base   = nullptr;
+        v->m_masks      = nullptr;
+        v->m_nb_diags   = 0;
+        v->m_max_diags  = 0;
+        v->m_diags      = nullptr;
+        v->m_version    = 0;
+        return v;
+    }
+
+    void validator_destroy(kvalidator_t* v)
+    {
+        if (v == nullptr)
+            return;
+        ::free(v->m_layer_base);
+        ::free(v->m_key_base);
+        ::free(v->m_masks);
+        ::free(v->m_diags);
+        ::free(v);
+    }
+
+    struct svalidate_t
+    {
+        kvalidator_t* m_validator;
+        s32           m_keymap;
+    };
+
+    static void add_diag(kdiag_t const& diag, void* user)
+    {
+        svalidate_t*  ctx = (svalidate_t*)user;
+        kvalidator_t* v   = ctx->m_validator;
+        if (v->m_nb_diags == v->m_max_diags)
+        {
+            v->m_max_diags = v->m_max_diags == 0 ? 64 : v->m_max_diags * 2;
+            v->m_diags     = (kvdiag_t*)::realloc(v->m_diags, sizeof(kvdiag_t) * v->m_max_diags);
+        }
+        kvdiag_t& d = v->m_diags[v->m_nb_diags++];
+        d.m_keymap  = ctx->m_keymap;
+        d.m_diag    = diag;
+        if (diag.m_key >= 0)
+            v->m_masks[v->m_key_base[v->m_layer_base[ctx->m_keymap] + diag.m_layer] + diag.m_key] |= 1u << diag.m_code;
+    }
+
+    s32 validator_run(kvalidator_t* v, keymaps_t const* keymaps)
+    {
+        ::free(v->m_layer_base);
+        ::free(v->m_key_base);
+        ::free(v->m_masks);
+
+        s32 nb_layers = 0;
+        s32 nb_keys   = 0;
+        for (s32 k = 0; k < keymaps->m_nb_keymaps; ++k)
+        {
+            nb_layers += keymaps->m_keymaps[k].m_nb_layers;
+            for (s32 l = 0; l < keymaps->m_keymaps[k].m_nb_layers; ++l)
+                nb_keys += keymaps->m_keymaps[k].m_layers[l].m_nb_keys;
+        }
+
+        v->m_nb_keymaps = keymaps->m_nb_keymaps;
+        v->m_layer_base = (s32*)::malloc(sizeof(s32) * (keymaps->m_nb_keymaps + 1));
+        v->m_key_base   = (s32*)::malloc(sizeof(s32) * (nb_layers + 1));
+        v->m_masks      = (u32*)::calloc(nb_keys + 1, sizeof(u32));
+
+        s32 layer_base = 0;
+        s32 key_base   = 0;
+        for (s32 k = 0; k < keymaps->m_nb_keymaps; ++k)
+        {
+            v->m_layer_base[k] = layer_base;
+            for (s32 l = 0; l < keymaps->m_keymaps[k].m_nb_layers; ++l)
+            {
+                v->m_key_base[layer_base++] = key_base;
+                key_base += keymaps->m_keymaps[k].m_layers[l].m_nb_keys;
+            }
+        }
+        v->m_layer_base[keymaps->m_nb_keymaps] = layer_base;
+        v->m_key_base[layer_base]              = key_base;
+
+        v->m_nb_diags = 0;
+        for (s32 k = 0; k < keymaps->m_nb_keymaps; ++k)
+        {
+            svalidate_t ctx;
+            ctx.m_validator = v;
+            ctx.m_keymap    = k;
+            validate_keymap(&keymaps->m_keymaps[k], v->m_kcdb, v->m_kbdb, add_diag, &ctx);
+        }
+        v->m_version += 1;
+        return v->m_nb_diags;
+    }
+
+    s32 validator_update(kvalidator_t* v, keymaps_t const* keymaps, kedit_t const& edit)
+    {
+        // layer colors do not affect any diagnostic
+        if (is_layer_edit(edit.m_op) || edit.m_keymap < 0 || edit.m_keymap >= v->m_nb_keymaps || edit.m_keymap >= keymaps->m_nb_keymaps)
+            return v->m_nb_diags;
+        keymap_t const* km = &keymaps->m_keymaps[edit.m_keymap];
+        if (edit.m_layer < 0 || edit.m_layer >= km->m_nb_layers || edit.m_key < 0 || edit.m_key >= km->m_layers[edit.m_layer].m_nb_keys)
+            return v->m_nb_diags;
+
+        u32& mask = v->m_masks[v->m_key_base[v->m_layer_base[edit.m_keymap] + edit.m_layer] + edit.m_key];
+        if (mask != 0)
+        {
+            // remove the diagnostics of this key, keeping the order of the others
+            s32 n = 0;
+            for (s32 i = 0; i < v->m_nb_diags; ++i)
+            {
+                kvdiag_t const& d = v->m_diags[i];
+                if (d.m_keymap == edit.m_keymap && d.m_diag.m_layer == edit.m_layer && d.m_diag.m_key == edit.m_key)
+                    continue;
+                v->m_diags[n++] = d;
+            }
+            v->m_nb_diags = n;
+            mask          = 0;
+            v->m_version += 1;
+        }
+
+        svalidate_t ctx;
+        ctx.m_validator = v;
+        ctx.m_keymap    = edit.m_keymap;
+        if (validate_key(km, edit.m_layer, edit.m_key, v->m_kcdb, add_diag, &ctx) > 0)
+            v->m_version += 1;
+        return v->m_nb_diags;
+    }
+
+    s32             validator_nb_diags(kvalidator_t* v) { return v->m_nb_diags; }
+    kvdiag_t const* validator_diags(kvalidator_t* v) { return v->m_diags; }
+    u32             validator_version(kvalidator_t* v) { return v->m_version; }
+
+    bool validator_key_ok(kvalidator_t* v, s32 keymap, s32 layer, s32 key)
+    {
+        if (keymap < 0 || keymap >= v->m_nb_keymaps)
+            return true;
+        s32 const l = v->m_layer_base[keymap] + layer;
+        if (layer < 0 || l >= v->m_layer_base[keymap + 1])
+            return true;
+        s32 const k = v->m_key_base[l] + key;
+        if (key < 0 || k >= v->m_key_base[l + 1])
+            return true;
+        return v->m_masks[k] == 0;
+    }
+
+} // namespace xcore
@@ -0,0 +1,294 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_files.h"
+#include "qmk-keymap-wiz/keyboard_jobs.h"
+#include "qmk-keymap-wiz/keyboard_workspace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace xcore
+{
+    struct sworkentry_t
+    {
+        kworkspaceentry_t m_info;
+        char              m_name[64];
+        char              m_keyboard[128];
+        karena_t          m_arena;   // only the main memory, the scratch memory is per decode
+        keymaps_t const*  m_keymaps; // nullptr when not in memory
+        u64               m_used;    // the clock of the last acquire, 0 when never acquired
+        s32               m_pins;
+    };
+
+    struct kworkspace_t
+    {
+        char*         m_dir;
+        s64           m_budget;
+        kfiles_t      m_files;
+        s32           m_nb_entries;
+        sworkentry_t* m_entries;
+        u64           m_clock;
+    };
+
+    static void drop(sworkentry_t& e)
+    {
+        exit_arena(e.m_arena);
+        e.m_keymaps       = nullptr;
+        e.m_info.m_memory = 0;
+    }
+
+    // the main memory is a guess from the file size, a file that does not fit is decoded once more with four times
+    // the memory
+    static void decode(sworkentry_t& e, karena_t& scratch)
+    {
+        drop(e);
+
+        s64 const size = file_size(e.m_info.m_filename);
+        e.m_info.m_file_size = size;
+        e.m_info.m_failed    = true;
+        if (size < 0)
+            return;
+
+        u32 const scratch_size = (u32)(size * 2 + 1024 * 1024);
+        if (scratch.m_scratch_size < scratch_size)
+        {
+            exit_arena(scratch);
+            init_arena(scratch, 0, scratch_size);
+        }
+
+        for (s32 attempt = 0; attempt < 2; ++attempt)
+        {
+            u32 const main_size = (u32)((size * 2 + 64 * 1024) << (2 * attempt));
+
+            karena_t arena;
+            arena.m_main_memory    = ::malloc(main_size);
+            arena.m_main_size      = main_size;
+            arena.m_scratch_memory = scratch.m_scratch_memory;
+            arena.m_scratch_size   = scratch.m_scratch_size;
+
+            keymaps_t const* keymaps = nullptr;
+            if (load_keymaps(e.m_info.m_filename, arena, keymaps) && keymaps->m_nb_keymaps > 0)
+            {
+                e.m_arena.m_main_memory = arena.m_main_memory;
+                e.m_arena.m_main_size   = arena.m_main_size;
+                e.m_keymaps             = keymaps;
+
+                keymap_t const& km = keymaps->m_keymaps[0];
+                strncpy(e.m_keyboard, km.m_name ? km.m_name : "", sizeof(e.m_keyboard) - 1);
+                e.m_keyboard[sizeof(e.m_keyboard) - 1] = 0;
+
+                s32 nb_keys = 0;
+                for (s32 l = 0; l < km.m_nb_layers; ++l)
+                    nb_keys += km.m_layers[l].m_nb_keys;
+
+                e.m_info.m_nb_keymaps = keymaps->m_nb_keymaps;
+                e.m_info.m_nb_layers  = km.m_nb_layers;
+                e.m_info.m_nb_keys    = nb_keys;
+                e.m_info.m_memory     = main_size;
+                e.m_info.m_failed     = false;
+                return;
+            }
+            ::free(arena.m_main_memory);
+        }
+    }
+
+    // evicts the least recently acquired keymaps that are not pinned until the rest fits in the budget, of the
+    // keymaps that were never acquired (a scan) the last files go first
+    static void trim(kworkspace_t* ws)
+    {
+        s64 memory = workspace_memory(ws);
+        while (memory > ws->m_budget)
+        {
+            s32 victim = -1;
+            for (s32 i = 0; i < ws->m_nb_entries; ++i)
+            {
+                sworkentry_t const& e = ws->m_entries[i];
+                if (e.m_keymaps == nullptr || e.m_pins > 0)
+                    continue;
+                if (victim < 0 || e.m_used <= ws->m_entries[victim].m_used)
+                    victim = i;
+            }
+            if (victim < 0)
+                break;
+
+            memory -= ws->m_entries[victim].m_info.m_memory;
+            drop(ws->m_entries[victim]);
+        }
+    }
+
+    static void clear(kworkspace_t* ws)
+    {
+        for (s32 i = 0; i < ws->m_nb_entries; ++i)
+            drop(ws->m_entries[i]);
+        ::free(ws->m_entries);
+        ws->m_entries    = nullptr;
+        ws->m_nb_entries = 0;
+        release_files(ws->m_files);
+    }
+
+    kworkspace_t* workspace_create(const char* dir, s64 memory_budget)
+    {
+        s32 const     len = (s32)strlen(dir);
+        kworkspace_t* ws  = (kworkspace_t*)::malloc(sizeof(kworkspace_t));
+        ws->m_dir         = (char*)::malloc(len + 1);
+        memcpy(ws->m_dir, dir, len + 1);
+        ws->m_files      = kfiles_t();
+        ws->m_budget     = memory_budget;
+        ws->m_nb_entries = 0;
+        ws->m_entries    = nullptr;
+        ws->m_clock      = 0;
+        return ws;
+    }
+
+    void workspace_destroy(kworkspace_t* ws)
+    {
+        if (ws == nullptr)
+            return;
+        clear(ws);
+        ::free(ws->m_dir);
+        ::free(ws);
+    }
+
+    struct sscan_t
+    {
+        kworkspace_t* m_ws;
+        karena_t*     m_scratch; // per worker
+    };
+
+    static void scan_job(s32 index, s32 worker, void* user)
+    {
+        sscan_t* scan = (sscan_t*)user;
+        decode(scan->m_ws->m_entries[index], scan->m_scratch[worker]);
+    }
+
+    bool workspace_scan(kworkspace_t* ws, s32 nb_workers)
+    {
+        for (s32 i = 0; i < ws->m_nb_entries; ++i)
+        {
+            if (ws->m_entries[i].m_pins > 0)
+            {
+                printf("workspace: %s is in use, %s is not scanned again\n", ws->m_entries[i].m_info.m_filename, ws->m_dir);
+                return false;
+            }
+        }
+        clear(ws);
+
+        if (!enumerate_files(ws->m_dir, ".json", true, ws->m_files))
+        {
+            return false;
+        }
+
+        s32 const nb_files = ws->m_files.m_nb_files;
+        ws->m_entries      = (sworkentry_t*)::malloc(sizeof(sworkentry_t) * (nb_files > 0 ? nb_files : 1));
+        ws->m_nb_entries   = nb_files;
+        for (s32 i = 0; i < nb_files; ++i)
+        {
+            sworkentry_t& e = ws->m_entries[i];
+            file_stem(ws->m_files.m_files[i], e.m_name, sizeof(e.m_name));
+            e.m_keyboard[0]       = 0;
+            e.m_arena             = karena_t();
+            e.m_keymaps           = nullptr;
+            e.m_used              = 0;
+            e.m_pins              = 0;
+            e.m_info.m_filename   = ws->m_files.m_files[i];
+            e.m_info.m_name       = e.m_name;
+            e.m_info.m_keyboard   = e.m_keyboard;
+            e.m_info.m_nb_keymaps = 0;
+            e.m_info.m_nb_layers  = 0;
+            e.m_info.m_nb_keys    = 0;
+            e.m_info.m_file_size  = 0;
+            e.m_info.m_memory     = 0;
+            e.m_info.m_failed     = false;
+        }
+
+        if (nb_workers <= 0)
+            nb_workers = jobs_nb_workers();
+
+        sscan_t scan;
+        scan.m_ws      = ws;
+        scan.m_scratch = (karena_t*)::malloc(sizeof(karena_t) * nb_workers);
+        for (s32 w = 0; w < nb_workers; ++w)
+            scan.m_scratch[w] = karena_t();
+
+        jobs_parallel_for(nb_files, scan_job, &scan, nb_workers);
+
+        for (s32 w = 0; w < nb_workers; ++w)
+            exit_arena(scan.m_scratch[w]);
+        ::free(scan.m_scratch);
+
+        trim(ws);
+        return true;
+    }
+
+    s32 workspace_nb_entries(kworkspace_t const* ws) { return ws->m_nb_entries; }
+
+    kworkspaceentry_t const* workspace_entry(kworkspace_t const* ws, s32 entry)
+    {
+        if (entry < 0 || entry >= ws->m_nb_entries)
+            return nullptr;
+        return &ws->m_entries[entry].m_info;
+    }
+
+    s32 workspace_find(kworkspace_t const* ws, const char* filename)
+    {
+        for (s32 i = 0; i < ws->m_nb_entries; ++i)
+        {
+            if (strcmp(ws->m_entries[i].m_info.m_filename, filename) == 0)
+                return i;
+        }
+        return -1;
+    }
+
+    keymaps_t const* workspace_acquire(kworkspace_t* ws, s32 entry)
+    {
+        if (entry < 0 || entry >= ws->m_nb_entries)
+            return nullptr;
+
+        sworkentry_t& e = ws->m_entries[entry];
+        if (e.m_keymaps == nullptr)
+        {
+            karena_t scratch;
+            decode(e, scratch);
+            exit_arena(scratch);
+            if (e.m_keymaps == nullptr)
+                return nullptr;
+        }
+
+        e.m_pins += 1;
+        e.m_used = ++ws->m_clock;
+        trim(ws);
+        return e.m_keymaps;
+    }
+
+    void workspace_release(kworkspace_t* ws, s32 entry)
+    {
+        if (entry < 0 || entry >= ws->m_nb_entries)
+            return;
+        sworkentry_t& e = ws->m_entries[entry];
+        if (e.m_pins > 0)
+            e.m_pins -= 1;
+        trim(ws);
+    }
+
+    void workspace_evict(kworkspace_t* ws, s32 entry)
+    {
+        if (entry < 0 || entry >= ws->m_nb_entries)
+            return;
+        sworkentry_t& e = ws->m_entries[entry];
+        if (e.m_pins == 0)
+            drop(e);
+    }
+
+    s64 workspace_memory(kworkspace_t const* ws)
+    {
+        s64 memory = 0;
+        for (s32 i = 0; i < ws->m_nb_entries; ++i)
+            memory += ws->m_entries[i].m_info.m_memory;
+        return memory;
+    }
+
+    s64 workspace_budget(kworkspace_t const* ws) { return ws->m_budget; }
+
+} // namespace xcore
@@ -0,0 +1,211 @@
+#include "xbase/x_base.h"
+
+#include "qmk-keymap-wiz/keyboard_writer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace xcore
+{
+    static bool writer_open(kwriter_t& w, const char* filename, const char* mode)
+    {
+        w.m_memory = false;
+        w.m_file   = fopen(filename, mode);
+        if (!w.m_file)
+        {
+            printf("failed to open file %s\n", filename);
+            return false;
+        }
+        w.m_cap     = 64 * 1024;
+        w.m_buffer  = (char*)::malloc(w.m_cap);
+        w.m_size    = 0;
+        w.m_written = 0;
+        w.m_error   = false;
+        return true;
+    }
+
+    bool writer_open(kwriter_t& w, const char* filename) { return writer_open(w, filename, "wb"); }
+    bool writer_append(kwriter_t& w, const char* filename) { return writer_open(w, filename, "ab"); }
+
+    void writer_count(kwriter_t& w)
+    {
+        w.m_memory  = false;
+        w.m_file    = nullptr;
+        w.m_buffer  = nullptr;
+        w.m_size    = 0;
+        w.m_cap     = 0;
+        w.m_written = 0;
+        w.m_error   = false;
+    }
+
+    void writer_memory(kwriter_t& w)
+    {
+        w.m_memory  = true;
+        w.m_file    = nullptr;
+        w.m_cap     = 4 * 1024;
+        w.m_buffer  = (char*)::malloc(w.m_cap);
+        w.m_size    = 0;
+        w.m_written = 0;
+        w.m_error   = false;
+    }
+
+    static void writer_flush(kwriter_t& w)
+    {
+        if (w.m_file != nullptr && w.m_size > 0)
+        {
+            if (fwrite(w.m_buffer, 1, w.m_size, w.m_file) != (size_t)w.m_size)
+                w.m_error = true;
+        }
+        w.m_size = 0;
+    }
+
+    bool writer_sync(kwriter_t& w)
+    {
+        if (w.m_file == nullptr)
+            return !w.m_error;
+        writer_flush(w);
+        if (fflush(w.m_file) != 0)
+            w.m_error = true;
+#ifdef _WIN32
+        if (_commit(_fileno(w.m_file)) != 0)
+            w.m_error = true;
+#else
+        if (fsync(fileno(w.m_file)) != 0)
+            w.m_error = true;
+#endif
+        return !w.m_error;
+    }
+
+    bool writer_close(kwriter_t& w)
+    {
+        if (w.m_file != nullptr)
+        {
+            writer_flush(w);
+            if (fclose(w.m_file) != 0)
+                w.m_error = true;
+            w.m_file = nullptr;
+        }
+        ::free(w.m_buffer);
+        w.m_buffer = nullptr;
+        w.m_size   = 0;
+        w.m_cap    = 0;
+        w.m_memory = false;
+        return !w.m_error;
+    }
+
+    void writer_write(kwriter_t& w, const char* str, s32 len)
+    {
+        w.m_written += len;
+        if (w.m_memory)
+        {
+            if (w.m_size + len > w.m_cap)
+            {
+                while (w.m_size + len > w.m_cap)
+                    w.m_cap *= 2;
+                w.m_buffer = (char*)::realloc(w.m_buffer, w.m_cap);
+            }
+            memcpy(w.m_buffer + w.m_size, str, len);
+            w.m_size += len;
+            return;
+        }
+        if (w.m_file == nullptr)
+            return;
+
+        while (len > 0)
+        {
+            if (w.m_size == w.m_cap)
+                writer_flush(w);
+            s32 n = w.m_cap - w.m_size;
+            if (n > len)
+                n = len;
+            memcpy(w.m_buffer + w.m_size, str, n);
+            w.m_size += n;
+            str += n;
+            len -= n;
+        }
+    }
+
+    void writer_str(kwriter_t& w, const char* str) { writer_write(w, str, (s32)strlen(str)); }
+
+    void writer_char(kwriter_t& w, char c) { writer_write(w, &c, 1); }
+
+    void writer_int(kwriter_t& w, s32 value) { writer_s64(w, value); }
+
+    void writer_s64(kwriter_t& w, s64 value)
+    {
+        char  digits[24];
+        char* end = digits + sizeof(digits);
+        char* p   = end;
+        u64   v   = value < 0 ? (u64)0 - (u64)value : (u64)value;
+        do
+        {
+            *--p = (char)('0' + (v % 10));
+            v /= 10;
+        } while (v != 0);
+        if (value < 0)
+            *--p = '-';
+        writer_write(w, p, (s32)(end - p));
+    }
+
+    void writer_spaces(kwriter_t& w, s32 count)
+    {
+        static const char s_spaces[] = "                                ";
+        while (count > 0)
+        {
+            s32 const n = count < 32 ? count : 32;
+            writer_write(w, s_spaces, n);
+            count -= n;
+        }
+    }
+
+    void writer_float(kwriter_t& w, float value, s32 decimals)
+    {
+        char      str[64];
+        s32 const len = snprintf(str, sizeof(str), "%.*f", decimals, (double)value);
+        writer_write(w, str, len);
+    }
+
+    void writer_json_str(kwriter_t& w, const char* str)
+    {
+        static const char s_hex[] = "0123456789abcdef";
+
+        writer_char(w, '"');
+        if (str != nullptr)
+        {
+            const char* run = str;
+            for (const char* c = str; *c != 0; ++c)
+            {
+                u8 const ch = (u8)*c;
+                if (ch >= 0x20 && ch != '"' && ch != '\\')
+                    continue;
+
+                writer_write(w, run, (s32)(c - run));
+                run = c + 1;
+                switch (ch)
+                {
+                    case '"': writer_str(w, "\\\""); break;
+                    case '\\': writer_str(w, "\\\\"); break;
+                    case '\n': writer_str(w, "\\n"); break;
+                    case '\r': writer_str(w, "\\r"); break;
+                    case '\t': writer_str(w, "\\t"); break;
+                    default:
+                    {
+                        char const esc[6] = {'\\', 'u', '0', '0', s_hex[ch >> 4], s_hex[ch & 0xF]};
+                        writer_write(w, esc, 6);
+                        break;
+                    }
+                }
+            }
+            writer_write(w, run, (s32)strlen(run));
+        }
+        writer_char(w, '"');
+    }
+
+} // namespace xcore
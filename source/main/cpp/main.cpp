@@ -3,6 +3,10 @@
 
 #include "qmk-keymap-wiz/keyboard_data.h"
 #include "qmk-keymap-wiz/keyboard_render.h"
+#include "qmk-keymap-wiz/keyboard_cli.h"
+#include "qmk-keymap-wiz/keyboard_editor.h"
+#include "qmk-keymap-wiz/keyboard_profile.h"
+#include "qmk-keymap-wiz/keyboard_app.h"
 
 #include "libimgui/imgui.h"
 #include "libimgui/imgui_internal.h"
@@ -10,6 +14,7 @@
 #include "libimgui/imgui_impl_opengl3.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <math.h> // sqrtf, powf, cosf, sinf, floorf, ceilf
 
 #define GL_SILENCE_DEPRECATION
@@ -40,10 +45,34 @@ namespace xcore
 
 static xcore::WizAssertHandler gAssertHandler;
 
-int main(int, char**)
+static const char* option_value(int argc, char** argv, const char* name)
+{
+    for (int i = 1; i < argc - 1; i++)
+    {
+        if (strcmp(argv[i], name) == 0)
+            return argv[i + 1];
+    }
+    return nullptr;
+}
+
+int main(int argc, char** argv)
 {
     xbase::init();
 
+    // Headless commands (render, ...) run without creating a window
+    int const cli_result = keyboard_cli(argc, argv);
+    if (cli_result >= 0)
+        return cli_result;
+
+    // --record <file> writes the input of every frame, --replay <file> feeds a recording back instead of the input
+    // of the window and writes the timings of every frame to --replay-out (replay.json)
+    const char* record_file = option_value(argc, argv, "--record");
+    const char* replay_file = option_value(argc, argv, "--replay");
+    const char* replay_out  = option_value(argc, argv, "--replay-out");
+    kreplay_t*  replay      = replay_file != nullptr ? keyboard_replay_open(replay_file, false) : nullptr;
+    if (replay_file != nullptr && replay == nullptr)
+        return 1;
+
 #ifdef TARGET_DEBUG
     xcore::context_t::set_assert_handler(&gAssertHandler);
 #endif
@@ -88,6 +117,7 @@ int main(int, char**)
 
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
+    keyboard_profile_allocators();
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO();
     (void)io;
@@ -99,7 +129,7 @@ int main(int, char**)
     // ImGui::StyleColorsClassic();
 
     // Setup Platform/Renderer backends
-    ImGui_ImplGlfw_InitForOpenGL(window, true);
+    ImGui_ImplGlfw_InitForOpenGL(window, replay == nullptr); // a replay does not take input from the window
     ImGui_ImplOpenGL3_Init(glsl_version);
 
     // Load Fonts
@@ -127,19 +157,50 @@ int main(int, char**)
     xcore::init_keyboards();
     xcore::load_keyboards(kbDB);
 
-    // Currently hardcoded loading of keymaps
-    xcore::keymaps_t const* keymaps;
+    // Every keymaps file under keymaps/ is decoded on all cores, the editor opens keymaps/jurgen.json (or the first
+    // file) and the workspace panel switches between them, the hardcoded file is loaded when there is no workspace
+    xcore::kworkspace_t* workspace = xcore::workspace_create("keymaps", 64 * 1024 * 1024);
+    xcore::workspace_scan(workspace);
+    xcore::s32 entry = xcore::workspace_find(workspace, xcore::keymaps_filename());
+    if (entry < 0)
+        entry = 0;
+
+    // Edits that have not made it into the keymaps file yet are in the journal, from here on the keymaps are
+    // owned by the editor
+    keditor_t editor;
     xcore::init_keymaps();
-    xcore::load_keymaps(keymaps);
-    xcore::keymap_t const* km = &keymaps->m_keymaps[0];
+    if (!keyboard_editor_open(editor, workspace, entry, kcDB, kbDB))
+    {
+        xcore::keymaps_t const* keymaps;
+        xcore::load_keymaps(keymaps);
+        keyboard_editor_init(editor, xcore::keymaps_filename(), keymaps, kcDB, kbDB);
+    }
+
+    xcore::krecorder_t* recorder = record_file != nullptr ? xcore::recorder_open(record_file) : nullptr;
 
 
     // Main loop
     while (!glfwWindowShouldClose(window))
     {
-        if (xcore::reload_keyboards(kbDB))
+        // the zones of the previous frame, including the swap, go into the graph
+        xcore::profile_frame();
+        if (replay != nullptr)
+            keyboard_replay_timings(replay);
+        xcore::kprofilescope_t frame_zone(xcore::PROFILE_FRAME);
+
+        {
+            xcore::kprofilescope_t zone(xcore::PROFILE_RELOAD);
+            bool const             kc_reloaded = xcore::reload_keycodes(kcDB);
+            bool const             kb_reloaded = xcore::reload_keyboards(kbDB);
+            if (kc_reloaded || kb_reloaded)
+            {
+                keyboard_editor_databases(editor, kcDB, kbDB);
+            }
+        }
+
         {
-            
+            xcore::kprofilescope_t zone(xcore::PROFILE_EDITOR_UPDATE);
+            keyboard_editor_update(editor);
         }
 
         // Poll and handle events (inputs, window resize, etc.)
@@ -152,127 +213,36 @@ int main(int, char**)
         // Start the Dear ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
+        if (replay != nullptr && !keyboard_replay_input(replay))
+            break;
         ImGui::NewFrame();
 
-        ImVec2 winSize;
-
+        if (recorder != nullptr)
         {
-            ImGui::SetNextWindowPos(ImVec2(0, 0));
-            ImGui::Begin("Keyboard Wiz", nullptr,
-                         ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse);
-
-            ImGui::BeginChildFrame(ImGui::GetID("Settings"), ImVec2(320, 200), ImGuiWindowFlags_NoMove);
-
-            // When clicking a key we would like a menu to popup
-            // The menu should be able to provide to the user:
-            //   - change the key's keycode
-            //   - change the key's modifiers (shift, ctrl, alt, etc.)
-            //   - change the key's cap color
-            //   - change the key's led color
-
-            // Adding/Removing layers
-            //   - add a new layer (see if there was a layer with the same name that is marked as deleted')
-            //   - remove a layer (when removing we should just mark it as 'deleted')
-
-            if (ImGui::Button("Key Pressed"))
-                ImGui::OpenPopup("Key Properties");
-
-            if (ImGui::BeginPopupModal("Key Properties", NULL, ImGuiWindowFlags_MenuBar))
-            {
-                if (ImGui::BeginMenuBar())
-                {
-                    if (ImGui::BeginMenu("File"))
-                    {
-                        if (ImGui::MenuItem("Some menu item")) {}
-                        ImGui::EndMenu();
-                    }
-                    ImGui::EndMenuBar();
-                }
-                ImGui::Text("Hello from Stacked The First\nUsing style.Colors[ImGuiCol_ModalWindowDimBg] behind it.");
-
-                // Testing behavior of widgets stacking their own regular popups over the modal.
-                static int item = 1;
-                static float color[4] = { 0.4f, 0.7f, 0.0f, 0.5f };
-                ImGui::Combo("Combo", &item, "aaaa\0bbbb\0cccc\0dddd\0eeee\0\0");
-                ImGui::ColorEdit4("color", color);
-
-                if (ImGui::Button("Close"))
-                    ImGui::CloseCurrentPopup();
-                ImGui::EndPopup();
-            }
-
-            ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
-
-            const float MIN_SCALE = 0.7f;
-            const float MAX_SCALE = 1.5f;
-            ImGui::DragFloat("global scale", &io.FontGlobalScale, 0.005f, MIN_SCALE, MAX_SCALE, "%.2f", ImGuiSliderFlags_AlwaysClamp); // Scale everything
-
-            ImGui::EndChildFrame();
-
-            static bool             show_leading_button  = true;
-            static bool             show_trailing_button = true;
-            static ImGuiTabBarFlags tab_bar_flags        = ImGuiTabBarFlags_AutoSelectNewTabs | ImGuiTabBarFlags_FittingPolicyResizeDown;
-
-            ImVec2 frameSize = ImVec2(2048, 840);
-            ImGui::BeginChildFrame(ImGui::GetID("keyboard_area"), frameSize);
-            if (ImGui::BeginTabBar("Layers", tab_bar_flags))
-            {
-                ImColor tabkgrndcolor(10, 10, 10, 256);
-
-                if (ImGui::TabItemButton("?", ImGuiTabItemFlags_Leading | ImGuiTabItemFlags_NoTooltip))
-                    ImGui::OpenPopup("MyHelpMenu");
-                if (ImGui::BeginPopup("MyHelpMenu"))
-                {
-                    ImGui::Selectable("Hello!");
-                    ImGui::EndPopup();
-                }
-
-                if (ImGui::TabItemButton("+", ImGuiTabItemFlags_Trailing | ImGuiTabItemFlags_NoTooltip))
-                {
-                    // create a new layer?
-                    //active_tabs.push_back(next_tab_id++); // Add new tab
-                }
-
-                // Submit our regular tabs
-                for (int n = 0; n < km->m_nb_layers; n++)
-                {
-                    char name[16];
-                    snprintf(name, IM_ARRAYSIZE(name), "%s", km->m_layers[n].m_name);
-                    if (ImGui::BeginTabItem(name))
-                    {
-                        ImVec2 p = ImGui::GetCursorScreenPos();
-
-                        ImDrawList* draw_list = ImGui::GetWindowDrawList();
-                        draw_list->AddRectFilled(ImVec2(p.x, p.y), ImVec2(p.x + frameSize.x, p.y + frameSize.y), tabkgrndcolor, 0, ImDrawFlags_RoundCornersAll);
-
-                        keyboard_render(&kbDB->m_keyboards[0], kcDB, km, n, p.x, p.y, io.MousePos.x, io.MousePos.y, io.FontGlobalScale);
-
-                        ImGui::EndTabItem();
-                    }
-                }
-                ImGui::EndTabBar();
-            }
-            ImGui::EndChildFrame();
-            winSize = ImGui::GetWindowSize();
-
-            ImGui::ShowDemoWindow();
-
-            ImGui::End();
+            xcore::kinputframe_t input;
+            keyboard_input_capture(input);
+            xcore::recorder_frame(recorder, input);
         }
 
+        ImVec2 winSize;
+        keyboard_app_frame(editor, kcDB, kbDB, winSize.x, winSize.y);
+
         if (winSize.x < 2048)
             winSize.x = 2048;
         if (winSize.y < 1024)
             winSize.y = 1024;
 
         // Rendering
-        ImGui::Render();
-        int display_w, display_h;
-        glfwGetFramebufferSize(window, &display_w, &display_h);
-        glViewport(0, 0, display_w, display_h);
-        glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, clear_color.w);
-        glClear(GL_COLOR_BUFFER_BIT);
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        {
+            xcore::kprofilescope_t zone(xcore::PROFILE_IMGUI_RENDER);
+            ImGui::Render();
+            int display_w, display_h;
+            glfwGetFramebufferSize(window, &display_w, &display_h);
+            glViewport(0, 0, display_w, display_h);
+            glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, clear_color.w);
+            glClear(GL_COLOR_BUFFER_BIT);
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
 
         glfwSwapBuffers(window);
         // glfwSetWindowPos( window, ((int)winSize.x) / 2, ((int)winSize.y) / 2 );
@@ -283,6 +253,26 @@ int main(int, char**)
     void exit_keyboards();
     void exit_keymaps();
 
+    keyboard_editor_exit(editor);
+    xcore::workspace_destroy(workspace);
+
+    if (recorder != nullptr)
+    {
+        xcore::s32 const nb_frames = xcore::recorder_nb_frames(recorder);
+        if (xcore::recorder_close(recorder))
+            printf("recorded %d frames to %s\n", nb_frames, record_file);
+    }
+    if (replay != nullptr)
+    {
+        if (replay_out == nullptr)
+            replay_out = "replay.json";
+        xcore::kwriter_t w;
+        bool const       opened = xcore::writer_open(w, replay_out);
+        keyboard_replay_close(replay, opened ? &w : nullptr, -1);
+        if (opened && xcore::writer_close(w))
+            printf("wrote %s\n", replay_out);
+    }
+
     // Cleanup
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
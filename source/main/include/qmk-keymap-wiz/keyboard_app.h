@@ -0,0 +1,46 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_APP_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_APP_H__
+#pragma once
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_editor.h"
+#include "qmk-keymap-wiz/keyboard_replay.h"
+#include "qmk-keymap-wiz/keyboard_writer.h"
+
+// The main window: the settings (toolbar, diagnostics, find, optimizer, profiler, global scale) and a tab per layer
+// of the first keymap with the keyboard. Shared by the application and the headless replay, so that a replay
+// runs exactly the code of a frame of the application. 'width' and 'height' return the size the window needs.
+void keyboard_app_frame(keditor_t& editor, xcore::keycodes_t const* kcdb, xcore::ckeyboards_t const* kbdb, float& width, float& height);
+
+// the milliseconds and allocations per frame of every profiling zone as rolling graphs, with a button to export a
+// Chrome trace
+void keyboard_profiler(float height);
+
+// ImGui allocates through functions that count every allocation in the profiler, before ImGui::CreateContext, they
+// are next to the global operator new in keyboard_memory.cpp
+void keyboard_profile_allocators();
+
+// the input state of the current frame, after ImGui::NewFrame
+void keyboard_input_capture(xcore::kinputframe_t& frame);
+
+// queues the input of a recorded frame as ImGui events, before ImGui::NewFrame, 'previous' is the frame that was
+// applied before it (cleared for the first one), the display size is only set when there is no window
+void keyboard_input_apply(xcore::kinputframe_t const& frame, xcore::kinputframe_t const& previous, bool display);
+
+// A replay of a recording with the timings and allocations of every frame, taken from the profiling zones. Every frame:
+// - keyboard_replay_timings after xcore::profile_frame, collects the timings of the frame before
+// - keyboard_replay_input before ImGui::NewFrame, returns false after the last frame
+struct kreplay_t;
+
+kreplay_t* keyboard_replay_open(const char* filename, bool headless);
+bool       keyboard_replay_input(kreplay_t* replay);
+void       keyboard_replay_timings(kreplay_t* replay);
+
+// prints a summary and writes the timings as JSON when 'out' is not null. With a 'warmup' of 0 or more the replay
+// fails when a steady frame allocates: a frame after the first 'warmup' frames with the same input as the one before.
+bool keyboard_replay_close(kreplay_t* replay, xcore::kwriter_t* out, xcore::s32 warmup);
+
+// a replay without a window, in an ImGui context that is never drawn, as fast as the frames can be built
+bool keyboard_replay_headless(xcore::kwriter_t& out, const char* filename, keditor_t& editor, xcore::keycodes_t const* kcdb, xcore::ckeyboards_t const* kbdb, xcore::s32 warmup);
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_APP_H__
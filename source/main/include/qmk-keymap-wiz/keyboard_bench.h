@@ -0,0 +1,36 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_BENCH_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_BENCH_H__
+#pragma once
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_writer.h"
+
+// Benchmarks on synthetic keyboards and keymaps, without GLFW or a window. For every size a keyboard (split halves
+// of 3x6 keygroups, every other one rotated) and a keymap with that many keys per layer are written as JSON and
+// then timed:
+// - decode_keyboards, decode_keymaps: load_keyboards/load_keymaps of the written files
+// - compile: compile_keymaps of the decoded keymaps
+// - find_keycode: a lookup of the keycode of every key
+// - layout, hit_test: keyboard_layout, and finding the key under a random point as keyboard_render does
+// - rgb: a frame of the splash effect of the RGB preview, per LED
+// - render: keyboard_render of every layer into an offscreen ImGui context without a renderer backend
+// The results are written to 'out' as JSON, one entry per size and benchmark, so that runs can be compared per
+// commit.
+struct kbenchsize_t
+{
+    xcore::s32 m_nb_keys;
+    xcore::s32 m_nb_layers;
+};
+
+// every benchmark runs for at least 'min_seconds', the synthetic files are written to 'tmpdir' and removed again,
+// 'label' (e.g. a commit hash) is copied into the report
+bool keyboard_bench(xcore::kwriter_t& out, xcore::keycodes_t const* kcdb, kbenchsize_t const* sizes, xcore::s32 nb_sizes, double min_seconds, const char* tmpdir, const char* label);
+
+// the synthetic keyboard and keymaps of a size as JSON files
+bool keyboard_bench_write(const char* kb_file, const char* km_file, xcore::keycodes_t const* kcdb, kbenchsize_t const& size);
+
+// creates an ImGui context without a renderer backend and builds the font atlas on the CPU, returns false when the
+// fonts are not found (the labels are drawn with the default font), ImGui::DestroyContext when done
+bool keyboard_bench_context();
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_BENCH_H__
@@ -0,0 +1,10 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_CLI_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_CLI_H__
+#pragma once
+
+// Headless command line interface: 'qmk-keymap-wiz <command> [options]'. None of the commands initialize GLFW or
+// OpenGL, so they can run on a build server. Returns the exit code of the command, or -1 when the command line
+// does not contain a command and the GUI should be started.
+int keyboard_cli(int argc, char** argv);
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_CLI_H__
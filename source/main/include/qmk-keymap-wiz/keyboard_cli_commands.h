@@ -0,0 +1,55 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_CLI_COMMANDS_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_CLI_COMMANDS_H__
+#pragma once
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+
+#include <chrono>
+
+// The commands of keyboard_cli live in a file per feature (keyboard_cli_<feature>.cpp), the helpers they share and
+// the table of commands in keyboard_cli.cpp. A command gets the whole command line (argv[1] is its name) and returns
+// the exit code.
+
+// the value that follows the option 'name', 'default_value' when the option is not there
+const char* arg_value(int argc, char** argv, const char* name, const char* default_value);
+bool        arg_flag(int argc, char** argv, const char* name);
+double      seconds_since(std::chrono::steady_clock::time_point start);
+
+// replace anything that is not safe in a file name
+void sanitize(const char* name, char* out, int maxlen);
+
+// the arenas grow with the largest file a worker has seen
+void reserve_arena(xcore::karena_t& arena, xcore::s64 file_size);
+
+// The keycode and keyboard databases are loaded once and shared (read-only) by all the jobs
+bool load_databases(xcore::keycodes_t const*& kcdb, xcore::ckeyboards_t const*& kbdb);
+void unload_databases();
+
+// keyboard_cli_export.cpp
+int cmd_render(int argc, char** argv);
+int cmd_export(int argc, char** argv);
+int cmd_validate(int argc, char** argv);
+
+// keyboard_cli_keycode.cpp
+int cmd_search(int argc, char** argv);
+int cmd_keycode(int argc, char** argv);
+int cmd_where(int argc, char** argv);
+
+// keyboard_cli_optimize.cpp
+int cmd_heatmap(int argc, char** argv);
+int cmd_optimize(int argc, char** argv);
+
+// keyboard_cli_bench.cpp
+int cmd_bench_undo(int argc, char** argv);
+int cmd_bench(int argc, char** argv);
+int cmd_replay(int argc, char** argv);
+int cmd_fingerprint(int argc, char** argv);
+
+// keyboard_cli_simulate.cpp
+int cmd_simulate(int argc, char** argv);
+
+// keyboard_cli_import.cpp
+int cmd_import_info(int argc, char** argv);
+int cmd_import_keymap(int argc, char** argv);
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_CLI_COMMANDS_H__
@@ -0,0 +1,57 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_COMPOSE_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_COMPOSE_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_journal.h"
+
+namespace xcore
+{
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // The effective keys of every layer of a keymap, what a key does when that layer is the highest active layer.
+    // A transparent key (KC_TRNS) falls through to the same key on the next active layer below it, the stack of a
+    // layer is the set of layers below it that are active, by default all of them.
+    // The composition is kept for all layers at once, an edit of a key only resolves that key again on the layers
+    // whose stack includes the edited layer, so rendering the composed view costs nothing per frame.
+    struct kcompose_t;
+
+    struct kcomposedkey_t
+    {
+        keycode_t const* m_keycode; // the resolved keycode, nullptr when unknown or when nothing is below
+        s16              m_source;  // the layer that the key resolves to, -1 when it is transparent down to the bottom
+    };
+
+    kcompose_t* compose_create();
+    void        compose_destroy(kcompose_t* c);
+
+    // resolve every key of every layer, 'kcdb' and 'km' are referenced until the next build, the keys should be
+    // compiled (see keyboard_keycode.h)
+    void compose_build(kcompose_t* c, keycodes_t const* kcdb, keymap_t const* km);
+
+    // 'below' is the mask of the layers that are active under 'layer' (bit n = layer n), only layers lower than
+    // 'layer' and below 64 are taken into account, the layer is resolved again
+    void compose_set_stack(kcompose_t* c, s32 layer, u64 below);
+    u64  compose_stack(kcompose_t* c, s32 layer);
+
+    // after 'edit' was applied to the keymap, returns true when any of the composed keys changed
+    bool compose_update(kcompose_t* c, keymap_t const* km, kedit_t const& edit);
+
+    s32                   compose_nb_layers(kcompose_t* c);
+    s32                   compose_nb_keys(kcompose_t* c, s32 layer);
+    kcomposedkey_t const* compose_layer(kcompose_t* c, s32 layer); // compose_nb_keys(c, layer) entries, or nullptr
+    u32                   compose_version(kcompose_t* c);
+
+    // the text to show for a composed key, the key string of the source key when its keycode is unknown, nullptr
+    // when nothing is below
+    const char* compose_label(kcompose_t* c, kcomposedkey_t const& ck, s32 key);
+
+    // whether a key lets the key below show through, KC_TRNS without modifiers or a layer switch
+    bool is_transparent_key(key_t const& key);
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_COMPOSE_H__
@@ -0,0 +1,74 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_CORPUS_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_CORPUS_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_reverse.h"
+
+namespace xcore
+{
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // How often every key is pressed when typing a text corpus on a keymap.
+    // A corpus is reduced once to a histogram of byte pairs (previous byte, byte), the file is memory mapped and
+    // counted in chunks on all workers, every worker has its own histogram. The keymap is not needed for that, so
+    // after an edit only the heatmap is computed again from the 65536 pairs, which takes well under a millisecond.
+    // The heatmap maps every byte to the best key that types it (see keyboard_reverse.h), a byte on another layer
+    // than the byte before it also presses the layer switches that lead there, a byte that needs Shift while the
+    // byte before it did not also presses a Shift key. Layer switches are counted as held (MO) for a run of bytes on
+    // the same layer. A carriage return is ignored, other bytes without a key (e.g. UTF-8) are counted as unmapped.
+    struct kcorpus_t
+    {
+        kcorpus_t()
+        {
+            m_nb_bytes  = 0;
+            m_nb_chunks = 0;
+            m_seconds   = 0.0;
+            m_pairs     = nullptr;
+        }
+
+        s64    m_nb_bytes;
+        s32    m_nb_chunks;
+        double m_seconds; // time it took to count the pairs
+        u64*   m_pairs;   // 256 * 256 counts, indexed by previous byte * 256 + byte, the first byte follows a 0
+    };
+
+    // map and count a file on 'nb_workers' threads (0 = all hardware threads)
+    bool corpus_load(const char* filename, kcorpus_t& corpus, s32 nb_workers = 0);
+    void corpus_release(kcorpus_t& corpus);
+
+    // add the byte pairs of 'data' to 'pairs' (65536 entries), 'previous' is the byte before data[0]
+    void corpus_count(u8 const* data, s64 size, u8 previous, u32* pairs);
+
+    enum
+    {
+        CORPUS_BYTE_UNMAPPED = -1,
+        CORPUS_BYTE_IGNORED  = -2,
+    };
+
+    // the best key for a byte of a corpus, space, enter and tab by their keycode and printable ASCII by the text on
+    // the key, returns 0 or CORPUS_BYTE_UNMAPPED/CORPUS_BYTE_IGNORED (a carriage return)
+    s32 corpus_byte_key(kreverse_t* r, u32 byte, kreversehit_t& hit);
+
+    struct kheatmap_t;
+
+    kheatmap_t* heatmap_create();
+    void        heatmap_destroy(kheatmap_t* h);
+
+    // the key presses of 'corpus' on the keymap that 'r' indexes
+    void heatmap_compute(kheatmap_t* h, kcorpus_t const& corpus, kreverse_t* r, keymap_t const* km);
+
+    s32        heatmap_nb_layers(kheatmap_t* h);
+    s32        heatmap_nb_keys(kheatmap_t* h, s32 layer);
+    u64 const* heatmap_presses(kheatmap_t* h, s32 layer); // per key of the layer, nullptr for an invalid layer
+    u64        heatmap_layer_bytes(kheatmap_t* h, s32 layer); // bytes typed on the layer
+    u64        heatmap_max_presses(kheatmap_t* h);            // the most pressed key, for normalizing
+    u64        heatmap_total(kheatmap_t* h);                  // bytes that have a key
+    u64        heatmap_unmapped(kheatmap_t* h);               // bytes without a key
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_CORPUS_H__
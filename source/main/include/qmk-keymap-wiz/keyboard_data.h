@@ -131,10 +131,37 @@ namespace xcore
 
     void get_color(ImVec4 const& c, u8* color);
 
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // Main and scratch memory used by the JSON decoder. The load functions that take an arena do not touch any global
+    // state, so multiple files can be decoded concurrently as long as every thread uses its own arena.
+    struct karena_t
+    {
+        karena_t()
+        {
+            m_main_memory    = nullptr;
+            m_main_size      = 0;
+            m_scratch_memory = nullptr;
+            m_scratch_size   = 0;
+        }
+
+        void*      m_main_memory;
+        xcore::u32 m_main_size;
+        void*      m_scratch_memory;
+        xcore::u32 m_scratch_size;
+    };
+
+    void init_arena(karena_t& arena, xcore::u32 main_size, xcore::u32 scratch_size);
+    void exit_arena(karena_t& arena);
+
     void init_keyboards();
     void exit_keyboards();
     bool load_keyboards(ckeyboards_t const*& kbs);
     bool reload_keyboards(ckeyboards_t const*& kbs);
+    bool load_keyboards(const char* filename, karena_t& arena, ckeyboards_t const*& kbs, char const** error_message = nullptr);
+
+    // find a keyboard by name, nullptr when there is no keyboard with that name
+    ckeyboard_t const* find_keyboard(ckeyboards_t const* kbs, const char* name);
 
     // -----------------------------------------------------------------------------------------------------------------
     // -----------------------------------------------------------------------------------------------------------------
@@ -164,6 +191,18 @@ namespace xcore
         OSM  = 0x200, // one-shot modifier
     };
 
+    // the JSON name of a modifier bit (see emod), e.g. key_mod_str(0) = "LShift", nullptr when out of range
+    const char* key_mod_str(s32 bit);
+
+    // The compiled form of a key (see keyboard_keycode.h), not part of the JSON, it is filled in by whoever owns the
+    // keymaps once the keycode database is known and reset by every edit of the keycode, modifier or layer fields.
+    enum
+    {
+        KEYCODE_UNKNOWN    = -1,     // m_kc, the keycode is not in the database
+        KEYCODE_UNCOMPILED = -2,     // m_kc, the key has not been compiled (yet)
+        KEYCODE_INVALID    = 0xFFFF, // m_code, the key has no QMK encoding (e.g. LT of a layer above 15)
+    };
+
     struct key_t
     {
         key_t();
@@ -177,6 +216,9 @@ namespace xcore
         const char* m_layer;
         xcore::u8   m_capcolor[4];
         xcore::u8   m_ledcolor[4];
+        xcore::u16  m_code; // the QMK value of the whole key, e.g. LT(2, KC_SPC) = 0x422C
+        xcore::u16  m_tap;  // the QMK value of m_keycode_str on its own
+        xcore::s16  m_kc;   // index of the (tap) keycode in keycodes_t, or KEYCODE_UNKNOWN/KEYCODE_UNCOMPILED
     };
 
     struct layer_t
@@ -197,13 +239,15 @@ namespace xcore
     {
         keymap_t()
         {
+            m_name      = "";
             m_nb_layers = 0;
             m_layers    = nullptr;
         }
 
         XCORE_CLASS_PLACEMENT_NEW_DELETE
 
-        xcore::s32 m_nb_layers;
+        const char* m_name; // name of the keyboard this keymap is for
+        xcore::s32  m_nb_layers;
         layer_t*   m_layers;
     };
 
@@ -224,6 +268,19 @@ namespace xcore
     void init_keymaps();
     void exit_keymaps();
     bool load_keymaps(keymaps_t const*& _keymaps);
+    const char* keymaps_filename(); // the file loaded by load_keymaps(_keymaps)
+    bool load_keymaps(const char* filename, karena_t& arena, keymaps_t const*& _keymaps, char const** error_message = nullptr);
+
+    // index of the layer with this name, -1 when there is no such layer
+    s32 find_layer(keymap_t const* km, const char* name);
+
+    // KC_TRNS and its aliases, the key falls through to the next active layer below
+    bool is_transparent_keycode(const char* keycode);
+
+    // A blank key is KC_NO or transparent without modifiers, layer switch or colors of its own, most keys of the upper
+    // layers are blank. blank_kind returns -1 for a key that is not blank, blank_key makes the blank key of a kind.
+    s32  blank_kind(key_t const& key);
+    void blank_key(s32 kind, key_t& key);
 
     // -----------------------------------------------------------------------------------------------------------------
     // -----------------------------------------------------------------------------------------------------------------
@@ -253,24 +310,41 @@ namespace xcore
         const char*  m_descr;    // A description of the keycode
     };
 
+    struct keycodeslot_t
+    {
+        const char* m_name;  // nullptr when the slot is empty
+        xcore::s32  m_index; // index of the keycode
+    };
+
     struct keycodes_t
     {
         keycodes_t()
         {
             m_nb_keycodes = 0;
             m_keycodes    = nullptr;
+            m_nb_slots    = 0;
+            m_slots       = nullptr;
+            m_values      = nullptr;
         }
 
         XCORE_CLASS_PLACEMENT_NEW_DELETE
 
         xcore::s32 m_nb_keycodes;
         keycode_t* m_keycodes;
+
+        // built when the database is loaded, not part of the JSON
+        xcore::s32     m_nb_slots; // open addressing hash table of every code and alias, a power of 2
+        keycodeslot_t* m_slots;
+        xcore::u16*    m_values;   // the QMK value of every keycode
     };
-    keycode_t const* find_keycode(keycodes_t const* keycodesDB, const char* keycode_str);
+    keycode_t const* find_keycode(keycodes_t const* keycodesDB, const char* keycode_str);   // falls back to the first keycode (KC_NO)
+    keycode_t const* lookup_keycode(keycodes_t const* keycodesDB, const char* keycode_str); // nullptr when the keycode is unknown
+    s32              lookup_keycode_index(keycodes_t const* keycodesDB, const char* name, s32 len); // -1 when the keycode is unknown
 
     void init_keycodes();
     void exit_keycodes();
     bool load_keycodes(keycodes_t const*& _kcds);
+    bool reload_keycodes(keycodes_t const*& _kcds); // true when the file changed and was loaded again
 
 } // namespace xcore
 
@@ -0,0 +1,180 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_EDITOR_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_EDITOR_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "qmk-keymap-wiz/keyboard_compose.h"
+#include "qmk-keymap-wiz/keyboard_corpus.h"
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_graph.h"
+#include "qmk-keymap-wiz/keyboard_journal.h"
+#include "qmk-keymap-wiz/keyboard_model.h"
+#include "qmk-keymap-wiz/keyboard_optimize.h"
+#include "qmk-keymap-wiz/keyboard_reverse.h"
+#include "qmk-keymap-wiz/keyboard_rgb.h"
+#include "qmk-keymap-wiz/keyboard_save.h"
+#include "qmk-keymap-wiz/keyboard_search.h"
+#include "qmk-keymap-wiz/keyboard_simulate.h"
+#include "qmk-keymap-wiz/keyboard_validate.h"
+#include "qmk-keymap-wiz/keyboard_workspace.h"
+
+// The editing state of the GUI: the editable model with its undo history, the journal that makes every edit
+// persistent, the saver that writes the keymaps file, the validator that keeps the diagnostics up to date, the
+// layer graph, the composed (transparent keys resolved) layers and the reverse (character -> keys) index of every
+// keymap.
+struct keditor_t
+{
+    xcore::kmodel_t*     m_model;
+    xcore::kjournal_t*   m_journal;
+    xcore::ksaver_t*     m_saver;
+    xcore::kvalidator_t* m_validator;
+    xcore::s32           m_nb_graphs;
+    xcore::kgraph_t**    m_graphs;   // one per keymap
+    xcore::kcompose_t**  m_composes; // one per keymap
+    xcore::kreverse_t**  m_reverses; // one per keymap
+    bool                 m_show_graph;
+    bool                 m_show_composed;
+    xcore::ksearch_t*    m_search;
+
+    // the keymap files the editor can switch between, the file that is open is pinned in the workspace
+    xcore::kworkspace_t* m_workspace; // nullptr when the keymaps did not come from a workspace
+    xcore::s32           m_entry;     // the file that is open, -1 when none
+    xcore::s32           m_open;      // the file to open at the start of the next frame, -1 when none
+
+    // keycode strings referenced by edits, a reload of the keycode database does not invalidate them
+    xcore::s32 m_nb_strings;
+    xcore::s32 m_max_strings;
+    char**     m_strings;
+
+    // the result of 'find' for the first keymap, queried again when the query or the index changes
+    char                 m_find[32];
+    bool                 m_find_dirty;
+    xcore::s32           m_nb_found;
+    xcore::kreversehit_t m_found[64];
+
+    // the heatmap of a text corpus on the first keymap, computed again after an edit
+    char               m_corpus_path[256];
+    xcore::kcorpus_t   m_corpus;
+    xcore::kheatmap_t* m_heatmap;
+    bool               m_heatmap_dirty;
+    bool               m_show_heatmap;
+
+    // the layout optimizer for the first keymap, started from the optimizer panel, stale after any other edit
+    xcore::koptimizer_t* m_optimizer;
+    xcore::u64           m_optimize_layers;
+    bool                 m_optimizer_stale;
+    bool                 m_show_candidate;
+
+    // the firmware simulator of the first keymap, while 'simulate' is checked the keys clicked in the keyboard view
+    // are pressed on it instead of being selected and the layer tabs follow its layer state, created again after an edit
+    xcore::ksim_t*      m_sim;
+    xcore::ksimparams_t m_sim_params;
+    bool                m_simulate;
+    bool                m_sim_stale;
+    double              m_sim_start; // ImGui time of simulator time 0
+    xcore::s32          m_sim_key;   // the key held down with the mouse, -1 when none
+    xcore::s32          m_sim_layer; // the highest active layer that the tabs followed last
+
+    // the RGB matrix preview of the first keymap, the LED colors of the layer that is shown, taken again after an edit
+    xcore::krgb_t*      m_rgb;
+    xcore::krgbparams_t m_rgb_params;
+    bool                m_show_rgb;
+    bool                m_rgb_dirty;
+    xcore::s32          m_rgb_layer; // the layer of the LED colors, -1 when none
+
+    // the key that is being edited in the key properties popup
+    xcore::s32          m_keymap;
+    xcore::s32          m_layer;
+    xcore::s32          m_key;
+    bool                m_open_popup;
+    char                m_keycode[64];
+    xcore::s32          m_nb_hits; // matches of m_keycode in the keycode database
+    xcore::ksearchhit_t m_hits[12];
+    float               m_color[2][4]; // cap and led color while being edited
+    bool                m_color_active[2];
+};
+
+// replays the journal on top of 'keymaps' (loaded from 'filename') and creates the model
+void                    keyboard_editor_init(keditor_t& editor, const char* filename, xcore::keymaps_t const* keymaps, xcore::keycodes_t const* kcdb, xcore::ckeyboards_t const* kbdb);
+void                    keyboard_editor_exit(keditor_t& editor);
+void                    keyboard_editor_databases(keditor_t& editor, xcore::keycodes_t const* kcdb, xcore::ckeyboards_t const* kbdb); // after a reload
+xcore::keymaps_t const* keyboard_editor_keymaps(keditor_t& editor);
+
+// keyboard_editor_init with the keymaps of a workspace file, they stay pinned until keyboard_editor_exit,
+// false when the file does not decode (the editor is not initialized then)
+bool keyboard_editor_open(keditor_t& editor, xcore::kworkspace_t* ws, xcore::s32 entry, xcore::keycodes_t const* kcdb, xcore::ckeyboards_t const* kbdb);
+
+// the files of the workspace with their keyboard and layers, a click on one asks to open it
+void keyboard_editor_workspace(keditor_t& editor, float height);
+
+// opens the file that keyboard_editor_workspace asked for, the file that was open is saved and closed first,
+// call it at the start of a frame; true when the editor switched to another file
+bool keyboard_editor_switch(keditor_t& editor, xcore::keycodes_t const* kcdb, xcore::ckeyboards_t const* kbdb);
+
+bool keyboard_editor_apply(keditor_t& editor, xcore::kedit_t const& edit);
+bool keyboard_editor_undo(keditor_t& editor);
+bool keyboard_editor_redo(keditor_t& editor);
+
+// once per frame, handles the undo/redo shortcuts and flushes the journal
+void keyboard_editor_update(keditor_t& editor);
+void keyboard_editor_toolbar(keditor_t& editor);
+
+// open the key properties popup for a key
+void keyboard_editor_select(keditor_t& editor, xcore::s32 keymap, xcore::s32 layer, xcore::s32 key);
+void keyboard_editor_popup(keditor_t& editor, xcore::keycodes_t const* kcdb);
+
+// the list of diagnostics, clicking one selects the key
+void keyboard_editor_diagnostics(keditor_t& editor, float height);
+
+// overlay of the layer graph of a keymap in a square of 'size' at (posx, posy), 'layer' is highlighted
+void keyboard_editor_layer_graph(keditor_t& editor, xcore::s32 keymap, xcore::s32 layer, float posx, float posy, float size);
+
+// find a character or keycode ('{', 'KC_LBRC'), lists the keys that type it with the modifiers and layer switches
+// needed, clicking one selects the key
+void keyboard_editor_find(keditor_t& editor, float height);
+
+// marks the keys of 'layer' that were found, the keyboard is laid out as keyboard_render does
+void keyboard_editor_find_overlay(keditor_t& editor, xcore::ckeyboard_t const* kb, xcore::s32 layer, float posx, float posy, float globalscale);
+
+// the heatmap of the first keymap when a corpus is loaded and the toolbar has 'heatmap' checked, nullptr otherwise
+xcore::kheatmap_t* keyboard_editor_heatmap(keditor_t& editor, xcore::s32 keymap);
+
+// the layout optimizer: the layers to rearrange, start/stop, the progress and applying the best layout as edits,
+// needs a loaded corpus and the keyboard of the keymap (nullptr when it is not in the keyboard database)
+void keyboard_editor_optimizer(keditor_t& editor, xcore::ckeyboard_t const* kb);
+
+// the best layout of the optimizer when the panel has 'show candidate' checked, nullptr otherwise
+xcore::keymap_t const* keyboard_editor_candidate(keditor_t& editor);
+
+// the simulator: 'simulate', the tapping term, the active layers (the highest one highlighted) and the HID report
+void keyboard_editor_simulator(keditor_t& editor);
+
+// a click on 'key' (-1 when the mouse is not on a key) presses it on the simulator until the mouse button goes up,
+// returns false when not simulating
+bool keyboard_editor_simulate_mouse(keditor_t& editor, xcore::s32 key);
+
+// the layers that are active on the simulator (bit n = layer n), 0 when not simulating
+xcore::u32 keyboard_editor_simulate_layers(keditor_t& editor);
+
+// the highest active layer of the simulator when it changed since the last call, -1 otherwise
+xcore::s32 keyboard_editor_simulate_follow(keditor_t& editor);
+
+// marks the keys that are down on the simulator, the keyboard is laid out as keyboard_render does
+void keyboard_editor_simulate_overlay(keditor_t& editor, xcore::ckeyboard_t const* kb, float posx, float posy, float globalscale);
+
+// the RGB matrix preview: 'rgb', the effect, its speed and the brightness
+void keyboard_editor_rgb(keditor_t& editor);
+
+// the RGB effect of this frame with the LED colors of 'layer' of the first keymap, to pass to keyboard_render,
+// nullptr when the preview is off
+xcore::krgb_t* keyboard_editor_rgb_frame(keditor_t& editor, xcore::ckeyboard_t const* kb, xcore::s32 layer);
+
+// a press of 'key' for the reactive and splash effects
+void keyboard_editor_rgb_hit(keditor_t& editor, xcore::s32 key);
+
+// the composed layers of a keymap when the toolbar has 'resolve transparent' checked, nullptr otherwise
+xcore::kcompose_t* keyboard_editor_compose(keditor_t& editor, xcore::s32 keymap);
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_EDITOR_H__
@@ -0,0 +1,32 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_EXPORT_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_EXPORT_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_writer.h"
+
+namespace xcore
+{
+    // QMK source generation, everything is streamed into the writer.
+    // - keymap.c, the LAYOUT(...) array of every layer
+    // - layers.h, the enum with a '_NAME' entry for every layer
+    // The keyboard (optional) is used to break the LAYOUT arguments into the rows of the physical keyboard.
+    bool export_keymap_c(kwriter_t& w, keymap_t const* km, ckeyboard_t const* kb);
+    bool export_layers_h(kwriter_t& w, keymap_t const* km);
+
+    // a single key, e.g. 'KC_A', 'LSFT(KC_A)', 'LT(_NAV, KC_SPC)', 'MT(MOD_LCTL | MOD_LSFT, KC_A)' or 'OSM(MOD_LSFT)'
+    void export_key(kwriter_t& w, key_t const& key);
+
+    // the same from the compiled form of the key (see keyboard_keycode.h), layers are written as the enum of the
+    // layer they resolved to, keys that are not compiled are written from their fields
+    void export_key(kwriter_t& w, keymap_t const* km, key_t const& key);
+
+    // the enum entry of a layer, e.g. "Nav 2" -> '_NAV_2'
+    void export_layer_enum(kwriter_t& w, const char* layer_name);
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_EXPORT_H__
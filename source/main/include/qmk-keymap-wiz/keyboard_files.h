@@ -0,0 +1,58 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_FILES_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_FILES_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+namespace xcore
+{
+    // A list of file paths, collected by enumerate_files
+    struct kfiles_t
+    {
+        kfiles_t()
+        {
+            m_nb_files  = 0;
+            m_max_files = 0;
+            m_files     = nullptr;
+        }
+
+        s32    m_nb_files;
+        s32    m_max_files;
+        char** m_files;
+    };
+
+    // A read-only memory mapping of a whole file
+    struct kmapping_t
+    {
+        kmapping_t()
+        {
+            m_data = nullptr;
+            m_size = 0;
+            m_file = nullptr;
+            m_map  = nullptr;
+        }
+
+        u8 const* m_data;
+        s64       m_size;
+        void*     m_file; // platform handles
+        void*     m_map;
+    };
+
+    bool map_file(const char* filename, kmapping_t& mapping); // an empty file maps to m_data == nullptr, m_size == 0
+    void unmap_file(kmapping_t& mapping);
+
+    // collect all files in 'dir' ending with 'ext' (e.g. ".json"), sorted by path
+    bool enumerate_files(const char* dir, const char* ext, bool recursive, kfiles_t& files);
+    void release_files(kfiles_t& files);
+
+    bool        make_dir(const char* dir);                            // ok when the directory already exists
+    bool        replace_file(const char* from, const char* to);       // atomic rename, 'to' is replaced when it exists
+    bool        delete_file(const char* filename);                    // ok when the file does not exist
+    s64         file_size(const char* filename);                      // -1 when the file does not exist
+    const char* file_basename(const char* path);                      // "keymaps/jurgen.json" -> "jurgen.json"
+    void        file_stem(const char* path, char* stem, s32 maxlen); // "keymaps/jurgen.json" -> "jurgen"
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_FILES_H__
@@ -0,0 +1,18 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_FINGERPRINT_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_FINGERPRINT_H__
+#pragma once
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_writer.h"
+
+// Fingerprints of the draw lists that keyboard_render emits for a fixed set of scenes: the synthetic keyboards of the
+// benchmark (36 and 360 keys), the first, second and last layer, three global scales and the mouse nowhere, on the
+// first key and on the last (rotated) key. Per scene the vertex, index and draw command counts are kept together with
+// - a hash of everything but the positions (indices, UVs, colors, elements per command), which has to be exact
+// - a hash of the positions and clip rectangles snapped to a grid of 'tolerance' pixels
+// - the mean, bounds and spread of the positions, which have to be within 'tolerance' when the hash differs
+// Scenes are compared with the golden file, with 'update' the golden file is written instead. The goldens depend on
+// the keycode database and the fonts. The result of every scene goes to 'out' as JSON when it is not null.
+bool keyboard_fingerprint(xcore::kwriter_t* out, xcore::keycodes_t const* kcdb, const char* golden, bool update, float tolerance, const char* tmpdir);
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_FINGERPRINT_H__
@@ -0,0 +1,85 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_GRAPH_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_GRAPH_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_journal.h"
+#include "qmk-keymap-wiz/keyboard_validate.h"
+
+namespace xcore
+{
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // The layer graph of a keymap, every layer switch key is an edge from the layer it is on to the layer it targets.
+    // Layers are analyzed from the base layer (layer 0):
+    // - unreachable, no chain of layer switch keys leads from the base layer to the layer
+    // - trap, the layer can be entered persistently (TG, TO, TT) but there is no way back to the base layer, a layer
+    //   has a way back when it can toggle itself off (TG/TT of itself, or a transparent key where the toggle key sits
+    //   on the layer below), when it has TO of the base layer, when it momentarily activates a layer that has TO of
+    //   the base layer or when it has TO of a layer that has a way back
+    // - cycle, layers that momentarily (MO, LT, OSL) activate each other
+    // Only the first 64 layers of a keymap are part of the graph, QMK itself supports at most 32.
+    enum
+    {
+        GRAPH_MAX_LAYERS = 64,
+    };
+
+    enum eedge
+    {
+        EDGE_MOMENTARY  = 0x01, // MO, LT and the hold of TT
+        EDGE_TOGGLE     = 0x02, // TG and the tap of TT
+        EDGE_SWITCH     = 0x04, // TO
+        EDGE_ONESHOT    = 0x08, // OSL
+        EDGE_PERSISTENT = EDGE_TOGGLE | EDGE_SWITCH,
+    };
+
+    u32 edge_kinds(u16 layer_switch); // elayer_switch -> eedge mask
+
+    struct kgraphedge_t
+    {
+        s16 m_from;
+        s16 m_to;
+        u16 m_kinds; // eedge mask
+        u16 m_count; // number of keys making this edge
+    };
+
+    struct kgraphlayer_t
+    {
+        bool m_reachable;
+        bool m_trap;
+        s16  m_depth; // number of switches needed from the base layer, -1 when unreachable
+        s16  m_cycle; // index of the momentary cycle that the layer is part of, -1 when none
+        u16  m_via;   // eedge mask of the edges that enter the layer from reachable layers
+    };
+
+    struct kgraph_t;
+
+    kgraph_t* graph_create();
+    void      graph_destroy(kgraph_t* g);
+
+    // build the graph of a keymap, 'km' is referenced until the next build
+    void graph_build(kgraph_t* g, keymap_t const* km);
+
+    // after 'edit' was applied to the keymap, only the key that the edit touches is re-examined, the analysis is
+    // only done again when the edges or the transparent keys changed, in which case it returns true.
+    bool graph_update(kgraph_t* g, keymap_t const* km, kedit_t const& edit);
+
+    s32                  graph_nb_layers(kgraph_t* g);
+    kgraphlayer_t const* graph_layers(kgraph_t* g);
+    s32                  graph_nb_edges(kgraph_t* g);
+    kgraphedge_t const*  graph_edges(kgraph_t* g);
+    s32                  graph_nb_cycles(kgraph_t* g);
+    u32                  graph_version(kgraph_t* g);
+
+    // report unreachable layers, traps and cycles as diagnostics (layer level, m_key is -1), returns the count
+    s32 graph_lint(kgraph_t* g, keymap_t const* km, diag_fn fn, void* user);
+
+    // build + lint in one go, for the headless path
+    s32 lint_layers(keymap_t const* km, diag_fn fn, void* user);
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_GRAPH_H__
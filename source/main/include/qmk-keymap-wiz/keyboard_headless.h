@@ -0,0 +1,16 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_HEADLESS_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_HEADLESS_H__
+#pragma once
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+
+// Headless rendering of a keyboard layer, without GLFW, OpenGL or an ImGui context. The key geometry, colors and
+// labels are the same as keyboard_render. The fonts are loaded into a CPU-only font atlas once by
+// keyboard_headless_init, after that the render functions can be called concurrently from multiple threads.
+bool keyboard_headless_init();
+void keyboard_headless_exit();
+
+bool keyboard_render_svg(const char* filename, xcore::ckeyboard_t const* kb, xcore::keycodes_t const* kcdb, xcore::keymap_t const* km, xcore::s32 layer, float globalscale);
+bool keyboard_render_png(const char* filename, xcore::ckeyboard_t const* kb, xcore::keycodes_t const* kcdb, xcore::keymap_t const* km, xcore::s32 layer, float globalscale);
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_HEADLESS_H__
@@ -0,0 +1,42 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_IMAGE_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_IMAGE_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+namespace xcore
+{
+    // A software RGBA8 image, used by the headless renderer to rasterize keyboards without a GPU
+    struct kimage_t
+    {
+        kimage_t()
+        {
+            m_w      = 0;
+            m_h      = 0;
+            m_pixels = nullptr;
+        }
+
+        s32 m_w;
+        s32 m_h;
+        u8* m_pixels; // m_w * m_h * 4 bytes, RGBA, not pre-multiplied
+    };
+
+    void init_image(kimage_t& img, s32 w, s32 h, u8 const* clear_color);
+    void exit_image(kimage_t& img);
+
+    // Shapes are given in the local space of a pivot (px, py) that they are rotated around by 'rad' radians,
+    // (cx, cy) is the center of the shape relative to the pivot. When 'stroke' is 0 the shape is filled,
+    // otherwise an outline of 'stroke' pixels is drawn centered on the edge (like ImDrawList::AddRect).
+    void image_roundrect(kimage_t& img, float px, float py, float rad, float cx, float cy, float hw, float hh, float rounding, float stroke, float const* color);
+
+    // Blend a coverage mask (e.g. a glyph from a font atlas) into the image, the quad (x0,y0)-(x1,y1) is in the
+    // local space of the pivot and is mapped to the texel rectangle (u0,v0)-(u1,v1) of the mask.
+    void image_mask(kimage_t& img, float px, float py, float rad, float x0, float y0, float x1, float y1, u8 const* mask, s32 mask_w, s32 mask_h, float u0, float v0, float u1, float v1, float const* color);
+
+    // Write the image as a PNG file, compressed with LZ77 and fixed Huffman codes
+    bool write_png(const char* filename, kimage_t const& img);
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_IMAGE_H__
@@ -0,0 +1,45 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_INFOJSON_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_INFOJSON_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+
+namespace xcore
+{
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // Import of the 'layouts' of a QMK info.json (or keyboard.json) as keyboards.
+    // Every layout becomes a keyboard named '<name> <layout>', e.g. "splitkb/kyria/rev3 LAYOUT_split_3x6_5". The keys
+    // of a layout are { x, y, w, h, r, rx, ry, label } in key units, x/y the top left corner before the rotation of
+    // r degrees (clockwise) around rx/ry. Keys that follow each other in the layout on the same row, with the same
+    // size and rotation and without a gap, become one keygroup of a single row, every other key a keygroup of its own.
+    // The index of a key is its position in the layout, the order of the arguments of LAYOUT(...) in a keymap.c.
+    // Only the file itself is read, layouts that a keyboard inherits from an info.json in a parent directory are
+    // imported from that file. The parser skips everything but the layouts and accepts the comments and trailing
+    // commas that QMK accepts (hjson).
+    struct kinfoboards_t
+    {
+        kinfoboards_t()
+        {
+            m_nb_keyboards = 0;
+            m_keyboards    = nullptr;
+            m_nb_keys      = 0;
+            m_memory       = nullptr;
+        }
+
+        s32          m_nb_keyboards;
+        ckeyboard_t* m_keyboards;
+        s32          m_nb_keys; // over all keyboards
+        void*        m_memory;  // the keyboards, keygroups, keys and strings, one allocation
+    };
+
+    // 'json' does not have to be zero terminated, on failure 'error' (when not nullptr) says why
+    bool infojson_import(const char* json, s64 size, const char* name, kinfoboards_t& boards, const char** error = nullptr);
+    void infojson_release(kinfoboards_t& boards);
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_INFOJSON_H__
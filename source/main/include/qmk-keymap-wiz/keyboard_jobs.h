@@ -0,0 +1,23 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_JOBS_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_JOBS_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+namespace xcore
+{
+    // Job function, 'index' is the job index in [0, count), 'worker' is the index of the worker thread in
+    // [0, nb_workers) so that a job can use per-worker data (e.g. a karena_t) without any locking.
+    typedef void (*job_fn)(s32 index, s32 worker, void* user);
+
+    // number of hardware threads
+    s32 jobs_nb_workers();
+
+    // run 'count' jobs on 'nb_workers' threads (0 = all hardware threads) and wait for all of them to finish,
+    // idle workers steal jobs from busy ones
+    void jobs_parallel_for(s32 count, job_fn fn, void* user, s32 nb_workers = 0);
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_JOBS_H__
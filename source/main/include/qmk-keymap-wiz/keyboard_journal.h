@@ -0,0 +1,89 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_JOURNAL_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_JOURNAL_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+
+namespace xcore
+{
+    struct ksaver_t;
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // A single edit of a keymap, every edit sets a field to a value (no deltas) so replaying an edit twice gives the
+    // same result as replaying it once.
+    enum eedit
+    {
+        EDIT_KEYCODE,        // m_str
+        EDIT_MOD,            // m_value
+        EDIT_MOD_TAP,        // m_value
+        EDIT_LAYER_SWITCH,   // m_value
+        EDIT_LAYER,          // m_str
+        EDIT_KEY_CAPCOLOR,   // m_color
+        EDIT_KEY_LEDCOLOR,   // m_color
+        EDIT_LAYER_CAPCOLOR, // m_color, m_key is ignored
+        EDIT_LAYER_LEDCOLOR, // m_color, m_key is ignored
+        EDIT_COUNT,
+    };
+
+    struct kedit_t
+    {
+        kedit_t()
+        {
+            m_op     = EDIT_KEYCODE;
+            m_keymap = 0;
+            m_layer  = 0;
+            m_key    = 0;
+            m_value  = 0;
+            m_str    = nullptr;
+            for (s32 i = 0; i < 4; ++i)
+                m_color[i] = 0;
+        }
+
+        s32         m_op;
+        s32         m_keymap;
+        s32         m_layer;
+        s32         m_key;
+        u32         m_value;
+        const char* m_str; // not owned, must outlive the keymap that the edit is applied to
+        u8          m_color[4];
+    };
+
+    inline bool is_layer_edit(s32 op) { return op == EDIT_LAYER_CAPCOLOR || op == EDIT_LAYER_LEDCOLOR; }
+
+    // apply an edit, returns false when the edit does not address an existing keymap, layer or key
+    bool apply_edit(keymaps_t* keymaps, kedit_t const& edit);
+    bool apply_key_edit(key_t& key, kedit_t const& edit);       // m_keymap, m_layer and m_key are ignored
+    bool apply_layer_edit(layer_t& layer, kedit_t const& edit); // only EDIT_LAYER_CAPCOLOR and EDIT_LAYER_LEDCOLOR
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // Append-only journal of edits, stored next to the keymaps file as '<file>.journal'.
+    // Appended edits are buffered and written + fsync'd in batches by journal_update. When the journal grows beyond
+    // a threshold the keymaps are saved as JSON (through a ksaver_t, in the background) and the journal is restarted.
+    // During compaction the previous journal is kept as '<file>.journal.old' until the JSON has been written, a crash
+    // in between is harmless since replaying edits that are already part of the JSON changes nothing.
+    struct kjournal_t;
+
+    kjournal_t* journal_open(const char* filename); // 'filename' is the keymaps file
+    void        journal_close(kjournal_t* journal); // flushes the pending edits
+
+    // replay the journal(s) on top of keymaps that have just been loaded from the JSON, returns the number of
+    // edits applied. A torn record at the end of the journal (crash during a write) is discarded.
+    s32 journal_replay(kjournal_t* journal, keymaps_t* keymaps);
+
+    void journal_append(kjournal_t* journal, kedit_t const& edit);
+    bool journal_flush(kjournal_t* journal); // write and fsync the pending edits now
+
+    // call regularly (e.g. once per frame), flushes the pending edits when the batch is full or old enough and
+    // compacts the journal into the keymaps file when it has grown too large
+    void journal_update(kjournal_t* journal, ksaver_t* saver, keymaps_t const* keymaps);
+
+    s64 journal_size(kjournal_t* journal); // bytes in the journal file, including pending edits
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_JOURNAL_H__
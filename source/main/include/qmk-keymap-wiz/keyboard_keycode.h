@@ -0,0 +1,85 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_KEYCODE_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_KEYCODE_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+
+namespace xcore
+{
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // Keycodes as 16-bit QMK values.
+    // A key is compiled once, when the keymaps are loaded or when the key is edited, into the value QMK would give it
+    // (e.g. LT(2, KC_SPC) = 0x422C) and the index of its keycode in the database. Rendering, validation and export
+    // work on those instead of looking the keycode string up again and again.
+    // The parser understands the compound forms of QMK:
+    // - modifier wrappers, LCTL(kc), S(kc), MEH(kc), HYPR(kc), ...
+    // - MT(mods, kc), LT(layer, kc), LM(layer, mods), MO/TG/TO/TT/OSL/DF(layer), OSM(mods)
+    // - mod-taps, LCTL_T(kc), SFT_T(kc), MEH_T(kc), ...
+    // - mods as 'MOD_LCTL | MOD_LSFT' or a number, layers as a number, a layer name or its enum ('_NAV')
+    // Keycodes of the database that are not QMK keycodes (user keycodes) get a value in the QK_USER range.
+    enum eqmk
+    {
+        QK_BASIC            = 0x0000,
+        QK_BASIC_MAX        = 0x00FF,
+        QK_MODS             = 0x0100,
+        QK_MODS_MAX         = 0x1FFF,
+        QK_MOD_TAP          = 0x2000,
+        QK_MOD_TAP_MAX      = 0x3FFF,
+        QK_LAYER_TAP        = 0x4000,
+        QK_LAYER_TAP_MAX    = 0x4FFF,
+        QK_LAYER_MOD        = 0x5000,
+        QK_LAYER_MOD_MAX    = 0x51FF,
+        QK_TO               = 0x5200,
+        QK_MOMENTARY        = 0x5220,
+        QK_DEF_LAYER        = 0x5240,
+        QK_TOGGLE_LAYER     = 0x5260,
+        QK_ONE_SHOT_LAYER   = 0x5280,
+        QK_ONE_SHOT_MOD     = 0x52A0,
+        QK_LAYER_TAP_TOGGLE = 0x52C0,
+        QK_USER             = 0x7E40,
+        QK_USER_MAX         = 0x7FFF,
+    };
+
+    // the 5-bit modifier mask that QMK packs into a keycode, the right bit applies to all of the others
+    enum eqmkmod
+    {
+        QMOD_CTL   = 0x01,
+        QMOD_SFT   = 0x02,
+        QMOD_ALT   = 0x04,
+        QMOD_GUI   = 0x08,
+        QMOD_RIGHT = 0x10,
+    };
+
+    // emod <-> 5-bit mask, returns false when left and right modifiers are mixed (QMK cannot encode that)
+    bool qmk_mods(u16 mods, u8& qmods);
+    u16  emod_from_qmk(u8 qmods);
+
+    struct kkeycode_t
+    {
+        u16 m_value; // QMK value
+        s16 m_index; // index of the keycode in the database, -1 for a numeric keycode
+    };
+
+    // parse a keycode expression, 'km' (optional) resolves layer names, returns false when the expression is not
+    // understood or refers to an unknown keycode or layer
+    bool parse_keycode(keycodes_t const* kcdb, keymap_t const* km, const char* expr, kkeycode_t& out);
+
+    // the QMK value of every keycode of the database, called when the database is loaded
+    void keycode_values(keycodes_t const* kcdb, u16* values);
+
+    // fill in m_code, m_tap and m_kc of a key, false when the key has no QMK encoding (m_code is KEYCODE_INVALID)
+    bool compile_key(keycodes_t const* kcdb, keymap_t const* km, key_t& key);
+    void compile_keymap(keycodes_t const* kcdb, keymap_t* km);
+    void compile_keymaps(keycodes_t const* kcdb, keymaps_t* keymaps);
+
+    // the keycode of a key, from the compiled index or by parsing the keycode string when the key is not compiled,
+    // nullptr when the keycode is unknown
+    keycode_t const* key_keycode(keycodes_t const* kcdb, key_t const& key);
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_KEYCODE_H__
@@ -0,0 +1,55 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_KEYMAPC_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_KEYMAPC_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+
+namespace xcore
+{
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // Import of a QMK keymap.c as a keymap.
+    // The file is split into C tokens (comments skipped, strings kept as one token) and the preprocessor lines are
+    // only read for their #define's, #include and #if are ignored, so every branch of an #if is seen. From the tokens
+    // the importer takes the enumerators of every enum and the entries of the 'keymaps' array, '[_NAV] =
+    // LAYOUT_xxx(k, k, ...)'. An entry is expanded with the #define's of the file (object and function-like,
+    // __VA_ARGS__, no # or ##) before it is split into the arguments of the LAYOUT macro, so aliases like
+    // '#define HOME_A LGUI_T(KC_A)' and wrappers like 'LAYOUT_wrapper(...)' resolve, macros from other files
+    // (userspace rows) do not.
+    // A layer is named after its enumerator without the leading underscores ('_NAV' -> "NAV"), or "Layer <n>" when
+    // the index is a number, layers that the array skips are empty. Every key is the text of its argument, with
+    // layer enumerators replaced by the layer names. With a keycode database the keys are compiled, and LT, MO, TG,
+    // TO, TT, OSL, MT, OSM, the mod-taps and the modifier wrappers are taken apart into keycode, modifiers and layer
+    // switch the way the editor makes them, as long as that compiles to the same QMK value; anything else (and a
+    // keycode that is not in the database) is kept as the expression.
+    struct kkeymapc_t
+    {
+        kkeymapc_t()
+        {
+            m_nb_layers  = 0;
+            m_nb_keys    = 0;
+            m_nb_unknown = 0;
+            m_nb_defines = 0;
+            m_memory     = nullptr;
+        }
+
+        keymaps_t m_keymaps;    // one keymap
+        s32       m_nb_layers;  //
+        s32       m_nb_keys;    // over all layers
+        s32       m_nb_unknown; // keys that did not compile, 0 without a keycode database
+        s32       m_nb_defines; // #define's in the file
+        void*     m_memory;     // the keymap, layers, keys and strings, one allocation
+    };
+
+    // 'src' does not have to be zero terminated, 'keyboard' (e.g. "splitkb/kyria/rev3") and the name of the LAYOUT
+    // macro make the keymap name, "splitkb/kyria/rev3 LAYOUT_split_3x6_5" like the keyboards of infojson_import.
+    // 'kcdb' can be nullptr. On failure 'error' (when not nullptr) says why.
+    bool keymapc_import(const char* src, s64 size, const char* keyboard, keycodes_t const* kcdb, kkeymapc_t& keymap, const char** error = nullptr);
+    void keymapc_release(kkeymapc_t& keymap);
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_KEYMAPC_H__
@@ -0,0 +1,44 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_LAYOUT_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_LAYOUT_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+
+namespace xcore
+{
+    // The placement of a single key cap in screen space, this is the geometry that the renderers (ImGui, SVG
+    // and PNG) draw and that the hit-testing uses.
+    struct ckeyplace_t
+    {
+        ckeygroup_t const* m_group;
+        ckey_t const*      m_key;
+        float              m_x;        // center of the key
+        float              m_y;        //
+        float              m_hw;       // half width of the key cap (spacing removed)
+        float              m_hh;       // half height of the key cap (spacing removed)
+        float              m_rounding; // corner rounding of the key cap
+        float              m_th;       // thickness of the led glow
+        float              m_rad;      // rotation of the key around its center, in radians
+        u8 const*          m_capcolor; // resolved color (keyboard -> keygroup -> key)
+        u8 const*          m_txtcolor; //
+        u8 const*          m_ledcolor; //
+    };
+
+    // total number of keys of a keyboard (sum of all keygroup keys)
+    s32 keyboard_nb_keys(ckeyboard_t const* kb);
+
+    // compute the placement of every key, returns the number of placed keys
+    s32 keyboard_layout(ckeyboard_t const* kb, float posx, float posy, float globalscale, ckeyplace_t* places, s32 max_places);
+
+    // is the point (px, py) inside of the (rotated) key cap
+    bool keyplace_contains(ckeyplace_t const& place, float px, float py);
+
+    // the text to display on a key for a specific layer of a keymap
+    const char* keyplace_label(ckeyplace_t const& place, keycodes_t const* kcdb, keymap_t const* km, s32 layer);
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_LAYOUT_H__
@@ -0,0 +1,62 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_MODEL_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_MODEL_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_journal.h"
+
+namespace xcore
+{
+    // Editable keymaps with unlimited undo/redo.
+    // Every edit creates a snapshot, snapshots are persistent (copy-on-write) trees of keymaps -> layers -> blocks
+    // of keys, an edit only copies the path to the key it changes and shares everything else with the previous
+    // snapshot. The memory used by the history is therefore proportional to the number of edits, not to the size
+    // of the keymaps. Within a snapshot only the keys that are not blank (KC_NO/KC_TRNS) are stored.
+    // The model also maintains a plain keymaps_t that reflects the current snapshot, this is what the rest of the
+    // application (rendering, exporting, saving) reads. It is dense, a key_t for every key of every layer, so only
+    // the memory of the snapshots scales with the keys that are not blank, not that of the model as a whole.
+    struct kmodel_t;
+
+    // callback for every change made to the current keymaps, e.g. to journal it or to mark a layer dirty
+    typedef void (*edit_fn)(kedit_t const& edit, void* user);
+
+    // the strings of 'keymaps' are referenced, not copied, they must outlive the model
+    kmodel_t*        model_create(keymaps_t const* keymaps);
+    void             model_destroy(kmodel_t* model);
+    keymaps_t const* model_keymaps(kmodel_t* model);
+
+    // compile the keys of the current keymaps for a keycode database (see keyboard_keycode.h), from then on every key
+    // that an edit, undo or redo changes is compiled again before 'fn' is called
+    void model_compile(kmodel_t* model, keycodes_t const* kcdb);
+
+    // returns false when the edit does not address an existing key or layer, or does not change anything
+    bool model_apply(kmodel_t* model, kedit_t const& edit, edit_fn fn, void* user);
+
+    // the edits applied between begin and end become a single snapshot, they are undone and redone as one step
+    void model_begin_group(kmodel_t* model);
+    void model_end_group(kmodel_t* model);
+
+    // 'fn' is called with the edits that bring the keymaps to the previous/next snapshot
+    bool model_undo(kmodel_t* model, edit_fn fn, void* user);
+    bool model_redo(kmodel_t* model, edit_fn fn, void* user);
+    bool model_can_undo(kmodel_t* model);
+    bool model_can_redo(kmodel_t* model);
+
+    struct kmodel_stats_t
+    {
+        s32 m_nb_snapshots; // snapshots in the history
+        s32 m_current;      // index of the current snapshot
+        s64 m_nb_nodes;     // allocated keymap, layer and key block nodes (shared nodes are counted once)
+        s64 m_nb_bytes;     // memory used by all snapshots
+        s64 m_nb_keys;      // keys in the current snapshot
+        s64 m_nb_stored;    // keys in the current snapshot that are not blank, only those take snapshot memory
+    };
+
+    void model_stats(kmodel_t* model, kmodel_stats_t& stats);
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_MODEL_H__
@@ -0,0 +1,79 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_OPTIMIZE_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_OPTIMIZE_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "qmk-keymap-wiz/keyboard_corpus.h"
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_journal.h"
+#include "qmk-keymap-wiz/keyboard_reverse.h"
+
+namespace xcore
+{
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // Layout optimizer, rearranges the keys of a set of layers to make a corpus easier to type.
+    // Only plain keys move (no modifiers, mod-taps, layer switches or transparent keys), the colors stay where they
+    // are. The cost per byte of the corpus is:
+    // - effort, the distance of the key from the home position of its finger, weighted per finger (the fingers
+    //   follow from the geometry of the keyboard, the home keys (m_nob) and the center line between the hands)
+    // - same finger bigrams, two different keys after each other on the same finger, weighted by their distance
+    // - layer switches, two bytes after each other on different layers, and the depth of a layer
+    // The corpus is reduced to the symbols that move (the keys) and the symbols that stay, with their unigram and
+    // bigram counts, so a swap of two keys is scored by a delta over the symbols in O(number of symbols).
+    // The search is parallel tempering, a number of annealing chains at fixed temperatures run in rounds on all
+    // workers, between rounds neighbouring chains exchange their layouts. It runs on a thread of its own, every
+    // better layout is published as a candidate keymap and as the edits that turn the keymap into it.
+    struct koptimize_params_t
+    {
+        u64   m_layers;          // the layers whose keys are rearranged, bit n = layer n
+        s32   m_nb_chains;       // chains (temperatures), 0 = 2 per worker
+        s32   m_nb_workers;      // 0 = all hardware threads
+        s32   m_swaps_per_round; // per chain
+        s32   m_nb_rounds;       // 0 = until stopped
+        float m_effort_weight;
+        float m_sfb_weight;
+        float m_layer_weight;
+        float m_t_min; // temperature of the coldest and hottest chain, in cost per byte
+        float m_t_max;
+        u32   m_seed;
+    };
+
+    void optimize_defaults(koptimize_params_t& params);
+
+    struct koptimize_stats_t
+    {
+        s32    m_nb_symbols; // keys that move
+        s64    m_nb_swaps;   // evaluated swaps, all chains
+        s32    m_nb_rounds;
+        double m_seconds;
+        double m_initial_cost; // per byte
+        double m_best_cost;
+        u32    m_version; // the number of times a better layout was found
+        bool   m_running;
+    };
+
+    struct koptimizer_t;
+
+    // everything that is needed is copied, 'kb', 'km', 'r' and 'corpus' can change after this returns, the keycode
+    // strings of 'km' are referenced by the candidate and the edits
+    koptimizer_t* optimizer_create(ckeyboard_t const* kb, keymap_t const* km, kreverse_t* r, kcorpus_t const& corpus, koptimize_params_t const& params);
+    void          optimizer_destroy(koptimizer_t* o); // stops the search
+
+    void optimizer_start(koptimizer_t* o);
+    void optimizer_stop(koptimizer_t* o); // waits for the current round to finish
+    void optimizer_run(koptimizer_t* o);  // on the calling thread, until m_nb_rounds or optimizer_stop
+    void optimizer_stats(koptimizer_t* o, koptimize_stats_t& stats);
+
+    // the keymap with the best layout so far, valid until the next call, can be called while the search is running
+    keymap_t const* optimizer_candidate(koptimizer_t* o);
+
+    // the keycode edits that turn the keymap that the optimizer was created for into the best layout so far, for
+    // keymap 'keymap', returns the number of edits
+    s32 optimizer_edits(koptimizer_t* o, s32 keymap, void (*fn)(kedit_t const& edit, void* user), void* user);
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_OPTIMIZE_H__
@@ -0,0 +1,101 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_PROFILE_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_PROFILE_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+namespace xcore
+{
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // Scoped timing zones. A zone is recorded as (zone, begin, end) into a ring buffer of the thread that runs it,
+    // only that thread writes to its ring and publishes an event by moving the head (release), so recording takes
+    // no locks. Readers (the frame graph, the trace export) copy events behind the head and drop the ones that
+    // were overwritten while copying. A thread claims a ring on its first zone and gives it back when it exits,
+    // the worker threads of jobs_parallel_for come and go without running out of rings.
+    //
+    // profile_frame aggregates the events that completed since the previous frame into a per zone history of
+    // milliseconds per frame, profile_export writes the events that are still in the rings as a Chrome trace
+    // (chrome://tracing, Perfetto).
+    //
+    // Heap allocations are counted per frame and per zone, an allocation belongs to the innermost zone of the
+    // thread that makes it (PROFILE_NB_ZONES when there is none). The counting hooks are the ImGui allocator
+    // functions (keyboard_profile_allocators) and the global operator new, see keyboard_memory.cpp.
+    enum eprofile_zone
+    {
+        PROFILE_FRAME = 0,
+        PROFILE_LOAD_KEYCODES,
+        PROFILE_LOAD_KEYBOARDS,
+        PROFILE_LOAD_KEYMAPS,
+        PROFILE_RELOAD,
+        PROFILE_EDITOR_UPDATE,
+        PROFILE_UI,
+        PROFILE_KEYBOARD_RENDER,
+        PROFILE_HIT_TEST,
+        PROFILE_KEY_RENDER,
+        PROFILE_TEXT_LAYOUT,
+        PROFILE_ROTATION,
+        PROFILE_RGB,
+        PROFILE_IMGUI_RENDER,
+        PROFILE_NB_ZONES,
+    };
+
+    enum
+    {
+        PROFILE_MAX_THREADS = 64,
+        PROFILE_RING_SIZE   = 16384, // events per thread, a power of two
+        PROFILE_HISTORY     = 120,   // frames
+    };
+
+    const char* profile_zone_name(s32 zone); // "other" for PROFILE_NB_ZONES
+
+    u64  profile_now(); // nanoseconds, steady clock
+    void profile_record(s32 zone, u64 begin, u64 end);
+
+    // the innermost zone of the calling thread, profile_enter returns the zone it replaces
+    s32  profile_enter(s32 zone);
+    void profile_leave(s32 outer);
+    void profile_alloc(u64 size); // counts an allocation in the innermost zone of the calling thread
+
+    void profile_enable(bool enable); // enabled by default
+    bool profile_enabled();
+
+    struct kprofilescope_t
+    {
+        inline kprofilescope_t(s32 zone)
+            : m_zone(zone)
+            , m_outer(profile_enter(zone))
+            , m_begin(profile_enabled() ? profile_now() : 0)
+        {
+        }
+        inline ~kprofilescope_t()
+        {
+            if (m_begin != 0)
+                profile_record(m_zone, m_begin, profile_now());
+            profile_leave(m_outer);
+        }
+
+        s32 m_zone;
+        s32 m_outer;
+        u64 m_begin;
+    };
+
+    // once per frame on the thread that draws the graph
+    void profile_frame();
+
+    // milliseconds per frame of a zone for the last PROFILE_HISTORY frames, 'offset' is the oldest frame
+    float const* profile_history(s32 zone, s32& offset);
+    float        profile_average(s32 zone); // over the history
+
+    // allocations per frame of a zone (PROFILE_NB_ZONES for the ones outside of any zone) for the last
+    // PROFILE_HISTORY frames, and the allocations and bytes of the last frame over all zones
+    float const* profile_alloc_history(s32 zone, s32& offset);
+    void         profile_frame_allocs(s64& count, s64& bytes);
+
+    // the events in the rings as a Chrome trace JSON file, returns the number of events written or -1
+    s32 profile_export(const char* filename);
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_PROFILE_H__
@@ -2,9 +2,21 @@
 #define __QMK_KEYMAP_WIZ_KEYBOARD_RENDER_H__
 #pragma once
 
+#include "qmk-keymap-wiz/keyboard_compose.h"
+#include "qmk-keymap-wiz/keyboard_corpus.h"
 #include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_rgb.h"
 
-void keyboard_render(xcore::ckeyboard_t const* kb, xcore::keycodes_t const* kcdb, xcore::keymap_t const* km, xcore::s32 layer, float posx, float posy, float mousex, float mousey, float globalscale);
+struct ImFont;
+struct ImFontAtlas;
+
+// returns the keymap index of the key under the mouse, -1 when there is none
+// with 'compose' the transparent keys of the layer show the key they fall through to, dimmed and marked with the
+// layer that it comes from, with 'heatmap' the key caps are tinted by how often they are pressed, with 'rgb' (built
+// for this keyboard) the LED glow around the key caps is the glow palette of its effect
+xcore::s32 keyboard_render(xcore::ckeyboard_t const* kb, xcore::keycodes_t const* kcdb, xcore::keymap_t const* km, xcore::s32 layer, float posx, float posy, float mousex, float mousey, float globalscale, xcore::kcompose_t* compose = nullptr, xcore::kheatmap_t* heatmap = nullptr, xcore::krgb_t* rgb = nullptr);
 void keyboard_loadfonts();
 
+void keyboard_addfonts(ImFontAtlas* atlas, ImFont** fonts); // fonts must hold 4 entries, largest to smallest
+
 #endif // __QMK_KEYMAP_WIZ_KEYBOARD_RENDER_H__
\ No newline at end of file
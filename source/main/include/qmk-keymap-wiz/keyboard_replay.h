@@ -0,0 +1,61 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_REPLAY_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_REPLAY_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+namespace xcore
+{
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // Recorded input sessions. A frame holds the input state that the UI saw in that frame, a recording is the
+    // sequence of frames. On disk a frame is a byte of flags, the delta time and only the fields that differ from
+    // the previous frame (keys as the indices that went up or down), so an idle frame takes 5 bytes. Floats are
+    // stored in the byte order of the machine that recorded them.
+    enum
+    {
+        INPUT_MAX_BUTTONS = 5,
+        INPUT_MAX_KEYS    = 256, // named keys, a bit each
+        INPUT_MAX_CHARS   = 32,  // characters typed in one frame
+    };
+
+    struct kinputframe_t
+    {
+        float m_delta_time;
+        float m_display_w;
+        float m_display_h;
+        float m_font_scale;
+        float m_mouse_x;
+        float m_mouse_y;
+        float m_wheel_x; // wheel and characters are events of this frame, not state
+        float m_wheel_y;
+        u32   m_buttons; // bit i is mouse button i
+        u8    m_keys[INPUT_MAX_KEYS / 8];
+        s32   m_nb_chars;
+        u32   m_chars[INPUT_MAX_CHARS];
+    };
+
+    void input_clear(kinputframe_t& frame);
+    bool input_key(kinputframe_t const& frame, s32 key);
+    void input_set_key(kinputframe_t& frame, s32 key, bool down);
+    bool input_idle(kinputframe_t const& frame, kinputframe_t const& previous); // nothing changed and no events
+
+    struct krecorder_t;
+
+    krecorder_t* recorder_open(const char* filename); // nullptr when the file cannot be created
+    void         recorder_frame(krecorder_t* recorder, kinputframe_t const& frame);
+    s32          recorder_nb_frames(krecorder_t* recorder);
+    bool         recorder_close(krecorder_t* recorder); // returns false when any write failed
+
+    struct kplayer_t;
+
+    kplayer_t* player_open(const char* filename); // nullptr when the file is missing or not a recording
+    bool       player_next(kplayer_t* player, kinputframe_t& frame); // false after the last frame
+    void       player_rewind(kplayer_t* player);
+    s32        player_nb_frames(kplayer_t* player);
+    void       player_close(kplayer_t* player);
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_REPLAY_H__
@@ -0,0 +1,61 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_REVERSE_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_REVERSE_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_journal.h"
+
+namespace xcore
+{
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // Where is a character or keycode on a keymap, e.g. "how do I type '{'?".
+    // The index holds, for every keycode of the database, the list of keys (layer, key index) that send it, and the
+    // normal and shifted text of every keycode, a query is the list of one keycode (by name or alias) or of the few
+    // keycodes that have the text. An edit of a keycode moves a single key from one list to another.
+    // A hit tells which modifiers have to be held (e.g. Shift for the shifted text of a key that does not shift by
+    // itself) and how many layer switches it takes from the base layer to reach it, the switches themselves come from
+    // reverse_path. The shortest paths are updated when a layer switch is edited.
+    struct kreverse_t;
+
+    struct kreversehit_t
+    {
+        s16 m_layer;
+        s16 m_key;
+        u16 m_mods;  // emod bits that have to be held while pressing the key
+        s16 m_depth; // number of layer switches from the base layer, -1 when the layer cannot be reached
+    };
+
+    // press the key m_key on layer m_layer, a layer switch (elayer_switch) to the next layer of the path
+    struct kreversestep_t
+    {
+        s16 m_layer;
+        s16 m_key;
+        u16 m_switch;
+    };
+
+    kreverse_t* reverse_create();
+    void        reverse_destroy(kreverse_t* r);
+
+    // index the keys of a keymap, the keys must be compiled (see keyboard_keycode.h), 'kcdb' and 'km' are referenced
+    // until the next build
+    void reverse_build(kreverse_t* r, keycodes_t const* kcdb, keymap_t const* km);
+
+    // after 'edit' was applied to the keymap, returns true when a key moved or a layer path changed
+    bool reverse_update(kreverse_t* r, keymap_t const* km, kedit_t const& edit);
+
+    // the keys that send a keycode, or that type 'query' (a keycode name or alias, or the text on a key), the best
+    // hits (fewest layer switches, then without modifiers) first, returns the number of hits
+    s32 reverse_find_keycode(kreverse_t* r, s32 keycode, kreversehit_t* hits, s32 max_hits);
+    s32 reverse_find(kreverse_t* r, const char* query, kreversehit_t* hits, s32 max_hits);
+
+    // the shortest chain of layer switches from the base layer to 'layer', returns the number of steps or -1 when
+    // the layer cannot be reached
+    s32 reverse_path(kreverse_t* r, s32 layer, kreversestep_t* steps, s32 max_steps);
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_REVERSE_H__
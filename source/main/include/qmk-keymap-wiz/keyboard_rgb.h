@@ -0,0 +1,79 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_RGB_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_RGB_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+
+namespace xcore
+{
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // A preview of QMK RGB matrix effects on the LEDs of a keyboard.
+    // Every key of the keyboard has an LED, in the order of keyboard_layout, at the center of the key scaled to the
+    // 224 x 64 grid that QMK uses for g_led_config. The LEDs are kept as contiguous arrays of floats (position, color,
+    // time of the last press), padded to a multiple of 4, and every effect is a kernel that does 4 LEDs at a time
+    // with SSE2 (one at a time on other targets). The output is the glow palette, the three packed colors that
+    // keyboard_render draws around every key cap, so the renderer does no color math for the LEDs at all.
+    enum ergbeffect
+    {
+        RGB_SOLID = 0,        // the LED colors of the keymap
+        RGB_BREATHING,        // the LED colors, the brightness going up and down
+        RGB_CYCLE_ALL,        // all LEDs go through the hues together
+        RGB_CYCLE_LEFT_RIGHT, // a rainbow that moves from left to right
+        RGB_CYCLE_OUT_IN,     // a rainbow that moves from the edges to the center
+        RGB_REACTIVE,         // SOLID_REACTIVE_SIMPLE, a pressed key lights up and fades out
+        RGB_SPLASH,           // a wave goes out from the last pressed keys
+        RGB_NB_EFFECTS,
+    };
+
+    const char* rgb_effect_name(s32 effect);
+
+    enum
+    {
+        RGB_MAX_HITS = 8, // LED_HITS_TO_REMEMBER, the presses that the splash follows
+    };
+
+    struct krgbparams_t
+    {
+        krgbparams_t()
+        {
+            m_effect     = RGB_SOLID;
+            m_speed      = 1.0f;
+            m_brightness = 1.0f;
+        }
+
+        s32   m_effect;
+        float m_speed;      // 1 = the default speed of QMK (RGB_MATRIX_DEFAULT_SPD 127)
+        float m_brightness; // 0..1
+    };
+
+    struct krgb_t;
+
+    krgb_t* rgb_create();
+    void    rgb_destroy(krgb_t* rgb);
+
+    // the LEDs of a keyboard, the colors are those of the keyboard until rgb_colors, the presses are forgotten
+    void               rgb_build(krgb_t* rgb, ckeyboard_t const* kb);
+    ckeyboard_t const* rgb_keyboard(krgb_t* rgb);
+    s32                rgb_nb_leds(krgb_t* rgb);
+
+    // the colors of the LEDs from a layer of a keymap, the LED color of the key, or of the layer for a key that the
+    // layer does not have
+    void rgb_colors(krgb_t* rgb, keymap_t const* km, s32 layer);
+
+    // a press of the key with this keymap index at 'time' (seconds, the same clock as rgb_update)
+    void rgb_hit(krgb_t* rgb, s32 key, double time);
+
+    // runs the effect at 'time' and fills the glow palette
+    void rgb_update(krgb_t* rgb, krgbparams_t const& params, double time);
+
+    // the glow palette, rgb_nb_leds colors per ring, ring 0 is the outer one, packed like IM_COL32 (red in the low
+    // byte, alpha in the high byte)
+    u32 const* rgb_glow(krgb_t* rgb, s32 ring);
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_RGB_H__
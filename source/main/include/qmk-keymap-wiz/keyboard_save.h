@@ -0,0 +1,53 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_SAVE_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_SAVE_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_writer.h"
+
+namespace xcore
+{
+    // JSON encoding of keymaps, the output can be read back with load_keymaps. Fields that have their default
+    // value are not written.
+    void encode_key(kwriter_t& w, key_t const& key);
+    void encode_layer(kwriter_t& w, layer_t const& layer);
+    void encode_keymaps(kwriter_t& w, keymaps_t const* keymaps);
+
+    // JSON encoding of a keyboard as an element of the "keyboards" array of a keyboards file (load_keyboards), a
+    // keygroup per line, fields with their default value are not written
+    void encode_keyboard(kwriter_t& w, ckeyboard_t const& kb);
+
+    // Incremental saving of a keymaps file.
+    // The encoded JSON of every layer is cached, a save only encodes the layers that have been marked dirty since
+    // the previous save. Writing the file happens on a background thread; the file is written to '<file>.tmp' and
+    // then renamed over the original, so a crash during a save never leaves a partially written keymap file.
+    struct ksaver_t;
+
+    struct ksaver_stats_t
+    {
+        s32 m_nb_saves;          // number of files written
+        s32 m_nb_encoded_layers; // layers encoded by the last save
+        s32 m_nb_cached_layers;  // layers reused from the cache by the last save
+        s64 m_nb_bytes;          // size of the last written file
+        s32 m_nb_errors;         // failed writes
+    };
+
+    ksaver_t* saver_create(const char* filename);
+    void      saver_destroy(ksaver_t* saver); // waits for a pending save to finish
+
+    void saver_mark_dirty(ksaver_t* saver, s32 keymap, s32 layer);
+    void saver_mark_all_dirty(ksaver_t* saver);
+
+    // Encode the dirty layers (on the calling thread) and queue the file write. When a previous write has not
+    // started yet it is replaced by this one.
+    void saver_save(ksaver_t* saver, keymaps_t const* keymaps);
+    void saver_wait(ksaver_t* saver); // block until all queued writes are done
+
+    void saver_stats(ksaver_t* saver, ksaver_stats_t& stats);
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_SAVE_H__
@@ -0,0 +1,51 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_SEARCH_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_SEARCH_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+
+namespace xcore
+{
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // Fuzzy search over the keycode database (code, aliases, normal and shifted text and the description).
+    // The index holds the (lower-case) trigrams of every keycode with the list of keycodes per trigram, a query is
+    // answered by counting the trigrams every keycode shares with the query and ranking the candidates, queries
+    // shorter than 3 characters use a sorted list of the codes and aliases for a prefix search.
+    // Building the index again after the database was reloaded only extracts the trigrams and sorts the names of
+    // keycodes that changed, the trigrams and the (already sorted) names of the others are taken from the previous
+    // build and merged with them.
+    struct ksearch_t;
+
+    struct ksearchhit_t
+    {
+        keycode_t const* m_keycode;
+        s32              m_score;
+    };
+
+    struct ksearch_stats_t
+    {
+        s32 m_nb_keycodes;
+        s32 m_nb_trigrams;  // unique trigrams in the index
+        s32 m_nb_postings;  // (trigram, keycode) pairs
+        s32 m_nb_reused;    // keycodes whose trigrams were taken from the previous build
+        s32 m_nb_extracted; // keycodes whose trigrams were extracted
+    };
+
+    ksearch_t* search_create();
+    void       search_destroy(ksearch_t* s);
+
+    // (re)build the index for a keycode database, the database must outlive the index (or the next build)
+    void search_build(ksearch_t* s, keycodes_t const* kcdb);
+
+    // the best matches for 'query' (case insensitive), best first, returns the number of hits
+    s32 search_keycodes(ksearch_t* s, const char* query, ksearchhit_t* hits, s32 max_hits);
+
+    void search_stats(ksearch_t* s, ksearch_stats_t& stats);
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_SEARCH_H__
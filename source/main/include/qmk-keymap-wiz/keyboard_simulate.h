@@ -0,0 +1,98 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_SIMULATE_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_SIMULATE_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+
+namespace xcore
+{
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // What the firmware sends for a stream of key presses and releases, with the semantics of QMK.
+    // The simulator works on the compiled keys (see keyboard_keycode.h), the QMK value of every key of every layer
+    // is copied into one table when it is created, so an edit of the keymap needs a new simulator.
+    // - a key press looks up the key on the highest active layer, KC_TRNS falls through to the next active layer
+    //   below, the release does what the press did even when the layers changed in between
+    // - MO, LM, TG, TO, DF, basic keycodes, modifier keys and modifier wrappers (LCTL(kc)) act on press and release
+    // - LT, MT and TT are tap-hold keys, a tap when released within the tapping term and a hold after it, the keys
+    //   pressed while one is undecided are held back until it is decided, as QMK does
+    // - TT toggles its layer after 'tapping toggle' taps in a row
+    // - OSL and OSM, tapped, apply to the next key press, held they act like MO and a held modifier
+    // The output is the 8 byte boot keyboard report (modifiers and 6 keys) every time it changes, with the time of
+    // the event that changed it. Events are in milliseconds and have to be in time order.
+    struct ksimevent_t
+    {
+        u32 m_time; // milliseconds
+        s16 m_key;  // index of the key in the keymap
+        u8  m_down; // 1 = press, 0 = release
+        u8  m_pad;
+    };
+
+    struct ksimreport_t
+    {
+        u32 m_time;
+        u8  m_mods; // HID modifier bits, left control, shift, alt and gui in bits 0..3, the right ones in 4..7
+        u8  m_keys[6];
+        u8  m_pad;
+    };
+
+    struct ksimparams_t
+    {
+        ksimparams_t()
+        {
+            m_tapping_term            = 200;
+            m_tapping_toggle          = 5;
+            m_permissive_hold         = false;
+            m_hold_on_other_key_press = false;
+        }
+
+        u32  m_tapping_term;            // TAPPING_TERM, milliseconds
+        s32  m_tapping_toggle;          // TAPPING_TOGGLE, taps of a TT key that toggle its layer
+        bool m_permissive_hold;         // PERMISSIVE_HOLD, a key tapped while a tap-hold key is held makes it a hold
+        bool m_hold_on_other_key_press; // HOLD_ON_OTHER_KEY_PRESS, any key pressed makes it a hold
+    };
+
+    struct ksimstats_t
+    {
+        s64 m_nb_events;
+        s64 m_nb_reports;
+        s64 m_nb_dropped;   // reports that did not fit in the output
+        s64 m_nb_rollover;  // keys that did not fit in the 6 slots of the report
+        s64 m_nb_unhandled; // presses of keys that the simulator does not know (user keycodes, media keys, ...)
+    };
+
+    struct ksim_t;
+
+    // 'km' has to be compiled, only its first 32 layers are used
+    ksim_t* sim_create(keymap_t const* km, ksimparams_t const& params);
+    void    sim_destroy(ksim_t* sim);
+    void    sim_reset(ksim_t* sim); // all keys up, only the first layer active, nothing pending, stats cleared
+
+    // processes 'nb_events' events, the reports they produce go to 'reports' (at most 'max_reports' of them, the rest
+    // is counted as dropped), returns the number of reports written
+    s32 sim_run(ksim_t* sim, ksimevent_t const* events, s32 nb_events, ksimreport_t* reports, s32 max_reports);
+
+    // the time passed without events, a tap-hold key that has been held for the tapping term turns into a hold
+    s32 sim_tick(ksim_t* sim, u32 time, ksimreport_t* reports, s32 max_reports);
+
+    u32                 sim_layer_state(ksim_t* sim);         // bit n = layer n is on
+    u32                 sim_default_layer_state(ksim_t* sim); // the layers set by DF
+    s32                 sim_top_layer(ksim_t* sim);           // the highest active layer
+    bool                sim_key_down(ksim_t* sim, s32 key);
+    bool                sim_pending(ksim_t* sim); // a tap-hold key is undecided
+    ksimreport_t const& sim_report(ksim_t* sim);  // the last report
+    void                sim_stats(ksim_t* sim, ksimstats_t& stats);
+
+    // Event and report files are text, a line per event '<time> <key> d|u' and a line per report
+    // '<time> <mods> <key> <key> <key> <key> <key> <key>' with the mods and keys in hexadecimal. Empty lines and
+    // lines that start with '#' are skipped. The arrays are allocated with ::malloc.
+    bool sim_load_events(const char* filename, ksimevent_t*& events, s32& nb_events);
+    bool sim_load_reports(const char* filename, ksimreport_t*& reports, s32& nb_reports);
+    bool sim_same_report(ksimreport_t const& a, ksimreport_t const& b);
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_SIMULATE_H__
@@ -0,0 +1,74 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_VALIDATE_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_VALIDATE_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+#include "qmk-keymap-wiz/keyboard_journal.h"
+
+namespace xcore
+{
+    enum ediag
+    {
+        DIAG_UNKNOWN_KEYBOARD, // the keymap names a keyboard that is not in the keyboard database
+        DIAG_KEY_COUNT,        // the layer does not have as many keys as the keyboard has key indices
+        DIAG_UNKNOWN_KEYCODE,  // the keycode is not in the keycode database
+        DIAG_MISSING_LAYER,    // a layer switch key without a target layer
+        DIAG_UNKNOWN_LAYER,    // a layer switch key targeting a layer that does not exist
+        DIAG_INVALID_SWITCH,   // the layer switch is not exactly one of MO, LT, TG, TO, TT or OSL
+        DIAG_LT_RANGE,         // LT can only target layers 0-15
+        DIAG_UNREACHABLE,      // no layer switch key leads from the base layer to the layer
+        DIAG_LAYER_TRAP,       // the layer can be entered persistently but has no way back to the base layer
+        DIAG_LAYER_CYCLE,      // layers that momentarily activate each other
+        DIAG_COUNT,
+    };
+
+    struct kdiag_t
+    {
+        ediag       m_code;
+        s32         m_layer;  // -1 when the diagnostic is about the keymap
+        s32         m_key;    // -1 when the diagnostic is about the layer
+        const char* m_detail; // e.g. the unknown keycode or layer name
+    };
+
+    typedef void (*diag_fn)(kdiag_t const& diag, void* user);
+
+    const char* diag_name(ediag code); // e.g. "unknown_keycode"
+
+    // number of keys a layer needs for a keyboard (highest key index + 1)
+    s32 keyboard_nb_indices(ckeyboard_t const* kb);
+
+    // check a keymap (or a single key) against the keycode and keyboard database, every problem is reported
+    // through 'fn', returns the number of problems
+    s32 validate_keymap(keymap_t const* km, keycodes_t const* kcdb, ckeyboards_t const* kbdb, diag_fn fn, void* user);
+    s32 validate_key(keymap_t const* km, s32 layer, s32 key, keycodes_t const* kcdb, diag_fn fn, void* user);
+
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // Incremental validation, the keymaps are validated in full once and after that only the key that an edit
+    // touches is validated again. The diagnostics are kept in a list that only changes when an edit changes the
+    // diagnostics of a key, m_version tells a UI when it has to refresh whatever it derived from the list.
+    struct kvalidator_t;
+
+    struct kvdiag_t
+    {
+        s32     m_keymap;
+        kdiag_t m_diag;
+    };
+
+    kvalidator_t* validator_create(keycodes_t const* kcdb, ckeyboards_t const* kbdb);
+    void          validator_destroy(kvalidator_t* v);
+
+    s32 validator_run(kvalidator_t* v, keymaps_t const* keymaps);                       // full validation
+    s32 validator_update(kvalidator_t* v, keymaps_t const* keymaps, kedit_t const& edit); // after 'edit' was applied
+
+    s32             validator_nb_diags(kvalidator_t* v);
+    kvdiag_t const* validator_diags(kvalidator_t* v);
+    u32             validator_version(kvalidator_t* v);
+    bool            validator_key_ok(kvalidator_t* v, s32 keymap, s32 layer, s32 key);
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_VALIDATE_H__
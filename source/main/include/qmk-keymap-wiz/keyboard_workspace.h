@@ -0,0 +1,59 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_WORKSPACE_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_WORKSPACE_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "qmk-keymap-wiz/keyboard_data.h"
+
+namespace xcore
+{
+    // -----------------------------------------------------------------------------------------------------------------
+    // -----------------------------------------------------------------------------------------------------------------
+    // The keymap files of a directory (and its sub-directories).
+    // A scan decodes every file on all cores, each into an arena of its own, and keeps a summary of every file that
+    // stays when the keymaps are evicted, so that the list of files (keyboard, layers) can be shown and switched
+    // between without decoding anything. The decoded keymaps are kept as long as they fit in the memory budget,
+    // the least recently acquired are evicted first; an evicted file is decoded again when it is acquired. A file
+    // that is acquired is pinned, it is not evicted until it is released.
+    struct kworkspaceentry_t
+    {
+        const char* m_filename;   // e.g. "keymaps/jurgen.json"
+        const char* m_name;       // the file name without directory and extension, "jurgen"
+        const char* m_keyboard;   // the keyboard of the first keymap, "" when the file did not decode
+        s32         m_nb_keymaps; //
+        s32         m_nb_layers;  // of the first keymap
+        s32         m_nb_keys;    // of all the layers of the first keymap
+        s64         m_file_size;  //
+        s64         m_memory;     // bytes held by the decoded keymaps, 0 when they are not in memory
+        bool        m_failed;     // the file is not a keymaps file, or it could not be read
+    };
+
+    struct kworkspace_t;
+
+    kworkspace_t* workspace_create(const char* dir, s64 memory_budget);
+    void          workspace_destroy(kworkspace_t* ws);
+
+    // enumerates the directory and decodes every .json file, on 'nb_workers' threads (0 = all hardware threads),
+    // then evicts down to the budget; the files of an earlier scan are forgotten, false when there is no directory
+    bool workspace_scan(kworkspace_t* ws, s32 nb_workers = 0);
+
+    s32                      workspace_nb_entries(kworkspace_t const* ws);
+    kworkspaceentry_t const* workspace_entry(kworkspace_t const* ws, s32 entry);
+    s32                      workspace_find(kworkspace_t const* ws, const char* filename); // -1 when it is not there
+
+    // the keymaps of a file, decoded now when they are not in memory, nullptr when the file does not decode;
+    // every acquire pins the keymaps until a matching release
+    keymaps_t const* workspace_acquire(kworkspace_t* ws, s32 entry);
+    void             workspace_release(kworkspace_t* ws, s32 entry);
+
+    // drop the decoded keymaps of a file that is not pinned, e.g. after the file was written
+    void workspace_evict(kworkspace_t* ws, s32 entry);
+
+    s64 workspace_memory(kworkspace_t const* ws); // bytes of all the decoded keymaps
+    s64 workspace_budget(kworkspace_t const* ws);
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_WORKSPACE_H__
@@ -0,0 +1,56 @@
+#ifndef __QMK_KEYMAP_WIZ_KEYBOARD_WRITER_H__
+#define __QMK_KEYMAP_WIZ_KEYBOARD_WRITER_H__
+#include "xbase/x_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include <stdio.h>
+
+namespace xcore
+{
+    // Buffered text writer, output is streamed to a file through a fixed size buffer. When opened with
+    // writer_count nothing is written and only the number of characters is counted, this allows a generator
+    // to measure (e.g. for column alignment) with exactly the same code that it uses to write. When opened
+    // with writer_memory the output is collected in m_buffer (m_size bytes) until the writer is closed.
+    struct kwriter_t
+    {
+        kwriter_t()
+        {
+            m_memory  = false;
+            m_file    = nullptr;
+            m_buffer  = nullptr;
+            m_size    = 0;
+            m_cap     = 0;
+            m_written = 0;
+            m_error   = false;
+        }
+
+        bool  m_memory;
+        FILE* m_file;
+        char* m_buffer;
+        s32   m_size;
+        s32   m_cap;
+        s64   m_written; // total number of characters written (or counted)
+        bool  m_error;
+    };
+
+    bool writer_open(kwriter_t& w, const char* filename);
+    bool writer_append(kwriter_t& w, const char* filename); // like writer_open, but appends to an existing file
+    void writer_count(kwriter_t& w);
+    void writer_memory(kwriter_t& w);
+    bool writer_sync(kwriter_t& w);  // flush and make sure the data is on disk (fsync)
+    bool writer_close(kwriter_t& w); // returns false when any write failed
+
+    void writer_write(kwriter_t& w, const char* str, s32 len);
+    void writer_str(kwriter_t& w, const char* str);
+    void writer_char(kwriter_t& w, char c);
+    void writer_int(kwriter_t& w, s32 value);
+    void writer_s64(kwriter_t& w, s64 value);
+    void writer_spaces(kwriter_t& w, s32 count);
+    void writer_float(kwriter_t& w, float value, s32 decimals);
+    void writer_json_str(kwriter_t& w, const char* str); // quoted and escaped JSON string
+
+} // namespace xcore
+
+#endif // __QMK_KEYMAP_WIZ_KEYBOARD_WRITER_H__